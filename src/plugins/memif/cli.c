@@ -62,6 +62,8 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	args.is_master = 1;
       else if (unformat (line_input, "slave"))
 	args.is_master = 0;
+      else if (unformat (line_input, "zero-copy"))
+	args.is_zero_copy = 1;
       else if (unformat (line_input, "mode ip"))
 	args.mode = MEMIF_INTERFACE_MODE_IP;
       else if (unformat (line_input, "hw-addr %U",
@@ -104,6 +106,9 @@ memif_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   if (r == VNET_API_ERROR_SUBIF_ALREADY_EXISTS)
     return clib_error_return (0, "Interface with same id already exists");
 
+  if (r == VNET_API_ERROR_UNSUPPORTED)
+    return clib_error_return (0, "zero-copy is supported on slaves only");
+
   return 0;
 }
 
@@ -113,7 +118,7 @@ VLIB_CLI_COMMAND (memif_create_command, static) = {
   .short_help = "create memif [id <id>] [socket <path>] "
                 "[ring-size <size>] [buffer-size <size>] [hw-addr <mac-address>] "
 		"<master|slave> [rx-queues <number>] [tx-queues <number>] "
-		"[mode ip] [secret <string>]",
+		"[mode ip] [secret <string>] [zero-copy]",
   .function = memif_create_command_fn,
 };
 /* *INDENT-ON* */
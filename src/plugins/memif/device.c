@@ -256,6 +256,130 @@ error:
   return frame->n_vectors;
 }
 
+/**
+ * @brief Zero-copy tx: put the packets' own buffers in the ring slots,
+ * one per segment, after freeing those the master is done with.
+ */
+static_always_inline uword
+memif_interface_tx_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      vlib_frame_t * frame, memif_if_t * mif)
+{
+  u8 qid;
+  memif_ring_t *ring;
+  u32 *buffers = vlib_frame_args (frame);
+  u32 n_left = frame->n_vectors;
+  u16 ring_size, mask;
+  u16 head, tail, slot, n_done;
+  u16 free_slots, n_segs;
+  u32 thread_index = vlib_get_thread_index ();
+  u8 tx_queues = vec_len (mif->tx_queues);
+  memif_queue_t *mq;
+  memif_desc_t *d;
+  vlib_buffer_t *b0;
+  u32 bi0;
+
+  if (PREDICT_FALSE (tx_queues == 0))
+    {
+      vlib_error_count (vm, node->node_index, MEMIF_TX_ERROR_NO_TX_QUEUES,
+			n_left);
+      vlib_buffer_free (vm, buffers, n_left);
+      return frame->n_vectors;
+    }
+
+  if (tx_queues < vec_len (vlib_mains))
+    {
+      qid = thread_index % tx_queues;
+      clib_spinlock_lock_if_init (&mif->lockp);
+    }
+  else
+    {
+      qid = thread_index;
+    }
+  mq = vec_elt_at_index (mif->tx_queues, qid);
+  ring = mq->ring;
+  ring_size = 1 << mq->log2_ring_size;
+  mask = ring_size - 1;
+
+  /* free consumed buffers, never past the slots we gave the master */
+  tail = ring->tail;
+  n_done = clib_min ((u16) (tail - mq->last_tail),
+		     (u16) (mq->last_head - mq->last_tail));
+  if (n_done)
+    {
+      memif_zc_free_slots (vm, mq, mq->last_tail, n_done);
+      mq->last_tail += n_done;
+    }
+  tail = mq->last_tail;
+
+  head = mq->last_head;
+  free_slots = ring_size - head + tail;
+
+  while (n_left)
+    {
+      if (n_left > 2)
+	{
+	  vlib_prefetch_buffer_header (vlib_get_buffer (vm, buffers[2]),
+				       LOAD);
+	  CLIB_PREFETCH (&ring->desc[(head + 4) & mask],
+			 CLIB_CACHE_LINE_BYTES, STORE);
+	}
+
+      /* all of a packet's segments, or none of them */
+      n_segs = 0;
+      bi0 = buffers[0];
+      do
+	{
+	  b0 = vlib_get_buffer (vm, bi0);
+	  n_segs++;
+	}
+      while ((bi0 = (b0->flags & VLIB_BUFFER_NEXT_PRESENT) ?
+	      b0->next_buffer : 0));
+
+      if (n_segs > free_slots)
+	break;
+
+      bi0 = buffers[0];
+      do
+	{
+	  b0 = vlib_get_buffer (vm, bi0);
+	  slot = head++ & mask;
+	  d = &ring->desc[slot];
+	  memif_zc_desc_set_buffer (mif, d, b0, b0->current_length);
+	  d->length = b0->current_length;
+	  d->flags = (b0->flags & VLIB_BUFFER_NEXT_PRESENT) ?
+	    MEMIF_DESC_FLAG_NEXT : 0;
+	  mq->buffers[slot] = bi0;
+	}
+      while ((bi0 = (b0->flags & VLIB_BUFFER_NEXT_PRESENT) ?
+	      b0->next_buffer : 0));
+
+      free_slots -= n_segs;
+      buffers++;
+      n_left--;
+    }
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->head = mq->last_head = head;
+
+  clib_spinlock_unlock_if_init (&mif->lockp);
+
+  if (n_left)
+    {
+      vlib_error_count (vm, node->node_index, MEMIF_TX_ERROR_NO_FREE_SLOTS,
+			n_left);
+      vlib_buffer_free (vm, buffers, n_left);
+    }
+
+  if ((ring->flags & MEMIF_RING_FLAG_MASK_INT) == 0 && mq->int_fd > -1)
+    {
+      u64 b = 1;
+      CLIB_UNUSED (int r) = write (mq->int_fd, &b, sizeof (b));
+      mq->int_count++;
+    }
+
+  return frame->n_vectors;
+}
+
 static uword
 memif_interface_tx (vlib_main_t * vm,
 		    vlib_node_runtime_t * node, vlib_frame_t * frame)
@@ -264,7 +388,9 @@ memif_interface_tx (vlib_main_t * vm,
   vnet_interface_output_runtime_t *rund = (void *) node->runtime_data;
   memif_if_t *mif = pool_elt_at_index (nm->interfaces, rund->dev_instance);
 
-  if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+  if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+    return memif_interface_tx_zc_inline (vm, node, frame, mif);
+  else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_S2M);
   else
     return memif_interface_tx_inline (vm, node, frame, mif, MEMIF_RING_M2S);
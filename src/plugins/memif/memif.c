@@ -65,6 +65,26 @@ memif_queue_intfd_close (memif_queue_t * mq)
     }
 }
 
+static void
+memif_queue_free_zc_buffers (memif_queue_t * mq, int is_rx)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  u16 ring_size = 1 << mq->log2_ring_size;
+
+  if (mq->buffers == 0)
+    return;
+
+  /* rx holds the slots not yet received, up to the last refill,
+     tx those the master has not consumed yet */
+  if (is_rx)
+    memif_zc_free_slots (vm, mq, mq->last_head,
+			 (u16) (mq->last_tail + ring_size - mq->last_head));
+  else
+    memif_zc_free_slots (vm, mq, mq->last_tail,
+			 (u16) (mq->last_head - mq->last_tail));
+  vec_free (mq->buffers);
+}
+
 void
 memif_disconnect (memif_if_t * mif, clib_error_t * err)
 {
@@ -125,16 +145,26 @@ memif_disconnect (memif_if_t * mif, clib_error_t * err)
   }
 
   /* free tx and rx queues */
-  vec_foreach (mq, mif->rx_queues) memif_queue_intfd_close (mq);
+  vec_foreach (mq, mif->rx_queues)
+  {
+    memif_queue_intfd_close (mq);
+    memif_queue_free_zc_buffers (mq, 1);
+  }
   vec_free (mif->rx_queues);
 
-  vec_foreach (mq, mif->tx_queues) memif_queue_intfd_close (mq);
+  vec_foreach (mq, mif->tx_queues)
+  {
+    memif_queue_intfd_close (mq);
+    memif_queue_free_zc_buffers (mq, 0);
+  }
   vec_free (mif->tx_queues);
 
   /* free memory regions */
   vec_foreach (mr, mif->regions)
   {
     int rv;
+    if (mr->is_external)
+      continue;
     if ((rv = munmap (mr->shm, mr->region_size)))
       clib_warning ("munmap failed, rv = %d", rv);
     if (mr->fd > -1)
@@ -262,6 +292,40 @@ memif_get_ring (memif_if_t * mif, memif_ring_type_t type, u16 ring_num)
   return (memif_ring_t *) p;
 }
 
+/*
+ * Zero-copy: add a region for each vlib buffer pool, in pool order so
+ * that a buffer's region follows from its pool index.
+ */
+static clib_error_t *
+memif_init_buffer_regions (memif_if_t * mif)
+{
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_buffer_pool_t *bp;
+  vlib_physmem_region_t *pr;
+  memif_region_t *r;
+
+  vec_foreach (bp, vm->buffer_main->buffer_pools)
+  {
+    pr = vlib_physmem_get_region (vm, bp->physmem_region);
+    if (pr->fd < 0)
+      return clib_error_return (0, "buffer memory '%s' cannot be shared",
+				pr->name);
+
+    vec_add2_aligned (mif->regions, r, 1, CLIB_CACHE_LINE_BYTES);
+    ASSERT (r - mif->regions ==
+	    MEMIF_ZC_BUFFER_REGION (bp - vm->buffer_main->buffer_pools));
+    r->shm = pr->mem;
+    r->region_size = pr->size;
+    r->fd = pr->fd;
+    r->is_external = 1;
+  }
+
+  if (vec_len (mif->regions) - 1 > MEMIF_MAX_REGION)
+    return clib_error_return (0, "too many buffer memory regions");
+
+  return 0;
+}
+
 clib_error_t *
 memif_init_regions_and_queues (memif_if_t * mif)
 {
@@ -271,6 +335,7 @@ memif_init_regions_and_queues (memif_if_t * mif)
   memif_region_t *r;
   clib_mem_vm_alloc_t alloc = { 0 };
   clib_error_t *err;
+  int zero_copy = (mif->flags & MEMIF_IF_FLAG_ZERO_COPY) != 0;
 
   vec_validate_aligned (mif->regions, 0, CLIB_CACHE_LINE_BYTES);
   r = vec_elt_at_index (mif->regions, 0);
@@ -279,9 +344,13 @@ memif_init_regions_and_queues (memif_if_t * mif)
     (sizeof (memif_ring_t) +
      sizeof (memif_desc_t) * (1 << mif->run.log2_ring_size));
 
-  r->region_size = buffer_offset +
-    mif->run.buffer_size * (1 << mif->run.log2_ring_size) *
-    (mif->run.num_s2m_rings + mif->run.num_m2s_rings);
+  /* in zero-copy mode the packets are in the buffer regions */
+  if (zero_copy)
+    r->region_size = buffer_offset;
+  else
+    r->region_size = buffer_offset +
+      mif->run.buffer_size * (1 << mif->run.log2_ring_size) *
+      (mif->run.num_s2m_rings + mif->run.num_m2s_rings);
 
   alloc.name = "memif region";
   alloc.size = r->region_size;
@@ -294,12 +363,15 @@ memif_init_regions_and_queues (memif_if_t * mif)
   r->fd = alloc.fd;
   r->shm = alloc.addr;
 
+  if (zero_copy && (err = memif_init_buffer_regions (mif)))
+    return err;
+
   for (i = 0; i < mif->run.num_s2m_rings; i++)
     {
       ring = memif_get_ring (mif, MEMIF_RING_S2M, i);
       ring->head = ring->tail = 0;
       ring->cookie = MEMIF_COOKIE;
-      for (j = 0; j < (1 << mif->run.log2_ring_size); j++)
+      for (j = 0; !zero_copy && j < (1 << mif->run.log2_ring_size); j++)
 	{
 	  u16 slot = i * (1 << mif->run.log2_ring_size) + j;
 	  ring->desc[j].region = 0;
@@ -313,7 +385,7 @@ memif_init_regions_and_queues (memif_if_t * mif)
       ring = memif_get_ring (mif, MEMIF_RING_M2S, i);
       ring->head = ring->tail = 0;
       ring->cookie = MEMIF_COOKIE;
-      for (j = 0; j < (1 << mif->run.log2_ring_size); j++)
+      for (j = 0; !zero_copy && j < (1 << mif->run.log2_ring_size); j++)
 	{
 	  u16 slot =
 	    (i + mif->run.num_s2m_rings) * (1 << mif->run.log2_ring_size) + j;
@@ -334,10 +406,14 @@ memif_init_regions_and_queues (memif_if_t * mif)
       return clib_error_return_unix (0, "eventfd[tx queue %u]", i);
     mq->int_clib_file_index = ~0;
     mq->ring = memif_get_ring (mif, MEMIF_RING_S2M, i);
-    mq->log2_ring_size = mif->cfg.log2_ring_size;
+    mq->log2_ring_size = mif->run.log2_ring_size;
     mq->region = 0;
     mq->offset = (void *) mq->ring - (void *) mif->regions[mq->region].shm;
     mq->last_head = 0;
+    mq->last_tail = 0;
+    if (zero_copy)
+      vec_validate_aligned (mq->buffers, (1 << mq->log2_ring_size) - 1,
+			    CLIB_CACHE_LINE_BYTES);
   }
 
   ASSERT (mif->rx_queues == 0);
@@ -350,10 +426,19 @@ memif_init_regions_and_queues (memif_if_t * mif)
       return clib_error_return_unix (0, "eventfd[rx queue %u]", i);
     mq->int_clib_file_index = ~0;
     mq->ring = memif_get_ring (mif, MEMIF_RING_M2S, i);
-    mq->log2_ring_size = mif->cfg.log2_ring_size;
+    mq->log2_ring_size = mif->run.log2_ring_size;
     mq->region = 0;
     mq->offset = (void *) mq->ring - (void *) mif->regions[mq->region].shm;
     mq->last_head = 0;
+    if (zero_copy)
+      {
+	/* every slot is free to start with, as if the previous ring's
+	   worth had just been received: refill them all */
+	vec_validate_aligned (mq->buffers, (1 << mq->log2_ring_size) - 1,
+			      CLIB_CACHE_LINE_BYTES);
+	mq->last_tail = -(1 << mq->log2_ring_size);
+	memif_zc_refill (vlib_get_main (), mif, mq);
+      }
   }
 
   return 0;
@@ -576,6 +661,13 @@ memif_create_if (vlib_main_t * vm, memif_create_if_args_t * args)
   else
     socket_filename = vec_dup (args->socket_filename);
 
+  /* only the slave owns the shared memory, see private.h */
+  if (args->is_zero_copy && args->is_master)
+    {
+      rv = VNET_API_ERROR_UNSUPPORTED;
+      goto done;
+    }
+
   p = mhash_get (&mm->socket_file_index_by_filename, socket_filename);
 
   if (p)
@@ -639,6 +731,8 @@ memif_create_if (vlib_main_t * vm, memif_create_if_args_t * args)
   mif->id = args->id;
   mif->sw_if_index = mif->hw_if_index = mif->per_interface_next_index = ~0;
   mif->mode = args->mode;
+  if (args->is_zero_copy)
+    mif->flags |= MEMIF_IF_FLAG_ZERO_COPY;
   if (args->secret)
     mif->secret = vec_dup (args->secret);
 
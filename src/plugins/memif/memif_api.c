@@ -177,6 +177,9 @@ vl_api_memif_create_t_handler (vl_api_memif_create_t * mp)
       args.hw_addr_set = 1;
     }
 
+  /* zero-copy */
+  args.is_zero_copy = mp->zero_copy;
+
   rv = memif_create_if (vm, &args);
 
   vec_free (args.socket_filename);
@@ -254,6 +257,7 @@ send_memif_details (unix_shared_memory_queue_t * q,
 
   mp->admin_up_down = (swif->flags & VNET_SW_INTERFACE_FLAG_ADMIN_UP) ? 1 : 0;
   mp->link_up_down = (hwif->flags & VNET_HW_INTERFACE_FLAG_LINK_UP) ? 1 : 0;
+  mp->zero_copy = (mif->flags & MEMIF_IF_FLAG_ZERO_COPY) ? 1 : 0;
 
   vl_msg_api_send_shmem (q, (u8 *) & mp);
 }
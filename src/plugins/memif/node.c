@@ -447,6 +447,181 @@ memif_device_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   return n_rx_packets;
 }
 
+/**
+ * @brief Zero-copy rx: give the master empty buffers for the slots
+ * received since the last refill and advance tail over them.
+ */
+void
+memif_zc_refill (vlib_main_t * vm, memif_if_t * mif, memif_queue_t * mq)
+{
+  memif_ring_t *ring = mq->ring;
+  u16 ring_size = 1 << mq->log2_ring_size;
+  u16 mask = ring_size - 1;
+  u16 n_slots = mq->last_head - mq->last_tail;
+  u32 n_buffer_bytes = vlib_buffer_free_list_buffer_size (vm,
+							  VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+  u16 slot, n, n_alloc, i;
+  vlib_buffer_t *b;
+
+  while (n_slots)
+    {
+      slot = mq->last_tail & mask;
+      n = clib_min (n_slots, ring_size - slot);
+      n_alloc = vlib_buffer_alloc (vm, mq->buffers + slot, n);
+
+      for (i = 0; i < n_alloc; i++)
+	{
+	  b = vlib_get_buffer (vm, mq->buffers[slot + i]);
+	  b->current_data = 0;
+	  memif_zc_desc_set_buffer (mif, &ring->desc[slot + i], b,
+				    n_buffer_bytes);
+	}
+
+      mq->last_tail += n_alloc;
+      n_slots -= n_alloc;
+      if (n_alloc < n)
+	break;
+    }
+
+  CLIB_MEMORY_STORE_BARRIER ();
+  ring->tail = mq->last_tail;
+}
+
+/**
+ * @brief Zero-copy rx: the packets are already in the buffers in the
+ * ring slots, so take the buffers, then refill the slots.
+ */
+static_always_inline uword
+memif_device_input_zc_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
+			      memif_if_t * mif, u16 qid,
+			      memif_interface_mode_t mode)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  memif_ring_t *ring;
+  memif_queue_t *mq;
+  memif_desc_t *d;
+  u16 head, ring_size, mask, num_slots, slot;
+  u32 next_index, next0, bi0, prev_bi0, first_bi0, len;
+  vlib_buffer_t *first_b0, *b0;
+  uword n_trace = vlib_get_trace_count (vm, node);
+  u32 n_rx_packets = 0;
+  u32 n_rx_bytes = 0;
+  u32 *to_next = 0;
+  u32 n_left_to_next;
+  u32 thread_index = vlib_get_thread_index ();
+  u32 n_buffer_bytes = vlib_buffer_free_list_buffer_size (vm,
+							  VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+
+  mq = vec_elt_at_index (mif->rx_queues, qid);
+  ring = mq->ring;
+  ring_size = 1 << mq->log2_ring_size;
+  mask = ring_size - 1;
+
+  if (mode == MEMIF_INTERFACE_MODE_IP)
+    next_index = VNET_DEVICE_INPUT_NEXT_IP6_INPUT;
+  else
+    next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+
+  /* only slots we filled hold buffers, whatever head the master wrote */
+  head = ring->head;
+  num_slots = clib_min ((u16) (head - mq->last_head),
+			(u16) (ring_size - (u16) (mq->last_head -
+						  mq->last_tail)));
+
+  while (num_slots)
+    {
+      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+
+      while (num_slots && n_left_to_next)
+	{
+	  /* first segment */
+	  slot = mq->last_head++ & mask;
+	  num_slots--;
+	  d = &ring->desc[slot];
+	  first_bi0 = bi0 = mq->buffers[slot];
+	  first_b0 = vlib_get_buffer (vm, bi0);
+	  len = clib_min (d->length, n_buffer_bytes);
+	  first_b0->current_length = len;
+	  first_b0->total_length_not_including_first_buffer = 0;
+	  first_b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
+	  vnet_buffer (first_b0)->sw_if_index[VLIB_RX] = mif->sw_if_index;
+	  vnet_buffer (first_b0)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+	  n_rx_bytes += len;
+
+	  /* chained segments */
+	  while ((d->flags & MEMIF_DESC_FLAG_NEXT) && num_slots)
+	    {
+	      prev_bi0 = bi0;
+	      slot = mq->last_head++ & mask;
+	      num_slots--;
+	      d = &ring->desc[slot];
+	      bi0 = mq->buffers[slot];
+	      len = clib_min (d->length, n_buffer_bytes);
+	      b0 = vlib_get_buffer (vm, bi0);
+	      b0->current_length = len;
+	      b0->flags = 0;
+	      memif_buffer_add_to_chain (vm, bi0, first_bi0, prev_bi0);
+	      n_rx_bytes += len;
+	    }
+
+	  next0 = next_index;
+	  if (mode == MEMIF_INTERFACE_MODE_IP)
+	    {
+	      next0 = memif_next_from_ip_hdr (node, first_b0);
+	    }
+	  else if (mode == MEMIF_INTERFACE_MODE_ETHERNET)
+	    {
+	      if (PREDICT_FALSE (mif->per_interface_next_index != ~0))
+		next0 = mif->per_interface_next_index;
+	      else
+		/* redirect if feature path
+		 * enabled */
+		vnet_feature_start_device_input_x1 (mif->sw_if_index,
+						    &next0, first_b0);
+	    }
+
+	  /* trace */
+	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (first_b0);
+
+	  if (PREDICT_FALSE (n_trace > 0))
+	    {
+	      memif_input_trace_t *tr;
+	      vlib_trace_buffer (vm, node, next0, first_b0,
+				 /* follow_chain */ 0);
+	      vlib_set_trace_count (vm, node, --n_trace);
+	      tr = vlib_add_trace (vm, node, first_b0, sizeof (*tr));
+	      tr->next_index = next0;
+	      tr->hw_if_index = mif->hw_if_index;
+	      tr->ring = qid;
+	    }
+
+	  /* enqueue buffer */
+	  to_next[0] = first_bi0;
+	  to_next += 1;
+	  n_left_to_next--;
+
+	  /* enqueue */
+	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index, to_next,
+					   n_left_to_next, first_bi0, next0);
+
+	  /* next packet */
+	  n_rx_packets++;
+	}
+      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+    }
+
+  /* also retries slots a previous refill could not allocate for */
+  if (mq->last_head != mq->last_tail)
+    memif_zc_refill (vm, mif, mq);
+
+  vlib_increment_combined_counter (vnm->interface_main.combined_sw_if_counters
+				   + VNET_INTERFACE_COUNTER_RX, thread_index,
+				   mif->hw_if_index, n_rx_packets,
+				   n_rx_bytes);
+
+  return n_rx_packets;
+}
+
 static uword
 memif_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		vlib_frame_t * frame)
@@ -463,7 +638,18 @@ memif_input_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
     if ((mif->flags & MEMIF_IF_FLAG_ADMIN_UP) &&
 	(mif->flags & MEMIF_IF_FLAG_CONNECTED))
       {
-	if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
+	if (mif->flags & MEMIF_IF_FLAG_ZERO_COPY)
+	  {
+	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
+	      n_rx += memif_device_input_zc_inline (vm, node, mif,
+						    dq->queue_id,
+						    MEMIF_INTERFACE_MODE_IP);
+	    else
+	      n_rx += memif_device_input_zc_inline (vm, node, mif,
+						    dq->queue_id,
+						    MEMIF_INTERFACE_MODE_ETHERNET);
+	  }
+	else if (mif->flags & MEMIF_IF_FLAG_IS_SLAVE)
 	  {
 	    if (mif->mode == MEMIF_INTERFACE_MODE_IP)
 	      n_rx += memif_device_input_inline (vm, node, frame, mif,
@@ -82,6 +82,8 @@ typedef struct
   void *shm;
   memif_region_size_t region_size;
   int fd;
+  /* memory not ours to unmap, e.g. vlib buffer memory in zero-copy mode */
+  u8 is_external;
 } memif_region_t;
 
 typedef struct
@@ -101,6 +103,9 @@ typedef struct
   u16 last_head;
   u16 last_tail;
 
+  /* zero-copy: vlib buffer index held in each ring slot */
+  u32 *buffers;
+
   /* interrupts */
   int int_fd;
   uword int_clib_file_index;
@@ -112,7 +117,8 @@ typedef struct
   _(1, IS_SLAVE, "slave")		\
   _(2, CONNECTING, "connecting")	\
   _(3, CONNECTED, "connected")		\
-  _(4, DELETING, "deleting")
+  _(4, DELETING, "deleting")		\
+  _(5, ZERO_COPY, "zero-copy")
 
 typedef enum
 {
@@ -212,6 +218,7 @@ typedef struct
   u8 hw_addr[6];
   u8 rx_queues;
   u8 tx_queues;
+  u8 is_zero_copy;
 
   /* return */
   u32 sw_if_index;
@@ -228,6 +235,66 @@ memif_get_buffer (memif_if_t * mif, memif_ring_t * ring, u16 slot)
   return mif->regions[region].shm + ring->desc[slot].offset;
 }
 
+/*
+ * Zero-copy mode (slave only)
+ *
+ * The slave owns the shared memory, so instead of a region of packet
+ * slots it advertises region 0 with the rings only, followed by one
+ * region per vlib buffer pool. Descriptors then point straight at vlib
+ * buffer data and what is exchanged is the ownership of the buffers:
+ *  - on M2S (rx) rings the slave fills the free slots with empty buffers
+ *    for the master to write into, and takes them back with the packet
+ *    once the master advances head. Slots are refilled, and tail
+ *    advanced, only as buffers can be allocated.
+ *  - on S2M (tx) rings the slave puts the packet's own buffers in the
+ *    slots and frees them once the master has advanced tail past them.
+ * The master side is unchanged; it maps the regions and copies as ever.
+ *
+ * Trust: the buffer regions are whole buffer pools, so the master can
+ * read and write every packet buffer of this VPP, not just the ones on
+ * its rings, including buffers of other interfaces and ones the graph
+ * is working on. Only use zero-copy with a master that is as trusted as
+ * VPP itself. What the slave does check is the ring state: descriptor
+ * lengths are capped at the buffer size, and head and tail are clamped
+ * to the slots the slave handed out, so a bad master cannot get a buffer
+ * received or freed twice. Buffer indices come from the slave's own
+ * per-slot array, never from the descriptors.
+ */
+
+/* memif region holding the data of a buffer from the given pool */
+#define MEMIF_ZC_BUFFER_REGION(buffer_pool_index) (1 + (buffer_pool_index))
+
+static_always_inline void
+memif_zc_desc_set_buffer (memif_if_t * mif, memif_desc_t * d,
+			  vlib_buffer_t * b, u32 length)
+{
+  memif_region_index_t region;
+
+  region = MEMIF_ZC_BUFFER_REGION (b->buffer_pool_index);
+  d->region = region;
+  d->offset =
+    (u8 *) vlib_buffer_get_current (b) - (u8 *) mif->regions[region].shm;
+  d->buffer_length = length;
+}
+
+/* free the buffers held in n ring slots starting at slot */
+static_always_inline void
+memif_zc_free_slots (vlib_main_t * vm, memif_queue_t * mq, u16 slot, u16 n)
+{
+  u16 ring_size = 1 << mq->log2_ring_size;
+  u16 n_first;
+
+  slot &= ring_size - 1;
+  n_first = clib_min (n, ring_size - slot);
+  vlib_buffer_free_no_next (vm, mq->buffers + slot, n_first);
+  if (n_first < n)
+    vlib_buffer_free_no_next (vm, mq->buffers, n - n_first);
+}
+
+/* node.c */
+void memif_zc_refill (vlib_main_t * vm, memif_if_t * mif,
+		      memif_queue_t * mq);
+
 /* memif.c */
 clib_error_t *memif_init_regions_and_queues (memif_if_t * mif);
 clib_error_t *memif_connect (memif_if_t * mif);
@@ -395,6 +395,8 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
             (sm->addresses, thread_index, &s->out2in, s->outside_address_index);
         }
       s->outside_address_index = ~0;
+      s->flags &= ~(SNAT_SESSION_FLAG_TCP_ESTABLISHED |
+                    SNAT_SESSION_FLAG_TCP_CLOSING);
 
       if (snat_alloc_outside_address_and_port (sm->addresses, rx_fib_index0,
                                                thread_index, &key1,
@@ -434,6 +436,7 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
       memset (s, 0, sizeof (*s));
 
       s->outside_address_index = address_index;
+      s->expire_timer_handle = ~0;
 
       if (static_mapping)
         {
@@ -472,6 +475,11 @@ static u32 slow_path (snat_main_t *sm, vlib_buffer_t *b0,
   s->ext_host_port = udp0->dst_port;
   *sessionp = s;
 
+  /* Recycled session keeps its expiry timer running */
+  if (s->expire_timer_handle == ~0)
+    nat44_session_timer_start (sm, thread_index, s,
+                               nat44_session_get_timeout (sm, s));
+
   /* Add to translation hashes */
   kv0.key = s->in2out.as_u64;
   kv0.value = s - sm->per_thread_data[thread_index].sessions;
@@ -1317,6 +1325,7 @@ create_ses:
           /* Create a new session */
           pool_get (tsm->sessions, s);
           memset (s, 0, sizeof (*s));
+          s->expire_timer_handle = ~0;
 
           /* Create list elts */
           pool_get (tsm->list_pool, elt);
@@ -1363,6 +1372,10 @@ create_ses:
       s_kv.key[1] = key.as_u64[1];
       if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &s_kv, 1))
         clib_warning ("out2in key add failed");
+
+      /* Recycled session keeps its expiry timer running */
+      if (s->expire_timer_handle == ~0)
+        nat44_session_timer_start (sm, thread_index, s, sm->udp_timeout);
   }
 
   /* Update IP checksum */
@@ -1508,6 +1521,9 @@ snat_in2out_lb (snat_main_t *sm,
       s_kv.key[1] = key.as_u64[1];
       if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &s_kv, 1))
         clib_warning ("out2in-ed key add failed");
+
+      nat44_session_timer_start (sm, thread_index, s,
+                                 nat44_session_get_timeout (sm, s));
     }
 
   new_addr = ip->src_address.as_u32 = s->out2in.addr.as_u32;
@@ -1544,6 +1560,63 @@ snat_in2out_lb (snat_main_t *sm,
   return s;
 }
 
+/**
+ * @brief Hash in2out session lookup keys of a whole frame.
+ *
+ * First stage of the session lookup pipeline: build the TCP/UDP session key
+ * of every buffer, hash it and prefetch the in2out bihash bucket. The
+ * per-packet loops prefetch the (key,value) page of packets two ahead and
+ * resolve the lookup with the precomputed hash, so the dependent bucket and
+ * page loads are overlapped across the frame instead of serialized per
+ * packet. Hashes of buffers which never reach the lookup are not used.
+ */
+static_always_inline void
+snat_in2out_frame_hash (vlib_main_t * vm, snat_main_t * sm,
+                        clib_bihash_8_8_t * t, u32 * from, u32 n_left_from,
+                        u64 * hashes, int is_output_feature)
+{
+  clib_bihash_kv_8_8_t kv0;
+  snat_session_key_t key0;
+  vlib_buffer_t * b0;
+  ip4_header_t * ip0;
+  udp_header_t * udp0;
+  u32 iph_offset0 = 0;
+
+  while (n_left_from > 0)
+    {
+      if (n_left_from > 4)
+        {
+          vlib_buffer_t * p4 = vlib_get_buffer (vm, from[4]);
+
+          vlib_prefetch_buffer_header (p4, LOAD);
+          CLIB_PREFETCH (p4->data, CLIB_CACHE_LINE_BYTES, STORE);
+        }
+
+      b0 = vlib_get_buffer (vm, from[0]);
+
+      if (is_output_feature)
+        iph_offset0 = vnet_buffer (b0)->ip.save_rewrite_length;
+
+      ip0 = (ip4_header_t *) ((u8 *) vlib_buffer_get_current (b0) +
+             iph_offset0);
+      udp0 = ip4_next_header (ip0);
+
+      key0.addr = ip0->src_address;
+      key0.port = udp0->src_port;
+      key0.protocol = ip_proto_to_snat_proto (ip0->protocol);
+      key0.fib_index = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
+                                vnet_buffer(b0)->sw_if_index[VLIB_RX]);
+      kv0.key = key0.as_u64;
+
+      hashes[0] = clib_bihash_hash_8_8 (&kv0);
+      clib_bihash_prefetch_bucket_8_8 (t, hashes[0]);
+
+      from += 1;
+      hashes += 1;
+      n_left_from -= 1;
+    }
+}
+
 static inline uword
 snat_in2out_node_fn_inline (vlib_main_t * vm,
                             vlib_node_runtime_t * node,
@@ -1557,6 +1630,8 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
   f64 now = vlib_time_now (vm);
   u32 stats_node_index;
   u32 thread_index = vlib_get_thread_index ();
+  clib_bihash_8_8_t * in2out = &sm->per_thread_data[thread_index].in2out;
+  u64 hashes[VLIB_FRAME_SIZE], * hash = hashes;
 
   stats_node_index = is_slow_path ? snat_in2out_slowpath_node.index :
     snat_in2out_node.index;
@@ -1565,6 +1640,9 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
 
+  snat_in2out_frame_hash (vm, sm, in2out, from, n_left_from, hashes,
+                          is_output_feature);
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -1591,6 +1669,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
           snat_session_t * s0 = 0, * s1 = 0;
           clib_bihash_kv_8_8_t kv0, value0, kv1, value1;
           u32 iph_offset0 = 0, iph_offset1 = 0;
+          u64 hash0, hash1;
 
 	  /* Prefetch next iteration. */
 	  {
@@ -1604,11 +1683,17 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
 	    CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, STORE);
 	    CLIB_PREFETCH (p3->data, CLIB_CACHE_LINE_BYTES, STORE);
+
+	    clib_bihash_prefetch_data_8_8 (in2out, hash[2]);
+	    clib_bihash_prefetch_data_8_8 (in2out, hash[3]);
 	  }
 
           /* speculatively enqueue b0 and b1 to the current next frame */
 	  to_next[0] = bi0 = from[0];
 	  to_next[1] = bi1 = from[1];
+	  hash0 = hash[0];
+	  hash1 = hash[1];
+	  hash += 2;
 	  from += 2;
 	  to_next += 2;
 	  n_left_from -= 2;
@@ -1687,8 +1772,8 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           kv0.key = key0.as_u64;
 
-          if (PREDICT_FALSE (clib_bihash_search_8_8 (
-              &sm->per_thread_data[thread_index].in2out, &kv0, &value0) != 0))
+          if (PREDICT_FALSE (clib_bihash_search_inline_2_with_hash_8_8 (
+              in2out, hash0, &kv0, &value0) != 0))
             {
               if (is_slow_path)
                 {
@@ -1761,6 +1846,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp_state (s0, tcp0);
             }
           else
             {
@@ -1869,8 +1955,8 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           kv1.key = key1.as_u64;
 
-            if (PREDICT_FALSE(clib_bihash_search_8_8 (
-                &sm->per_thread_data[thread_index].in2out, &kv1, &value1) != 0))
+            if (PREDICT_FALSE(clib_bihash_search_inline_2_with_hash_8_8 (
+                in2out, hash1, &kv1, &value1) != 0))
             {
               if (is_slow_path)
                 {
@@ -1941,6 +2027,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp1->checksum = ip_csum_fold(sum1);
+              nat44_session_update_tcp_state (s1, tcp1);
             }
           else
             {
@@ -2003,10 +2090,16 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
           snat_session_t * s0 = 0;
           clib_bihash_kv_8_8_t kv0, value0;
           u32 iph_offset0 = 0;
+          u64 hash0;
+
+          if (n_left_from > 1)
+            clib_bihash_prefetch_data_8_8 (in2out, hash[1]);
 
           /* speculatively enqueue b0 to the current next frame */
 	  bi0 = from[0];
 	  to_next[0] = bi0;
+	  hash0 = hash[0];
+	  hash += 1;
 	  from += 1;
 	  to_next += 1;
 	  n_left_from -= 1;
@@ -2083,8 +2176,8 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
 
           kv0.key = key0.as_u64;
 
-          if (clib_bihash_search_8_8 (&sm->per_thread_data[thread_index].in2out,
-                                      &kv0, &value0))
+          if (clib_bihash_search_inline_2_with_hash_8_8 (in2out, hash0,
+                                                         &kv0, &value0))
             {
               if (is_slow_path)
                 {
@@ -2158,6 +2251,7 @@ snat_in2out_node_fn_inline (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp_state (s0, tcp0);
             }
           else
             {
@@ -2693,6 +2787,7 @@ nat44_in2out_reass_node_fn (vlib_main_t * vm,
                                          ip4_header_t /* cheat */,
                                          length /* changed member */);
                   tcp0->checksum = ip_csum_fold(sum0);
+                  nat44_session_update_tcp_state (s0, tcp0);
                 }
               else
                 {
@@ -711,6 +711,8 @@ int snat_add_static_mapping(ip4_address_t l_addr, ip4_address_t e_addr,
                       if (clib_bihash_add_del_8_8 (&tsm->out2in, &value, 0))
                         clib_warning ("out2in key del failed");
 delete:
+                      nat44_session_timer_stop (sm, tsm - sm->per_thread_data,
+                                                s);
                       pool_put (tsm->sessions, s);
 
                       clib_dlist_remove (tsm->list_pool, del_elt_index);
@@ -1075,6 +1077,8 @@ int snat_del_address (snat_main_t *sm, ip4_address_t addr, u8 delete_sm)
                     kv.key = ses->out2in.as_u64;
                     clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 0);
                   }
+                nat44_session_timer_stop (sm, tsm - sm->per_thread_data,
+                                          ses);
                 vec_add1 (ses_to_be_removed, ses - tsm->sessions);
                 clib_dlist_remove (tsm->list_pool, ses->per_user_index);
                 user_key.addr = ses->in2out.addr;
@@ -2447,6 +2451,177 @@ snat_get_worker_out2in_cb (ip4_header_t * ip0, u32 rx_fib_index0)
   return (u32) ((clib_net_to_host_u16 (port) - 1024) / sm->port_per_thread);
 }
 
+static void
+nat44_session_expired_timer_callback (u32 * expired_timers)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, vlib_get_thread_index ());
+  snat_session_t *s;
+  u32 session_index;
+  int i;
+
+  for (i = 0; i < vec_len (expired_timers); i++)
+    {
+      session_index = expired_timers[i] & 0x7FFFFFFF;
+      /* timer handle is freed by the wheel, do not stop it later */
+      s = pool_elt_at_index (tsm->sessions, session_index);
+      s->expire_timer_handle = ~0;
+      vec_add1 (tsm->expired_sessions, session_index);
+    }
+}
+
+#define foreach_nat44_session_expire_error      \
+_(EXPIRED, "expired sessions")                  \
+_(RESCHEDULED, "rescheduled session timers")
+
+typedef enum {
+#define _(sym,str) NAT44_SESSION_EXPIRE_ERROR_##sym,
+  foreach_nat44_session_expire_error
+#undef _
+  NAT44_SESSION_EXPIRE_N_ERROR,
+} nat44_session_expire_error_t;
+
+static char * nat44_session_expire_error_strings[] = {
+#define _(sym,string) string,
+  foreach_nat44_session_expire_error
+#undef _
+};
+
+/**
+ * @brief Per-thread NAT44 session expiry walk.
+ *
+ * Tick the session timer wheel of the thread and free sessions idle longer
+ * than their protocol timeout. Timers are armed once per session and are not
+ * touched in the data-plane; sessions with recent traffic get their timer
+ * re-armed with the remaining idle time.
+ */
+static uword
+nat44_session_expire_walk_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
+                              vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vm->thread_index;
+  snat_main_per_thread_data_t *tsm;
+  f64 now = vlib_time_now (vm);
+  u32 *session_index, n_expired = 0, n_rescheduled = 0, count = 0;
+  snat_session_t *s;
+  u32 timeout;
+  f64 idle;
+
+  if (thread_index >= vec_len (sm->per_thread_data))
+    return 0;
+
+  tsm = vec_elt_at_index (sm->per_thread_data, thread_index);
+  if (!tsm->timer_wheel)
+    return 0;
+
+  tw_timer_expire_timers_2t_1w_2048sl (tsm->timer_wheel, now);
+
+  vec_foreach (session_index, tsm->expired_sessions)
+    {
+      if (count >= NAT44_SESSION_EXPIRE_BATCH)
+        break;
+      count++;
+
+      if (pool_is_free_index (tsm->sessions, session_index[0]))
+        continue;
+
+      s = pool_elt_at_index (tsm->sessions, session_index[0]);
+
+      /* session index reused, new session owns a running timer */
+      if (s->expire_timer_handle != ~0)
+        continue;
+
+      timeout = nat44_session_get_timeout (sm, s);
+      idle = now - s->last_heard;
+      if (idle < (f64) timeout)
+        {
+          nat44_session_timer_start (sm, thread_index, s,
+                                     timeout - (u32) idle);
+          n_rescheduled++;
+          continue;
+        }
+
+      nat44_free_session (sm, s, thread_index);
+      n_expired++;
+    }
+
+  if (count)
+    vec_delete (tsm->expired_sessions, count, 0);
+
+  vlib_node_increment_counter (vm, node->node_index,
+                               NAT44_SESSION_EXPIRE_ERROR_EXPIRED, n_expired);
+  vlib_node_increment_counter (vm, node->node_index,
+                               NAT44_SESSION_EXPIRE_ERROR_RESCHEDULED,
+                               n_rescheduled);
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_session_expire_walk_node) = {
+  .function = nat44_session_expire_walk_fn,
+  .name = "nat44-session-expire-walk",
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .n_errors = ARRAY_LEN (nat44_session_expire_error_strings),
+  .error_strings = nat44_session_expire_error_strings,
+};
+
+/**
+ * @brief The 'nat44-session-expire-process' process's main loop.
+ *
+ * Send an interrupt to the per-thread session expiry walk node of every
+ * thread holding NAT44 sessions.
+ */
+static uword
+nat44_session_expire_process_fn (vlib_main_t * vm, vlib_node_runtime_t * rt,
+                                 vlib_frame_t * f)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  vlib_main_t *worker_vm;
+  f64 sleep_duration;
+  u32 i;
+
+  while (1)
+    {
+      sleep_duration = NAT44_SESSION_TIMER_TICK;
+      vec_foreach (tsm, sm->per_thread_data)
+        {
+          if (!tsm->timer_wheel)
+            continue;
+
+          i = tsm - sm->per_thread_data;
+          if (vec_len (vlib_mains) == 0)
+            worker_vm = vm;
+          else if (i < vec_len (vlib_mains))
+            worker_vm = vlib_mains[i];
+          else
+            continue;
+          if (!worker_vm)
+            continue;
+
+          vlib_node_set_interrupt_pending (worker_vm,
+                                           nat44_session_expire_walk_node.index);
+          /* backlog of expired sessions, come back soon */
+          if (vec_len (tsm->expired_sessions))
+            sleep_duration = 1e-3;
+        }
+      vlib_process_suspend (vm, sleep_duration);
+    }
+
+  return 0;
+}
+
+static vlib_node_registration_t nat44_session_expire_process_node;
+
+VLIB_REGISTER_NODE (nat44_session_expire_process_node, static) = {
+  .function = nat44_session_expire_process_fn,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-session-expire-process",
+};
+
 static clib_error_t *
 snat_config (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -2549,6 +2724,12 @@ snat_config (vlib_main_t * vm, unformat_input_t * input)
 
               clib_bihash_init_8_8 (&tsm->user_hash, "users", user_buckets,
                                     user_memory_size);
+
+              tsm->timer_wheel =
+                clib_mem_alloc (sizeof (tw_timer_wheel_2t_1w_2048sl_t));
+              tw_timer_wheel_init_2t_1w_2048sl (
+                tsm->timer_wheel, nat44_session_expired_timer_callback,
+                NAT44_SESSION_TIMER_TICK, ~0);
             }
 
           clib_bihash_init_16_8 (&sm->in2out_ed, "in2out-ed",
@@ -2864,14 +3045,15 @@ show_snat_command_fn (vlib_main_t * vm,
         }
     }
 
+  vlib_cli_output (vm, "udp timeout: %dsec", sm->udp_timeout);
+  vlib_cli_output (vm, "tcp-established timeout: %dsec",
+                   sm->tcp_established_timeout);
+  vlib_cli_output (vm, "tcp-transitory timeout: %dsec",
+                   sm->tcp_transitory_timeout);
+  vlib_cli_output (vm, "icmp timeout: %dsec", sm->icmp_timeout);
+
   if (sm->deterministic)
     {
-      vlib_cli_output (vm, "udp timeout: %dsec", sm->udp_timeout);
-      vlib_cli_output (vm, "tcp-established timeout: %dsec",
-                       sm->tcp_established_timeout);
-      vlib_cli_output (vm, "tcp-transitory timeout: %dsec",
-                       sm->tcp_transitory_timeout);
-      vlib_cli_output (vm, "icmp timeout: %dsec", sm->icmp_timeout);
       vlib_cli_output (vm, "%d deterministic mappings",
                        pool_elts (sm->det_maps));
       if (verbose > 0)
@@ -3170,6 +3352,98 @@ VLIB_CLI_COMMAND (snat_add_interface_address_command, static) = {
     .function = snat_add_interface_address_command_fn,
 };
 
+void
+nat44_free_session (snat_main_t *sm, snat_session_t *s, u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  clib_bihash_kv_8_8_t kv, value;
+  clib_bihash_kv_16_8_t ed_kv;
+  nat_ed_ses_key_t ed_key;
+  snat_user_key_t u_key;
+  snat_user_t *u;
+
+  if (snat_is_unk_proto_session (s) ||
+      (s->flags & SNAT_SESSION_FLAG_LOAD_BALANCING))
+    {
+      ed_key.l_addr = s->in2out.addr;
+      ed_key.r_addr = s->ext_host_addr;
+      ed_key.fib_index = s->in2out.fib_index;
+      ed_key.rsvd = 0;
+      if (snat_is_unk_proto_session (s))
+        {
+          ed_key.proto = s->in2out.port;
+          ed_key.l_port = 0;
+        }
+      else
+        {
+          ed_key.proto = snat_proto_to_ip_proto (s->in2out.protocol);
+          ed_key.l_port = s->in2out.port;
+        }
+      ed_kv.key[0] = ed_key.as_u64[0];
+      ed_kv.key[1] = ed_key.as_u64[1];
+      if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &ed_kv, 0))
+        clib_warning ("in2out-ed key del failed");
+
+      ed_key.l_addr = s->out2in.addr;
+      ed_key.fib_index = s->out2in.fib_index;
+      if (!snat_is_unk_proto_session (s))
+        ed_key.l_port = s->out2in.port;
+      ed_kv.key[0] = ed_key.as_u64[0];
+      ed_kv.key[1] = ed_key.as_u64[1];
+      if (clib_bihash_add_del_16_8 (&sm->out2in_ed, &ed_kv, 0))
+        clib_warning ("out2in-ed key del failed");
+    }
+  else
+    {
+      /* log NAT event */
+      snat_ipfix_logging_nat44_ses_delete(s->in2out.addr.as_u32,
+                                          s->out2in.addr.as_u32,
+                                          s->in2out.protocol,
+                                          s->in2out.port,
+                                          s->out2in.port,
+                                          s->in2out.fib_index);
+
+      kv.key = s->in2out.as_u64;
+      if (clib_bihash_add_del_8_8 (&tsm->in2out, &kv, 0))
+        clib_warning ("in2out key del failed");
+      kv.key = s->out2in.as_u64;
+      if (clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 0))
+        clib_warning ("out2in key del failed");
+
+      if (!snat_is_session_static (s) && s->outside_address_index != ~0)
+        snat_free_outside_address_and_port (sm->addresses, thread_index,
+                                            &s->out2in,
+                                            s->outside_address_index);
+    }
+
+  clib_dlist_remove (tsm->list_pool, s->per_user_index);
+  pool_put_index (tsm->list_pool, s->per_user_index);
+
+  u_key.addr = s->in2out.addr;
+  u_key.fib_index = s->in2out.fib_index;
+  kv.key = u_key.as_u64;
+  if (!clib_bihash_search_8_8 (&tsm->user_hash, &kv, &value))
+    {
+      u = pool_elt_at_index (tsm->users, value.value);
+      if (snat_is_session_static (s))
+        u->nstaticsessions--;
+      else
+        u->nsessions--;
+
+      /* Last session of the user gone, release the user as well */
+      if (!u->nsessions && !u->nstaticsessions)
+        {
+          pool_put_index (tsm->list_pool,
+                          u->sessions_per_user_list_head_index);
+          pool_put (tsm->users, u);
+          clib_bihash_add_del_8_8 (&tsm->user_hash, &kv, 0);
+        }
+    }
+
+  pool_put (tsm->sessions, s);
+}
+
 int
 nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
                    snat_protocol_t proto, u32 vrf_id, int is_in)
@@ -3181,16 +3455,14 @@ nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
   snat_session_key_t key;
   snat_session_t *s;
   clib_bihash_8_8_t *t;
-  snat_user_key_t u_key;
-  snat_user_t *u;
+  u32 thread_index;
 
   ip.dst_address.as_u32 = ip.src_address.as_u32 = addr->as_u32;
   if (sm->num_workers)
-    tsm =
-      vec_elt_at_index (sm->per_thread_data,
-			sm->worker_in2out_cb (&ip, fib_index));
+    thread_index = sm->worker_in2out_cb (&ip, fib_index);
   else
-    tsm = vec_elt_at_index (sm->per_thread_data, sm->num_workers);
+    thread_index = sm->num_workers;
+  tsm = vec_elt_at_index (sm->per_thread_data, thread_index);
 
   key.addr.as_u32 = addr->as_u32;
   key.port = clib_host_to_net_u16 (port);
@@ -3201,20 +3473,8 @@ nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
   if (!clib_bihash_search_8_8 (t, &kv, &value))
     {
       s = pool_elt_at_index (tsm->sessions, value.value);
-      kv.key = s->in2out.as_u64;
-      clib_bihash_add_del_8_8 (&tsm->in2out, &kv, 0);
-      kv.key = s->out2in.as_u64;
-      clib_bihash_add_del_8_8 (&tsm->out2in, &kv, 0);
-      u_key.addr = s->in2out.addr;
-      u_key.fib_index = s->in2out.fib_index;
-      kv.key = u_key.as_u64;
-      if (!clib_bihash_search_8_8 (&tsm->user_hash, &kv, &value))
-        {
-          u = pool_elt_at_index (tsm->users, value.value);
-          u->nsessions--;
-        }
-      clib_dlist_remove (tsm->list_pool, s->per_user_index);
-      pool_put (tsm->sessions, s);
+      nat44_session_timer_stop (sm, thread_index, s);
+      nat44_free_session (sm, s, thread_index);
       return 0;
     }
 
@@ -3588,6 +3848,26 @@ VLIB_CLI_COMMAND (set_timeout_command, static) = {
     "tcp-transitory <sec> | icmp <sec> | reset]",
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{set nat44 timeout}
+ * Set idle timeouts of dynamic NAT44 sessions (in seconds). Sessions idle
+ * longer than the protocol timeout are freed by the per-thread session
+ * expiry walk, use:
+ *  vpp# set nat44 timeout udp 120 tcp-established 7500
+ *  tcp-transitory 250 icmp 90
+ * To reset default values use:
+ *  vpp# set nat44 timeout reset
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (set_nat44_timeout_command, static) = {
+  .path = "set nat44 timeout",
+  .function = set_timeout_command_fn,
+  .short_help =
+    "set nat44 timeout [udp <sec> | tcp-established <sec> "
+    "tcp-transitory <sec> | icmp <sec> | reset]",
+};
+
 static clib_error_t *
 snat_det_close_session_out_fn (vlib_main_t *vm,
                                unformat_input_t * input,
@@ -27,6 +27,8 @@
 #include <vppinfra/bihash_16_8.h>
 #include <vppinfra/dlist.h>
 #include <vppinfra/error.h>
+#include <vppinfra/tw_timer_2t_1w_2048sl.h>
+#include <vnet/tcp/tcp_packet.h>
 #include <vlibapi/api.h>
 
 
@@ -37,6 +39,12 @@
 #define SNAT_TCP_INCOMING_SYN 6
 #define SNAT_ICMP_TIMEOUT 60
 
+/* Session expiry timer wheel tick (seconds) and longest single interval */
+#define NAT44_SESSION_TIMER_TICK 1.0
+#define NAT44_SESSION_TIMER_MAX_INTERVAL 2047
+/* Max number of expired sessions processed per walk */
+#define NAT44_SESSION_EXPIRE_BATCH 1024
+
 #define SNAT_FLAG_HAIRPINNING (1 << 0)
 
 /* Key */
@@ -128,6 +136,8 @@ typedef enum {
 #define SNAT_SESSION_FLAG_STATIC_MAPPING 1
 #define SNAT_SESSION_FLAG_UNKNOWN_PROTO  2
 #define SNAT_SESSION_FLAG_LOAD_BALANCING 4
+#define SNAT_SESSION_FLAG_TCP_ESTABLISHED 8
+#define SNAT_SESSION_FLAG_TCP_CLOSING 16
 
 #define NAT_INTERFACE_FLAG_IS_INSIDE 1
 #define NAT_INTERFACE_FLAG_IS_OUTSIDE 2
@@ -157,6 +167,9 @@ typedef CLIB_PACKED(struct {
   /* External host address and port */
   ip4_address_t ext_host_addr;  /* 68-71 */
   u16 ext_host_port;            /* 72-73 */
+
+  /* Idle expiry timer handle */
+  u32 expire_timer_handle;      /* 74-77 */
 }) snat_session_t;
 
 
@@ -251,6 +264,12 @@ typedef struct {
   /* Pool of doubly-linked list elements */
   dlist_elt_t * list_pool;
 
+  /* Session idle expiry timer wheel */
+  tw_timer_wheel_2t_1w_2048sl_t * timer_wheel;
+
+  /* Sessions whose expiry timer popped, not processed yet */
+  u32 * expired_sessions;
+
   u32 snat_thread_index;
 } snat_main_per_thread_data_t;
 
@@ -388,6 +407,7 @@ extern vlib_node_registration_t snat_det_in2out_node;
 extern vlib_node_registration_t snat_det_out2in_node;
 extern vlib_node_registration_t snat_hairpin_dst_node;
 extern vlib_node_registration_t snat_hairpin_src_node;
+extern vlib_node_registration_t nat44_session_expire_walk_node;
 
 void snat_free_outside_address_and_port (snat_address_t * addresses,
                                          u32 thread_index,
@@ -431,7 +451,7 @@ typedef struct {
     @param s SNAT session
     @return 1 if SNAT session for unknown protocol otherwise 0
 */
-#define snat_is_unk_proto_session(s) s->flags & SNAT_SESSION_FLAG_UNKNOWN_PROTO
+#define snat_is_unk_proto_session(s) (s->flags & SNAT_SESSION_FLAG_UNKNOWN_PROTO)
 
 #define nat_interface_is_inside(i) i->flags & NAT_INTERFACE_FLAG_IS_INSIDE
 #define nat_interface_is_outside(i) i->flags & NAT_INTERFACE_FLAG_IS_OUTSIDE
@@ -525,6 +545,8 @@ int nat44_add_del_lb_static_mapping (ip4_address_t e_addr, u16 e_port,
                                      nat44_lb_addr_port_t *locals, u8 is_add);
 int nat44_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
                        snat_protocol_t proto, u32 vrf_id, int is_in);
+void nat44_free_session (snat_main_t *sm, snat_session_t *s,
+                         u32 thread_index);
 
 static_always_inline u8
 icmp_is_error_message (icmp46_header_t * icmp)
@@ -576,6 +598,85 @@ maximum_sessions_exceeded (snat_main_t *sm, u32 thread_index)
   return 0;
 }
 
+/** \brief Get idle timeout of NAT44 session.
+    @param sm SNAT main
+    @param s SNAT session
+    @return idle timeout in seconds
+*/
+always_inline u32
+nat44_session_get_timeout (snat_main_t *sm, snat_session_t *s)
+{
+  if (snat_is_unk_proto_session (s))
+    return sm->udp_timeout;
+
+  switch (s->in2out.protocol)
+    {
+    case SNAT_PROTOCOL_ICMP:
+      return sm->icmp_timeout;
+    case SNAT_PROTOCOL_TCP:
+      if ((s->flags & SNAT_SESSION_FLAG_TCP_ESTABLISHED) &&
+          !(s->flags & SNAT_SESSION_FLAG_TCP_CLOSING))
+        return sm->tcp_established_timeout;
+      return sm->tcp_transitory_timeout;
+    default:
+      return sm->udp_timeout;
+    }
+}
+
+/** \brief Track TCP session state for idle timeout selection.
+    @param s SNAT session
+    @param tcp TCP header of the translated packet
+*/
+always_inline void
+nat44_session_update_tcp_state (snat_session_t *s, tcp_header_t *tcp)
+{
+  if (PREDICT_FALSE (tcp->flags & (TCP_FLAG_FIN | TCP_FLAG_RST)))
+    s->flags |= SNAT_SESSION_FLAG_TCP_CLOSING;
+  else if (!(tcp->flags & TCP_FLAG_SYN))
+    s->flags |= SNAT_SESSION_FLAG_TCP_ESTABLISHED;
+}
+
+/** \brief Arm idle expiry timer of NAT44 session.
+    @param sm SNAT main
+    @param thread_index thread index of the session owner
+    @param s SNAT session
+    @param interval timer interval in seconds
+*/
+always_inline void
+nat44_session_timer_start (snat_main_t *sm, u32 thread_index,
+                           snat_session_t *s, u32 interval)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+
+  if (PREDICT_FALSE (tsm->timer_wheel == 0))
+    {
+      s->expire_timer_handle = ~0;
+      return;
+    }
+
+  interval = clib_max (interval, 1);
+  interval = clib_min (interval, NAT44_SESSION_TIMER_MAX_INTERVAL);
+  s->expire_timer_handle =
+    tw_timer_start_2t_1w_2048sl (tsm->timer_wheel, s - tsm->sessions, 0,
+                                 interval);
+}
+
+/** \brief Disarm idle expiry timer of NAT44 session.
+    @param sm SNAT main
+    @param thread_index thread index of the session owner
+    @param s SNAT session
+*/
+always_inline void
+nat44_session_timer_stop (snat_main_t *sm, u32 thread_index,
+                          snat_session_t *s)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+
+  if (s->expire_timer_handle != ~0)
+    tw_timer_stop_2t_1w_2048sl (tsm->timer_wheel, s->expire_timer_handle);
+  s->expire_timer_handle = ~0;
+}
+
 static_always_inline void
 nat_send_all_to_node(vlib_main_t *vm, u32 *bi_vector,
                      vlib_node_runtime_t *node, vlib_error_t *error, u32 next)
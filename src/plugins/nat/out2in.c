@@ -262,6 +262,9 @@ create_session_for_static_mapping (snat_main_t *sm,
                                       s->in2out.port,
                                       s->out2in.port,
                                       s->in2out.fib_index);
+
+  nat44_session_timer_start (sm, thread_index, s,
+                             nat44_session_get_timeout (sm, s));
    return s;
 }
 
@@ -775,6 +778,8 @@ snat_out2in_unknown_proto (snat_main_t *sm,
       s_kv.key[1] = key.as_u64[1];
       if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &s_kv, 1))
         clib_warning ("in2out key add failed");
+
+      nat44_session_timer_start (sm, thread_index, s, sm->udp_timeout);
    }
 
   /* Update IP checksum */
@@ -915,6 +920,9 @@ snat_out2in_lb (snat_main_t *sm,
       s_kv.key[1] = key.as_u64[1];
       if (clib_bihash_add_del_16_8 (&sm->in2out_ed, &s_kv, 1))
         clib_warning ("in2out-ed key add failed");
+
+      nat44_session_timer_start (sm, thread_index, s,
+                                 nat44_session_get_timeout (sm, s));
     }
 
   new_addr = ip->dst_address.as_u32 = s->in2out.addr.as_u32;
@@ -950,6 +958,53 @@ snat_out2in_lb (snat_main_t *sm,
   return s;
 }
 
+/**
+ * @brief Hash out2in session lookup keys of a whole frame.
+ *
+ * First stage of the session lookup pipeline, see snat_in2out_frame_hash.
+ */
+static_always_inline void
+snat_out2in_frame_hash (vlib_main_t * vm, snat_main_t * sm,
+                        clib_bihash_8_8_t * t, u32 * from, u32 n_left_from,
+                        u64 * hashes)
+{
+  clib_bihash_kv_8_8_t kv0;
+  snat_session_key_t key0;
+  vlib_buffer_t * b0;
+  ip4_header_t * ip0;
+  udp_header_t * udp0;
+
+  while (n_left_from > 0)
+    {
+      if (n_left_from > 4)
+        {
+          vlib_buffer_t * p4 = vlib_get_buffer (vm, from[4]);
+
+          vlib_prefetch_buffer_header (p4, LOAD);
+          CLIB_PREFETCH (p4->data, CLIB_CACHE_LINE_BYTES, STORE);
+        }
+
+      b0 = vlib_get_buffer (vm, from[0]);
+
+      ip0 = vlib_buffer_get_current (b0);
+      udp0 = ip4_next_header (ip0);
+
+      key0.addr = ip0->dst_address;
+      key0.port = udp0->dst_port;
+      key0.protocol = ip_proto_to_snat_proto (ip0->protocol);
+      key0.fib_index = vec_elt (sm->ip4_main->fib_index_by_sw_if_index,
+                                vnet_buffer(b0)->sw_if_index[VLIB_RX]);
+      kv0.key = key0.as_u64;
+
+      hashes[0] = clib_bihash_hash_8_8 (&kv0);
+      clib_bihash_prefetch_bucket_8_8 (t, hashes[0]);
+
+      from += 1;
+      hashes += 1;
+      n_left_from -= 1;
+    }
+}
+
 static uword
 snat_out2in_node_fn (vlib_main_t * vm,
 		  vlib_node_runtime_t * node,
@@ -961,11 +1016,15 @@ snat_out2in_node_fn (vlib_main_t * vm,
   snat_main_t * sm = &snat_main;
   f64 now = vlib_time_now (vm);
   u32 thread_index = vlib_get_thread_index ();
+  clib_bihash_8_8_t * out2in = &sm->per_thread_data[thread_index].out2in;
+  u64 hashes[VLIB_FRAME_SIZE], * hash = hashes;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
 
+  snat_out2in_frame_hash (vm, sm, out2in, from, n_left_from, hashes);
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -994,6 +1053,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
           u32 proto0, proto1;
           snat_session_t * s0 = 0, * s1 = 0;
           clib_bihash_kv_8_8_t kv0, kv1, value0, value1;
+          u64 hash0, hash1;
 
 	  /* Prefetch next iteration. */
 	  {
@@ -1007,11 +1067,17 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
 	    CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, STORE);
 	    CLIB_PREFETCH (p3->data, CLIB_CACHE_LINE_BYTES, STORE);
+
+	    clib_bihash_prefetch_data_8_8 (out2in, hash[2]);
+	    clib_bihash_prefetch_data_8_8 (out2in, hash[3]);
 	  }
 
           /* speculatively enqueue b0 and b1 to the current next frame */
 	  to_next[0] = bi0 = from[0];
 	  to_next[1] = bi1 = from[1];
+	  hash0 = hash[0];
+	  hash1 = hash[1];
+	  hash += 2;
 	  from += 2;
 	  to_next += 2;
 	  n_left_from -= 2;
@@ -1074,8 +1140,8 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
           kv0.key = key0.as_u64;
 
-          if (clib_bihash_search_8_8 (&sm->per_thread_data[thread_index].out2in,
-                                      &kv0, &value0))
+          if (clib_bihash_search_inline_2_with_hash_8_8 (out2in, hash0,
+                                                         &kv0, &value0))
             {
               /* Try to match static mapping by external address and port,
                  destination address and port in packet */
@@ -1146,6 +1212,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp_state (s0, tcp0);
             }
           else
             {
@@ -1235,8 +1302,8 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
           kv1.key = key1.as_u64;
 
-          if (clib_bihash_search_8_8 (&sm->per_thread_data[thread_index].out2in,
-                                      &kv1, &value1))
+          if (clib_bihash_search_inline_2_with_hash_8_8 (out2in, hash1,
+                                                         &kv1, &value1))
             {
               /* Try to match static mapping by external address and port,
                  destination address and port in packet */
@@ -1307,6 +1374,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp1->checksum = ip_csum_fold(sum1);
+              nat44_session_update_tcp_state (s1, tcp1);
             }
           else
             {
@@ -1368,10 +1436,16 @@ snat_out2in_node_fn (vlib_main_t * vm,
           u32 proto0;
           snat_session_t * s0 = 0;
           clib_bihash_kv_8_8_t kv0, value0;
+          u64 hash0;
+
+          if (n_left_from > 1)
+            clib_bihash_prefetch_data_8_8 (out2in, hash[1]);
 
           /* speculatively enqueue b0 to the current next frame */
 	  bi0 = from[0];
 	  to_next[0] = bi0;
+	  hash0 = hash[0];
+	  hash += 1;
 	  from += 1;
 	  to_next += 1;
 	  n_left_from -= 1;
@@ -1432,8 +1506,8 @@ snat_out2in_node_fn (vlib_main_t * vm,
 
           kv0.key = key0.as_u64;
 
-          if (clib_bihash_search_8_8 (&sm->per_thread_data[thread_index].out2in,
-                                      &kv0, &value0))
+          if (clib_bihash_search_inline_2_with_hash_8_8 (out2in, hash0,
+                                                         &kv0, &value0))
             {
               /* Try to match static mapping by external address and port,
                  destination address and port in packet */
@@ -1505,6 +1579,7 @@ snat_out2in_node_fn (vlib_main_t * vm,
                                      ip4_header_t /* cheat */,
                                      length /* changed member */);
               tcp0->checksum = ip_csum_fold(sum0);
+              nat44_session_update_tcp_state (s0, tcp0);
             }
           else
             {
@@ -1755,6 +1830,7 @@ nat44_out2in_reass_node_fn (vlib_main_t * vm,
                                          ip4_header_t /* cheat */,
                                          length /* changed member */);
                   tcp0->checksum = ip_csum_fold(sum0);
+                  nat44_session_update_tcp_state (s0, tcp0);
                 }
               else
                 {
@@ -18,7 +18,7 @@
 int
 ssvm_master_init (ssvm_private_t * ssvm, u32 master_index)
 {
-  svm_main_region_t *smr = svm_get_root_rp ()->data_base;
+  svm_region_t *root_rp = svm_get_root_rp ();
   int ssvm_fd;
   u8 *ssvm_filename;
   u8 junk = 0;
@@ -51,8 +51,13 @@ ssvm_master_init (ssvm_private_t * ssvm, u32 master_index)
 
   if (fchmod (ssvm_fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP) < 0)
     clib_unix_warning ("ssvm segment chmod");
-  if (fchown (ssvm_fd, smr->uid, smr->gid) < 0)
-    clib_unix_warning ("ssvm segment chown");
+  /* Segments created before the svm root region keep the creator's ids */
+  if (root_rp)
+    {
+      svm_main_region_t *smr = root_rp->data_base;
+      if (fchown (ssvm_fd, smr->uid, smr->gid) < 0)
+	clib_unix_warning ("ssvm segment chown");
+    }
 
   if (lseek (ssvm_fd, ssvm->ssvm_size, SEEK_SET) < 0)
     {
@@ -53,6 +53,7 @@ typedef struct _svm_fifo
     CLIB_CACHE_LINE_ALIGN_MARK (end_cursize);
 
   volatile u32 has_event;	/**< non-zero if deq event exists */
+  volatile u8 want_tx_evt;	/**< producer wants an event on deq */
 
   /* Backpointers */
   u32 master_session_index;
@@ -93,6 +94,13 @@ typedef struct _svm_fifo
 #define svm_fifo_trace_add(_f, _s, _l, _t)
 #endif
 
+/** Reference to contiguous fifo data */
+typedef struct
+{
+  u8 *data;
+  u32 len;
+} svm_fifo_seg_t;
+
 u8 *svm_fifo_dump_trace (u8 * s, svm_fifo_t * f);
 u8 *svm_fifo_replay (u8 * s, svm_fifo_t * f, u8 no_read, u8 verbose);
 
@@ -114,6 +122,40 @@ svm_fifo_has_ooo_data (svm_fifo_t * f)
   return f->ooos_list_head != OOO_SEGMENT_INVALID_INDEX;
 }
 
+/**
+ * References, rather than a copy, of up to max_bytes of fifo data from
+ * relative_offset on. The data wraps at most once, so it takes at most
+ * two segments; fs[1].len is 0 if one is enough.
+ *
+ * Only the consumer may hold references: they stay valid until it
+ * dequeues or drops the data.
+ *
+ * @return number of bytes referenced
+ */
+always_inline u32
+svm_fifo_segments (svm_fifo_t * f, u32 relative_offset, u32 max_bytes,
+		   svm_fifo_seg_t fs[2])
+{
+  u32 cursize, nitems, real_head, n_bytes;
+
+  /* read cursize, which can only increase while we're working */
+  cursize = svm_fifo_max_dequeue (f);
+  fs[0].len = fs[1].len = 0;
+  if (PREDICT_FALSE (cursize <= relative_offset))
+    return 0;
+
+  nitems = f->nitems;
+  real_head = f->head + relative_offset;
+  real_head = real_head >= nitems ? real_head - nitems : real_head;
+  n_bytes = clib_min (cursize - relative_offset, max_bytes);
+
+  fs[0].data = &f->data[real_head];
+  fs[0].len = clib_min (nitems - real_head, n_bytes);
+  fs[1].data = &f->data[0];
+  fs[1].len = n_bytes - fs[0].len;
+  return n_bytes;
+}
+
 /**
  * Sets fifo event flag.
  *
@@ -136,6 +178,28 @@ svm_fifo_unset_event (svm_fifo_t * f)
   __sync_lock_release (&f->has_event);
 }
 
+/**
+ * Asks the consumer to post an event to the producer once it frees
+ * space, e.g., because the producer found the fifo full.
+ */
+always_inline void
+svm_fifo_set_want_tx_evt (svm_fifo_t * f)
+{
+  f->want_tx_evt = 1;
+}
+
+always_inline u8
+svm_fifo_want_tx_evt (svm_fifo_t * f)
+{
+  return f->want_tx_evt;
+}
+
+always_inline void
+svm_fifo_unset_want_tx_evt (svm_fifo_t * f)
+{
+  f->want_tx_evt = 0;
+}
+
 svm_fifo_t *svm_fifo_create (u32 data_size_in_bytes);
 void svm_fifo_free (svm_fifo_t * f);
 
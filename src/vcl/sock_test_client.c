@@ -33,6 +33,8 @@ typedef struct
   sock_test_socket_t ctrl_socket;
   sock_test_socket_t *test_socket;
   uint32_t num_test_sockets;
+  int *idle_fd;
+  uint32_t num_idle_sockets;
   uint8_t dump_cfg;
 } sock_client_main_t;
 
@@ -424,6 +426,14 @@ exit_client (void)
   sock_test_socket_t *tsock;
   int i;
 
+  for (i = 0; i < scm->num_idle_sockets; i++)
+#ifdef VCL_TEST
+    vppcom_session_close (scm->idle_fd[i]);
+#else
+    close (scm->idle_fd[i]);
+#endif
+  free (scm->idle_fd);
+
   for (i = 0; i < ctrl->cfg.num_test_sockets; i++)
     {
       tsock = &scm->test_socket[i];
@@ -551,6 +561,68 @@ sock_test_connect_test_sockets (uint32_t num_test_sockets)
   return 0;
 }
 
+/*
+ * Connections that never send anything. They load the server's epoll set,
+ * so the cost of an epoll wait with many idle sessions shows in the test
+ * results.
+ */
+static int
+sock_test_connect_idle_sockets (uint32_t num_idle_sockets)
+{
+  sock_client_main_t *scm = &sock_client_main;
+  int i, fd, rv, errno_val;
+
+  scm->idle_fd = calloc (num_idle_sockets, sizeof (*scm->idle_fd));
+  if (!scm->idle_fd)
+    {
+      errno_val = errno;
+      perror ("ERROR in sock_test_connect_idle_sockets()");
+      fprintf (stderr, "ERROR: calloc failed (errno = %d)!\n", errno_val);
+      return -1;
+    }
+
+  for (i = 0; i < num_idle_sockets; i++)
+    {
+#ifdef VCL_TEST
+      fd = vppcom_session_create (VPPCOM_VRF_DEFAULT, VPPCOM_PROTO_TCP,
+				  1 /* is_nonblocking */ );
+      if (fd < 0)
+	{
+	  errno = -fd;
+	  fd = -1;
+	}
+#else
+      fd = socket (AF_INET, SOCK_STREAM, 0);
+#endif
+      if (fd < 0)
+	{
+	  errno_val = errno;
+	  perror ("ERROR in sock_test_connect_idle_sockets()");
+	  fprintf (stderr, "ERROR: socket failed (errno = %d)!\n",
+		   errno_val);
+	  return fd;
+	}
+
+#ifdef VCL_TEST
+      rv = vppcom_session_connect (fd, &scm->server_endpt);
+#else
+      rv = connect (fd, (struct sockaddr *) &scm->server_addr,
+		    sizeof (scm->server_addr));
+#endif
+      if (rv < 0)
+	{
+	  errno_val = errno;
+	  perror ("ERROR in sock_test_connect_idle_sockets()");
+	  fprintf (stderr, "ERROR: connect failed (errno = %d)!\n",
+		   errno_val);
+	}
+      scm->idle_fd[scm->num_idle_sockets++] = fd;
+    }
+
+  printf ("CLIENT: %u idle sockets connected.\n", scm->num_idle_sockets);
+  return 0;
+}
+
 static void
 dump_help (void)
 {
@@ -730,6 +802,7 @@ print_usage_and_exit (void)
 	   "  OPTIONS\n"
 	   "  -h               Print this message and exit.\n"
 	   "  -c               Print test config before test.\n"
+	   "  -i <num-idle>    Open <num-idle> idle connections first.\n"
 	   "  -w <dir>         Write test results to <dir>.\n"
 	   "  -X               Exit after running test.\n"
 	   "  -E               Run Echo test.\n"
@@ -749,12 +822,13 @@ main (int argc, char **argv)
   sock_test_socket_t *ctrl = &scm->ctrl_socket;
   int c, rv, errno_val;
   sock_test_t post_test = SOCK_TEST_TYPE_NONE;
+  uint32_t num_idle_sockets = 0;
 
   sock_test_cfg_init (&ctrl->cfg);
   sock_test_socket_buf_alloc (ctrl);
 
   opterr = 0;
-  while ((c = getopt (argc, argv, "chn:w:XE:I:N:R:T:UBV")) != -1)
+  while ((c = getopt (argc, argv, "chn:w:XE:I:N:R:T:UBVi:")) != -1)
     switch (c)
       {
       case 'c':
@@ -814,6 +888,15 @@ main (int argc, char **argv)
 	  }
 	break;
 
+      case 'i':
+	if (sscanf (optarg, "0x%x", &num_idle_sockets) != 1)
+	  if (sscanf (optarg, "%u", &num_idle_sockets) != 1)
+	    {
+	      fprintf (stderr, "ERROR: Invalid value for option -%c!\n", c);
+	      print_usage_and_exit ();
+	    }
+	break;
+
       case 'N':
 	if (sscanf (optarg, "0x%lx", &ctrl->cfg.num_writes) != 1)
 	  if (sscanf (optarg, "%ld", &ctrl->cfg.num_writes) != 1)
@@ -890,6 +973,7 @@ main (int argc, char **argv)
 	  {
 	  case 'E':
 	  case 'I':
+	  case 'i':
 	  case 'N':
 	  case 'R':
 	  case 'T':
@@ -983,6 +1067,8 @@ main (int argc, char **argv)
     }
   while (rv < 0);
 
+  if (num_idle_sockets)
+    sock_test_connect_idle_sockets (num_idle_sockets);
   sock_test_connect_test_sockets (ctrl->cfg.num_test_sockets);
 
   while (ctrl->cfg.test != SOCK_TEST_TYPE_EXIT)
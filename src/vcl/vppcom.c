@@ -85,6 +85,8 @@ typedef struct
 #define VEP_DEFAULT_ET_MASK  (EPOLLIN|EPOLLOUT)
 #define VEP_UNSUPPORTED_EVENTS (EPOLLONESHOT|EPOLLEXCLUSIVE)
   u32 et_mask;
+  u32 *ready;			/* vep: sids that may have events */
+  u8 on_ready;			/* sid is on its vep's ready list */
 } vppcom_epoll_t;
 
 typedef struct
@@ -113,7 +115,6 @@ typedef struct
   u8 is_nonblocking;
   u8 is_vep;
   u8 is_vep_session;
-  u32 wait_cont_idx;
   vppcom_epoll_t vep;
   u32 vrf;
   vppcom_ip46_t lcl_addr;
@@ -176,6 +177,9 @@ typedef struct vppcom_main_t_
   /* Our event queue */
   unix_shared_memory_queue_t *app_event_queue;
 
+  /* Spare vep ready list, swapped in by vppcom_epoll_wait */
+  u32 *vep_ready_tmp;
+
   /* unique segment name counter */
   u32 unique_segment_index;
 
@@ -306,6 +310,66 @@ vppcom_session_at_index (u32 session_index, session_t * volatile *sess)
   return VPPCOM_OK;
 }
 
+/*
+ * Queue a vep session for vppcom_epoll_wait to look at. Sessions only
+ * need checking once this or an io event from vpp says they may be ready.
+ */
+static inline void
+vep_session_mark_ready (session_t * session, u32 sid)
+{
+  session_t *vep_session;
+
+  /* Assumes that caller has acquired spinlock: vcm->sessions_lockp */
+  if (!session->is_vep_session || session->vep.on_ready
+      || pool_is_free_index (vcm->sessions, session->vep.vep_idx))
+    return;
+
+  vep_session = pool_elt_at_index (vcm->sessions, session->vep.vep_idx);
+  vec_add1 (vep_session->vep.ready, sid);
+  session->vep.on_ready = 1;
+}
+
+/*
+ * Move the sessions vpp posted io events for onto their vep ready lists.
+ */
+static void
+vppcom_app_event_queue_drain (void)
+{
+  unix_shared_memory_queue_t *q = vcm->app_event_queue;
+  session_fifo_event_t e;
+  session_t *session;
+  u32 sid;
+
+  /* Assumes that caller has acquired spinlock: vcm->sessions_lockp */
+  if (PREDICT_FALSE (!q))
+    return;
+
+  while (q->cursize && !unix_shared_memory_queue_sub (q, (u8 *) & e,
+						      1 /* nowait */ ))
+    {
+      sid = e.fifo->client_session_index;
+      if (pool_is_free_index (vcm->sessions, sid))
+	continue;
+      session = pool_elt_at_index (vcm->sessions, sid);
+
+      switch (e.event_type)
+	{
+	case FIFO_EVENT_APP_RX:
+	  /* Let vpp post again before we look at the fifo, so new data
+	   * is never missed */
+	  svm_fifo_unset_event (e.fifo);
+	  session->vep.et_mask |= EPOLLIN;
+	  break;
+	case FIFO_EVENT_APP_TX:
+	  session->vep.et_mask |= EPOLLOUT;
+	  break;
+	default:
+	  continue;
+	}
+      vep_session_mark_ready (session, sid);
+    }
+}
+
 static int
 vppcom_connect_to_vpp (char *app_name)
 {
@@ -624,6 +688,7 @@ vl_api_disconnect_session_reply_t_handler (vl_api_disconnect_session_reply_t *
 			  getpid (), mp->handle, session_index);
 
 	  session->state = STATE_DISCONNECT;
+	  vep_session_mark_ready (session, session_index);
 	}
       clib_spinlock_unlock (&vcm->sessions_lockp);
     }
@@ -2117,6 +2182,8 @@ vppcom_session_close (uint32_t session_index)
 	  goto done;
     }
   clib_spinlock_lock (&vcm->sessions_lockp);
+  if (is_vep)
+    vec_free (session->vep.ready);
   pool_put_index (vcm->sessions, session_index);
   clib_spinlock_unlock (&vcm->sessions_lockp);
 done:
@@ -2651,6 +2718,28 @@ vppcom_session_read_ready (session_t * session, u32 session_index)
   return ready;
 }
 
+/*
+ * Ask vpp for a FIFO_EVENT_APP_TX when there's room in a full tx fifo.
+ * vpp dequeues first and checks the request after, so if it drains the
+ * fifo before the request is visible no event is ever posted. Look at
+ * the fifo again once the request is out and return the room found, 0
+ * if the event will come.
+ */
+static inline u32
+vppcom_session_want_tx_evt (svm_fifo_t * tx_fifo)
+{
+  u32 room;
+
+  svm_fifo_set_want_tx_evt (tx_fifo);
+  CLIB_MEMORY_BARRIER ();
+  room = svm_fifo_max_enqueue (tx_fifo);
+
+  /* Don't need the event, though vpp may have posted it already */
+  if (room)
+    svm_fifo_unset_want_tx_evt (tx_fifo);
+  return room;
+}
+
 int
 vppcom_session_write (uint32_t session_index, void *buf, int n)
 {
@@ -2730,11 +2819,24 @@ vppcom_session_write (uint32_t session_index, void *buf, int n)
 				    0 /* do wait for mutex */ );
     }
 
-  if (poll_et && (n_write <= 0))
+  if (n_write <= 0)
     {
-      clib_spinlock_lock (&vcm->sessions_lockp);
-      session->vep.et_mask |= EPOLLOUT;
-      clib_spinlock_unlock (&vcm->sessions_lockp);
+      u32 room = 0;
+
+      if (!session->is_cut_thru)
+	room = vppcom_session_want_tx_evt (tx_fifo);
+      if (poll_et || room)
+	{
+	  clib_spinlock_lock (&vcm->sessions_lockp);
+	  if (!vppcom_session_at_index (session_index, &session))
+	    {
+	      session->vep.et_mask |= EPOLLOUT;
+	      /* Drained before vpp saw the request, report it ourselves */
+	      if (room)
+		vep_session_mark_ready (session, session_index);
+	    }
+	  clib_spinlock_unlock (&vcm->sessions_lockp);
+	}
     }
 
   if (VPPCOM_DEBUG > 2)
@@ -2787,8 +2889,16 @@ vppcom_session_write_ready (session_t * session, u32 session_index)
 		  session_index, fifo_str, tx_fifo, ready);
   poll_et = (((EPOLLET | EPOLLOUT) & session->vep.ev.events) ==
 	     (EPOLLET | EPOLLOUT));
-  if (poll_et && (ready == 0))
-    session->vep.et_mask |= EPOLLOUT;
+  if (ready == 0)
+    {
+      /* Have vpp tell us when there's room again. If it was freed before
+       * vpp saw the request, the session is writable now, with EPOLLOUT
+       * armed as if vpp had posted the event */
+      if (!session->is_cut_thru)
+	ready = vppcom_session_want_tx_evt (tx_fifo);
+      if (poll_et)
+	session->vep.et_mask |= EPOLLOUT;
+    }
 
   return ready;
 }
@@ -2958,10 +3068,10 @@ vep_verify_epoll_chain (u32 vep_idx)
 		"{\n"
 		"   is_vep         = %u\n"
 		"   is_vep_session = %u\n"
-		"   wait_cont_idx  = 0x%x (%u)\n"
+		"   ready          = %u\n"
 		"}\n", getpid (),
 		vep_idx, session->is_vep, session->is_vep_session,
-		session->wait_cont_idx, session->wait_cont_idx);
+		vec_len (session->vep.ready));
   do
     {
       vep = &session->vep;
@@ -3027,7 +3137,6 @@ vppcom_epoll_create (void)
   vep_session->vep.vep_idx = ~0;
   vep_session->vep.next_sid = ~0;
   vep_session->vep.prev_sid = ~0;
-  vep_session->wait_cont_idx = ~0;
   clib_spinlock_unlock (&vcm->sessions_lockp);
 
   if (VPPCOM_DEBUG > 0)
@@ -3121,6 +3230,7 @@ vppcom_epoll_ctl (uint32_t vep_idx, int op, uint32_t session_index,
       session->vep.ev = *event;
       session->is_vep_session = 1;
       vep_session->vep.next_sid = session_index;
+      vep_session_mark_ready (session, session_index);
       if (VPPCOM_DEBUG > 1)
 	clib_warning ("[%d] EPOLL_CTL_ADD: vep_idx %u, sid %u, events 0x%x,"
 		      " data 0x%llx!", getpid (), vep_idx, session_index,
@@ -3155,6 +3265,7 @@ vppcom_epoll_ctl (uint32_t vep_idx, int op, uint32_t session_index,
 	}
       session->vep.et_mask = VEP_DEFAULT_ET_MASK;
       session->vep.ev = *event;
+      vep_session_mark_ready (session, session_index);
       if (VPPCOM_DEBUG > 1)
 	clib_warning ("[%d] EPOLL_CTL_MOD: vep_idx %u, sid %u, events 0x%x,"
 		      " data 0x%llx!", getpid (), vep_idx, session_index,
@@ -3181,10 +3292,6 @@ vppcom_epoll_ctl (uint32_t vep_idx, int op, uint32_t session_index,
 	  goto done;
 	}
 
-      vep_session->wait_cont_idx =
-	(vep_session->wait_cont_idx == session_index) ?
-	session->vep.next_sid : vep_session->wait_cont_idx;
-
       if (session->vep.prev_sid == vep_idx)
 	vep_session->vep.next_sid = session->vep.next_sid;
       else
@@ -3242,17 +3349,100 @@ done:
   return rv;
 }
 
+/*
+ * Check a session on the ready list for the events it's polled for.
+ * Returns non-zero if it must be checked again on the next wait: level
+ * triggered sessions that are ready, and sessions vpp sends no io events
+ * for, i.e., listeners and cut-thru sessions.
+ */
+static inline int
+vep_session_poll (session_t * session, u32 sid, struct epoll_event *ev)
+{
+  u32 session_events = session->vep.ev.events;
+  u32 clear_et_mask = 0;
+  u8 add_event = 0;
+  int ready;
+
+  /* Assumes caller has acquired spinlock: vcm->sessions_lockp */
+  if (EPOLLIN & session_events)
+    {
+      ready = vppcom_session_read_ready (session, sid);
+      if ((ready > 0) && (EPOLLIN & session->vep.et_mask))
+	{
+	  add_event = 1;
+	  ev->events |= EPOLLIN;
+	  if (((EPOLLET | EPOLLIN) & session_events) == (EPOLLET | EPOLLIN))
+	    clear_et_mask |= EPOLLIN;
+	}
+      else if (ready < 0)
+	{
+	  add_event = 1;
+	  switch (ready)
+	    {
+	    case VPPCOM_ECONNRESET:
+	      ev->events |= EPOLLHUP | EPOLLRDHUP;
+	      break;
+
+	    default:
+	      ev->events |= EPOLLERR;
+	      break;
+	    }
+	}
+    }
+
+  if (EPOLLOUT & session_events)
+    {
+      ready = vppcom_session_write_ready (session, sid);
+      if ((ready > 0) && (EPOLLOUT & session->vep.et_mask))
+	{
+	  add_event = 1;
+	  ev->events |= EPOLLOUT;
+	  if (((EPOLLET | EPOLLOUT) & session_events) ==
+	      (EPOLLET | EPOLLOUT))
+	    clear_et_mask |= EPOLLOUT;
+	}
+      else if (ready < 0)
+	{
+	  add_event = 1;
+	  switch (ready)
+	    {
+	    case VPPCOM_ECONNRESET:
+	      ev->events |= EPOLLHUP;
+	      break;
+
+	    default:
+	      ev->events |= EPOLLERR;
+	      break;
+	    }
+	}
+    }
+
+  if (!add_event)
+    return (session->is_listen || session->is_cut_thru);
+
+  ev->data.u64 = session->vep.ev.data.u64;
+  session->vep.et_mask &= ~clear_et_mask;
+  if (EPOLLONESHOT & session_events)
+    {
+      session->vep.ev.events = 0;
+      return 0;
+    }
+
+  return (session->is_listen || session->is_cut_thru
+	  || !(EPOLLET & session_events));
+}
+
 int
 vppcom_epoll_wait (uint32_t vep_idx, struct epoll_event *events,
 		   int maxevents, double wait_for_time)
 {
   session_t *vep_session;
+  session_t *session;
   int rv;
   f64 timeout = clib_time_now (&vcm->clib_time) + wait_for_time;
   u32 keep_trying = 1;
   int num_ev = 0;
-  u32 vep_next_sid, wait_cont_idx;
-  u8 is_vep;
+  u32 *ready, sid, n_seen, n_keep, i;
 
   if (PREDICT_FALSE (maxevents <= 0))
     {
@@ -3264,173 +3454,81 @@ vppcom_epoll_wait (uint32_t vep_idx, struct epoll_event *events,
   memset (events, 0, sizeof (*events) * maxevents);
 
   VCL_LOCK_AND_GET_SESSION (vep_idx, &vep_session);
-  vep_next_sid = vep_session->vep.next_sid;
-  is_vep = vep_session->is_vep;
-  wait_cont_idx = vep_session->wait_cont_idx;
-  clib_spinlock_unlock (&vcm->sessions_lockp);
-
-  if (PREDICT_FALSE (!is_vep))
+  if (PREDICT_FALSE (!vep_session->is_vep))
     {
+      clib_spinlock_unlock (&vcm->sessions_lockp);
       if (VPPCOM_DEBUG > 0)
 	clib_warning ("[%d] ERROR: vep_idx (%u) is not a vep!",
 		      getpid (), vep_idx);
       rv = VPPCOM_EINVAL;
       goto done;
     }
-  if (PREDICT_FALSE (vep_next_sid == ~0))
+  if (PREDICT_FALSE (vep_session->vep.next_sid == ~0))
     {
+      clib_spinlock_unlock (&vcm->sessions_lockp);
       if (VPPCOM_DEBUG > 0)
 	clib_warning ("[%d] WARNING: vep_idx (%u) is empty!",
 		      getpid (), vep_idx);
       goto done;
     }
+  clib_spinlock_unlock (&vcm->sessions_lockp);
 
+  /*
+   * Only sessions on the ready list are looked at, so the cost of a pass
+   * is proportional to the number of sessions with io, not to the number
+   * registered. The lock is taken once per pass.
+   */
   do
     {
-      u32 sid;
-      u32 next_sid = ~0;
-      session_t *session;
-
-      for (sid = (wait_cont_idx == ~0) ? vep_next_sid : wait_cont_idx;
-	   sid != ~0; sid = next_sid)
-	{
-	  u32 session_events, et_mask, clear_et_mask, session_vep_idx;
-	  u8 add_event, is_vep_session;
-	  int ready;
-	  u64 session_ev_data;
+      VCL_LOCK_AND_GET_SESSION (vep_idx, &vep_session);
+      vppcom_app_event_queue_drain ();
 
-	  VCL_LOCK_AND_GET_SESSION (sid, &session);
-	  next_sid = session->vep.next_sid;
-	  session_events = session->vep.ev.events;
-	  et_mask = session->vep.et_mask;
-	  is_vep = session->is_vep;
-	  is_vep_session = session->is_vep_session;
-	  session_vep_idx = session->vep.vep_idx;
-	  session_ev_data = session->vep.ev.data.u64;
-	  clib_spinlock_unlock (&vcm->sessions_lockp);
+      /* Swap in the spare list, sessions that stay ready are put back */
+      ready = vep_session->vep.ready;
+      vep_session->vep.ready = vcm->vep_ready_tmp;
+      vec_reset_length (vep_session->vep.ready);
 
-	  if (PREDICT_FALSE (is_vep))
-	    {
-	      if (VPPCOM_DEBUG > 0)
-		clib_warning ("[%d] ERROR: sid (%u) is a vep!",
-			      getpid (), vep_idx);
-	      rv = VPPCOM_EINVAL;
-	      goto done;
-	    }
-	  if (PREDICT_FALSE (!is_vep_session))
-	    {
-	      if (VPPCOM_DEBUG > 0)
-		clib_warning ("[%d] ERROR: session (%u) is not "
-			      "a vep session!", getpid (), sid);
-	      rv = VPPCOM_EINVAL;
-	      goto done;
-	    }
-	  if (PREDICT_FALSE (session_vep_idx != vep_idx))
-	    {
-	      clib_warning ("[%d] ERROR: session (%u) "
-			    "vep_idx (%u) != vep_idx (%u)!",
-			    getpid (), sid, session->vep.vep_idx, vep_idx);
-	      rv = VPPCOM_EINVAL;
-	      goto done;
-	    }
+      for (i = 0; i < vec_len (ready) && num_ev < maxevents; i++)
+	{
+	  sid = ready[i];
+	  if (pool_is_free_index (vcm->sessions, sid))
+	    continue;
+	  session = pool_elt_at_index (vcm->sessions, sid);
+
+	  /* Stale entry, e.g., session was removed and added back */
+	  if (!session->vep.on_ready || !session->is_vep_session
+	      || session->vep.vep_idx != vep_idx)
+	    continue;
+	  session->vep.on_ready = 0;
+
+	  if (vep_session_poll (session, sid, &events[num_ev]))
+	    vec_add1 (vep_session->vep.ready, sid);
+	  if (events[num_ev].events)
+	    num_ev++;
+	}
+      n_seen = i;
 
-	  add_event = clear_et_mask = 0;
+      n_keep = vec_len (vep_session->vep.ready);
+      for (i = 0; i < n_keep; i++)
+	{
+	  sid = vep_session->vep.ready[i];
+	  vcm->sessions[sid].vep.on_ready = 1;
+	}
 
-	  if (EPOLLIN & session_events)
-	    {
-	      VCL_LOCK_AND_GET_SESSION (sid, &session);
-	      ready = vppcom_session_read_ready (session, sid);
-	      clib_spinlock_unlock (&vcm->sessions_lockp);
-	      if ((ready > 0) && (EPOLLIN & et_mask))
-		{
-		  add_event = 1;
-		  events[num_ev].events |= EPOLLIN;
-		  if (((EPOLLET | EPOLLIN) & session_events) ==
-		      (EPOLLET | EPOLLIN))
-		    clear_et_mask |= EPOLLIN;
-		}
-	      else if (ready < 0)
-		{
-		  add_event = 1;
-		  switch (ready)
-		    {
-		    case VPPCOM_ECONNRESET:
-		      events[num_ev].events |= EPOLLHUP | EPOLLRDHUP;
-		      break;
-
-		    default:
-		      events[num_ev].events |= EPOLLERR;
-		      break;
-		    }
-		}
-	    }
+      /* Out of room. What wasn't looked at goes first next time */
+      if (n_seen < vec_len (ready))
+	vec_insert_elts (vep_session->vep.ready, ready + n_seen,
+			 vec_len (ready) - n_seen, 0);
 
-	  if (EPOLLOUT & session_events)
-	    {
-	      VCL_LOCK_AND_GET_SESSION (sid, &session);
-	      ready = vppcom_session_write_ready (session, sid);
-	      clib_spinlock_unlock (&vcm->sessions_lockp);
-	      if ((ready > 0) && (EPOLLOUT & et_mask))
-		{
-		  add_event = 1;
-		  events[num_ev].events |= EPOLLOUT;
-		  if (((EPOLLET | EPOLLOUT) & session_events) ==
-		      (EPOLLET | EPOLLOUT))
-		    clear_et_mask |= EPOLLOUT;
-		}
-	      else if (ready < 0)
-		{
-		  add_event = 1;
-		  switch (ready)
-		    {
-		    case VPPCOM_ECONNRESET:
-		      events[num_ev].events |= EPOLLHUP;
-		      break;
-
-		    default:
-		      events[num_ev].events |= EPOLLERR;
-		      break;
-		    }
-		}
-	    }
+      vec_reset_length (ready);
+      vcm->vep_ready_tmp = ready;
+      clib_spinlock_unlock (&vcm->sessions_lockp);
 
-	  if (add_event)
-	    {
-	      events[num_ev].data.u64 = session_ev_data;
-	      if (EPOLLONESHOT & session_events)
-		{
-		  VCL_LOCK_AND_GET_SESSION (sid, &session);
-		  session->vep.ev.events = 0;
-		  clib_spinlock_unlock (&vcm->sessions_lockp);
-		}
-	      num_ev++;
-	      if (num_ev == maxevents)
-		{
-		  VCL_LOCK_AND_GET_SESSION (vep_idx, &vep_session);
-		  vep_session->wait_cont_idx = next_sid;
-		  clib_spinlock_unlock (&vcm->sessions_lockp);
-		  goto done;
-		}
-	    }
-	  if (wait_cont_idx != ~0)
-	    {
-	      if (next_sid == ~0)
-		next_sid = vep_next_sid;
-	      else if (next_sid == wait_cont_idx)
-		next_sid = ~0;
-	    }
-	}
       if (wait_for_time != -1)
 	keep_trying = (clib_time_now (&vcm->clib_time) <= timeout) ? 1 : 0;
     }
   while ((num_ev == 0) && keep_trying);
 
-  if (wait_cont_idx != ~0)
-    {
-      VCL_LOCK_AND_GET_SESSION (vep_idx, &vep_session);
-      vep_session->wait_cont_idx = ~0;
-      clib_spinlock_unlock (&vcm->sessions_lockp);
-    }
 done:
   return (rv != VPPCOM_OK) ? rv : num_ev;
 }
@@ -74,26 +74,58 @@ vlib_clear_combined_counters (vlib_combined_counter_main_t * cm)
     }
 }
 
+/* Default stats segment hooks, for images without a stats segment */
+void *vlib_stats_push_heap (void *cm, u32 index, int is_combined)
+  __attribute__ ((weak));
+void *
+vlib_stats_push_heap (void *cm, u32 index, int is_combined)
+{
+  return clib_mem_get_heap ();
+}
+
+void vlib_stats_pop_heap (void *cm, void *oldheap, int is_combined)
+  __attribute__ ((weak));
+void
+vlib_stats_pop_heap (void *cm, void *oldheap, int is_combined)
+{
+  clib_mem_set_heap (oldheap);
+}
+
 void
 vlib_validate_simple_counter (vlib_simple_counter_main_t * cm, u32 index)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap = 0;
   int i;
 
+  if (cm->stat_segment_name)
+    oldheap = vlib_stats_push_heap (cm, index, 0 /* is_combined */ );
+
   vec_validate (cm->counters, tm->n_vlib_mains - 1);
   for (i = 0; i < tm->n_vlib_mains; i++)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+
+  /* Cleared by the push hook if the vectors left the segment */
+  if (cm->stat_segment_name)
+    vlib_stats_pop_heap (cm, oldheap, 0 /* is_combined */ );
 }
 
 void
 vlib_validate_combined_counter (vlib_combined_counter_main_t * cm, u32 index)
 {
   vlib_thread_main_t *tm = vlib_get_thread_main ();
+  void *oldheap = 0;
   int i;
 
+  if (cm->stat_segment_name)
+    oldheap = vlib_stats_push_heap (cm, index, 1 /* is_combined */ );
+
   vec_validate (cm->counters, tm->n_vlib_mains - 1);
   for (i = 0; i < tm->n_vlib_mains; i++)
     vec_validate_aligned (cm->counters[i], index, CLIB_CACHE_LINE_BYTES);
+
+  if (cm->stat_segment_name)
+    vlib_stats_pop_heap (cm, oldheap, 1 /* is_combined */ );
 }
 
 u32
@@ -63,6 +63,7 @@ typedef struct
                                            serialized incrementally. */
 
   char *name;			/**< The counter collection's name. */
+  char *stat_segment_name;    /**< Name in stats segment directory */
 } vlib_simple_counter_main_t;
 
 /** The number of counters (not the number of per-thread counters) */
@@ -183,12 +184,26 @@ typedef struct
   vlib_counter_t *value_at_last_serialize; /**< Counter values as of last serialize. */
   u32 last_incremental_serialize_index;	/**< Last counter index serialized incrementally. */
   char *name; /**< The counter collection's name. */
+  char *stat_segment_name;    /**< Name in stats segment directory */
 } vlib_combined_counter_main_t;
 
 /** The number of counters (not the number of per-thread counters) */
 u32 vlib_combined_counter_n_counters (const vlib_combined_counter_main_t *
 				      cm);
 
+/** Stats segment hooks, implemented by vpp/stats/stat_segment.c
+
+    Counter collections with a stat_segment_name keep their per-thread
+    vectors in the stats segment heap, and are listed in its directory.
+    vlib_stats_push_heap switches to that heap and marks the segment
+    as being updated; vlib_stats_pop_heap records the (possibly moved)
+    vectors in the directory and switches back. A collection that
+    would not fit in the segment any more is moved to the main heap
+    instead, and its stat_segment_name cleared.
+*/
+void *vlib_stats_push_heap (void *cm, u32 index, int is_combined);
+void vlib_stats_pop_heap (void *cm, void *oldheap, int is_combined);
+
 /** Clear a collection of simple counters
     @param cm - (vlib_simple_counter_main_t *) collection to clear
 */
@@ -1423,6 +1423,141 @@ dispatch_suspended_process (vlib_main_t * vm,
   return t;
 }
 
+static void
+vlib_worker_adaptive_poll_init (vlib_main_t * vm)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_adaptive_poll_t *ap = &vm->adaptive_poll;
+  f64 clocks_per_usec = vm->clib_time.clocks_per_second * 1e-6;
+  clib_error_t *error;
+
+  memset (ap, 0, sizeof (*ap));
+  ap->epoll_fd = ap->wakeup_fd = -1;
+
+  if (tm->adaptive_polling == 0)
+    return;
+
+  ap->backoff_after_clocks =
+    tm->adaptive_polling_backoff_usec * clocks_per_usec;
+  ap->sleep_after_clocks = tm->adaptive_polling_sleep_usec * clocks_per_usec;
+  ap->max_sleep = tm->adaptive_polling_max_sleep_usec * 1e-6;
+  ap->last_busy_time = ap->last_time = clib_cpu_time_now ();
+  ap->state = VLIB_POLL_STATE_POLL;
+  ap->entries[VLIB_POLL_STATE_POLL] = 1;
+
+  error = linux_epoll_worker_init (vm);
+  if (error)
+    {
+      clib_error_report (error);
+      return;
+    }
+
+  CLIB_MEMORY_BARRIER ();
+  ap->enabled = 1;
+}
+
+/* Anything another thread could have handed us since the last loop? */
+static int
+vlib_worker_has_pending_work (vlib_main_t * vm)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_node_main_t *nm = &vm->node_main;
+  vlib_frame_queue_main_t *fqm;
+  vlib_frame_queue_t *fq;
+
+  if (_vec_len (nm->pending_interrupt_node_runtime_indices))
+    return 1;
+
+  if (*vlib_worker_threads->wait_at_barrier)
+    return 1;
+
+  vec_foreach (fqm, tm->frame_queue_mains)
+  {
+    fq = fqm->vlib_frame_queues[vm->thread_index];
+    if (fq && fq->head != fq->tail)
+      return 1;
+    /* or buffers we still owe another thread */
+    if (fqm->deferred && fqm->deferred[vm->thread_index].n_buffers)
+      return 1;
+  }
+
+  return 0;
+}
+
+static_always_inline void
+vlib_worker_adaptive_poll_set_state (vlib_adaptive_poll_t * ap,
+				     vlib_poll_state_t state)
+{
+  ap->state = state;
+  ap->entries[state]++;
+}
+
+/*
+ * Runs at the end of each worker main loop. After backoff_after_clocks
+ * without work the worker spins with pause instructions; after
+ * sleep_after_clocks it blocks in epoll until another thread hands it
+ * work (interrupt pending, frame queue element, barrier) or max_sleep
+ * expires. Input nodes in polling state are only polled on timeouts
+ * while asleep, so traffic on them keeps the worker awake.
+ */
+static_always_inline u64
+vlib_worker_adaptive_poll (vlib_main_t * vm, int is_busy, u64 cpu_time_now)
+{
+  vlib_adaptive_poll_t *ap = &vm->adaptive_poll;
+  u64 idle;
+  int i;
+
+  ap->clocks[ap->state] += cpu_time_now - ap->last_time;
+  ap->last_time = cpu_time_now;
+
+  if (is_busy)
+    {
+      ap->last_busy_time = cpu_time_now;
+      if (PREDICT_FALSE (ap->state != VLIB_POLL_STATE_POLL))
+	vlib_worker_adaptive_poll_set_state (ap, VLIB_POLL_STATE_POLL);
+      return cpu_time_now;
+    }
+
+  idle = cpu_time_now - ap->last_busy_time;
+
+  if (idle < ap->backoff_after_clocks)
+    return cpu_time_now;
+
+  if (idle < ap->sleep_after_clocks)
+    {
+      if (ap->state != VLIB_POLL_STATE_BACKOFF)
+	vlib_worker_adaptive_poll_set_state (ap, VLIB_POLL_STATE_BACKOFF);
+      for (i = 0; i < 32; i++)
+	CLIB_PAUSE ();
+      return clib_cpu_time_now ();
+    }
+
+  if (ap->state != VLIB_POLL_STATE_SLEEP)
+    vlib_worker_adaptive_poll_set_state (ap, VLIB_POLL_STATE_SLEEP);
+
+  /* Publish the sleeping flag before the final check for work, so
+     that either we see the work or its producer sees the flag. */
+  ap->sleeping = 1;
+  CLIB_MEMORY_BARRIER ();
+  i = vlib_worker_has_pending_work (vm)
+    || linux_epoll_worker_sleep (vm, ap->max_sleep);
+  ap->sleeping = 0;
+
+  cpu_time_now = clib_cpu_time_now ();
+  ap->clocks[ap->state] += cpu_time_now - ap->last_time;
+  ap->last_time = cpu_time_now;
+
+  /* Kicked: expect work shortly, poll rather than go back to sleep */
+  if (i)
+    {
+      ap->wakeups++;
+      ap->last_busy_time = cpu_time_now;
+      vlib_worker_adaptive_poll_set_state (ap, VLIB_POLL_STATE_POLL);
+    }
+
+  return cpu_time_now;
+}
+
 static_always_inline void
 vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 {
@@ -1432,6 +1567,7 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
   u64 cpu_time_now;
   vlib_frame_queue_main_t *fqm;
   u32 *last_node_runtime_indices = 0;
+  int is_busy = 0;
 
   /* Initialize pending node vector. */
   if (is_main)
@@ -1461,6 +1597,9 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
   if (!nm->interrupt_threshold_vector_length)
     nm->interrupt_threshold_vector_length = 5;
 
+  if (!is_main)
+    vlib_worker_adaptive_poll_init (vm);
+
   /* Start all processes. */
   if (is_main)
     {
@@ -1478,10 +1617,22 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (!is_main)
 	{
 	  vlib_worker_thread_barrier_check ();
+	  is_busy = 0;
 	  vec_foreach (fqm, tm->frame_queue_mains)
-	    vlib_frame_queue_dequeue (vm, fqm);
+	    is_busy |= vlib_frame_queue_dequeue (vm, fqm) > 0;
 	}
 
+      /* Retry handoffs deferred by a congested frame queue. */
+      vec_foreach (fqm, tm->frame_queue_mains)
+      {
+	if (PREDICT_FALSE (fqm->deferred &&
+			   fqm->deferred[vm->thread_index].n_buffers))
+	  {
+	    vlib_frame_queue_flush_deferred (vm, fqm);
+	    is_busy = 1;
+	  }
+      }
+
       /* Process pre-input nodes. */
       if (is_main)
 	vec_foreach (n, nm->nodes_by_type[VLIB_NODE_TYPE_PRE_INPUT])
@@ -1604,11 +1755,16 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       if (is_main && _vec_len (nm->data_from_advancing_timing_wheel) > 0)
 	goto processes_timing_wheel_data;
 
+      is_busy |= vm->main_loop_vectors_processed > 0;
+
       vlib_increment_main_loop_counter (vm);
 
       /* Record time stamp in case there are no enabled nodes and above
          calls do not update time stamp. */
       cpu_time_now = clib_cpu_time_now ();
+
+      if (!is_main && vm->adaptive_poll.enabled)
+	cpu_time_now = vlib_worker_adaptive_poll (vm, is_busy, cpu_time_now);
     }
 }
 
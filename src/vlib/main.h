@@ -56,6 +56,52 @@
 #define VLIB_ELOG_MAIN_LOOP 0
 #endif
 
+#define foreach_vlib_poll_state		\
+  _(POLL, "polling")			\
+  _(BACKOFF, "backoff")			\
+  _(SLEEP, "sleeping")
+
+typedef enum
+{
+#define _(f,s) VLIB_POLL_STATE_##f,
+  foreach_vlib_poll_state
+#undef _
+    VLIB_N_POLL_STATE,
+} vlib_poll_state_t;
+
+/* Adaptive polling: workers with no work back off, then sleep. */
+typedef struct
+{
+  /* Enabled by cpu { adaptive-polling } */
+  u8 enabled;
+
+  /* Current vlib_poll_state_t */
+  u8 state;
+
+  /* Set while the worker is blocked in the kernel */
+  volatile u32 sleeping;
+
+  /* Idle time before spinning with pause, then before sleeping */
+  u64 backoff_after_clocks;
+  u64 sleep_after_clocks;
+
+  /* Upper bound on a single sleep, in seconds */
+  f64 max_sleep;
+
+  /* Time stamps of the last work done, and of the last state update */
+  u64 last_busy_time;
+  u64 last_time;
+
+  /* Statistics: time spent in, and entries into, each state */
+  u64 clocks[VLIB_N_POLL_STATE];
+  u64 entries[VLIB_N_POLL_STATE];
+  u64 wakeups;
+
+  /* Per-thread epoll set and the eventfd other threads kick us with */
+  int epoll_fd;
+  int wakeup_fd;
+} vlib_adaptive_poll_t;
+
 typedef struct vlib_main_t
 {
   /* Instruction level timing state. */
@@ -210,6 +256,9 @@ typedef struct vlib_main_t
   /* Earliest barrier can be closed again */
   f64 barrier_no_close_before;
 
+  /* Worker idle backoff state */
+  vlib_adaptive_poll_t adaptive_poll;
+
 } vlib_main_t;
 
 /* Global main structure. */
@@ -347,6 +396,21 @@ vlib_increment_main_loop_counter (vlib_main_t * vm)
     clib_longjmp (&vm->main_loop_exit, VLIB_MAIN_LOOP_EXIT_CLI);
 }
 
+/* Kick a sleeping worker, see unix/input.c */
+void vlib_worker_wakeup_sleeping (vlib_main_t * vm);
+
+/* Call after handing work to another thread's vm */
+always_inline void
+vlib_worker_wakeup (vlib_main_t * vm)
+{
+  if (PREDICT_FALSE (vm->adaptive_poll.enabled))
+    {
+      CLIB_MEMORY_BARRIER ();
+      if (vm->adaptive_poll.sleeping)
+	vlib_worker_wakeup_sleeping (vm);
+    }
+}
+
 always_inline void vlib_set_queue_signal_callback
   (vlib_main_t * vm, void (*fp) (vlib_main_t *))
 {
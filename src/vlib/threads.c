@@ -1254,6 +1254,9 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
   tm->n_thread_stacks = 1;	/* account for main thread */
   tm->sched_policy = ~0;
   tm->sched_priority = ~0;
+  tm->adaptive_polling_backoff_usec = 100;
+  tm->adaptive_polling_sleep_usec = 1000;
+  tm->adaptive_polling_max_sleep_usec = 10000;
 
   tr = tm->next;
 
@@ -1314,6 +1317,17 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "scheduler-priority %u", &tm->sched_priority))
 	;
+      else if (unformat (input, "adaptive-polling"))
+	tm->adaptive_polling = 1;
+      else if (unformat (input, "adaptive-polling-backoff-usec %u",
+			 &tm->adaptive_polling_backoff_usec))
+	;
+      else if (unformat (input, "adaptive-polling-sleep-usec %u",
+			 &tm->adaptive_polling_sleep_usec))
+	;
+      else if (unformat (input, "adaptive-polling-max-sleep-usec %u",
+			 &tm->adaptive_polling_max_sleep_usec))
+	;
       else if (unformat (input, "%s %u", &name, &count))
 	{
 	  p = hash_get_mem (tm->thread_registrations_by_name, name);
@@ -1349,6 +1363,11 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
 	     tm->sched_priority);
 	}
     }
+  if (tm->adaptive_polling_sleep_usec < tm->adaptive_polling_backoff_usec)
+    return clib_error_return
+      (0, "adaptive-polling-sleep-usec must not be less than "
+       "adaptive-polling-backoff-usec");
+
   tr = tm->next;
 
   if (!tm->thread_prefix)
@@ -1436,6 +1455,7 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
   f64 t_open;
   f64 t_closed;
   u32 count;
+  int i;
 
   if (vec_len (vlib_mains) < 2)
     return;
@@ -1469,6 +1489,8 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm)
   deadline = now + BARRIER_SYNC_TIMEOUT;
 
   *vlib_worker_threads->wait_at_barrier = 1;
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    vlib_worker_wakeup (vlib_mains[i]);
   while (*vlib_worker_threads->workers_at_barrier != count)
     {
       if ((now = vlib_time_now (vm)) > deadline)
@@ -1652,6 +1674,13 @@ vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
 	  return processed;
 	}
 
+      if (processed == 0)
+	{
+	  u64 n_in_use = clib_min (fq->tail - fq->head, fq->nelts);
+	  fq->occupancy[(n_in_use - 1) * VLIB_FRAME_QUEUE_N_OCCUPANCY_BUCKETS
+			/ fq->nelts]++;
+	}
+
       from = elt->buffer_index;
       msg_type = elt->msg_type;
 
@@ -1764,9 +1793,171 @@ vlib_frame_queue_main_init (u32 node_index, u32 frame_queue_nelts)
       vec_add1 (fqm->vlib_frame_queues, fq);
     }
 
+  fqm->congestion_policy = VLIB_FRAME_QUEUE_CONGESTION_WAIT;
+  fqm->queue_hi_thresh = frame_queue_nelts;
+  fqm->max_deferred = 2 * VLIB_FRAME_SIZE;
+  vec_validate_aligned (fqm->deferred, tm->n_vlib_mains - 1,
+			CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < tm->n_vlib_mains; i++)
+    vec_validate (fqm->deferred[i].buffers_by_thread, tm->n_vlib_mains - 1);
+
   return (fqm - tm->frame_queue_mains);
 }
 
+/* Hand off as many buffers as the ring has room for */
+static u32
+vlib_frame_queue_enqueue_nowait (u32 frame_queue_index, u32 thread_index,
+				 u32 * buffers, u32 n_buffers)
+{
+  vlib_frame_queue_elt_t *elt;
+  u32 n_sent = 0, n;
+
+  while (n_sent < n_buffers)
+    {
+      elt = vlib_get_frame_queue_elt_nowait (frame_queue_index,
+					     thread_index);
+      if (elt == 0)
+	break;
+      n = clib_min (n_buffers - n_sent, VLIB_FRAME_SIZE);
+      clib_memcpy (elt->buffer_index, buffers + n_sent, n * sizeof (u32));
+      elt->n_vectors = n;
+      vlib_put_frame_queue_elt (elt);
+      n_sent += n;
+    }
+
+  return n_sent;
+}
+
+static void
+vlib_frame_queue_send_deferred (vlib_frame_queue_main_t * fqm,
+				vlib_frame_queue_deferred_t * d,
+				u32 thread_index)
+{
+  u32 frame_queue_index = fqm - vlib_thread_main.frame_queue_mains;
+  u32 **buffers = &d->buffers_by_thread[thread_index];
+  u32 n_sent;
+
+  n_sent = vlib_frame_queue_enqueue_nowait (frame_queue_index, thread_index,
+					    *buffers, vec_len (*buffers));
+  if (n_sent)
+    {
+      vec_delete (*buffers, n_sent, 0);
+      d->n_buffers -= n_sent;
+    }
+}
+
+/*
+ * Hand n_buffers off to thread_index's frame queue without blocking,
+ * unless the policy is WAIT. Under the DEFER policy, buffers that do
+ * not fit are kept, in order, and retried each time round the sending
+ * thread's main loop, up to max_deferred of them. Returns the number of
+ * buffers taken; the caller must drop the rest.
+ */
+u32
+vlib_frame_queue_enqueue_buffers (vlib_main_t * vm, u32 frame_queue_index,
+				  u32 thread_index, u32 * buffers,
+				  u32 n_buffers)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_frame_queue_main_t *fqm =
+    vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
+  vlib_frame_queue_t *fq = fqm->vlib_frame_queues[thread_index];
+  vlib_frame_queue_deferred_t *d = &fqm->deferred[vm->thread_index];
+  u32 **deferred = &d->buffers_by_thread[thread_index];
+  vlib_frame_queue_elt_t *elt;
+  u32 n_sent = 0, n;
+
+  if (fqm->congestion_policy == VLIB_FRAME_QUEUE_CONGESTION_WAIT)
+    {
+      while (n_sent < n_buffers)
+	{
+	  elt = vlib_get_frame_queue_elt (frame_queue_index, thread_index);
+	  n = clib_min (n_buffers - n_sent, VLIB_FRAME_SIZE);
+	  clib_memcpy (elt->buffer_index, buffers + n_sent,
+		       n * sizeof (u32));
+	  elt->n_vectors = n;
+	  vlib_put_frame_queue_elt (elt);
+	  n_sent += n;
+	}
+      return n_sent;
+    }
+
+  /* earlier buffers for this thread go first */
+  if (PREDICT_FALSE (vec_len (*deferred) != 0))
+    vlib_frame_queue_send_deferred (fqm, d, thread_index);
+
+  if (PREDICT_TRUE (vec_len (*deferred) == 0))
+    n_sent = vlib_frame_queue_enqueue_nowait (frame_queue_index,
+					      thread_index, buffers,
+					      n_buffers);
+  if (PREDICT_TRUE (n_sent == n_buffers))
+    return n_sent;
+
+  fq->enqueue_full_events++;
+
+  if (fqm->congestion_policy == VLIB_FRAME_QUEUE_CONGESTION_DEFER &&
+      vec_len (*deferred) < fqm->max_deferred)
+    {
+      n = clib_min (n_buffers - n_sent,
+		    fqm->max_deferred - vec_len (*deferred));
+      vec_add (*deferred, buffers + n_sent, n);
+      d->n_buffers += n;
+      n_sent += n;
+      __sync_fetch_and_add (&fq->congestion_defers, n);
+    }
+
+  if (n_sent < n_buffers)
+    __sync_fetch_and_add (&fq->congestion_drops, n_buffers - n_sent);
+
+  return n_sent;
+}
+
+/* Retry deferred buffers; called from the sending thread's main loop */
+void
+vlib_frame_queue_flush_deferred (vlib_main_t * vm,
+				 vlib_frame_queue_main_t * fqm)
+{
+  vlib_frame_queue_deferred_t *d = &fqm->deferred[vm->thread_index];
+  u32 i;
+
+  for (i = 0; i < vec_len (d->buffers_by_thread); i++)
+    if (vec_len (d->buffers_by_thread[i]))
+      vlib_frame_queue_send_deferred (fqm, d, i);
+}
+
+u8 *
+format_vlib_frame_queue_congestion_policy (u8 * s, va_list * args)
+{
+  vlib_frame_queue_congestion_policy_t p = va_arg (*args, int);
+  char *t = 0;
+
+  switch (p)
+    {
+#define _(v,str) case VLIB_FRAME_QUEUE_CONGESTION_##v: t = str; break;
+      foreach_vlib_frame_queue_congestion_policy
+#undef _
+    default:
+      return format (s, "unknown");
+    }
+  return format (s, "%s", t);
+}
+
+uword
+unformat_vlib_frame_queue_congestion_policy (unformat_input_t * input,
+					     va_list * args)
+{
+  vlib_frame_queue_congestion_policy_t *p = va_arg (*args, void *);
+
+  if (0);
+#define _(v,str) else if (unformat (input, str)) \
+    *p = VLIB_FRAME_QUEUE_CONGESTION_##v;
+  foreach_vlib_frame_queue_congestion_policy
+#undef _
+    else
+    return 0;
+  return 1;
+}
+
 int
 vlib_thread_cb_register (struct vlib_main_t *vm, vlib_thread_callbacks_t * cb)
 {
@@ -131,6 +131,9 @@ typedef struct
 
 extern vlib_worker_thread_t *vlib_worker_threads;
 
+/* Occupancy histogram buckets, each an eighth of the ring */
+#define VLIB_FRAME_QUEUE_N_OCCUPANCY_BUCKETS 8
+
 typedef struct
 {
   /* enqueue side */
@@ -141,6 +144,10 @@ typedef struct
   u64 enqueue_vectors;
   u32 enqueue_full_events;
 
+  /* non-blocking enqueue: buffers dropped or deferred on a full ring */
+  u64 congestion_drops;
+  u64 congestion_defers;
+
   /* dequeue side */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
   volatile u64 head;
@@ -150,6 +157,9 @@ typedef struct
   u64 trace;
   u64 vector_threshold;
 
+  /* elements in use, sampled whenever the consumer finds work */
+  u64 occupancy[VLIB_FRAME_QUEUE_N_OCCUPANCY_BUCKETS];
+
   /* dequeue hint to enqueue side */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
   volatile u64 head_hint;
@@ -161,11 +171,44 @@ typedef struct
 }
 vlib_frame_queue_t;
 
+/*
+ * What a non-blocking enqueue does when the destination ring is full:
+ * give the buffers back to the caller to drop, or hold on to them and
+ * retry from the sending thread's main loop.
+ */
+#define foreach_vlib_frame_queue_congestion_policy \
+  _(WAIT, "wait")                                   \
+  _(DROP, "drop")                                   \
+  _(DEFER, "defer")
+
+typedef enum
+{
+#define _(v,s) VLIB_FRAME_QUEUE_CONGESTION_##v,
+  foreach_vlib_frame_queue_congestion_policy
+#undef _
+} vlib_frame_queue_congestion_policy_t;
+
+typedef struct
+{
+  /* buffers waiting for room, by destination thread */
+  u32 **buffers_by_thread;
+  u32 n_buffers;
+} vlib_frame_queue_deferred_t;
+
 typedef struct
 {
   u32 node_index;
   vlib_frame_queue_t **vlib_frame_queues;
 
+  /* non-blocking enqueue */
+  vlib_frame_queue_congestion_policy_t congestion_policy;
+  /* ring counts as full at this many elements in use */
+  u32 queue_hi_thresh;
+  /* most buffers deferred per destination, beyond that they drop */
+  u32 max_deferred;
+  /* by sending thread */
+  vlib_frame_queue_deferred_t *deferred;
+
   /* for frame queue tracing */
   frame_queue_trace_t *frame_queue_traces;
   frame_queue_nelt_counter_t *frame_queue_histogram;
@@ -188,6 +231,14 @@ int vlib_frame_queue_enqueue (vlib_main_t * vm, u32 node_runtime_index,
 int
 vlib_frame_queue_dequeue (vlib_main_t * vm, vlib_frame_queue_main_t * fqm);
 
+u32 vlib_frame_queue_enqueue_buffers (vlib_main_t * vm,
+				      u32 frame_queue_index, u32 thread_index,
+				      u32 * buffers, u32 n_buffers);
+void vlib_frame_queue_flush_deferred (vlib_main_t * vm,
+				      vlib_frame_queue_main_t * fqm);
+format_function_t format_vlib_frame_queue_congestion_policy;
+unformat_function_t unformat_vlib_frame_queue_congestion_policy;
+
 void vlib_worker_thread_node_runtime_update (void);
 
 void vlib_create_worker_threads (vlib_main_t * vm, int n,
@@ -343,6 +394,12 @@ typedef struct
   /* scheduling policy priority */
   u32 sched_priority;
 
+  /* idle workers back off, then sleep until woken or timed out */
+  u8 adaptive_polling;
+  u32 adaptive_polling_backoff_usec;
+  u32 adaptive_polling_sleep_usec;
+  u32 adaptive_polling_max_sleep_usec;
+
   /* callbacks */
   vlib_thread_callbacks_t cb;
   int extern_thread_mgmt;
@@ -450,6 +507,10 @@ vlib_get_frame_queue_elt (u32 frame_queue_index, u32 index)
 
   new_tail = __sync_add_and_fetch (&fq->tail, 1);
 
+  /* The consumer spins for a while before sleeping, plenty of time to
+     fill in and post the element */
+  vlib_worker_wakeup (vlib_mains[index]);
+
   /* Wait until a ring slot is available */
   while (new_tail >= fq->head_hint + fq->nelts)
     vlib_worker_thread_barrier_check ();
@@ -466,6 +527,45 @@ vlib_get_frame_queue_elt (u32 frame_queue_index, u32 index)
   return elt;
 }
 
+/*
+ * Non-blocking vlib_get_frame_queue_elt: returns 0 rather than waiting
+ * if the ring already holds queue_hi_thresh elements.
+ */
+static inline vlib_frame_queue_elt_t *
+vlib_get_frame_queue_elt_nowait (u32 frame_queue_index, u32 index)
+{
+  vlib_frame_queue_t *fq;
+  vlib_frame_queue_elt_t *elt;
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_frame_queue_main_t *fqm =
+    vec_elt_at_index (tm->frame_queue_mains, frame_queue_index);
+  u64 tail;
+
+  fq = fqm->vlib_frame_queues[index];
+  ASSERT (fq);
+
+  /* reserve a slot, unless another producer takes it first */
+  do
+    {
+      tail = fq->tail;
+      if (tail + 1 >= fq->head_hint + fqm->queue_hi_thresh &&
+	  tail + 1 >= fq->head + fqm->queue_hi_thresh)
+	return 0;
+    }
+  while (!__sync_bool_compare_and_swap (&fq->tail, tail, tail + 1));
+
+  vlib_worker_wakeup (vlib_mains[index]);
+
+  /* the consumer is past this slot, so it has been released */
+  elt = fq->elts + ((tail + 1) & (fq->nelts - 1));
+  ASSERT (elt->valid == 0);
+
+  elt->msg_type = VLIB_FRAME_QUEUE_ELT_DISPATCH_FRAME;
+  elt->last_n_vectors = elt->n_vectors = 0;
+
+  return elt;
+}
+
 static inline vlib_frame_queue_t *
 is_vlib_frame_queue_congested (u32 frame_queue_index,
 			       u32 index,
@@ -40,6 +40,16 @@ format_sched_policy_and_priority (u8 * s, va_list * args)
     return format (s, "%s (n/a)", t);
 }
 
+static u8 *
+format_adaptive_poll_state_time (u8 * s, va_list * args)
+{
+  f64 seconds = va_arg (*args, f64);
+  f64 percent = va_arg (*args, f64);
+  u64 entries = va_arg (*args, u64);
+
+  return format (s, "%.2f (%.1f%%) x %llu", seconds, percent, entries);
+}
+
 static clib_error_t *
 show_threads_fn (vlib_main_t * vm,
 		 unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -134,6 +144,88 @@ VLIB_CLI_COMMAND (show_threads_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_adaptive_polling_fn (vlib_main_t * vm,
+			  unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_adaptive_poll_t *ap;
+  vlib_main_t *wm;
+  f64 total, clocks_per_second = vm->clib_time.clocks_per_second;
+  int i;
+
+  if (tm->adaptive_polling == 0)
+    {
+      vlib_cli_output (vm, "adaptive polling not enabled");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "backoff after %uus idle, sleep after %uus idle, "
+		   "max sleep %uus",
+		   tm->adaptive_polling_backoff_usec,
+		   tm->adaptive_polling_sleep_usec,
+		   tm->adaptive_polling_max_sleep_usec);
+
+  vlib_cli_output (vm, "%-7s%-20s%-10s%-25s%-25s%-25s%-12s",
+		   "ID", "Name", "State", "Polling (s, %)",
+		   "Backoff (s, %)", "Sleeping (s, %)", "Wakeups");
+
+  for (i = 1; i < vec_len (vlib_mains); i++)
+    {
+      u8 *line = 0;
+
+      wm = vlib_mains[i];
+      ap = &wm->adaptive_poll;
+      if (!ap->enabled)
+	continue;
+
+      total = ap->clocks[VLIB_POLL_STATE_POLL]
+	+ ap->clocks[VLIB_POLL_STATE_BACKOFF]
+	+ ap->clocks[VLIB_POLL_STATE_SLEEP];
+      total = clib_max (total, 1);
+
+      line = format (line, "%-7d%-20v%-10s", i, vlib_worker_threads[i].name,
+		     ap->sleeping ? "sleeping" :
+		     ap->state == VLIB_POLL_STATE_BACKOFF ? "backoff" :
+		     ap->state == VLIB_POLL_STATE_SLEEP ? "idle" : "polling");
+#define _(f,s)								\
+      line = format (line, "%-25U", format_adaptive_poll_state_time,	\
+		     ap->clocks[VLIB_POLL_STATE_##f] / clocks_per_second,	\
+		     100.0 * ap->clocks[VLIB_POLL_STATE_##f] / total,		\
+		     ap->entries[VLIB_POLL_STATE_##f]);
+      foreach_vlib_poll_state
+#undef _
+      line = format (line, "%-12llu", ap->wakeups);
+
+      vlib_cli_output (vm, "%v", line);
+      vec_free (line);
+    }
+
+  return 0;
+}
+
+/*?
+ * Show, for each worker, the time spent busy polling, spinning in
+ * backoff and sleeping since startup, with the number of times each
+ * state was entered, and how often other threads woke the worker up.
+ * Requires adaptive polling to be enabled in the startup configuration
+ * with '<em>cpu { adaptive-polling }</em>'.
+ *
+ * @cliexpar
+ * @cliexstart{show adaptive-polling}
+ * backoff after 100us idle, sleep after 1000us idle, max sleep 10000us
+ * ID     Name                State     Polling (s, %)           Backoff (s, %)           Sleeping (s, %)          Wakeups
+ * 1      vpp_wk_0            sleeping  1.20 (2.9%) x 310        .36 (.8%) x 310          40.80 (96.3%) x 310      291
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_adaptive_polling_command, static) = {
+  .path = "show adaptive-polling",
+  .short_help = "show adaptive-polling",
+  .function = show_adaptive_polling_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * Trigger threads to grab frame queue trace data
  */
@@ -364,6 +456,47 @@ show_frame_queue_internal (vlib_main_t * vm,
   return error;
 }
 
+/*
+ * Display the congestion counters and occupancy histogram, which are
+ * kept whether or not tracing is on.
+ */
+static void
+show_frame_queue_stats (vlib_main_t * vm, vlib_frame_queue_main_t * fqm)
+{
+  vlib_frame_queue_t *fq;
+  u64 total;
+  u32 i, j;
+
+  vlib_cli_output (vm, "  congestion policy %U  high threshold %u"
+		   "  max deferred %u",
+		   format_vlib_frame_queue_congestion_policy,
+		   fqm->congestion_policy, fqm->queue_hi_thresh,
+		   fqm->max_deferred);
+  vlib_cli_output (vm, "  %-8s%12s%12s%12s  %s", "Thread", "Full",
+		   "Drops", "Deferred", "Occupancy by eighths of the ring");
+
+  for (i = 0; i < vec_len (fqm->vlib_frame_queues); i++)
+    {
+      u8 *s = 0;
+
+      fq = fqm->vlib_frame_queues[i];
+      if (fq == 0)
+	continue;
+
+      total = 0;
+      for (j = 0; j < VLIB_FRAME_QUEUE_N_OCCUPANCY_BUCKETS; j++)
+	total += fq->occupancy[j];
+      for (j = 0; j < VLIB_FRAME_QUEUE_N_OCCUPANCY_BUCKETS; j++)
+	s = format (s, "%3d%% ", total ?
+		    (fq->occupancy[j] * 100 + total - 1) / total : 0);
+
+      vlib_cli_output (vm, "  %-8u%12u%12llu%12llu  %v", i,
+		       fq->enqueue_full_events, fq->congestion_drops,
+		       fq->congestion_defers, s);
+      vec_free (s);
+    }
+}
+
 static clib_error_t *
 show_frame_queue_trace (vlib_main_t * vm, unformat_input_t * input,
 			vlib_cli_command_t * cmd)
@@ -377,6 +510,7 @@ show_frame_queue_trace (vlib_main_t * vm, unformat_input_t * input,
     vlib_cli_output (vm, "Worker handoff queue index %u (next node '%U'):",
 		     fqm - tm->frame_queue_mains,
 		     format_vlib_node_name, vm, fqm->node_index);
+    show_frame_queue_stats (vm, fqm);
     error = show_frame_queue_internal (vm, fqm, 0);
     if (error)
       return error;
@@ -48,6 +48,7 @@
 #ifdef HAVE_LINUX_EPOLL
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 typedef struct
 {
@@ -253,6 +254,73 @@ linux_epoll_input_init (vlib_main_t * vm)
 
 VLIB_INIT_FUNCTION (linux_epoll_input_init);
 
+/*
+ * Idle workers block on their own epoll set. Device fds stay in the
+ * main thread's set; their read functions mark the worker's input
+ * node interrupt pending, which kicks the worker's eventfd.
+ */
+clib_error_t *
+linux_epoll_worker_init (vlib_main_t * vm)
+{
+  vlib_adaptive_poll_t *ap = &vm->adaptive_poll;
+  struct epoll_event e;
+
+  ap->wakeup_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (ap->wakeup_fd < 0)
+    return clib_error_return_unix (0, "eventfd");
+
+  ap->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (ap->epoll_fd < 0)
+    {
+      close (ap->wakeup_fd);
+      ap->wakeup_fd = -1;
+      return clib_error_return_unix (0, "epoll_create1");
+    }
+
+  memset (&e, 0, sizeof (e));
+  e.events = EPOLLIN;
+  if (epoll_ctl (ap->epoll_fd, EPOLL_CTL_ADD, ap->wakeup_fd, &e) < 0)
+    {
+      close (ap->epoll_fd);
+      close (ap->wakeup_fd);
+      ap->epoll_fd = ap->wakeup_fd = -1;
+      return clib_error_return_unix (0, "epoll_ctl");
+    }
+
+  return 0;
+}
+
+/* Returns 1 if kicked by another thread, 0 on timeout */
+int
+linux_epoll_worker_sleep (vlib_main_t * vm, f64 timeout)
+{
+  vlib_adaptive_poll_t *ap = &vm->adaptive_poll;
+  struct epoll_event e;
+  u64 count;
+  int n_fds_ready;
+
+  n_fds_ready = epoll_wait (ap->epoll_fd, &e, 1, clib_max (1, timeout * 1e3));
+
+  if (n_fds_ready <= 0)
+    return 0;
+
+  /* Drain the eventfd counter, all kicks so far are handled */
+  if (read (ap->wakeup_fd, &count, sizeof (count)) < 0 && errno != EAGAIN)
+    clib_unix_warning ("read");
+
+  return 1;
+}
+
+void
+vlib_worker_wakeup_sleeping (vlib_main_t * vm)
+{
+  u64 one = 1;
+
+  if (write (vm->adaptive_poll.wakeup_fd, &one, sizeof (one)) < 0
+      && errno != EAGAIN)
+    clib_unix_warning ("write");
+}
+
 #endif /* HAVE_LINUX_EPOLL */
 
 static clib_error_t *
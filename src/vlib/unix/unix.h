@@ -125,6 +125,10 @@ int vlib_unix_main (int argc, char *argv[]);
 
 clib_error_t *unix_physmem_init (vlib_main_t * vm);
 
+/* Adaptive polling: per-worker epoll set and wakeup eventfd */
+clib_error_t *linux_epoll_worker_init (vlib_main_t * vm);
+int linux_epoll_worker_sleep (vlib_main_t * vm, f64 timeout);
+
 /* Set prompt for CLI. */
 void vlib_unix_cli_set_prompt (char *prompt);
 
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Messages/sec through a unix shared memory queue between two processes.
+ * The queue is allocated in a shared mapping, then the process forks into
+ * a producer and a consumer that checks message order.
+ *
+ * test_shm_queue [mutex | spsc | evtfd] [msgs <n>] [qlen <n>] [elsize <n>]
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/eventfd.h>
+#include <vppinfra/mem.h>
+#include <vppinfra/mheap.h>
+#include <vppinfra/time.h>
+#include <vppinfra/format.h>
+#include <vppinfra/error.h>
+#include <vlibmemory/unix_shared_memory_queue.h>
+
+typedef enum
+{
+  QUEUE_TEST_MUTEX,
+  QUEUE_TEST_SPSC,
+  QUEUE_TEST_EVTFD,
+} queue_test_mode_t;
+
+static char *queue_test_mode_str[] = { "mutex", "spsc", "spsc + eventfd" };
+
+static void
+consumer (unix_shared_memory_queue_t * q, u64 n_msgs, u8 * elt)
+{
+  u64 i, seq;
+
+  for (i = 0; i < n_msgs; i++)
+    {
+      unix_shared_memory_queue_sub (q, elt, 0 /* wait */ );
+      clib_memcpy (&seq, elt, sizeof (seq));
+      if (seq != i)
+	{
+	  fformat (stderr, "consumer: got msg %llu, expected %llu\n", seq, i);
+	  exit (1);
+	}
+    }
+  exit (0);
+}
+
+static clib_error_t *
+test_shm_queue (unformat_input_t * input)
+{
+  queue_test_mode_t mode = QUEUE_TEST_SPSC;
+  u32 qlen = 1024, elsize = sizeof (uword);
+  u64 i, n_msgs = 10 << 20;
+  uword heap_size;
+  unix_shared_memory_queue_t *q;
+  void *shm, *shm_heap, *oldheap;
+  clib_time_t ct;
+  f64 start, elapsed;
+  int status;
+  pid_t pid;
+  u8 *elt;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "mutex"))
+	mode = QUEUE_TEST_MUTEX;
+      else if (unformat (input, "spsc"))
+	mode = QUEUE_TEST_SPSC;
+      else if (unformat (input, "evtfd"))
+	mode = QUEUE_TEST_EVTFD;
+      else if (unformat (input, "msgs %llu", &n_msgs))
+	;
+      else if (unformat (input, "qlen %u", &qlen))
+	;
+      else if (unformat (input, "elsize %u", &elsize))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (elsize < sizeof (u64))
+    return clib_error_return (0, "elsize must be at least %u",
+			      sizeof (u64));
+
+  heap_size = ((uword) qlen * elsize) + (1 << 20);
+  shm = mmap (0, heap_size, PROT_READ | PROT_WRITE,
+	      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shm == MAP_FAILED)
+    return clib_error_return_unix (0, "mmap");
+
+  shm_heap = mheap_alloc (shm, heap_size);
+  oldheap = clib_mem_set_heap (shm_heap);
+  if (mode == QUEUE_TEST_MUTEX)
+    q = unix_shared_memory_queue_init (qlen, elsize, 0, 0);
+  else
+    q = unix_shared_memory_queue_init_spsc (qlen, elsize);
+  clib_mem_set_heap (oldheap);
+
+  /* Inherited across fork, so the fd number is the same in both */
+  if (mode == QUEUE_TEST_EVTFD)
+    {
+      int fd = eventfd (0, 0);
+      if (fd < 0)
+	return clib_error_return_unix (0, "eventfd");
+      unix_shared_memory_queue_set_consumer_evtfd (q, fd);
+    }
+
+  elt = clib_mem_alloc (elsize);
+  memset (elt, 0, elsize);
+
+  clib_time_init (&ct);
+  start = clib_time_now (&ct);
+
+  pid = fork ();
+  if (pid < 0)
+    return clib_error_return_unix (0, "fork");
+  if (pid == 0)
+    consumer (q, n_msgs, elt);
+
+  for (i = 0; i < n_msgs; i++)
+    {
+      clib_memcpy (elt, &i, sizeof (i));
+      unix_shared_memory_queue_add (q, elt, 0 /* wait */ );
+    }
+
+  if (waitpid (pid, &status, 0) < 0)
+    return clib_error_return_unix (0, "waitpid");
+  elapsed = clib_time_now (&ct) - start;
+
+  if (!WIFEXITED (status) || WEXITSTATUS (status))
+    return clib_error_return (0, "consumer failed");
+
+  fformat (stdout, "%s: %llu msgs of %u bytes, qlen %u, in %.3f s, "
+	   "%.2f Mmsgs/s\n", queue_test_mode_str[mode], n_msgs, elsize,
+	   qlen, elapsed, n_msgs / elapsed / 1e6);
+
+  clib_mem_free (elt);
+  munmap (shm, heap_size);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unformat_input_t i;
+  clib_error_t *error;
+
+  clib_mem_init (0, 64 << 20);
+  unformat_init_command_line (&i, argv);
+  error = test_shm_queue (&i);
+  unformat_free (&i);
+
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -26,6 +26,9 @@
 #include <vppinfra/cache.h>
 #include <vlibmemory/unix_shared_memory_queue.h>
 #include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 /*
  * unix_shared_memory_queue_init
@@ -63,6 +66,7 @@ unix_shared_memory_queue_init (int nels,
   q->maxsize = nels;
   q->consumer_pid = consumer_pid;
   q->signal_when_queue_non_empty = signal_when_queue_non_empty;
+  q->consumer_evtfd = -1;
 
   memset (&attr, 0, sizeof (attr));
   memset (&cattr, 0, sizeof (cattr));
@@ -88,6 +92,149 @@ unix_shared_memory_queue_init (int nels,
   return (q);
 }
 
+/*
+ * unix_shared_memory_queue_init_spsc
+ *
+ * Lock-free variant for queues with exactly one producer and one
+ * consumer thread, e.g., an app event queue fed by a single vpp thread.
+ * The producer owns tail, the consumer head, and cursize is updated
+ * atomically, so neither side takes the mutex. A side that has to wait
+ * sleeps on a futex on cursize, which works across processes without
+ * any setup, or, for the consumer, reads an eventfd if one is set.
+ *
+ * The usual add/sub calls work on it. lock/unlock still serialize
+ * producers that share it by convention, but the consumer ignores them.
+ */
+unix_shared_memory_queue_t *
+unix_shared_memory_queue_init_spsc (int nels, int elsize)
+{
+  unix_shared_memory_queue_t *q;
+
+  q = unix_shared_memory_queue_init (nels, elsize, 0 /* consumer pid */ ,
+				     0 /* signal when queue non-empty */ );
+  q->is_spsc = 1;
+  return q;
+}
+
+/*
+ * unix_shared_memory_queue_set_consumer_evtfd
+ *
+ * Have the producer wake the consumer through an eventfd, e.g., one the
+ * consumer polls on together with its other fds. The fd number is used
+ * by the producer, so both need to share it, i.e., run in the same
+ * process or have inherited it.
+ */
+void
+unix_shared_memory_queue_set_consumer_evtfd (unix_shared_memory_queue_t * q,
+					     int fd)
+{
+  q->consumer_evtfd = fd;
+}
+
+/*
+ * Sleep while cursize is busy_val, i.e., empty for the consumer and
+ * full for the producer. The other side clears *waiting and wakes us.
+ */
+static void
+unix_shared_memory_queue_spsc_wait (unix_shared_memory_queue_t * q,
+				    volatile int *waiting, int busy_val,
+				    int evtfd)
+{
+  u64 cnt;
+
+  while (q->cursize == busy_val)
+    {
+      *waiting = 1;
+      /* Order the flag before the check, the other side does the reverse */
+      CLIB_MEMORY_BARRIER ();
+      if (q->cursize != busy_val)
+	break;
+      if (evtfd >= 0)
+	(void) read (evtfd, &cnt, sizeof (cnt));
+      else
+	syscall (SYS_futex, &q->cursize, FUTEX_WAIT, busy_val, 0, 0, 0);
+    }
+  *waiting = 0;
+}
+
+static inline void
+unix_shared_memory_queue_spsc_wake (unix_shared_memory_queue_t * q,
+				    volatile int *waiting, int evtfd)
+{
+  u64 one = 1;
+
+  if (PREDICT_TRUE (!*waiting))
+    return;
+
+  *waiting = 0;
+  if (evtfd >= 0)
+    (void) write (evtfd, &one, sizeof (one));
+  else
+    syscall (SYS_futex, &q->cursize, FUTEX_WAKE, 1, 0, 0, 0);
+}
+
+static int
+unix_shared_memory_queue_add_spsc (unix_shared_memory_queue_t * q,
+				   u8 * elem, int nowait)
+{
+  i8 *tailp;
+  int cursize;
+
+  if (PREDICT_FALSE (q->cursize == q->maxsize))
+    {
+      if (nowait)
+	return (-2);
+      unix_shared_memory_queue_spsc_wait (q, &q->producer_waiting,
+					  q->maxsize, -1);
+    }
+
+  tailp = (i8 *) (&q->data[0] + q->elsize * q->tail);
+  clib_memcpy (tailp, elem, q->elsize);
+
+  q->tail++;
+  if (q->tail == q->maxsize)
+    q->tail = 0;
+
+  /* Full barrier, publishes the element before the new size */
+  cursize = __sync_fetch_and_add (&q->cursize, 1);
+
+  unix_shared_memory_queue_spsc_wake (q, &q->consumer_waiting,
+				      q->consumer_evtfd);
+  if (cursize == 0 && q->signal_when_queue_non_empty)
+    kill (q->consumer_pid, q->signal_when_queue_non_empty);
+
+  return 0;
+}
+
+static int
+unix_shared_memory_queue_sub_spsc (unix_shared_memory_queue_t * q,
+				   u8 * elem, int nowait)
+{
+  i8 *headp;
+
+  if (PREDICT_FALSE (q->cursize == 0))
+    {
+      if (nowait)
+	return (-2);
+      unix_shared_memory_queue_spsc_wait (q, &q->consumer_waiting, 0,
+					  q->consumer_evtfd);
+    }
+
+  headp = (i8 *) (&q->data[0] + q->elsize * q->head);
+  clib_memcpy (elem, headp, q->elsize);
+
+  q->head++;
+  if (q->head == q->maxsize)
+    q->head = 0;
+
+  /* Full barrier, the slot is free only once we're done reading it */
+  __sync_fetch_and_sub (&q->cursize, 1);
+
+  unix_shared_memory_queue_spsc_wake (q, &q->producer_waiting, -1);
+
+  return 0;
+}
+
 /*
  * unix_shared_memory_queue_free
  */
@@ -127,6 +274,9 @@ unix_shared_memory_queue_add_nolock (unix_shared_memory_queue_t * q,
   i8 *tailp;
   int need_broadcast = 0;
 
+  if (q->is_spsc)
+    return unix_shared_memory_queue_add_spsc (q, elem, 0 /* wait */ );
+
   if (PREDICT_FALSE (q->cursize == q->maxsize))
     {
       while (q->cursize == q->maxsize)
@@ -160,6 +310,9 @@ unix_shared_memory_queue_add_raw (unix_shared_memory_queue_t * q, u8 * elem)
 {
   i8 *tailp;
 
+  if (q->is_spsc)
+    return unix_shared_memory_queue_add_spsc (q, elem, 0 /* wait */ );
+
   if (PREDICT_FALSE (q->cursize == q->maxsize))
     {
       while (q->cursize == q->maxsize)
@@ -188,6 +341,9 @@ unix_shared_memory_queue_add (unix_shared_memory_queue_t * q,
   i8 *tailp;
   int need_broadcast = 0;
 
+  if (q->is_spsc)
+    return unix_shared_memory_queue_add_spsc (q, elem, nowait);
+
   if (nowait)
     {
       /* zero on success */
@@ -244,6 +400,15 @@ unix_shared_memory_queue_add2 (unix_shared_memory_queue_t * q, u8 * elem,
   i8 *tailp;
   int need_broadcast = 0;
 
+  if (q->is_spsc)
+    {
+      /* Only one producer, nobody can take the second slot */
+      if (nowait && q->cursize + 2 > q->maxsize)
+	return (-2);
+      unix_shared_memory_queue_add_spsc (q, elem, 0 /* wait */ );
+      return unix_shared_memory_queue_add_spsc (q, elem2, 0 /* wait */ );
+    }
+
   if (nowait)
     {
       /* zero on success */
@@ -309,6 +474,9 @@ unix_shared_memory_queue_sub (unix_shared_memory_queue_t * q,
   i8 *headp;
   int need_broadcast = 0;
 
+  if (q->is_spsc)
+    return unix_shared_memory_queue_sub_spsc (q, elem, nowait);
+
   if (nowait)
     {
       /* zero on success */
@@ -359,6 +527,9 @@ unix_shared_memory_queue_sub_raw (unix_shared_memory_queue_t * q, u8 * elem)
 {
   i8 *headp;
 
+  if (q->is_spsc)
+    return unix_shared_memory_queue_sub_spsc (q, elem, 0 /* wait */ );
+
   if (PREDICT_FALSE (q->cursize == 0))
     {
       while (q->cursize == 0)
@@ -33,6 +33,10 @@ typedef struct _unix_shared_memory_queue
   int elsize;
   int consumer_pid;
   int signal_when_queue_non_empty;
+  int is_spsc;			/* lock-free, one producer and one consumer */
+  int consumer_evtfd;		/* spsc: wakes consumer if >= 0, else futex */
+  volatile int consumer_waiting;	/* spsc: consumer sleeps until non-empty */
+  volatile int producer_waiting;	/* spsc: producer sleeps until not full */
   char data[0];
 } unix_shared_memory_queue_t;
 
@@ -41,6 +45,10 @@ unix_shared_memory_queue_t *unix_shared_memory_queue_init (int nels,
 							   int consumer_pid,
 							   int
 							   signal_when_queue_non_empty);
+unix_shared_memory_queue_t *unix_shared_memory_queue_init_spsc (int nels,
+								int elsize);
+void unix_shared_memory_queue_set_consumer_evtfd (unix_shared_memory_queue_t *
+						  q, int fd);
 void unix_shared_memory_queue_free (unix_shared_memory_queue_t * q);
 int unix_shared_memory_queue_add (unix_shared_memory_queue_t * q, u8 * elem,
 				  int nowait);
@@ -55,7 +55,8 @@
   _(10, OFFLOAD_IP_CKSUM)				\
   _(11, OFFLOAD_TCP_CKSUM)				\
   _(12, OFFLOAD_UDP_CKSUM)                              \
-  _(13, IS_NATED)
+  _(13, IS_NATED)					\
+  _(14, GSO)
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -327,6 +328,14 @@ STATIC_ASSERT (sizeof (vnet_buffer_opaque_t) <=
 /* Full cache line (64 bytes) of additional space */
 typedef struct
 {
+  /*
+   * VNET_BUFFER_F_GSO: a TCP packet larger than the MTU, to be sent as
+   * segments of gso_size payload bytes, each with a copy of its
+   * headers. l4_hdr_offset points to the TCP header.
+   */
+  u16 gso_size;
+  u16 gso_l4_hdr_sz;
+
   union
   {
 #if VLIB_BUFFER_TRACE_TRAJECTORY > 0
@@ -336,7 +345,7 @@ typedef struct
       u16 *trajectory_trace;
     };
 #endif
-    u32 unused[12];
+    u32 unused[11];
   };
 } vnet_buffer_opaque2_t;
 
@@ -350,6 +359,19 @@ STATIC_ASSERT (sizeof (vnet_buffer_opaque2_t) <=
 	       STRUCT_SIZE_OF (vlib_buffer_t, opaque2),
 	       "VNET buffer opaque2 meta-data too large for vlib_buffer");
 
+/*
+ * Length of the packet from the current data on, as far as MTU checks
+ * go: a GSO packet is checked for the size of its segments.
+ */
+always_inline u32
+vnet_buffer_mtu_length (vlib_main_t * vm, vlib_buffer_t * b)
+{
+  if (PREDICT_FALSE (b->flags & VNET_BUFFER_F_GSO))
+    return vnet_buffer (b)->l4_hdr_offset - b->current_data +
+      vnet_buffer2 (b)->gso_l4_hdr_sz + vnet_buffer2 (b)->gso_size;
+  return vlib_buffer_length_in_chain (vm, b);
+}
+
 
 #endif /* included_vnet_buffer_h */
 
@@ -24,6 +24,7 @@
 #include <vnet/api_errno.h>
 
 #include <vnet/classify/vnet_classify.h>
+#include <vnet/classify/vnet_classify_tss.h>
 #include <vnet/classify/input_acl.h>
 #include <vnet/classify/policer_classify.h>
 #include <vnet/classify/flow_classify.h>
@@ -50,6 +51,8 @@
 #define foreach_vpe_api_msg                                             \
 _(CLASSIFY_ADD_DEL_TABLE, classify_add_del_table)                       \
 _(CLASSIFY_ADD_DEL_SESSION, classify_add_del_session)                   \
+_(CLASSIFY_TSS_ADD_DEL_TABLE, classify_tss_add_del_table)               \
+_(CLASSIFY_TSS_ADD_DEL_RULE, classify_tss_add_del_rule)                 \
 _(CLASSIFY_TABLE_IDS,classify_table_ids)                                \
 _(CLASSIFY_TABLE_BY_INTERFACE, classify_table_by_interface)             \
 _(CLASSIFY_TABLE_INFO,classify_table_info)                              \
@@ -155,6 +158,57 @@ static void vl_api_classify_add_del_session_t_handler
   REPLY_MACRO (VL_API_CLASSIFY_ADD_DEL_SESSION_REPLY);
 }
 
+static void vl_api_classify_tss_add_del_table_t_handler
+  (vl_api_classify_tss_add_del_table_t * mp)
+{
+  vl_api_classify_tss_add_del_table_reply_t *rmp;
+  u32 table_index;
+  int rv;
+
+  table_index = ntohl (mp->table_index);
+
+  rv = vnet_classify_tss_add_del_table
+    (ntohl (mp->nbuckets), ntohl (mp->memory_size),
+     ntohl (mp->skip_n_vectors), ntohl (mp->match_n_vectors),
+     ntohl (mp->next_table_index), ntohl (mp->miss_next_index),
+     &table_index, mp->is_add);
+
+  /* *INDENT-OFF* */
+  REPLY_MACRO2(VL_API_CLASSIFY_TSS_ADD_DEL_TABLE_REPLY,
+  ({
+    rmp->new_table_index = (rv == 0 && mp->is_add) ? ntohl (table_index) : ~0;
+  }));
+  /* *INDENT-ON* */
+}
+
+static void vl_api_classify_tss_add_del_rule_t_handler
+  (vl_api_classify_tss_add_del_rule_t * mp)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vl_api_classify_tss_add_del_rule_reply_t *rmp;
+  vnet_classify_table_t *t;
+  u32 table_index;
+  int rv;
+
+  table_index = ntohl (mp->table_index);
+
+  if (pool_is_free_index (cm->tables, table_index))
+    {
+      rv = VNET_API_ERROR_NO_SUCH_TABLE;
+      goto out;
+    }
+  t = pool_elt_at_index (cm->tables, table_index);
+
+  /* The match follows the mask */
+  rv = vnet_classify_tss_table_add_del_rule
+    (table_index, mp->mask_and_match,
+     mp->mask_and_match + t->match_n_vectors * sizeof (u32x4),
+     ntohl (mp->rule_index), ntohl (mp->hit_next_index), mp->is_add);
+
+out:
+  REPLY_MACRO (VL_API_CLASSIFY_TSS_ADD_DEL_RULE_REPLY);
+}
+
 static void
   vl_api_policer_classify_set_interface_t_handler
   (vl_api_policer_classify_set_interface_t * mp)
@@ -15,6 +15,7 @@
 #include <vnet/ip/ip.h>
 #include <vnet/ethernet/ethernet.h>	/* for ethernet_header_t */
 #include <vnet/classify/vnet_classify.h>
+#include <vnet/classify/vnet_classify_tss.h>
 #include <vnet/dpo/classify_dpo.h>
 
 typedef struct {
@@ -65,6 +66,7 @@ ip_classify_inline (vlib_main_t * vm,
   ip_lookup_next_t next_index;
   vnet_classify_main_t * vcm = &vnet_classify_main;
   f64 now = vlib_time_now (vm);
+  u32 thread_index = vlib_get_thread_index ();
   u32 hits = 0;
   u32 misses = 0;
   u32 chain_hits = 0;
@@ -235,8 +237,12 @@ ip_classify_inline (vlib_main_t * vm,
               hash0 = vnet_buffer(b0)->l2_classify.hash;
               t0 = pool_elt_at_index (vcm->tables, table_index0);
 
-              e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0,
-                                             now);
+              if (PREDICT_FALSE (t0->tss_index != ~0))
+                e0 = vnet_classify_tss_table_find_entry (t0, (u8 *) h0,
+                                                         thread_index, now);
+              else
+                e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0,
+                                               now);
               if (e0)
                 {
                   vnet_buffer(b0)->l2_classify.opaque_index
@@ -261,9 +267,15 @@ ip_classify_inline (vlib_main_t * vm,
                           break;
                         }
 
-                      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-                      e0 = vnet_classify_find_entry
-                        (t0, (u8 *) h0, hash0, now);
+                      if (PREDICT_FALSE (t0->tss_index != ~0))
+                        e0 = vnet_classify_tss_table_find_entry
+                          (t0, (u8 *) h0, thread_index, now);
+                      else
+                        {
+                          hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
+                          e0 = vnet_classify_find_entry
+                            (t0, (u8 *) h0, hash0, now);
+                        }
                       if (e0)
                         {
                           vnet_buffer(b0)->l2_classify.opaque_index
@@ -286,7 +298,11 @@ ip_classify_inline (vlib_main_t * vm,
                 vlib_add_trace (vm, node, b0, sizeof (*t));
               t->next_index = next0;
               t->table_index = t0 ? t0 - vcm->tables : ~0;
-              t->entry_index = e0 ? e0 - t0->entries : ~0;
+              /* The rule index, for tss tables */
+              if (e0 && t0->tss_index != ~0)
+                t->entry_index = e0->opaque_index;
+              else
+                t->entry_index = e0 ? e0 - t0->entries : ~0;
             }
 
           /* verify speculative enqueue, maybe switch current next frame */
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include <vnet/classify/vnet_classify.h>
+#include <vnet/classify/vnet_classify_tss.h>
 #include <vnet/classify/input_acl.h>
 #include <vnet/ip/ip.h>
 #include <vnet/api_errno.h>     /* for API error numbers */
@@ -122,6 +123,7 @@ vnet_classify_new_table (vnet_classify_main_t *cm,
   clib_memcpy (t->mask, mask, match_n_vectors * sizeof (u32x4));
 
   t->next_table_index = ~0;
+  t->tss_index = ~0;
   t->nbuckets = nbuckets;
   t->log2_nbuckets = max_log2 (nbuckets);
   t->match_n_vectors = match_n_vectors;
@@ -155,6 +157,9 @@ void vnet_classify_delete_table_index (vnet_classify_main_t *cm,
     /* Recursively delete the entire chain */
     vnet_classify_delete_table_index (cm, t->next_table_index, del_chain);
 
+  if (t->tss_index != ~0)
+    vnet_classify_tss_table_free (t);
+
   vec_free (t->mask);
   vec_free (t->buckets);
   mheap_free (t->mheap);
@@ -1466,6 +1471,7 @@ classify_table_command_fn (vlib_main_t * vm,
   u32 tmp;
   u32 current_data_flag = 0;
   int current_data_offset = 0;
+  int is_tss = 0;
 
   u8 * mask = 0;
   vnet_classify_main_t * cm = &vnet_classify_main;
@@ -1474,6 +1480,8 @@ classify_table_command_fn (vlib_main_t * vm,
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT) {
     if (unformat (input, "del"))
       is_add = 0;
+    else if (unformat (input, "tss"))
+      is_tss = 1;
     else if (unformat (input, "del-chain"))
       {
 	is_add = 0;
@@ -1517,9 +1525,13 @@ classify_table_command_fn (vlib_main_t * vm,
       break;
   }
   
-  if (is_add && mask == 0 && table_index == ~0)
+  if (is_add && mask == 0 && table_index == ~0 && !is_tss)
     return clib_error_return (0, "Mask required");
 
+  /* Rules carry their own masks */
+  if (is_tss && mask)
+    return clib_error_return (0, "No mask for a tss table");
+
   if (is_add && skip == ~0 && table_index == ~0)
     return clib_error_return (0, "skip count required");
 
@@ -1529,9 +1541,14 @@ classify_table_command_fn (vlib_main_t * vm,
   if (!is_add && table_index == ~0)
     return clib_error_return (0, "table index required for delete");
 
-  rv = vnet_classify_add_del_table (cm, mask, nbuckets, memory_size,
-        skip, match, next_table_index, miss_next_index, &table_index,
-	current_data_flag, current_data_offset, is_add, del_chain);
+  if (is_tss)
+    rv = vnet_classify_tss_add_del_table (nbuckets, memory_size, skip, match,
+                                          next_table_index, miss_next_index,
+                                          &table_index, is_add);
+  else
+    rv = vnet_classify_add_del_table (cm, mask, nbuckets, memory_size,
+          skip, match, next_table_index, miss_next_index, &table_index,
+	  current_data_flag, current_data_offset, is_add, del_chain);
   switch (rv)
     {
     case 0:
@@ -1551,7 +1568,9 @@ VLIB_CLI_COMMAND (classify_table, static) = {
   "\n mask <mask-value> buckets <nn> [skip <n>] [match <n>]"
   "\n [current-data-flag <n>] [current-data-offset <n>] [table <n>]"
   "\n [memory-size <nn>[M][G]] [next-table <n>]"
-  "\n [del] [del-chain]",
+  "\n [del] [del-chain]"
+  "\n or, for a tuple space search table:"
+  "\n classify table tss skip <n> match <n> buckets <nn> [miss-next <n>]",
   .function = classify_table_command_fn,
 };
 
@@ -1582,6 +1601,10 @@ static u8 * format_vnet_classify_table (u8 * s, va_list * args)
               t->match_n_vectors * sizeof (u32x4));
   s = format (s, "\n  linear-search buckets %d\n", t->linear_buckets);
 
+  if (t->tss_index != ~0)
+    s = format (s, "  tuple space search %U\n", format_vnet_classify_tss,
+                t->tss_index, verbose);
+
   if (verbose == 0)
     return s;
 
@@ -2091,6 +2114,10 @@ int vnet_classify_add_del_session (vnet_classify_main_t * cm,
     return VNET_API_ERROR_NO_SUCH_TABLE;
   
   t = pool_elt_at_index (cm->tables, table_index);
+
+  /* Each rule of a tss mode table has its own mask */
+  if (t->tss_index != ~0)
+    return VNET_API_ERROR_INVALID_VALUE;
   
   e = (vnet_classify_entry_t *)&_max_e;
   e->next_index = hit_next_index;
@@ -2141,6 +2168,9 @@ classify_session_command_fn (vlib_main_t * vm,
   u32 hit_next_index = ~0;
   u64 opaque_index = ~0;
   u8 * match = 0;
+  u8 * mask = 0;
+  u32 skip = ~0, match_n = ~0;
+  u32 rule_index = ~0;
   i32 advance = 0;
   u32 action = 0;
   u32 metadata = 0;
@@ -2170,6 +2200,11 @@ classify_session_command_fn (vlib_main_t * vm,
       else if (unformat (input, "match %U", unformat_classify_match,
                          cm, &match, table_index))
         ;
+      else if (unformat (input, "mask %U", unformat_classify_mask,
+                         &mask, &skip, &match_n))
+        ;
+      else if (unformat (input, "rule %d", &rule_index))
+        ;
       else if (unformat (input, "advance %d", &advance))
         ;
       else if (unformat (input, "table-index %d", &table_index))
@@ -2201,10 +2236,40 @@ classify_session_command_fn (vlib_main_t * vm,
   if (is_add && match == 0)
     return clib_error_return (0, "Match value required");
 
-  rv = vnet_classify_add_del_session (cm, table_index, match, 
-                                      hit_next_index,
-                                      opaque_index, advance,
-                                      action, metadata, is_add);
+  if (mask || rule_index != ~0)
+    {
+      vnet_classify_table_t * t;
+      u8 * tss_mask = 0;
+
+      if (pool_is_free_index (cm->tables, table_index))
+        return clib_error_return (0, "No such table %d", table_index);
+      t = pool_elt_at_index (cm->tables, table_index);
+
+      if (t->tss_index == ~0)
+        return clib_error_return (0, "Table %d is not a tss table",
+                                  table_index);
+      if (mask == 0 || match == 0 || rule_index == ~0)
+        return clib_error_return (0, "Mask, match and rule index required");
+
+      /* Place the rule's mask within the table's match vectors */
+      if (skip < t->skip_n_vectors
+          || skip + match_n > t->skip_n_vectors + t->match_n_vectors)
+        return clib_error_return (0, "Mask outside the table's vectors");
+      vec_validate (tss_mask, t->match_n_vectors * sizeof (u32x4) - 1);
+      clib_memcpy (tss_mask + (skip - t->skip_n_vectors) * sizeof (u32x4),
+                   mask, match_n * sizeof (u32x4));
+
+      rv = vnet_classify_tss_table_add_del_rule (table_index, tss_mask,
+                                                 match, rule_index,
+                                                 hit_next_index, is_add);
+      vec_free (tss_mask);
+      vec_free (mask);
+    }
+  else
+    rv = vnet_classify_add_del_session (cm, table_index, match, 
+                                        hit_next_index,
+                                        opaque_index, advance,
+                                        action, metadata, is_add);
 
   switch(rv)
     {
@@ -2225,7 +2290,10 @@ VLIB_CLI_COMMAND (classify_session_command, static) = {
     "classify session [hit-next|l2-hit-next|"
     "acl-hit-next <next_index>|policer-hit-next <policer_name>]"
     "\n table-index <nn> match [hex] [l2] [l3 ip4] [opaque-index <index>]"
-    "\n [action set-ip4-fib-id|set-ip6-fib-id|set-sr-policy-index <n>] [del]",
+    "\n [action set-ip4-fib-id|set-ip6-fib-id|set-sr-policy-index <n>] [del]"
+    "\n or, for a tss table:"
+    "\n classify session hit-next <next_index> table-index <nn>"
+    "\n mask <mask-value> match <match-value> rule <n> [del]",
     .function = classify_session_command_fn,
 };
 
@@ -167,6 +167,9 @@ typedef struct {
   
   /* Miss next index, return if next_table_index = 0 */
   u32 miss_next_index;
+
+  /* Tuple space search set holding the rules of a tss mode table, else ~0 */
+  u32 tss_index;
   
   /* Per-bucket working copies, one per thread */
   vnet_classify_entry_t ** working_copies;
@@ -483,6 +486,9 @@ vnet_classify_new_table (vnet_classify_main_t *cm,
                          u32 skip_n_vectors,
                          u32 match_n_vectors);
 
+void vnet_classify_delete_table_index (vnet_classify_main_t *cm,
+                                       u32 table_index, int del_chain);
+
 int vnet_classify_add_del_session (vnet_classify_main_t * cm, 
                                    u32 table_index, 
                                    u8 * match, 
@@ -0,0 +1,1147 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/classify/vnet_classify_tss.h>
+#include <vnet/udp/udp_packet.h>
+#include <vlib/threads.h>
+
+vnet_classify_tss_main_t vnet_classify_tss_main;
+
+/* Seconds between hit rate reorders */
+#define TSS_REORDER_INTERVAL 1.0
+
+/* Packets looked up together by the batch lookup */
+#define TSS_LOOKUP_BATCH 16
+
+static void
+tss_rebuild_tuple_by_mask (vnet_classify_tss_t * tss)
+{
+  vnet_classify_tss_tuple_t *tp;
+
+  hash_free (tss->tuple_by_mask);
+  tss->tuple_by_mask = hash_create_mem (0, tss->match_n_vectors
+					* sizeof (u32x4), sizeof (uword));
+  vec_foreach (tp, tss->tuples)
+    hash_set_mem (tss->tuple_by_mask, tp->mask, tp - tss->tuples);
+}
+
+static void
+tss_tuple_free (vnet_classify_tss_tuple_t * tp)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  hash_pair_t *hp;
+  u64 *shadowed;
+  u8 *key;
+
+  vnet_classify_delete_table_index (cm, tp->table_index, 0 /* del_chain */ );
+  vec_free (tp->mask);
+
+  /* *INDENT-OFF* */
+  hash_foreach_pair (hp, tp->shadowed, ({
+    key = uword_to_pointer (hp->key, u8 *);
+    shadowed = uword_to_pointer (hp->value[0], u64 *);
+    vec_free (key);
+    vec_free (shadowed);
+  }));
+  /* *INDENT-ON* */
+  hash_free (tp->shadowed);
+}
+
+int
+vnet_classify_tss_create (u32 skip_n_vectors, u32 match_n_vectors,
+			  u32 nbuckets, u32 memory_size, u32 * tss_index)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vlib_thread_main_t *vtm = vlib_get_thread_main ();
+  vnet_classify_tss_t *tss;
+
+  if (match_n_vectors < 1 || match_n_vectors > 5)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  pool_get (tm->sets, tss);
+  memset (tss, 0, sizeof (*tss));
+
+  tss->skip_n_vectors = skip_n_vectors;
+  tss->match_n_vectors = match_n_vectors;
+  tss->nbuckets = nbuckets;
+  tss->memory_size = memory_size;
+  tss->table_index = ~0;
+  vec_validate (tss->hits_by_thread, vtm->n_vlib_mains - 1);
+  tss_rebuild_tuple_by_mask (tss);
+
+  *tss_index = tss - tm->sets;
+  return 0;
+}
+
+int
+vnet_classify_tss_delete (u32 tss_index)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_tss_tuple_t *tp;
+  vnet_classify_tss_t *tss;
+  u64 **hits;
+
+  if (pool_is_free_index (tm->sets, tss_index))
+    return VNET_API_ERROR_NO_SUCH_TABLE;
+
+  tss = pool_elt_at_index (tm->sets, tss_index);
+
+  /* Goes with its table */
+  if (tss->table_index != ~0)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  vec_foreach (tp, tss->tuples) tss_tuple_free (tp);
+  vec_foreach (hits, tss->hits_by_thread) vec_free (hits[0]);
+
+  vec_free (tss->tuples);
+  vec_free (tss->hits_by_thread);
+  hash_free (tss->tuple_by_mask);
+  pool_put (tm->sets, tss);
+  return 0;
+}
+
+static void
+tss_tuple_del (vnet_classify_tss_t * tss, u32 index)
+{
+  u64 **hits;
+
+  tss_tuple_free (vec_elt_at_index (tss->tuples, index));
+
+  vec_delete (tss->tuples, 1, index);
+  vec_foreach (hits, tss->hits_by_thread) vec_delete (hits[0], 1, index);
+
+  /* Positions after index moved down */
+  tss_rebuild_tuple_by_mask (tss);
+}
+
+/**
+ * Rules shadowed by the rule holding the session with masked key key
+ */
+static u64 *
+tss_shadowed_get (vnet_classify_tss_tuple_t * tp, u8 * key)
+{
+  uword *p = hash_get_mem (tp->shadowed, key);
+  return p ? uword_to_pointer (p[0], u64 *) : 0;
+}
+
+static void
+tss_shadowed_set (vnet_classify_tss_t * tss, vnet_classify_tss_tuple_t * tp,
+		  u8 * key, u64 * shadowed)
+{
+  hash_pair_t *hp;
+  u8 *key_copy;
+
+  hp = hash_get_pair_mem (tp->shadowed, key);
+  if (hp && vec_len (shadowed))
+    hp->value[0] = pointer_to_uword (shadowed);
+  else if (hp)
+    {
+      key_copy = uword_to_pointer (hp->key, u8 *);
+      hash_unset_mem (tp->shadowed, key);
+      vec_free (key_copy);
+      vec_free (shadowed);
+    }
+  else if (vec_len (shadowed))
+    {
+      key_copy = 0;
+      vec_add (key_copy, key, tss->match_n_vectors * sizeof (u32x4));
+      hash_set_mem (tp->shadowed, key_copy, pointer_to_uword (shadowed));
+    }
+}
+
+/**
+ * Add or delete a rule. mask is match_n_vectors u32x4s, match includes the
+ * skipped vectors, as for classify tables and sessions. The first rule to
+ * use a mask creates its tuple, the last one to go deletes it.
+ *
+ * Only the earliest of the rules with the same mask and match can hit, so
+ * only it gets a session. The others are kept, in rule order, and the next
+ * one takes over the session when it's deleted.
+ */
+int
+vnet_classify_tss_add_del_rule (u32 tss_index, u8 * mask, u8 * match,
+				u32 rule_index, u32 hit_next_index,
+				int is_add)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  u8 key[5 * sizeof (u32x4)];
+  vnet_classify_tss_tuple_t *tp;
+  vnet_classify_entry_t *e;
+  vnet_classify_table_t *t;
+  vnet_classify_tss_t *tss;
+  u64 **hits, *shadowed, rule;
+  u32 index, mask_len, i;
+  uword *p;
+  int rv;
+
+  if (pool_is_free_index (tm->sets, tss_index))
+    return VNET_API_ERROR_NO_SUCH_TABLE;
+
+  tss = pool_elt_at_index (tm->sets, tss_index);
+  mask_len = tss->match_n_vectors * sizeof (u32x4);
+
+  p = hash_get_mem (tss->tuple_by_mask, mask);
+  if (p)
+    index = p[0];
+  else
+    {
+      if (!is_add)
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+      t = vnet_classify_new_table (cm, mask, tss->nbuckets,
+				   tss->memory_size, tss->skip_n_vectors,
+				   tss->match_n_vectors);
+      t->miss_next_index = ~0;
+
+      index = vec_len (tss->tuples);
+      vec_add2 (tss->tuples, tp, 1);
+      tp->table_index = t - cm->tables;
+      tp->min_rule_index = ~0;
+      vec_validate (tp->mask, mask_len - 1);
+      clib_memcpy (tp->mask, mask, mask_len);
+      tp->shadowed = hash_create_mem (0, mask_len, sizeof (uword));
+      vec_foreach (hits, tss->hits_by_thread) vec_validate (hits[0], index);
+      hash_set_mem (tss->tuple_by_mask, tp->mask, index);
+    }
+
+  tp = vec_elt_at_index (tss->tuples, index);
+  t = pool_elt_at_index (cm->tables, tp->table_index);
+  e = vnet_classify_find_entry (t, match, vnet_classify_hash_packet (t, match),
+				0 /* now */ );
+  if (!e && !is_add)
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  /* Entries move when buckets split, keep the key */
+  shadowed = 0;
+  if (e)
+    {
+      clib_memcpy (key, e->key, mask_len);
+      shadowed = tss_shadowed_get (tp, key);
+    }
+
+  if (e && e->opaque_index != rule_index)
+    {
+      /* Earlier rule in the session, keep this one aside in order. A new
+       * earlier rule takes the session and keeps the old one aside */
+      if (is_add && e->opaque_index < rule_index)
+	rule = (u64) rule_index << 32 | hit_next_index;
+      else if (is_add)
+	rule = (u64) e->opaque_index << 32 | e->next_index;
+      else
+	rule = (u64) rule_index << 32;
+
+      for (i = 0; i < vec_len (shadowed); i++)
+	if (shadowed[i] >> 32 >= rule >> 32)
+	  break;
+
+      if (!is_add)
+	{
+	  if (i == vec_len (shadowed) || shadowed[i] >> 32 != rule_index)
+	    return VNET_API_ERROR_NO_SUCH_ENTRY;
+	  vec_delete (shadowed, 1, i);
+	  tss_shadowed_set (tss, tp, key, shadowed);
+	  return 0;
+	}
+
+      if (i < vec_len (shadowed) && shadowed[i] >> 32 == rule >> 32)
+	shadowed[i] = rule;
+      else
+	vec_insert_elts (shadowed, &rule, 1, i);
+      tss_shadowed_set (tss, tp, key, shadowed);
+
+      if (e->opaque_index < rule_index)
+	return 0;
+    }
+  else if (!is_add && vec_len (shadowed))
+    {
+      /* The first rule kept aside takes over */
+      rule_index = shadowed[0] >> 32;
+      hit_next_index = (u32) shadowed[0];
+      vec_delete (shadowed, 1, 0);
+      tss_shadowed_set (tss, tp, key, shadowed);
+      is_add = 1;
+    }
+
+  rv = vnet_classify_add_del_session (cm, tp->table_index, match,
+				      hit_next_index, rule_index,
+				      0 /* advance */ , 0 /* action */ ,
+				      0 /* metadata */ , is_add);
+  if (!rv && is_add)
+    tp->min_rule_index = clib_min (tp->min_rule_index, rule_index);
+
+  t = pool_elt_at_index (cm->tables, tp->table_index);
+  if (t->active_elements == 0)
+    tss_tuple_del (tss, index);
+
+  return rv;
+}
+
+typedef struct
+{
+  u64 hits;
+  u32 min_rule_index;
+  u32 index;
+} tss_tuple_rank_t;
+
+static int
+tss_tuple_rank_cmp (void *a1, void *a2)
+{
+  tss_tuple_rank_t *r1 = a1, *r2 = a2;
+
+  if (r1->hits != r2->hits)
+    return r1->hits > r2->hits ? -1 : 1;
+  /* Same rate, earlier rules first so they prune more */
+  if (r1->min_rule_index != r2->min_rule_index)
+    return r1->min_rule_index < r2->min_rule_index ? -1 : 1;
+  return (i32) r1->index - (i32) r2->index;
+}
+
+/**
+ * Sort tuples by hits since the last reorder, then halve the counters so
+ * the order follows recent traffic. Workers are only stopped if the order
+ * actually changes. Returns 1 if it did.
+ */
+int
+vnet_classify_tss_reorder (u32 tss_index)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vlib_main_t *vm = vlib_get_main ();
+  vnet_classify_tss_tuple_t *tuples = 0;
+  tss_tuple_rank_t *ranks = 0, *r;
+  vnet_classify_tss_t *tss;
+  u64 **hits, *new_hits;
+  u32 i, n_tuples;
+  int changed = 0;
+
+  if (pool_is_free_index (tm->sets, tss_index))
+    return 0;
+
+  tss = pool_elt_at_index (tm->sets, tss_index);
+  n_tuples = vec_len (tss->tuples);
+  if (n_tuples < 2)
+    goto decay;
+
+  vec_validate (ranks, n_tuples - 1);
+  for (i = 0; i < n_tuples; i++)
+    {
+      r = vec_elt_at_index (ranks, i);
+      r->index = i;
+      r->min_rule_index = tss->tuples[i].min_rule_index;
+      vec_foreach (hits, tss->hits_by_thread) r->hits += hits[0][i];
+    }
+  vec_sort_with_function (ranks, tss_tuple_rank_cmp);
+
+  for (i = 0; i < n_tuples; i++)
+    if (ranks[i].index != i)
+      changed = 1;
+
+  if (changed)
+    {
+      vlib_worker_thread_barrier_sync (vm);
+
+      vec_validate (tuples, n_tuples - 1);
+      for (i = 0; i < n_tuples; i++)
+	tuples[i] = tss->tuples[ranks[i].index];
+      vec_free (tss->tuples);
+      tss->tuples = tuples;
+
+      vec_foreach (hits, tss->hits_by_thread)
+      {
+	new_hits = 0;
+	vec_validate (new_hits, n_tuples - 1);
+	for (i = 0; i < n_tuples; i++)
+	  new_hits[i] = hits[0][ranks[i].index];
+	vec_free (hits[0]);
+	hits[0] = new_hits;
+      }
+
+      tss_rebuild_tuple_by_mask (tss);
+      tss->n_reorders++;
+
+      vlib_worker_thread_barrier_release (vm);
+    }
+
+  vec_free (ranks);
+
+decay:
+  /* Racy with the workers, but these are only statistics */
+  vec_foreach (hits, tss->hits_by_thread)
+    for (i = 0; i < vec_len (hits[0]); i++)
+    hits[0][i] >>= 1;
+
+  return changed;
+}
+
+/* Reorder process events */
+enum
+{
+  TSS_REORDER_EVENT_TABLE_ADDED = 1,
+};
+
+static uword
+tss_reorder_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+		     vlib_frame_t * f)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_tss_t *tss;
+  u32 *indices = 0, *index;
+
+  while (1)
+    {
+      /* No timer at all while no table uses a set */
+      if (tm->n_tables)
+	vlib_process_wait_for_event_or_clock (vm, TSS_REORDER_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, 0);
+
+      vec_reset_length (indices);
+      /* *INDENT-OFF* */
+      pool_foreach (tss, tm->sets, ({
+        if (tss->table_index != ~0)
+          vec_add1 (indices, tss - tm->sets);
+      }));
+      /* *INDENT-ON* */
+
+      vec_foreach (index, indices) vnet_classify_tss_reorder (index[0]);
+    }
+  return 0;
+}
+
+/* Not registered at init: see tss_reorder_process_enable */
+/* *INDENT-OFF* */
+static vlib_node_registration_t tss_reorder_process_node = {
+  .function = tss_reorder_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "classify-tss-reorder-process",
+};
+/* *INDENT-ON* */
+
+/*
+ * Register and start the reorder process for the first table, or wake it
+ * up for a table added after the last one went away.
+ */
+static void
+tss_reorder_process_enable (vlib_main_t * vm)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vlib_node_main_t *nm = &vm->node_main;
+  uword current_process_index;
+  vlib_node_t *n;
+
+  if (tm->reorder_node_index)
+    {
+      vlib_process_signal_event (vm, tm->reorder_node_index,
+				 TSS_REORDER_EVENT_TABLE_ADDED, 0);
+      return;
+    }
+
+  tm->reorder_node_index = vlib_register_node (vm,
+					       &tss_reorder_process_node);
+  n = vlib_get_node (vm, tm->reorder_node_index);
+
+  /*
+   * Tables are added by CLI and API handlers, which run in a process.
+   * vlib_start_process returns with no current process, put it back.
+   */
+  current_process_index = nm->current_process_index;
+  vlib_start_process (vm, n->runtime_index);
+  nm->current_process_index = current_process_index;
+}
+
+/**
+ * Add, update or delete a classify table in tss mode. The table gets a
+ * set of its own, with per tuple tables sized by nbuckets and memory_size;
+ * updates and deletes are those of any table.
+ */
+int
+vnet_classify_tss_add_del_table (u32 nbuckets, u32 memory_size,
+				 u32 skip_n_vectors, u32 match_n_vectors,
+				 u32 next_table_index, u32 miss_next_index,
+				 u32 * table_index, int is_add)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_tss_t *tss;
+  vnet_classify_table_t *t;
+  u32 tss_index;
+  u8 *mask = 0;
+  int rv;
+
+  if (!is_add || *table_index != ~0)
+    {
+      if (pool_is_free_index (cm->tables, *table_index))
+	return VNET_API_ERROR_NO_SUCH_TABLE;
+      t = pool_elt_at_index (cm->tables, *table_index);
+      if (t->tss_index == ~0)
+	return VNET_API_ERROR_INVALID_VALUE;
+      return vnet_classify_add_del_table (cm, 0, 0, 0, 0, 0,
+					  next_table_index, miss_next_index,
+					  table_index, 0, 0, is_add,
+					  0 /* del_chain */ );
+    }
+
+  if (memory_size == 0)
+    return VNET_API_ERROR_INVALID_MEMORY_SIZE;
+  if (nbuckets == 0)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if ((rv = vnet_classify_tss_create (skip_n_vectors, match_n_vectors,
+				      nbuckets, memory_size, &tss_index)))
+    return rv;
+
+  /* The table itself never holds a session */
+  vec_validate (mask, match_n_vectors * sizeof (u32x4) - 1);
+  rv = vnet_classify_add_del_table (cm, mask, 2 /* nbuckets */ ,
+				    memory_size, skip_n_vectors,
+				    match_n_vectors, next_table_index,
+				    miss_next_index, table_index,
+				    0 /* current_data_flag */ ,
+				    0 /* current_data_offset */ ,
+				    1 /* is_add */ , 0 /* del_chain */ );
+  vec_free (mask);
+  if (rv)
+    {
+      vnet_classify_tss_delete (tss_index);
+      return rv;
+    }
+
+  t = pool_elt_at_index (cm->tables, *table_index);
+  tss = pool_elt_at_index (tm->sets, tss_index);
+  t->tss_index = tss_index;
+  tss->table_index = *table_index;
+
+  tm->n_tables++;
+  tss_reorder_process_enable (vlib_get_main ());
+  return 0;
+}
+
+/**
+ * vnet_classify_tss_add_del_rule for the set of a tss mode table
+ */
+int
+vnet_classify_tss_table_add_del_rule (u32 table_index, u8 * mask,
+				      u8 * match, u32 rule_index,
+				      u32 hit_next_index, int is_add)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_table_t *t;
+
+  if (pool_is_free_index (cm->tables, table_index))
+    return VNET_API_ERROR_NO_SUCH_TABLE;
+  t = pool_elt_at_index (cm->tables, table_index);
+  if (t->tss_index == ~0)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  return vnet_classify_tss_add_del_rule (t->tss_index, mask, match,
+					 rule_index, hit_next_index, is_add);
+}
+
+/**
+ * Free the set of a tss mode table being deleted
+ */
+void
+vnet_classify_tss_table_free (vnet_classify_table_t * t)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_tss_t *tss;
+
+  tss = pool_elt_at_index (tm->sets, t->tss_index);
+  tss->table_index = ~0;
+  vnet_classify_tss_delete (t->tss_index);
+  t->tss_index = ~0;
+
+  ASSERT (tm->n_tables > 0);
+  tm->n_tables--;
+}
+
+/* Clones target the variant's instruction set rather than its arch=
+ * string: gcc won't inline base architecture functions, i.e. all of the
+ * lookup, into a function built for another arch */
+#define TSS_LOOKUP_CLONE_TEMPLATE(arch, fn, tgt)			\
+  void									\
+  __attribute__ ((flatten))						\
+  __attribute__ ((target (#arch)))					\
+  CLIB_CPU_OPTIMIZED							\
+  fn ## _ ## arch (vnet_classify_tss_t * tss, u8 ** h, u32 n_lookups,	\
+		   vnet_classify_entry_t ** results, f64 now)		\
+  { fn ## _inline (tss, h, n_lookups, results, now); }
+
+static_always_inline void
+vnet_classify_tss_lookup_batch_ma_inline (vnet_classify_tss_t * tss,
+					  u8 ** h, u32 n_lookups,
+					  vnet_classify_entry_t ** results,
+					  f64 now)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  u32 best_rule[TSS_LOOKUP_BATCH], best_tuple[TSS_LOOKUP_BATCH];
+  u64 hashes[TSS_LOOKUP_BATCH], *hits;
+  u32 j, n, thread_index = vlib_get_thread_index ();
+  vnet_classify_tss_tuple_t *tp;
+  vnet_classify_table_t *t;
+  vnet_classify_entry_t *e;
+
+  hits = tss->hits_by_thread[thread_index];
+
+  /* Tuple by tuple over a batch of packets, so bucket and entry fetches
+   * for one packet overlap with the others' */
+  while (n_lookups)
+    {
+      n = clib_min (n_lookups, TSS_LOOKUP_BATCH);
+      for (j = 0; j < n; j++)
+	{
+	  best_rule[j] = ~0;
+	  results[j] = 0;
+	}
+
+      vec_foreach (tp, tss->tuples)
+      {
+	t = pool_elt_at_index (cm->tables, tp->table_index);
+
+	for (j = 0; j < n; j++)
+	  if (tp->min_rule_index < best_rule[j])
+	    {
+	      hashes[j] = vnet_classify_hash_packet_inline (t, h[j]);
+	      vnet_classify_prefetch_bucket (t, hashes[j]);
+	    }
+
+	for (j = 0; j < n; j++)
+	  if (tp->min_rule_index < best_rule[j])
+	    vnet_classify_prefetch_entry (t, hashes[j]);
+
+	for (j = 0; j < n; j++)
+	  {
+	    /* Nothing in this tuple can beat what we have */
+	    if (tp->min_rule_index >= best_rule[j])
+	      continue;
+
+	    e = vnet_classify_tss_find_entry_inline (t, h[j], hashes[j], now);
+	    if (e && e->opaque_index < best_rule[j])
+	      {
+		results[j] = e;
+		best_rule[j] = e->opaque_index;
+		best_tuple[j] = tp - tss->tuples;
+	      }
+	  }
+      }
+
+      for (j = 0; j < n; j++)
+	if (results[j])
+	  hits[best_tuple[j]]++;
+
+      h += n;
+      results += n;
+      n_lookups -= n;
+    }
+}
+
+static void
+vnet_classify_tss_lookup_batch_ma (vnet_classify_tss_t * tss, u8 ** h,
+				   u32 n_lookups,
+				   vnet_classify_entry_t ** results, f64 now)
+{
+  vnet_classify_tss_lookup_batch_ma_inline (tss, h, n_lookups, results, now);
+}
+
+foreach_march_variant (TSS_LOOKUP_CLONE_TEMPLATE,
+		       vnet_classify_tss_lookup_batch_ma);
+CLIB_MULTIARCH_SELECT_FN (vnet_classify_tss_lookup_batch_ma);
+
+/**
+ * Look up n_lookups packets, using the AVX2 build of the lookup when the
+ * cpu has it. Misses give a null result.
+ */
+void
+vnet_classify_tss_lookup_batch (u32 tss_index, u8 ** h, u32 n_lookups,
+				vnet_classify_entry_t ** results, f64 now)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_tss_t *tss = pool_elt_at_index (tm->sets, tss_index);
+
+#if CLIB_DEBUG > 0
+  vnet_classify_tss_lookup_batch_ma (tss, h, n_lookups, results, now);
+#else
+  static void (*fp) (vnet_classify_tss_t *, u8 **, u32,
+		     vnet_classify_entry_t **, f64);
+
+  if (PREDICT_FALSE (fp == 0))
+    fp = (void *) vnet_classify_tss_lookup_batch_ma_multiarch_select ();
+
+  (*fp) (tss, h, n_lookups, results, now);
+#endif
+}
+
+/**
+ * Rules in a tuple, with a session or shadowed
+ */
+static u32
+tss_tuple_n_rules (vnet_classify_tss_tuple_t * tp)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_table_t *t;
+  hash_pair_t *hp;
+  u32 n_rules;
+
+  t = pool_elt_at_index (cm->tables, tp->table_index);
+  n_rules = t->active_elements;
+  /* *INDENT-OFF* */
+  hash_foreach_pair (hp, tp->shadowed, ({
+    n_rules += vec_len (uword_to_pointer (hp->value[0], u64 *));
+  }));
+  /* *INDENT-ON* */
+  return n_rules;
+}
+
+u8 *
+format_vnet_classify_tss (u8 * s, va_list * args)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  u32 tss_index = va_arg (*args, u32);
+  int verbose = va_arg (*args, int);
+  vnet_classify_tss_tuple_t *tp;
+  vnet_classify_tss_t *tss;
+  u64 **hits, n_hits;
+  u32 n_rules = 0;
+
+  tss = pool_elt_at_index (tm->sets, tss_index);
+  vec_foreach (tp, tss->tuples) n_rules += tss_tuple_n_rules (tp);
+
+  s = format (s, "[%u] skip %u match %u, %u rules in %u tuples, "
+	      "%u reorders", tss_index, tss->skip_n_vectors,
+	      tss->match_n_vectors, n_rules, vec_len (tss->tuples),
+	      tss->n_reorders);
+  if (!verbose)
+    return s;
+
+  vec_foreach (tp, tss->tuples)
+  {
+    n_hits = 0;
+    vec_foreach (hits, tss->hits_by_thread)
+      n_hits += hits[0][tp - tss->tuples];
+    s = format (s, "\n  table %u: %u rules, first rule %u, hits %llu"
+		"\n    mask %U", tp->table_index, tss_tuple_n_rules (tp),
+		tp->min_rule_index, n_hits, format_hex_bytes, tp->mask,
+		vec_len (tp->mask));
+  }
+  return s;
+}
+
+static clib_error_t *
+show_classify_tss_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+  vnet_classify_tss_t *tss;
+  int verbose = 0;
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
+
+  if (pool_elts (tm->sets) == 0)
+    {
+      vlib_cli_output (vm, "No tuple space search sets configured");
+      return 0;
+    }
+
+  /* *INDENT-OFF* */
+  pool_foreach (tss, tm->sets, ({
+    vlib_cli_output (vm, "%U", format_vnet_classify_tss, tss - tm->sets,
+                     verbose);
+  }));
+  /* *INDENT-ON* */
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_classify_tss_command, static) = {
+  .path = "show classify tss",
+  .short_help = "show classify tss [verbose]",
+  .function = show_classify_tss_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * Benchmark: random ACL style ip4 rules, protocol plus src and dst prefixes
+ * and optionally a dst port, some of them duplicates of earlier ones,
+ * looked up with packets that mostly hit one of them. Results are checked
+ * against a linear walk of the rules, after adding all of them, deleting
+ * some and adding those back.
+ */
+
+typedef union
+{
+  struct
+  {
+    ip4_header_t ip;
+    udp_header_t udp;
+    u8 pad[4];
+  };
+  u32 as_u32[8];
+  u64 as_u64[4];
+} tss_test_packet_t;
+
+STATIC_ASSERT (sizeof (tss_test_packet_t) == 2 * sizeof (u32x4),
+	       "tss test packet len");
+
+static const u8 tss_test_src_lens[] = { 8, 16, 24, 32 };
+static const u8 tss_test_dst_lens[] = { 16, 24, 32 };
+
+#define TSS_TEST_N_PACKETS (64 << 10)
+#define TSS_TEST_N_VERIFY 1024
+
+/* The low bits of random_u32 have short periods */
+static u32
+tss_test_random (u32 * seed, u32 n)
+{
+  return (random_u32 (seed) >> 8) % n;
+}
+
+static void
+tss_test_make_rule (tss_test_packet_t * mask, tss_test_packet_t * match,
+		    u32 * seed)
+{
+  ip4_address_t prefix_mask;
+  u8 src_len, dst_len;
+
+  memset (mask, 0, sizeof (*mask));
+  memset (match, 0, sizeof (*match));
+
+  src_len = tss_test_src_lens[tss_test_random (seed,
+					       ARRAY_LEN (tss_test_src_lens))];
+  dst_len = tss_test_dst_lens[tss_test_random (seed,
+					       ARRAY_LEN (tss_test_dst_lens))];
+  ip4_preflen_to_mask (src_len, &prefix_mask);
+  mask->ip.src_address = prefix_mask;
+  ip4_preflen_to_mask (dst_len, &prefix_mask);
+  mask->ip.dst_address = prefix_mask;
+  mask->ip.protocol = 0xff;
+  if (tss_test_random (seed, 2))
+    mask->udp.dst_port = 0xffff;
+
+  match->ip.src_address.as_u32 = random_u32 (seed)
+    & mask->ip.src_address.as_u32;
+  match->ip.dst_address.as_u32 = random_u32 (seed)
+    & mask->ip.dst_address.as_u32;
+  match->ip.protocol = tss_test_random (seed, 2) ?
+    IP_PROTOCOL_TCP : IP_PROTOCOL_UDP;
+  match->udp.dst_port = clib_host_to_net_u16 (tss_test_random (seed, 1024))
+    & mask->udp.dst_port;
+}
+
+static u32
+tss_test_linear_lookup (tss_test_packet_t * masks,
+			tss_test_packet_t * matches, u8 * is_deleted,
+			tss_test_packet_t * pkt)
+{
+  u64 *d = pkt->as_u64, *m, *k;
+  u32 i;
+
+  for (i = 0; i < vec_len (masks); i++)
+    {
+      if (is_deleted[i])
+	continue;
+      m = masks[i].as_u64;
+      k = matches[i].as_u64;
+      if (((d[0] & m[0]) ^ k[0]) == 0 && ((d[1] & m[1]) ^ k[1]) == 0
+	  && ((d[2] & m[2]) ^ k[2]) == 0 && ((d[3] & m[3]) ^ k[3]) == 0)
+	return i;
+    }
+  return ~0;
+}
+
+/**
+ * Check batch and single lookups of the first TSS_TEST_N_VERIFY packets
+ * against the linear walk. Rules' hit next index is their rule index.
+ */
+static clib_error_t *
+tss_test_verify (u32 tss_index, tss_test_packet_t * masks,
+		 tss_test_packet_t * matches, u8 * is_deleted, u8 ** h,
+		 vnet_classify_entry_t ** results, char *what)
+{
+  vnet_classify_tss_t *tss;
+  vnet_classify_entry_t *e;
+  u32 i, expected, got;
+
+  tss = pool_elt_at_index (vnet_classify_tss_main.sets, tss_index);
+  vnet_classify_tss_lookup_batch (tss_index, h, TSS_TEST_N_VERIFY, results,
+				  0 /* now */ );
+  for (i = 0; i < TSS_TEST_N_VERIFY; i++)
+    {
+      expected = tss_test_linear_lookup (masks, matches, is_deleted,
+					 (tss_test_packet_t *) h[i]);
+      e = vnet_classify_tss_lookup_inline (tss, h[i],
+					   vlib_get_thread_index (),
+					   0 /* now */ );
+      got = results[i] ? results[i]->opaque_index : ~0;
+      if (got != expected || (e ? e->opaque_index : ~0) != expected)
+	return clib_error_return (0, "%s: packet %u: got rule %d, single "
+				  "lookup %d, expected %d", what, i, got,
+				  e ? e->opaque_index : ~0, expected);
+      if (results[i] && results[i]->next_index != expected)
+	return clib_error_return (0, "%s: packet %u: rule %d has hit next "
+				  "%d", what, i, got, results[i]->next_index);
+    }
+  return 0;
+}
+
+static f64
+tss_test_run (vlib_main_t * vm, u32 tss_index, u8 ** h, u32 n_lookups,
+	      vnet_classify_entry_t ** results)
+{
+  u32 i, n;
+  f64 start;
+
+  start = vlib_time_now (vm);
+  for (i = 0; i < n_lookups; i += n)
+    {
+      n = clib_min (n_lookups - i, vec_len (h));
+      vnet_classify_tss_lookup_batch (tss_index, h, n, results,
+				      vlib_time_now (vm));
+    }
+  return n_lookups / (vlib_time_now (vm) - start);
+}
+
+static clib_error_t *
+tss_test_one (vlib_main_t * vm, u32 n_rules, u32 n_lookups, u32 seed)
+{
+  tss_test_packet_t *masks = 0, *matches = 0, *pkts = 0, *pkt;
+  vnet_classify_entry_t **results = 0;
+  clib_error_t *error = 0;
+  u32 i, j, r, tss_index = ~0, n_hits = 0, n_deleted = 0;
+  f64 rate_unordered, rate_ordered;
+  u8 **h = 0, *is_deleted = 0;
+  int rv;
+
+  vec_validate_aligned (masks, n_rules - 1, sizeof (u32x4));
+  vec_validate_aligned (matches, n_rules - 1, sizeof (u32x4));
+  vec_validate_aligned (pkts, TSS_TEST_N_PACKETS - 1, sizeof (u32x4));
+  vec_validate (is_deleted, n_rules - 1);
+  vec_validate (h, TSS_TEST_N_PACKETS - 1);
+  vec_validate (results, TSS_TEST_N_PACKETS - 1);
+
+  rv = vnet_classify_tss_create (0 /* skip */ , 2 /* match */ ,
+				 clib_max (n_rules / 16, 64),
+				 clib_max (n_rules * 64, 8 << 20),
+				 &tss_index);
+  if (rv)
+    {
+      error = clib_error_return (0, "tss create returned %d", rv);
+      goto done;
+    }
+
+  /* One in 16 rules duplicates an earlier one */
+  for (i = 0; i < n_rules; i++)
+    {
+      if (i && tss_test_random (&seed, 16) == 0)
+	{
+	  r = tss_test_random (&seed, i);
+	  masks[i] = masks[r];
+	  matches[i] = matches[r];
+	}
+      else
+	tss_test_make_rule (masks + i, matches + i, &seed);
+      rv = vnet_classify_tss_add_del_rule (tss_index, (u8 *) (masks + i),
+					   (u8 *) (matches + i), i,
+					   i /* hit_next_index */ ,
+					   1 /* is_add */ );
+      if (rv)
+	{
+	  error = clib_error_return (0, "rule %u add returned %d", i, rv);
+	  goto done;
+	}
+    }
+
+  /* 7 out of 8 packets are built to hit a random rule */
+  for (i = 0; i < TSS_TEST_N_PACKETS; i++)
+    {
+      pkt = pkts + i;
+      for (j = 0; j < ARRAY_LEN (pkt->as_u32); j++)
+	pkt->as_u32[j] = random_u32 (&seed);
+      if (tss_test_random (&seed, 8))
+	{
+	  r = tss_test_random (&seed, n_rules);
+	  for (j = 0; j < ARRAY_LEN (pkt->as_u64); j++)
+	    pkt->as_u64[j] = (pkt->as_u64[j] & ~masks[r].as_u64[j])
+	      | matches[r].as_u64[j];
+	}
+      h[i] = (u8 *) pkt;
+    }
+
+  if ((error = tss_test_verify (tss_index, masks, matches, is_deleted, h,
+				results, "add")))
+    goto done;
+
+  /* Delete half of the rules, including shadowed rules and rules that
+   * shadow others, then check a rule can't be deleted twice */
+  for (i = 0; i < n_rules; i++)
+    {
+      if (tss_test_random (&seed, 2))
+	continue;
+      rv = vnet_classify_tss_add_del_rule (tss_index, (u8 *) (masks + i),
+					   (u8 *) (matches + i), i,
+					   0 /* hit_next_index */ ,
+					   0 /* is_add */ );
+      if (rv)
+	{
+	  error = clib_error_return (0, "rule %u del returned %d", i, rv);
+	  goto done;
+	}
+      is_deleted[i] = 1;
+      n_deleted++;
+    }
+  for (i = 0; i < n_rules && !is_deleted[i]; i++)
+    ;
+  if (i < n_rules
+      && vnet_classify_tss_add_del_rule (tss_index, (u8 *) (masks + i),
+					 (u8 *) (matches + i), i,
+					 0 /* hit_next_index */ ,
+					 0 /* is_add */ ) == 0)
+    {
+      error = clib_error_return (0, "rule %u deleted twice", i);
+      goto done;
+    }
+
+  if ((error = tss_test_verify (tss_index, masks, matches, is_deleted, h,
+				results, "del")))
+    goto done;
+
+  /* Add them back last to first, so earlier rules take over sessions */
+  for (i = n_rules; i > 0; i--)
+    {
+      if (!is_deleted[i - 1])
+	continue;
+      rv = vnet_classify_tss_add_del_rule (tss_index, (u8 *) (masks + i - 1),
+					   (u8 *) (matches + i - 1), i - 1,
+					   i - 1 /* hit_next_index */ ,
+					   1 /* is_add */ );
+      if (rv)
+	{
+	  error = clib_error_return (0, "rule %u re-add returned %d", i - 1,
+				     rv);
+	  goto done;
+	}
+      is_deleted[i - 1] = 0;
+    }
+
+  if ((error = tss_test_verify (tss_index, masks, matches, is_deleted, h,
+				results, "re-add")))
+    goto done;
+
+  vnet_classify_tss_lookup_batch (tss_index, h, TSS_TEST_N_PACKETS,
+				  results, 0 /* now */ );
+  for (i = 0; i < TSS_TEST_N_PACKETS; i++)
+    n_hits += results[i] != 0;
+
+  rate_unordered = tss_test_run (vm, tss_index, h, n_lookups, results);
+  vnet_classify_tss_reorder (tss_index);
+  rate_ordered = tss_test_run (vm, tss_index, h, n_lookups, results);
+
+  if ((error = tss_test_verify (tss_index, masks, matches, is_deleted, h,
+				results, "reorder")))
+    goto done;
+
+  vlib_cli_output (vm, "%U", format_vnet_classify_tss, tss_index,
+		   0 /* verbose */ );
+  vlib_cli_output (vm, "  hit %.1f%%, %.2f Mlookups/s in insertion order, "
+		   "%.2f Mlookups/s in hit rate order, %u rules deleted and "
+		   "added back", 100.0 * n_hits / TSS_TEST_N_PACKETS,
+		   rate_unordered / 1e6, rate_ordered / 1e6, n_deleted);
+
+  /* All tuples go with the last rule */
+  for (i = 0; i < n_rules; i++)
+    {
+      rv = vnet_classify_tss_add_del_rule (tss_index, (u8 *) (masks + i),
+					   (u8 *) (matches + i), i,
+					   0 /* hit_next_index */ ,
+					   0 /* is_add */ );
+      if (rv)
+	{
+	  error = clib_error_return (0, "rule %u final del returned %d", i,
+				     rv);
+	  goto done;
+	}
+    }
+  if (vec_len (vnet_classify_tss_main.sets[tss_index].tuples))
+    error = clib_error_return (0, "%u tuples left without rules",
+			       vec_len (vnet_classify_tss_main.sets
+					[tss_index].tuples));
+
+done:
+  vnet_classify_tss_delete (tss_index);
+  vec_free (masks);
+  vec_free (matches);
+  vec_free (pkts);
+  vec_free (is_deleted);
+  vec_free (h);
+  vec_free (results);
+  return error;
+}
+
+static clib_error_t *
+test_classify_tss_command_fn (vlib_main_t * vm, unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  u32 default_rules[] = { 1000, 10000, 100000 };
+  u32 *rules = 0, *n_rules, n_lookups = 10 << 20, seed = 0xdeaddabe, tmp;
+  clib_error_t *error = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rules %u", &tmp))
+	vec_add1 (rules, tmp);
+      else if (unformat (input, "lookups %u", &n_lookups))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, input);
+	  goto done;
+	}
+    }
+
+  if (vec_len (rules) == 0)
+    vec_add (rules, default_rules, ARRAY_LEN (default_rules));
+
+  vec_foreach (n_rules, rules)
+  {
+    if (n_rules[0] == 0)
+      continue;
+    if ((error = tss_test_one (vm, n_rules[0], n_lookups, seed)))
+      break;
+  }
+
+done:
+  vec_free (rules);
+  return error;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_classify_tss_command, static) = {
+  .path = "test classify tss",
+  .short_help = "test classify tss [rules <n>]... [lookups <n>] [seed <n>]",
+  .function = test_classify_tss_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
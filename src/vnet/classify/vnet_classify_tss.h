@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __included_vnet_classify_tss_h__
+#define __included_vnet_classify_tss_h__
+
+#include <vnet/classify/vnet_classify.h>
+
+/*
+ * Tuple space search on top of classify tables.
+ *
+ * ACL style rule sets mix many masks, and chaining one classify table per
+ * mask by hand means a miss walks every table. Here rules are grouped by
+ * mask (a tuple) and each tuple gets its own classify table, created and
+ * deleted as rules come and go. As in an ACL, the first rule wins: a rule
+ * is identified by its rule index, stored in the session's opaque_index,
+ * and the match with the lowest rule index is returned.
+ *
+ * Lookups visit tuples in decreasing hit rate order and skip tuples that
+ * can't hold a rule earlier than the best match found so far, so a hot
+ * tuple with early rules prunes most of the others. The order is refreshed
+ * from per-thread hit counters by a process node, registered when the
+ * first table uses a set.
+ *
+ * A set is used through a classify table created in tss mode: the table
+ * holds no sessions itself, its rules live in the set, and the ip4/ip6
+ * classify nodes look it up through the set. Chaining and the miss next
+ * index work as for any other table.
+ *
+ * Like the classify tables, sets must only be modified from the main
+ * thread with the workers stopped at the barrier, as CLI and API handlers
+ * are by default.
+ */
+
+typedef struct
+{
+  /** Classify table holding this tuple's rules */
+  u32 table_index;
+
+  /** No rule in the table comes before this one. Only lowered on add, so
+   *  after deletes it's a lower bound, which is still safe for pruning */
+  u32 min_rule_index;
+
+  /** Mask, match_n_vectors u32x4s, key for tuple_by_mask */
+  u8 *mask;
+
+  /** Rules with the same mask and match as an earlier rule, so they can't
+   *  hit while it's there. Masked key to a vec of rule index << 32 | hit
+   *  next index, in rule order. The first one takes over the session when
+   *  the earlier rule is deleted */
+  uword *shadowed;
+} vnet_classify_tss_tuple_t;
+
+typedef struct
+{
+  /** Tuples in lookup order */
+  vnet_classify_tss_tuple_t *tuples;
+
+  /** Per thread hits, indexed like tuples, decayed on each reorder */
+  u64 **hits_by_thread;
+
+  /** Mask to position in tuples */
+  uword *tuple_by_mask;
+
+  /** Shared by all tuples */
+  u32 skip_n_vectors;
+  u32 match_n_vectors;
+
+  /** Sizing of the per tuple classify tables */
+  u32 nbuckets;
+  u32 memory_size;
+
+  /** Reorders that changed the lookup order */
+  u32 n_reorders;
+
+  /** Classify table using the set, ~0 for none */
+  u32 table_index;
+} vnet_classify_tss_t;
+
+typedef struct
+{
+  /** Pool of tuple space search sets */
+  vnet_classify_tss_t *sets;
+
+  /** Sets used by a classify table. The reorder process idles at 0 */
+  u32 n_tables;
+
+  /** Reorder process node, 0 until registered */
+  u32 reorder_node_index;
+} vnet_classify_tss_main_t;
+
+extern vnet_classify_tss_main_t vnet_classify_tss_main;
+
+/**
+ * Compare packet data against an entry's key, 256 bits at a time.
+ *
+ * Written with generic vectors and unaligned loads, so it compiles to two
+ * 128-bit ops per chunk on the base architecture and to single AVX2 ops in
+ * functions cloned for core-avx2. Neither data nor key need be aligned.
+ */
+always_inline int
+vnet_classify_tss_key_match (u8 * data, u8 * mask, u8 * key,
+			     u32 match_n_vectors)
+{
+  u64x4 r = { 0 };
+  u64x2 r_tail = { 0 };
+  u32 tail;
+
+#define _(p, i, t) clib_mem_unaligned ((p) + (i) * sizeof (t), t)
+  switch (match_n_vectors)
+    {
+    case 5:
+    case 4:
+      r |= (_(data, 1, u64x4) & _(mask, 1, u64x4)) ^ _(key, 1, u64x4);
+      /* FALLTHROUGH */
+    case 3:
+    case 2:
+      r |= (_(data, 0, u64x4) & _(mask, 0, u64x4)) ^ _(key, 0, u64x4);
+      /* FALLTHROUGH */
+    case 1:
+      break;
+    default:
+      abort ();
+    }
+
+  if (match_n_vectors & 1)
+    {
+      tail = match_n_vectors - 1;
+      r_tail = ((_(data, tail, u64x2) & _(mask, tail, u64x2))
+		^ _(key, tail, u64x2));
+    }
+#undef _
+
+  return (r[0] | r[1] | r[2] | r[3] | r_tail[0] | r_tail[1]) == 0;
+}
+
+/**
+ * vnet_classify_find_entry_inline with the wide key compare. h points at
+ * the packet data, before the skipped vectors.
+ */
+always_inline vnet_classify_entry_t *
+vnet_classify_tss_find_entry_inline (vnet_classify_table_t * t, u8 * h,
+				     u64 hash, f64 now)
+{
+  vnet_classify_entry_t *v;
+  vnet_classify_bucket_t *b;
+  u32 value_index, limit, i;
+  u8 *data;
+
+  b = &t->buckets[hash & (t->nbuckets - 1)];
+  if (b->offset == 0)
+    return 0;
+
+  hash >>= t->log2_nbuckets;
+
+  v = vnet_classify_get_entry (t, b->offset);
+  value_index = hash & ((1 << b->log2_pages) - 1);
+  limit = t->entries_per_page;
+  if (PREDICT_FALSE (b->linear_search))
+    {
+      value_index = 0;
+      limit *= (1 << b->log2_pages);
+    }
+
+  v = vnet_classify_entry_at_index (t, v, value_index);
+  data = h + t->skip_n_vectors * sizeof (u32x4);
+
+  for (i = 0; i < limit; i++)
+    {
+      if (vnet_classify_tss_key_match (data, (u8 *) t->mask, (u8 *) v->key,
+				       t->match_n_vectors))
+	{
+	  if (PREDICT_TRUE (now))
+	    {
+	      v->hits++;
+	      v->last_heard = now;
+	    }
+	  return v;
+	}
+      v = vnet_classify_entry_at_index (t, v, 1);
+    }
+  return 0;
+}
+
+/**
+ * Find the first rule, i.e., the one with the lowest rule index, that
+ * matches the packet data h. Returns 0 on miss.
+ */
+always_inline vnet_classify_entry_t *
+vnet_classify_tss_lookup_inline (vnet_classify_tss_t * tss, u8 * h,
+				 u32 thread_index, f64 now)
+{
+  vnet_classify_main_t *cm = &vnet_classify_main;
+  vnet_classify_entry_t *e, *best = 0;
+  vnet_classify_tss_tuple_t *tp;
+  vnet_classify_table_t *t;
+  u32 i, best_rule = ~0, best_tuple = 0;
+
+  for (i = 0; i < vec_len (tss->tuples); i++)
+    {
+      tp = vec_elt_at_index (tss->tuples, i);
+
+      /* Nothing in this tuple can beat what we have */
+      if (tp->min_rule_index >= best_rule)
+	continue;
+
+      t = pool_elt_at_index (cm->tables, tp->table_index);
+      e = vnet_classify_tss_find_entry_inline (t, h,
+					       vnet_classify_hash_packet_inline
+					       (t, h), now);
+      if (e && e->opaque_index < best_rule)
+	{
+	  best = e;
+	  best_rule = e->opaque_index;
+	  best_tuple = i;
+	}
+    }
+
+  if (best)
+    tss->hits_by_thread[thread_index][best_tuple]++;
+
+  return best;
+}
+
+/**
+ * Look up a classify table in tss mode, for the classify nodes
+ */
+always_inline vnet_classify_entry_t *
+vnet_classify_tss_table_find_entry (vnet_classify_table_t * t, u8 * h,
+				    u32 thread_index, f64 now)
+{
+  vnet_classify_tss_main_t *tm = &vnet_classify_tss_main;
+
+  return vnet_classify_tss_lookup_inline (pool_elt_at_index (tm->sets,
+							     t->tss_index),
+					  h, thread_index, now);
+}
+
+int vnet_classify_tss_create (u32 skip_n_vectors, u32 match_n_vectors,
+			      u32 nbuckets, u32 memory_size, u32 * tss_index);
+int vnet_classify_tss_delete (u32 tss_index);
+int vnet_classify_tss_add_del_rule (u32 tss_index, u8 * mask, u8 * match,
+				    u32 rule_index, u32 hit_next_index,
+				    int is_add);
+int vnet_classify_tss_reorder (u32 tss_index);
+int vnet_classify_tss_add_del_table (u32 nbuckets, u32 memory_size,
+				     u32 skip_n_vectors, u32 match_n_vectors,
+				     u32 next_table_index,
+				     u32 miss_next_index, u32 * table_index,
+				     int is_add);
+int vnet_classify_tss_table_add_del_rule (u32 table_index, u8 * mask,
+					  u8 * match, u32 rule_index,
+					  u32 hit_next_index, int is_add);
+void vnet_classify_tss_table_free (vnet_classify_table_t * t);
+void vnet_classify_tss_lookup_batch (u32 tss_index, u8 ** h, u32 n_lookups,
+				     vnet_classify_entry_t ** results,
+				     f64 now);
+
+format_function_t format_vnet_classify_tss;
+
+#endif /* __included_vnet_classify_tss_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -96,6 +96,31 @@
  * more array entries.
  */
 #define VHOST_USER_TX_COPY_THRESHOLD (VHOST_USER_COPY_ARRAY_N - 40)
+/*
+ * Both data paths look up the descriptor chain posted this many
+ * available ring slots ahead of the one being processed, so that the
+ * descriptor is in cache by the time it is parsed.
+ */
+#define VHOST_USER_DESC_PREFETCH_AHEAD 4
+/*
+ * Most guest receive buffers a packet is merged over on a packed ring,
+ * enough for 64kB in 1kB buffers.
+ */
+#define VHOST_USER_PACKED_TX_MAX_CHAINS 64
+
+/* Offered to the guest on top of the base features when gso is enabled */
+#define VHOST_USER_OFFLOAD_FEATURES				\
+  ((1ULL << FEAT_VIRTIO_NET_F_CSUM) |				\
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM) |			\
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4) |			\
+   (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6) |			\
+   (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO4) |			\
+   (1ULL << FEAT_VIRTIO_NET_F_HOST_TSO6))
+
+/* Buffer flags handed over to the guest in the virtio header */
+#define VHOST_USER_TX_OFFLOAD_BUFFER_FLAGS				\
+  (VNET_BUFFER_F_OFFLOAD_IP_CKSUM | VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |	\
+   VNET_BUFFER_F_OFFLOAD_UDP_CKSUM | VNET_BUFFER_F_GSO)
 
 #define UNIX_GET_FD(unixfd_idx) \
     (unixfd_idx != ~0) ? \
@@ -146,7 +171,8 @@ static char *vhost_user_tx_func_error_strings[] = {
   _(MMAP_FAIL, "mmap failure")  \
   _(INDIRECT_OVERFLOW, "indirect descriptor overflows table")  \
   _(UNDERSIZED_FRAME, "undersized ethernet frame received (< 14 bytes)") \
-  _(FULL_RX_QUEUE, "full rx queue (possible driver tx drop)")
+  _(FULL_RX_QUEUE, "full rx queue (possible driver tx drop)") \
+  _(BAD_OFFLOAD, "offload request for a packet that can't be offloaded")
 
 typedef enum
 {
@@ -292,6 +318,24 @@ map_user_mem (vhost_user_intf_t * vui, uword addr)
   return 0;
 }
 
+/* Guest physical address of a QEMU virtual address */
+static u64
+map_user_mem_to_guest (vhost_user_intf_t * vui, uword addr)
+{
+  int i;
+  for (i = 0; i < vui->nregions; i++)
+    {
+      if ((vui->regions[i].userspace_addr <= addr) &&
+	  ((vui->regions[i].userspace_addr + vui->regions[i].memory_size) >
+	   addr))
+	{
+	  return addr - vui->regions[i].userspace_addr +
+	    vui->regions[i].guest_phys_addr;
+	}
+    }
+  return 0;
+}
+
 static long
 get_huge_page_size (int fd)
 {
@@ -300,6 +344,27 @@ get_huge_page_size (int fd)
   return s.f_bsize;
 }
 
+/*
+ * Let the output path know which offloads the guest negotiated: packets
+ * with checksum offload flags are left for the guest to checksum, and
+ * GSO packets go to the guest whole.
+ */
+static void
+vhost_user_update_offload_flags (vnet_main_t * vnm, vhost_user_intf_t * vui)
+{
+  vnet_hw_interface_t *hw = vnet_get_hw_interface (vnm, vui->hw_if_index);
+  u64 gso = (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM) |
+    (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4) |
+    (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6);
+
+  hw->flags &= ~(VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD |
+		 VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO);
+  if (vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_CSUM))
+    hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD;
+  if ((vui->features & gso) == gso)
+    hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO;
+}
+
 static void
 unmap_all_mem_regions (vhost_user_intf_t * vui)
 {
@@ -334,6 +399,10 @@ unmap_all_mem_regions (vhost_user_intf_t * vui)
 	}
     }
   vui->nregions = 0;
+
+  /* Cached region indexes are meaningless for the next memory table */
+  for (i = 0; i < VHOST_VRING_MAX_N; i++)
+    vui->vrings[i].map_hint = 0;
 }
 
 static void
@@ -559,6 +628,8 @@ vhost_user_vring_init (vhost_user_intf_t * vui, u32 qid)
   vring->kickfd_idx = ~0;
   vring->callfd_idx = ~0;
   vring->errfd = -1;
+  vring->avail_wrap_counter = 1;
+  vring->used_wrap_counter = 1;
 
   /*
    * We have a bug with some qemu 2.5, and this may be a fix.
@@ -770,7 +841,11 @@ vhost_user_socket_read (clib_file_t * uf)
 	(1ULL << FEAT_VIRTIO_NET_F_GUEST_ANNOUNCE) |
 	(1ULL << FEAT_VIRTIO_NET_F_MQ) |
 	(1ULL << FEAT_VHOST_USER_F_PROTOCOL_FEATURES) |
-	(1ULL << FEAT_VIRTIO_F_VERSION_1);
+	(1ULL << FEAT_VIRTIO_F_VERSION_1) |
+	(1ULL << FEAT_VIRTIO_F_RING_PACKED) |
+	(1ULL << FEAT_VIRTIO_F_IN_ORDER);
+      if (vui->enable_gso)
+	msg.u64 |= VHOST_USER_OFFLOAD_FEATURES;
       msg.u64 &= vui->feature_mask;
       msg.size = sizeof (msg.u64);
       DBG_SOCK ("if %d msg VHOST_USER_GET_FEATURES - reply 0x%016llx",
@@ -792,6 +867,9 @@ vhost_user_socket_read (clib_file_t * uf)
 
       vui->is_any_layout =
 	(vui->features & (1 << FEAT_VIRTIO_F_ANY_LAYOUT)) ? 1 : 0;
+      vui->is_packed =
+	(vui->features & (1ULL << FEAT_VIRTIO_F_RING_PACKED)) ? 1 : 0;
+      vhost_user_update_offload_flags (vnm, vui);
 
       ASSERT (vui->virtio_net_hdr_sz < VLIB_BUFFER_PRE_DATA_SIZE);
       vnet_hw_interface_set_flags (vnm, vui->hw_if_index, 0);
@@ -905,6 +983,11 @@ vhost_user_socket_read (clib_file_t * uf)
       vui->vrings[msg.state.index].log_used =
 	(msg.addr.flags & (1 << VHOST_VRING_F_LOG)) ? 1 : 0;
 
+      /* A packed ring is written back in the descriptor ring itself */
+      if (vui->is_packed)
+	vui->vrings[msg.state.index].log_guest_addr =
+	  map_user_mem_to_guest (vui, msg.addr.desc_user_addr);
+
       /* Spec says: If VHOST_USER_F_PROTOCOL_FEATURES has not been negotiated,
          the ring is initialized in an enabled state. */
       if (!(vui->features & (1 << FEAT_VHOST_USER_F_PROTOCOL_FEATURES)))
@@ -912,6 +995,14 @@ vhost_user_socket_read (clib_file_t * uf)
 	  vui->vrings[msg.state.index].enabled = 1;
 	}
 
+      if (vui->is_packed)
+	{
+	  /* Positions come from VHOST_USER_SET_VRING_BASE only */
+	  vui->vrings[msg.state.index].used_event->flags =
+	    VRING_EVENT_F_DISABLE;
+	  break;
+	}
+
       vui->vrings[msg.state.index].last_used_idx =
 	vui->vrings[msg.state.index].last_avail_idx =
 	vui->vrings[msg.state.index].used->idx;
@@ -1024,6 +1115,16 @@ vhost_user_socket_read (clib_file_t * uf)
       DBG_SOCK ("if %d msg VHOST_USER_SET_VRING_BASE idx %d num %d",
 		vui->hw_if_index, msg.state.index, msg.state.num);
 
+      if (vui->is_packed)
+	{
+	  vhost_user_vring_t *vq = &vui->vrings[msg.state.index];
+
+	  vq->last_avail_idx = vq->last_used_idx =
+	    msg.state.num & ~VHOST_VRING_IDX_WRAP_COUNTER;
+	  vq->avail_wrap_counter = vq->used_wrap_counter =
+	    (msg.state.num & VHOST_VRING_IDX_WRAP_COUNTER) ? 1 : 0;
+	  break;
+	}
       vui->vrings[msg.state.index].last_avail_idx = msg.state.num;
       break;
 
@@ -1040,6 +1141,8 @@ vhost_user_socket_read (clib_file_t * uf)
        * closing the vring also initializes the vring last_avail_idx
        */
       msg.state.num = vui->vrings[msg.state.index].last_avail_idx;
+      if (vui->is_packed && vui->vrings[msg.state.index].avail_wrap_counter)
+	msg.state.num |= VHOST_VRING_IDX_WRAP_COUNTER;
       msg.flags |= 4;
       msg.size = sizeof (msg.state);
 
@@ -1358,6 +1461,130 @@ vhost_user_send_call (vlib_main_t * vm, vhost_user_vring_t * vq)
   vq->int_deadline = vlib_time_now (vm) + vum->coalesce_time;
 }
 
+/*
+ * Prefetch the part of the available ring holding the next n entries.
+ */
+static_always_inline void
+vhost_user_prefetch_avail (vhost_user_vring_t * vq, u16 n)
+{
+  u16 i;
+
+  for (i = 0; i < n; i += CLIB_CACHE_LINE_BYTES / sizeof (u16))
+    CLIB_PREFETCH (&vq->avail->ring[(vq->last_avail_idx + i) &
+				    vq->qsz_mask], CLIB_CACHE_LINE_BYTES,
+		   LOAD);
+}
+
+/*
+ * Prefetch the head descriptor of the chain posted n entries after
+ * last_avail_idx. The caller checks that the entry is available.
+ */
+static_always_inline void
+vhost_user_prefetch_desc (vhost_user_vring_t * vq, u16 n)
+{
+  u16 desc_head;
+
+  desc_head = vq->avail->ring[(vq->last_avail_idx + n) & vq->qsz_mask];
+  CLIB_PREFETCH (&vq->desc[desc_head & vq->qsz_mask],
+		 sizeof (vring_desc_t), LOAD);
+}
+
+/*
+ * Fill in the offload metadata of a packet the guest sent with a partial
+ * checksum, or as a TSO frame. The packet is not copied yet, so its
+ * headers are read from guest memory: from the descriptor holding the
+ * virtio header if there is more than the header in it, else from the
+ * next one (next_len is 0 if there is none). Returns non-zero if the
+ * packet has to be dropped.
+ */
+static_always_inline int
+vhost_user_handle_rx_offload (vhost_user_intf_t * vui, vlib_buffer_t * b,
+			      u64 desc_addr, u32 desc_len, u64 next_addr,
+			      u32 next_len, u32 * map_hint)
+{
+  virtio_net_hdr_t *hdr;
+  ethernet_header_t *eh;
+  u16 ethertype, l2_len, l4_len;
+  u8 *frame;
+  u32 frame_len;
+  int n_tags = 0;
+
+  if (PREDICT_FALSE (desc_len < vui->virtio_net_hdr_sz ||
+		     !(hdr = map_guest_mem (vui, desc_addr, map_hint))))
+    return 1;
+
+  if (PREDICT_TRUE (!(hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)))
+    return 0;
+
+  if (desc_len > vui->virtio_net_hdr_sz)
+    {
+      frame = (u8 *) hdr + vui->virtio_net_hdr_sz;
+      frame_len = desc_len - vui->virtio_net_hdr_sz;
+    }
+  else if (next_len && (frame = map_guest_mem (vui, next_addr, map_hint)))
+    frame_len = next_len;
+  else
+    return 1;
+
+  /* The checksum field is in the first buffer, and so are the headers */
+  if (PREDICT_FALSE ((u32) hdr->csum_start + hdr->csum_offset + 2 >
+		     frame_len))
+    return 1;
+
+  eh = (ethernet_header_t *) frame;
+  ethertype = clib_net_to_host_u16 (eh->type);
+  l2_len = sizeof (ethernet_header_t);
+  while ((ethertype == ETHERNET_TYPE_VLAN ||
+	  ethertype == ETHERNET_TYPE_DOT1AD) && n_tags++ < 2)
+    {
+      ethernet_vlan_header_t *vlan = (void *) (frame + l2_len);
+      ethertype = clib_net_to_host_u16 (vlan->type);
+      l2_len += sizeof (ethernet_vlan_header_t);
+    }
+  if (PREDICT_FALSE (l2_len >= hdr->csum_start))
+    return 1;
+
+  if (ethertype == ETHERNET_TYPE_IP4)
+    b->flags |= VNET_BUFFER_F_IS_IP4;
+  else if (ethertype == ETHERNET_TYPE_IP6)
+    b->flags |= VNET_BUFFER_F_IS_IP6;
+  else
+    return 1;
+
+  /* The checksum field offset tells TCP from UDP */
+  if (hdr->csum_offset == STRUCT_OFFSET_OF (tcp_header_t, checksum))
+    b->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+  else if (hdr->csum_offset == STRUCT_OFFSET_OF (udp_header_t, checksum))
+    b->flags |= VNET_BUFFER_F_OFFLOAD_UDP_CKSUM;
+  else
+    return 1;
+
+  vnet_buffer (b)->l2_hdr_offset = b->current_data;
+  vnet_buffer (b)->l3_hdr_offset = b->current_data + l2_len;
+  vnet_buffer (b)->l4_hdr_offset = b->current_data + hdr->csum_start;
+
+  /* Nothing to verify: the checksum is computed on output, if at all */
+  b->flags |= VNET_BUFFER_F_L4_CHECKSUM_COMPUTED |
+    VNET_BUFFER_F_L4_CHECKSUM_CORRECT;
+
+  if (hdr->gso_type == VIRTIO_NET_HDR_GSO_NONE)
+    return 0;
+
+  if (PREDICT_FALSE (!(b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM) ||
+		     hdr->gso_size == 0 ||
+		     hdr->csum_start + sizeof (tcp_header_t) > frame_len))
+    return 1;
+
+  l4_len = tcp_header_bytes ((tcp_header_t *) (frame + hdr->csum_start));
+  if (PREDICT_FALSE (hdr->csum_start + l4_len > frame_len))
+    return 1;
+
+  b->flags |= VNET_BUFFER_F_GSO;
+  vnet_buffer2 (b)->gso_size = hdr->gso_size;
+  vnet_buffer2 (b)->gso_l4_hdr_sz = l4_len;
+  return 0;
+}
+
 static_always_inline u32
 vhost_user_input_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
 		       u16 copy_len, u32 * map_hint)
@@ -1384,6 +1611,8 @@ vhost_user_input_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
 
 	  CLIB_PREFETCH (src2, 64, LOAD);
 	  CLIB_PREFETCH (src3, 64, LOAD);
+	  CLIB_PREFETCH ((void *) cpy[2].dst, 64, STORE);
+	  CLIB_PREFETCH ((void *) cpy[3].dst, 64, STORE);
 
 	  clib_memcpy ((void *) cpy[0].dst, src0, cpy[0].len);
 	  clib_memcpy ((void *) cpy[1].dst, src1, cpy[1].len);
@@ -1478,9 +1707,10 @@ vhost_user_if_input (vlib_main_t * vm,
   u32 n_left_to_next, *to_next;
   u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
   u32 n_trace = vlib_get_trace_count (vm, node);
-  u32 map_hint = 0;
+  u32 map_hint = txvq->map_hint;
   u16 thread_index = vlib_get_thread_index ();
   u16 copy_len = 0;
+  u16 i;
 
   {
     /* do we have pending interrupts ? */
@@ -1591,6 +1821,16 @@ vhost_user_if_input (vlib_main_t * vm,
 	}
     }
 
+  /*
+   * Fetch the whole batch of available ring entries, and the first
+   * descriptors, while the buffers are being set up. The loop below
+   * keeps the descriptor prefetch VHOST_USER_DESC_PREFETCH_AHEAD
+   * packets ahead.
+   */
+  vhost_user_prefetch_avail (txvq, n_left);
+  for (i = 0; i < n_left && i < VHOST_USER_DESC_PREFETCH_AHEAD; i++)
+    vhost_user_prefetch_desc (txvq, i);
+
   while (n_left > 0)
     {
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
@@ -1602,6 +1842,7 @@ vhost_user_if_input (vlib_main_t * vm,
 	  u16 desc_current;
 	  u32 desc_data_offset;
 	  vring_desc_t *desc_table = txvq->desc;
+	  int bad_offload = 0;
 
 	  if (PREDICT_FALSE (vum->cpus[thread_index].rx_buffers_len <= 1))
 	    {
@@ -1615,6 +1856,8 @@ vhost_user_if_input (vlib_main_t * vm,
 
 	  desc_current =
 	    txvq->avail->ring[txvq->last_avail_idx & txvq->qsz_mask];
+	  if (PREDICT_TRUE (n_left > VHOST_USER_DESC_PREFETCH_AHEAD))
+	    vhost_user_prefetch_desc (txvq, VHOST_USER_DESC_PREFETCH_AHEAD);
 	  vum->cpus[thread_index].rx_buffers_len--;
 	  bi_current = (vum->cpus[thread_index].rx_buffers)
 	    [vum->cpus[thread_index].rx_buffers_len];
@@ -1669,6 +1912,18 @@ vhost_user_if_input (vlib_main_t * vm,
 		}
 	    }
 
+	  if (PREDICT_FALSE (vui->features &
+			     (1ULL << FEAT_VIRTIO_NET_F_CSUM)))
+	    {
+	      vring_desc_t *d = &desc_table[desc_current], *n = 0;
+	      if (d->flags & VIRTQ_DESC_F_NEXT)
+		n = &desc_table[d->next];
+	      bad_offload =
+		vhost_user_handle_rx_offload (vui, b_head, d->addr, d->len,
+					      n ? n->addr : 0, n ? n->len : 0,
+					      &map_hint);
+	    }
+
 	  if (PREDICT_TRUE (vui->is_any_layout) ||
 	      (!(desc_table[desc_current].flags & VIRTQ_DESC_F_NEXT)))
 	    {
@@ -1774,9 +2029,16 @@ vhost_user_if_input (vlib_main_t * vm,
 	  {
 	    u32 next0 = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
 
-	    /* redirect if feature path enabled */
-	    vnet_feature_start_device_input_x1 (vui->sw_if_index, &next0,
-						b_head);
+	    if (PREDICT_FALSE (bad_offload))
+	      {
+		next0 = VNET_DEVICE_INPUT_NEXT_DROP;
+		b_head->error =
+		  node->errors[VHOST_USER_INPUT_FUNC_ERROR_BAD_OFFLOAD];
+	      }
+	    else
+	      /* redirect if feature path enabled */
+	      vnet_feature_start_device_input_x1 (vui->sw_if_index, &next0,
+						  b_head);
 
 	    u32 bi = to_next[-1];	//Cannot use to_next[-1] in the macro
 	    vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
@@ -1820,6 +2082,7 @@ vhost_user_if_input (vlib_main_t * vm,
       vlib_error_count (vm, node->node_index,
 			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
     }
+  txvq->map_hint = map_hint;
 
   /* give buffers back to driver */
   CLIB_MEMORY_BARRIER ();
@@ -1847,138 +2110,998 @@ vhost_user_if_input (vlib_main_t * vm,
   return n_rx_packets;
 }
 
-static uword
-vhost_user_input (vlib_main_t * vm,
-		  vlib_node_runtime_t * node, vlib_frame_t * f)
+/*
+ * Packed virtqueues (VIRTIO_F_RING_PACKED)
+ *
+ * Driver and device share a single descriptor ring. The driver makes a
+ * chain available by writing its descriptors in ring order, the head
+ * last, with the AVAIL flag equal to its wrap counter and USED to the
+ * inverse. The device gives the chain back by writing one descriptor
+ * where the chain started, holding the buffer id and both flags equal
+ * to its own wrap counter, and then skips the rest of the chain. Chains
+ * are used in order, so exchanging a descriptor touches one cache line
+ * of shared state instead of the three of a split ring.
+ *
+ * The flags of the first descriptor given back in a burst are written
+ * last, so that the driver, which polls the ring in order, picks up the
+ * whole burst at once.
+ */
+static_always_inline int
+vhost_user_packed_desc_is_avail (vhost_user_vring_t * vq, u16 idx)
 {
-  vhost_user_main_t *vum = &vhost_user_main;
-  uword n_rx_packets = 0;
-  vhost_user_intf_t *vui;
-  vnet_device_input_runtime_t *rt =
-    (vnet_device_input_runtime_t *) node->runtime_data;
-  vnet_device_and_queue_t *dq;
+  u16 flags = __atomic_load_n (&vq->packed_desc[idx].flags,
+			       __ATOMIC_ACQUIRE);
 
-  vec_foreach (dq, rt->devices_and_queues)
-  {
-    if (clib_smp_swap (&dq->interrupt_pending, 0) ||
-	(node->state == VLIB_NODE_STATE_POLLING))
-      {
-	vui =
-	  pool_elt_at_index (vum->vhost_user_interfaces, dq->dev_instance);
-	n_rx_packets = vhost_user_if_input (vm, vum, vui, dq->queue_id, node,
-					    dq->mode);
-      }
-  }
+  return ((((flags & VIRTQ_DESC_F_AVAIL) != 0) == vq->avail_wrap_counter)
+	  && (((flags & VIRTQ_DESC_F_USED) != 0) != vq->avail_wrap_counter));
+}
 
-  return n_rx_packets;
+static_always_inline void
+vhost_user_packed_advance_avail (vhost_user_vring_t * vq, u16 n_descs)
+{
+  vq->last_avail_idx += n_descs;
+  if (vq->last_avail_idx > vq->qsz_mask)
+    {
+      vq->last_avail_idx -= vq->qsz_mask + 1;
+      vq->avail_wrap_counter ^= 1;
+    }
 }
 
-/* *INDENT-OFF* */
-VLIB_REGISTER_NODE (vhost_user_input_node) = {
-  .function = vhost_user_input,
-  .type = VLIB_NODE_TYPE_INPUT,
-  .name = "vhost-user-input",
-  .sibling_of = "device-input",
+static_always_inline void
+vhost_user_packed_advance_used (vhost_user_vring_t * vq, u16 n_descs)
+{
+  vq->last_used_idx += n_descs;
+  if (vq->last_used_idx > vq->qsz_mask)
+    {
+      vq->last_used_idx -= vq->qsz_mask + 1;
+      vq->used_wrap_counter ^= 1;
+    }
+}
 
-  /* Will be enabled if/when hardware is detected. */
-  .state = VLIB_NODE_STATE_DISABLED,
+/*
+ * Follow the NEXT flags from ring position idx to the last descriptor
+ * of a chain, counting the slots in *n_descs. A chain cannot be longer
+ * than the ring.
+ */
+static_always_inline u16
+vhost_user_packed_chain_end (vhost_user_vring_t * vq, u16 idx,
+			     u16 * n_descs)
+{
+  while ((vq->packed_desc[idx].flags & VIRTQ_DESC_F_NEXT) &&
+	 *n_descs <= vq->qsz_mask)
+    {
+      idx = (idx + 1) & vq->qsz_mask;
+      (*n_descs)++;
+    }
+  return idx;
+}
 
-  .format_buffer = format_ethernet_header_with_length,
-  .format_trace = format_vhost_trace,
+static_always_inline void
+vhost_user_log_dirty_packed_desc (vhost_user_intf_t * vui,
+				  vhost_user_vring_t * vq, u16 idx)
+{
+  if (PREDICT_FALSE (vq->log_used))
+    vhost_user_log_dirty_pages (vui, vq->log_guest_addr +
+				idx * sizeof (vring_packed_desc_t),
+				sizeof (vring_packed_desc_t));
+}
 
-  .n_errors = VHOST_USER_INPUT_FUNC_N_ERROR,
-  .error_strings = vhost_user_input_func_error_strings,
-};
+/*
+ * Give back the n_descs long chain at last_used_idx. The flags of the
+ * first descriptor of a burst are kept in *first_used, ~0 when the
+ * burst is empty, for vhost_user_packed_flush_used().
+ */
+static_always_inline void
+vhost_user_packed_put_used (vhost_user_intf_t * vui,
+			    vhost_user_vring_t * vq, u16 id, u32 len,
+			    u16 n_descs, u16 flags, u32 * first_used)
+{
+  vring_packed_desc_t *desc = &vq->packed_desc[vq->last_used_idx];
 
-VLIB_NODE_FUNCTION_MULTIARCH (vhost_user_input_node, vhost_user_input)
-/* *INDENT-ON* */
+  if (vq->used_wrap_counter)
+    flags |= VIRTQ_DESC_F_AVAIL | VIRTQ_DESC_F_USED;
 
+  desc->id = id;
+  desc->len = len;
+  if (*first_used == ~0)
+    *first_used = vq->last_used_idx | ((u32) flags << 16);
+  else
+    {
+      __atomic_store_n (&desc->flags, flags, __ATOMIC_RELEASE);
+      vhost_user_log_dirty_packed_desc (vui, vq, vq->last_used_idx);
+    }
+  vhost_user_packed_advance_used (vq, n_descs);
+}
 
-void
-vhost_user_tx_trace (vhost_trace_t * t,
-		     vhost_user_intf_t * vui, u16 qid,
-		     vlib_buffer_t * b, vhost_user_vring_t * rxvq)
+static_always_inline void
+vhost_user_packed_flush_used (vhost_user_intf_t * vui,
+			      vhost_user_vring_t * vq, u32 first_used)
+{
+  u16 idx = first_used & 0xffff;
+
+  if (first_used == ~0)
+    return;
+
+  CLIB_MEMORY_BARRIER ();
+  vq->packed_desc[idx].flags = first_used >> 16;
+  vhost_user_log_dirty_packed_desc (vui, vq, idx);
+}
+
+static void
+vhost_user_packed_trace (vhost_trace_t * t, vhost_user_intf_t * vui,
+			 u16 qid, vhost_user_vring_t * vq)
 {
   vhost_user_main_t *vum = &vhost_user_main;
-  u32 last_avail_idx = rxvq->last_avail_idx;
-  u32 desc_current = rxvq->avail->ring[last_avail_idx & rxvq->qsz_mask];
-  vring_desc_t *hdr_desc = 0;
-  u32 hint = 0;
+  vring_packed_desc_t *desc = &vq->packed_desc[vq->last_avail_idx];
 
   memset (t, 0, sizeof (*t));
   t->device_index = vui - vum->vhost_user_interfaces;
   t->qid = qid;
 
-  hdr_desc = &rxvq->desc[desc_current];
-  if (rxvq->desc[desc_current].flags & VIRTQ_DESC_F_INDIRECT)
-    {
-      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_INDIRECT;
-      /* Header is the first here */
-      hdr_desc = map_guest_mem (vui, rxvq->desc[desc_current].addr, &hint);
-    }
-  if (rxvq->desc[desc_current].flags & VIRTQ_DESC_F_NEXT)
-    {
-      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SIMPLE_CHAINED;
-    }
-  if (!(rxvq->desc[desc_current].flags & VIRTQ_DESC_F_NEXT) &&
-      !(rxvq->desc[desc_current].flags & VIRTQ_DESC_F_INDIRECT))
+  if (desc->flags & VIRTQ_DESC_F_INDIRECT)
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_INDIRECT;
+  else if (desc->flags & VIRTQ_DESC_F_NEXT)
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SIMPLE_CHAINED;
+  else
+    t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SINGLE_DESC;
+
+  t->first_desc_len = desc->len;
+}
+
+/*
+ * Give back up to discard_max packets from the tx ring (VPP RX path)
+ * without reading them.
+ */
+static u32
+vhost_user_packed_discard (vhost_user_intf_t * vui,
+			   vhost_user_vring_t * txvq, u32 discard_max)
+{
+  u32 discarded_packets = 0;
+  u32 first_used = ~0;
+
+  while (discarded_packets != discard_max &&
+	 vhost_user_packed_desc_is_avail (txvq, txvq->last_avail_idx))
     {
-      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SINGLE_DESC;
+      u16 last = txvq->last_avail_idx;
+      u16 n_descs = 1;
+
+      if (!(txvq->packed_desc[last].flags & VIRTQ_DESC_F_INDIRECT))
+	last = vhost_user_packed_chain_end (txvq, last, &n_descs);
+
+      vhost_user_packed_put_used (vui, txvq, txvq->packed_desc[last].id, 0,
+				  n_descs, 0, &first_used);
+      vhost_user_packed_advance_avail (txvq, n_descs);
+      discarded_packets++;
     }
 
-  t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
+  vhost_user_packed_flush_used (vui, txvq, first_used);
+  return discarded_packets;
 }
 
-static_always_inline u32
-vhost_user_tx_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
-		    u16 copy_len, u32 * map_hint)
+static u32
+vhost_user_if_input_packed (vlib_main_t * vm,
+			    vhost_user_main_t * vum,
+			    vhost_user_intf_t * vui,
+			    u16 qid, vlib_node_runtime_t * node,
+			    vnet_hw_interface_rx_mode mode)
 {
-  void *dst0, *dst1, *dst2, *dst3;
-  if (PREDICT_TRUE (copy_len >= 4))
-    {
-      if (PREDICT_FALSE (!(dst2 = map_guest_mem (vui, cpy[0].dst, map_hint))))
-	return 1;
-      if (PREDICT_FALSE (!(dst3 = map_guest_mem (vui, cpy[1].dst, map_hint))))
-	return 1;
-      while (PREDICT_TRUE (copy_len >= 4))
-	{
-	  dst0 = dst2;
-	  dst1 = dst3;
+  vhost_user_vring_t *txvq = &vui->vrings[VHOST_VRING_IDX_TX (qid)];
+  u16 n_rx_packets = 0;
+  u32 n_rx_bytes = 0;
+  u16 n_left = VLIB_FRAME_SIZE;
+  u32 n_left_to_next, *to_next;
+  u32 next_index = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+  u32 n_trace = vlib_get_trace_count (vm, node);
+  u32 map_hint = txvq->map_hint;
+  u16 thread_index = vlib_get_thread_index ();
+  vhost_cpu_t *cpu = &vum->cpus[thread_index];
+  u16 copy_len = 0;
+  u32 first_used = ~0;
 
-	  if (PREDICT_FALSE
-	      (!(dst2 = map_guest_mem (vui, cpy[2].dst, map_hint))))
-	    return 1;
-	  if (PREDICT_FALSE
-	      (!(dst3 = map_guest_mem (vui, cpy[3].dst, map_hint))))
-	    return 1;
+  {
+    /* do we have pending interrupts ? */
+    vhost_user_vring_t *rxvq = &vui->vrings[VHOST_VRING_IDX_RX (qid)];
+    f64 now = vlib_time_now (vm);
 
-	  CLIB_PREFETCH ((void *) cpy[2].src, 64, LOAD);
-	  CLIB_PREFETCH ((void *) cpy[3].src, 64, LOAD);
+    if ((txvq->n_since_last_int) && (txvq->int_deadline < now))
+      vhost_user_send_call (vm, txvq);
 
-	  clib_memcpy (dst0, (void *) cpy[0].src, cpy[0].len);
-	  clib_memcpy (dst1, (void *) cpy[1].src, cpy[1].len);
+    if ((rxvq->n_since_last_int) && (rxvq->int_deadline < now))
+      vhost_user_send_call (vm, rxvq);
+  }
 
-	  vhost_user_log_dirty_pages_2 (vui, cpy[0].dst, cpy[0].len, 1);
-	  vhost_user_log_dirty_pages_2 (vui, cpy[1].dst, cpy[1].len, 1);
-	  copy_len -= 2;
-	  cpy += 2;
-	}
-    }
-  while (copy_len)
+  /* See vhost_user_if_input() */
+  if (PREDICT_FALSE (mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE))
     {
-      if (PREDICT_FALSE (!(dst0 = map_guest_mem (vui, cpy->dst, map_hint))))
-	return 1;
-      clib_memcpy (dst0, (void *) cpy->src, cpy->len);
-      vhost_user_log_dirty_pages_2 (vui, cpy->dst, cpy->len, 1);
-      copy_len -= 1;
-      cpy += 1;
+      if ((node->flags &
+	   VLIB_NODE_FLAG_SWITCH_FROM_POLLING_TO_INTERRUPT_MODE) ||
+	  !(node->flags &
+	    VLIB_NODE_FLAG_SWITCH_FROM_INTERRUPT_TO_POLLING_MODE))
+	txvq->used_event->flags = VRING_EVENT_F_ENABLE;
+      else
+	txvq->used_event->flags = VRING_EVENT_F_DISABLE;
     }
-  return 0;
-}
 
+  /* nothing to do */
+  if (!vhost_user_packed_desc_is_avail (txvq, txvq->last_avail_idx))
+    return 0;
 
-static uword
-vhost_user_tx (vlib_main_t * vm,
+  if (PREDICT_FALSE (!vui->admin_up || !(txvq->enabled)))
+    {
+      vhost_user_packed_discard (vui, txvq, VHOST_USER_DOWN_DISCARD_COUNT);
+      return 0;
+    }
+
+  /*
+   * Packets are only taken off the ring once buffers are found for
+   * them, so when buffers run short the rest simply wait in the ring.
+   */
+  if (PREDICT_FALSE (cpu->rx_buffers_len < VLIB_FRAME_SIZE + 1))
+    {
+      u32 curr_len = cpu->rx_buffers_len;
+      cpu->rx_buffers_len +=
+	vlib_buffer_alloc_from_free_list (vm, cpu->rx_buffers + curr_len,
+					  VHOST_USER_RX_BUFFERS_N - curr_len,
+					  VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
+    }
+
+  while (n_left > 0)
+    {
+      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+
+      while (n_left > 0 && n_left_to_next > 0)
+	{
+	  vring_packed_desc_t *desc_table = txvq->packed_desc;
+	  vlib_buffer_t *b_head, *b_current;
+	  u32 bi_current;
+	  u16 desc_current = txvq->last_avail_idx;
+	  u16 n_descs = 1;
+	  u16 n_indirect = 0;
+	  u16 buffer_id;
+	  u32 desc_data_offset;
+	  int bad_offload = 0;
+
+	  if (!vhost_user_packed_desc_is_avail (txvq, desc_current))
+	    {
+	      n_left = 0;
+	      break;
+	    }
+
+	  if (PREDICT_FALSE (cpu->rx_buffers_len <= 1))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_INPUT_FUNC_ERROR_NO_BUFFER, 1);
+	      n_left = 0;
+	      break;
+	    }
+
+	  cpu->rx_buffers_len--;
+	  bi_current = cpu->rx_buffers[cpu->rx_buffers_len];
+	  b_head = b_current = vlib_get_buffer (vm, bi_current);
+	  to_next[0] = bi_current;
+	  to_next++;
+	  n_left_to_next--;
+
+	  vlib_prefetch_buffer_with_index (vm,
+					   cpu->rx_buffers[cpu->rx_buffers_len
+							   - 1], LOAD);
+
+	  /* The buffer should already be initialized */
+	  b_head->total_length_not_including_first_buffer = 0;
+	  b_head->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+
+	  if (PREDICT_FALSE (n_trace))
+	    {
+	      vlib_trace_buffer (vm, node, next_index, b_head,
+				 /* follow_chain */ 0);
+	      vhost_trace_t *t0 =
+		vlib_add_trace (vm, node, b_head, sizeof (t0[0]));
+	      vhost_user_packed_trace (t0, vui, qid, txvq);
+	      n_trace--;
+	      vlib_set_trace_count (vm, node, n_trace);
+	    }
+
+	  buffer_id = desc_table[desc_current].id;
+	  if (desc_table[desc_current].flags & VIRTQ_DESC_F_INDIRECT)
+	    {
+	      n_indirect = desc_table[desc_current].len /
+		sizeof (vring_packed_desc_t);
+	      desc_table = map_guest_mem (vui, desc_table[desc_current].addr,
+					  &map_hint);
+	      desc_current = 0;
+	      if (PREDICT_FALSE (desc_table == 0 || n_indirect == 0))
+		{
+		  vlib_error_count (vm, node->node_index,
+				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+		  goto out;
+		}
+	    }
+
+	  if (PREDICT_FALSE (vui->features &
+			     (1ULL << FEAT_VIRTIO_NET_F_CSUM)))
+	    {
+	      vring_packed_desc_t *d = &desc_table[desc_current], *n = 0;
+	      if (n_indirect > 1)
+		n = d + 1;
+	      else if (!n_indirect && (d->flags & VIRTQ_DESC_F_NEXT))
+		n = &txvq->packed_desc[(desc_current + 1) & txvq->qsz_mask];
+	      bad_offload =
+		vhost_user_handle_rx_offload (vui, b_head, d->addr, d->len,
+					      n ? n->addr : 0, n ? n->len : 0,
+					      &map_hint);
+	    }
+
+	  /* VIRTIO_F_VERSION_1 comes with the packed ring: any layout */
+	  desc_data_offset = vui->virtio_net_hdr_sz;
+
+	  while (1)
+	    {
+	      /* Get more input if necessary. Or end of packet. */
+	      if (desc_data_offset >= desc_table[desc_current].len)
+		{
+		  desc_data_offset -= desc_table[desc_current].len;
+		  if (n_indirect)
+		    {
+		      if (++desc_current == n_indirect)
+			goto out;
+		    }
+		  else if ((desc_table[desc_current].flags &
+			    VIRTQ_DESC_F_NEXT) && n_descs <= txvq->qsz_mask)
+		    {
+		      desc_current = (desc_current + 1) & txvq->qsz_mask;
+		      n_descs++;
+		    }
+		  else
+		    {
+		      buffer_id = desc_table[desc_current].id;
+		      goto out;
+		    }
+		  continue;
+		}
+
+	      /* Get more output if necessary. Or end of packet. */
+	      if (PREDICT_FALSE
+		  (b_current->current_length == VLIB_BUFFER_DATA_SIZE))
+		{
+		  if (PREDICT_FALSE (cpu->rx_buffers_len == 0))
+		    {
+		      /* Cancel speculation, the packet stays in the ring */
+		      to_next--;
+		      n_left_to_next++;
+		      vhost_user_input_rewind_buffers (vm, cpu, b_head);
+		      n_left = 0;
+		      goto stop;
+		    }
+
+		  /* Get next output */
+		  cpu->rx_buffers_len--;
+		  u32 bi_next = cpu->rx_buffers[cpu->rx_buffers_len];
+		  b_current->next_buffer = bi_next;
+		  b_current->flags |= VLIB_BUFFER_NEXT_PRESENT;
+		  bi_current = bi_next;
+		  b_current = vlib_get_buffer (vm, bi_current);
+		}
+
+	      /* Prepare a copy order executed later for the data */
+	      vhost_copy_t *cpy = &cpu->copy[copy_len];
+	      copy_len++;
+	      u32 desc_data_l =
+		desc_table[desc_current].len - desc_data_offset;
+	      cpy->len = VLIB_BUFFER_DATA_SIZE - b_current->current_length;
+	      cpy->len = (cpy->len > desc_data_l) ? desc_data_l : cpy->len;
+	      cpy->dst = (uword) (vlib_buffer_get_current (b_current) +
+				  b_current->current_length);
+	      cpy->src = desc_table[desc_current].addr + desc_data_offset;
+
+	      desc_data_offset += cpy->len;
+
+	      b_current->current_length += cpy->len;
+	      b_head->total_length_not_including_first_buffer += cpy->len;
+	    }
+
+	out:
+	  n_rx_bytes += b_head->total_length_not_including_first_buffer;
+	  n_rx_packets++;
+
+	  b_head->total_length_not_including_first_buffer -=
+	    b_head->current_length;
+
+	  /*
+	   * The copy orders hold all we need from the descriptors, so the
+	   * chain can be given back now; the driver will not see it before
+	   * the copies are done and the burst is flushed.
+	   */
+	  vhost_user_packed_put_used (vui, txvq, buffer_id, 0, n_descs, 0,
+				      &first_used);
+	  vhost_user_packed_advance_avail (txvq, n_descs);
+
+	  VLIB_BUFFER_TRACE_TRAJECTORY_INIT (b_head);
+
+	  vnet_buffer (b_head)->sw_if_index[VLIB_RX] = vui->sw_if_index;
+	  vnet_buffer (b_head)->sw_if_index[VLIB_TX] = (u32) ~ 0;
+	  b_head->error = 0;
+
+	  {
+	    u32 next0 = VNET_DEVICE_INPUT_NEXT_ETHERNET_INPUT;
+
+	    if (PREDICT_FALSE (bad_offload))
+	      {
+		next0 = VNET_DEVICE_INPUT_NEXT_DROP;
+		b_head->error =
+		  node->errors[VHOST_USER_INPUT_FUNC_ERROR_BAD_OFFLOAD];
+	      }
+	    else
+	      /* redirect if feature path enabled */
+	      vnet_feature_start_device_input_x1 (vui->sw_if_index, &next0,
+						  b_head);
+
+	    u32 bi = to_next[-1];	//Cannot use to_next[-1] in the macro
+	    vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
+					     to_next, n_left_to_next,
+					     bi, next0);
+	  }
+
+	  n_left--;
+
+	  /* As for split rings, hand descriptors back from time to time */
+	  if (PREDICT_FALSE (copy_len >= VHOST_USER_RX_COPY_THRESHOLD))
+	    {
+	      if (PREDICT_FALSE
+		  (vhost_user_input_copy (vui, cpu->copy, copy_len,
+					  &map_hint)))
+		{
+		  vlib_error_count (vm, node->node_index,
+				    VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+		}
+	      copy_len = 0;
+
+	      vhost_user_packed_flush_used (vui, txvq, first_used);
+	      first_used = ~0;
+	    }
+	}
+    stop:
+      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+    }
+
+  /* Do the memory copies */
+  if (PREDICT_FALSE
+      (vhost_user_input_copy (vui, cpu->copy, copy_len, &map_hint)))
+    {
+      vlib_error_count (vm, node->node_index,
+			VHOST_USER_INPUT_FUNC_ERROR_MMAP_FAIL, 1);
+    }
+  txvq->map_hint = map_hint;
+
+  /* give buffers back to driver */
+  vhost_user_packed_flush_used (vui, txvq, first_used);
+
+  /* interrupt (call) handling */
+  if ((txvq->callfd_idx != ~0) &&
+      (txvq->avail_event->flags != VRING_EVENT_F_DISABLE))
+    {
+      txvq->n_since_last_int += n_rx_packets;
+
+      if (txvq->n_since_last_int > vum->coalesce_frames)
+	vhost_user_send_call (vm, txvq);
+    }
+
+  /* increase rx counters */
+  vlib_increment_combined_counter
+    (vnet_main.interface_main.combined_sw_if_counters
+     + VNET_INTERFACE_COUNTER_RX,
+     vlib_get_thread_index (), vui->sw_if_index, n_rx_packets, n_rx_bytes);
+
+  vnet_device_increment_rx_packets (thread_index, n_rx_packets);
+
+  return n_rx_packets;
+}
+
+static uword
+vhost_user_input (vlib_main_t * vm,
+		  vlib_node_runtime_t * node, vlib_frame_t * f)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  uword n_rx_packets = 0;
+  vhost_user_intf_t *vui;
+  vnet_device_input_runtime_t *rt =
+    (vnet_device_input_runtime_t *) node->runtime_data;
+  vnet_device_and_queue_t *dq;
+
+  vec_foreach (dq, rt->devices_and_queues)
+  {
+    if (clib_smp_swap (&dq->interrupt_pending, 0) ||
+	(node->state == VLIB_NODE_STATE_POLLING))
+      {
+	vui =
+	  pool_elt_at_index (vum->vhost_user_interfaces, dq->dev_instance);
+	if (vui->is_packed)
+	  n_rx_packets = vhost_user_if_input_packed (vm, vum, vui,
+						     dq->queue_id, node,
+						     dq->mode);
+	else
+	  n_rx_packets = vhost_user_if_input (vm, vum, vui, dq->queue_id,
+					      node, dq->mode);
+      }
+  }
+
+  return n_rx_packets;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (vhost_user_input_node) = {
+  .function = vhost_user_input,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .name = "vhost-user-input",
+  .sibling_of = "device-input",
+
+  /* Will be enabled if/when hardware is detected. */
+  .state = VLIB_NODE_STATE_DISABLED,
+
+  .format_buffer = format_ethernet_header_with_length,
+  .format_trace = format_vhost_trace,
+
+  .n_errors = VHOST_USER_INPUT_FUNC_N_ERROR,
+  .error_strings = vhost_user_input_func_error_strings,
+};
+
+VLIB_NODE_FUNCTION_MULTIARCH (vhost_user_input_node, vhost_user_input)
+/* *INDENT-ON* */
+
+
+void
+vhost_user_tx_trace (vhost_trace_t * t,
+		     vhost_user_intf_t * vui, u16 qid,
+		     vlib_buffer_t * b, vhost_user_vring_t * rxvq)
+{
+  vhost_user_main_t *vum = &vhost_user_main;
+  u32 last_avail_idx = rxvq->last_avail_idx;
+  u32 desc_current = rxvq->avail->ring[last_avail_idx & rxvq->qsz_mask];
+  vring_desc_t *hdr_desc = 0;
+  u32 hint = 0;
+
+  memset (t, 0, sizeof (*t));
+  t->device_index = vui - vum->vhost_user_interfaces;
+  t->qid = qid;
+
+  hdr_desc = &rxvq->desc[desc_current];
+  if (rxvq->desc[desc_current].flags & VIRTQ_DESC_F_INDIRECT)
+    {
+      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_INDIRECT;
+      /* Header is the first here */
+      hdr_desc = map_guest_mem (vui, rxvq->desc[desc_current].addr, &hint);
+    }
+  if (rxvq->desc[desc_current].flags & VIRTQ_DESC_F_NEXT)
+    {
+      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SIMPLE_CHAINED;
+    }
+  if (!(rxvq->desc[desc_current].flags & VIRTQ_DESC_F_NEXT) &&
+      !(rxvq->desc[desc_current].flags & VIRTQ_DESC_F_INDIRECT))
+    {
+      t->virtio_ring_flags |= 1 << VIRTIO_TRACE_F_SINGLE_DESC;
+    }
+
+  t->first_desc_len = hdr_desc ? hdr_desc->len : 0;
+}
+
+/*
+ * Hand the checksum and segmentation of a packet over to the guest. The
+ * checksum field gets the pseudo-header sum the guest completes from
+ * csum_start on. The IP header checksum is not offloaded by virtio, it
+ * is done here.
+ */
+static_always_inline void
+vhost_user_handle_tx_offload (vlib_main_t * vm, vhost_user_intf_t * vui,
+			      vlib_buffer_t * b, virtio_net_hdr_t * hdr)
+{
+  ip4_header_t *ip4 = 0;
+  ip6_header_t *ip6 = 0;
+  tcp_header_t *th = 0;
+  udp_header_t *uh = 0;
+  ip_csum_t sum;
+  u32 l4_len;
+  u8 proto;
+  int i;
+
+  if (b->flags & VNET_BUFFER_F_IS_IP4)
+    {
+      ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
+      if (b->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM)
+	ip4->checksum = ip4_header_checksum (ip4);
+    }
+  else if (b->flags & VNET_BUFFER_F_IS_IP6)
+    ip6 = (ip6_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
+  else
+    return;
+
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    {
+      th = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
+      hdr->csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+      proto = IP_PROTOCOL_TCP;
+    }
+  else if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
+    {
+      uh = (udp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
+      hdr->csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+      proto = IP_PROTOCOL_UDP;
+    }
+  else
+    return;
+
+  hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+  hdr->csum_start = vnet_buffer (b)->l4_hdr_offset - b->current_data;
+
+  l4_len = vlib_buffer_length_in_chain (vm, b) - hdr->csum_start;
+  sum = clib_host_to_net_u32 (l4_len + (proto << 16));
+  if (ip4)
+    {
+      sum = ip_csum_with_carry (sum, clib_mem_unaligned (&ip4->src_address,
+							 u32));
+      sum = ip_csum_with_carry (sum, clib_mem_unaligned (&ip4->dst_address,
+							 u32));
+    }
+  else
+    {
+      for (i = 0; i < ARRAY_LEN (ip6->src_address.as_uword); i++)
+	{
+	  sum = ip_csum_with_carry (sum, ip6->src_address.as_uword[i]);
+	  sum = ip_csum_with_carry (sum, ip6->dst_address.as_uword[i]);
+	}
+    }
+  if (th)
+    th->checksum = ip_csum_fold (sum);
+  else
+    uh->checksum = ip_csum_fold (sum);
+
+  if (!(b->flags & VNET_BUFFER_F_GSO))
+    return;
+
+  if (ip4 && (vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO4)))
+    hdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+  else if (ip6 && (vui->features & (1ULL << FEAT_VIRTIO_NET_F_GUEST_TSO6)))
+    hdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV6;
+  else
+    return;
+  hdr->gso_size = vnet_buffer2 (b)->gso_size;
+  hdr->hdr_len = hdr->csum_start + vnet_buffer2 (b)->gso_l4_hdr_sz;
+}
+
+static_always_inline u32
+vhost_user_tx_copy (vhost_user_intf_t * vui, vhost_copy_t * cpy,
+		    u16 copy_len, u32 * map_hint)
+{
+  void *dst0, *dst1, *dst2, *dst3;
+  if (PREDICT_TRUE (copy_len >= 4))
+    {
+      if (PREDICT_FALSE (!(dst2 = map_guest_mem (vui, cpy[0].dst, map_hint))))
+	return 1;
+      if (PREDICT_FALSE (!(dst3 = map_guest_mem (vui, cpy[1].dst, map_hint))))
+	return 1;
+      while (PREDICT_TRUE (copy_len >= 4))
+	{
+	  dst0 = dst2;
+	  dst1 = dst3;
+
+	  if (PREDICT_FALSE
+	      (!(dst2 = map_guest_mem (vui, cpy[2].dst, map_hint))))
+	    return 1;
+	  if (PREDICT_FALSE
+	      (!(dst3 = map_guest_mem (vui, cpy[3].dst, map_hint))))
+	    return 1;
+
+	  CLIB_PREFETCH ((void *) cpy[2].src, 64, LOAD);
+	  CLIB_PREFETCH ((void *) cpy[3].src, 64, LOAD);
+	  CLIB_PREFETCH (dst2, 64, STORE);
+	  CLIB_PREFETCH (dst3, 64, STORE);
+
+	  clib_memcpy (dst0, (void *) cpy[0].src, cpy[0].len);
+	  clib_memcpy (dst1, (void *) cpy[1].src, cpy[1].len);
+
+	  vhost_user_log_dirty_pages_2 (vui, cpy[0].dst, cpy[0].len, 1);
+	  vhost_user_log_dirty_pages_2 (vui, cpy[1].dst, cpy[1].len, 1);
+	  copy_len -= 2;
+	  cpy += 2;
+	}
+    }
+  while (copy_len)
+    {
+      if (PREDICT_FALSE (!(dst0 = map_guest_mem (vui, cpy->dst, map_hint))))
+	return 1;
+      clib_memcpy (dst0, (void *) cpy->src, cpy->len);
+      vhost_user_log_dirty_pages_2 (vui, cpy->dst, cpy->len, 1);
+      copy_len -= 1;
+      cpy += 1;
+    }
+  return 0;
+}
+
+static uword
+vhost_user_tx_packed (vlib_main_t * vm, vlib_node_runtime_t * node,
+		      vlib_frame_t * frame, vhost_user_intf_t * vui)
+{
+  u32 *buffers = vlib_frame_args (frame);
+  u32 n_left = frame->n_vectors;
+  vhost_user_main_t *vum = &vhost_user_main;
+  u32 thread_index = vlib_get_thread_index ();
+  vhost_cpu_t *cpu = &vum->cpus[thread_index];
+  vhost_user_vring_t *rxvq;
+  u32 qid = ~0;
+  u32 map_hint;
+  u32 first_used = ~0;
+  u8 error = VHOST_USER_TX_FUNC_ERROR_NONE;
+  u16 copy_len = 0;
+  u16 tx_headers_len = 0;
+  int is_mrg = (vui->features & (1 << FEAT_VIRTIO_NET_F_MRG_RXBUF)) != 0;
+  struct
+  {
+    u16 id;
+    u16 n_descs;
+    u32 len;
+  } chains[VHOST_USER_PACKED_TX_MAX_CHAINS];
+
+  if (PREDICT_FALSE (!vui->admin_up))
+    {
+      error = VHOST_USER_TX_FUNC_ERROR_DOWN;
+      goto done3;
+    }
+
+  if (PREDICT_FALSE (!vui->is_up))
+    {
+      error = VHOST_USER_TX_FUNC_ERROR_NOT_READY;
+      goto done3;
+    }
+
+  qid =
+    VHOST_VRING_IDX_RX (*vec_elt_at_index
+			(vui->per_cpu_tx_qid, thread_index));
+  rxvq = &vui->vrings[qid];
+  if (PREDICT_FALSE (vui->use_tx_spinlock))
+    vhost_user_vring_lock (vui, qid);
+  map_hint = rxvq->map_hint;
+
+  while (n_left > 0)
+    {
+      vlib_buffer_t *b0, *current_b0;
+      virtio_net_hdr_mrg_rxbuf_t *hdr;
+      u16 avail_idx = rxvq->last_avail_idx;
+      u8 avail_wrap_counter = rxvq->avail_wrap_counter;
+      u16 packet_copy_len = copy_len;
+      u16 n_chains = 0, i;
+      uword src;
+      u32 bytes_left;
+
+      if (PREDICT_TRUE (n_left > 1))
+	vlib_prefetch_buffer_with_index (vm, buffers[1], LOAD);
+
+      b0 = vlib_get_buffer (vm, buffers[0]);
+
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  cpu->current_trace =
+	    vlib_add_trace (vm, node, b0, sizeof (*cpu->current_trace));
+	  vhost_user_packed_trace (cpu->current_trace, vui, qid / 2, rxvq);
+	}
+
+      /*
+       * The virtio header is copied first, from the header array. Its
+       * num_buffers is final by the time the copies are done.
+       */
+      hdr = &cpu->tx_headers[tx_headers_len];
+      tx_headers_len++;
+      hdr->hdr.flags = 0;
+      hdr->hdr.gso_type = 0;
+      hdr->num_buffers = 0;
+      if (PREDICT_FALSE (b0->flags & VHOST_USER_TX_OFFLOAD_BUFFER_FLAGS))
+	vhost_user_handle_tx_offload (vm, vui, b0, &hdr->hdr);
+      src = (uword) hdr;
+      bytes_left = vui->virtio_net_hdr_sz;
+      current_b0 = 0;
+
+      /* One receive buffer (descriptor chain) at a time */
+      while (1)
+	{
+	  vring_packed_desc_t *desc_table = rxvq->packed_desc;
+	  u16 desc_current = rxvq->last_avail_idx;
+	  u16 n_indirect = 0;
+	  u16 n_descs = 1;
+	  u32 chain_len = 0;
+	  uword dst;
+	  u32 dst_len;
+
+	  if (PREDICT_FALSE
+	      (!vhost_user_packed_desc_is_avail (rxvq, desc_current)))
+	    {
+	      error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOBUF;
+	      goto rollback;
+	    }
+
+	  if (PREDICT_FALSE (n_chains == VHOST_USER_PACKED_TX_MAX_CHAINS))
+	    {
+	      error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOMRG;
+	      goto rollback;
+	    }
+
+	  if (desc_table[desc_current].flags & VIRTQ_DESC_F_INDIRECT)
+	    {
+	      n_indirect = desc_table[desc_current].len /
+		sizeof (vring_packed_desc_t);
+	      if (PREDICT_FALSE (n_indirect == 0))
+		{
+		  error = VHOST_USER_TX_FUNC_ERROR_INDIRECT_OVERFLOW;
+		  goto rollback;
+		}
+	      chains[n_chains].id = desc_table[desc_current].id;
+	      if (PREDICT_FALSE
+		  (!(desc_table =
+		     map_guest_mem (vui, desc_table[desc_current].addr,
+				    &map_hint))))
+		{
+		  error = VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL;
+		  goto rollback;
+		}
+	      desc_current = 0;
+	    }
+
+	  dst = desc_table[desc_current].addr;
+	  dst_len = desc_table[desc_current].len;
+	  while (1)
+	    {
+	      if (PREDICT_FALSE (bytes_left == 0))
+		{
+		  /* Header done, then each buffer of the packet */
+		  if (current_b0 == 0)
+		    current_b0 = b0;
+		  else if (current_b0->flags & VLIB_BUFFER_NEXT_PRESENT)
+		    current_b0 = vlib_get_buffer (vm, current_b0->next_buffer);
+		  else
+		    break;	/* end of packet */
+		  src = (uword) vlib_buffer_get_current (current_b0);
+		  bytes_left = current_b0->current_length;
+		  continue;
+		}
+
+	      if (dst_len == 0)
+		{
+		  if (n_indirect)
+		    {
+		      if (++desc_current == n_indirect)
+			break;	/* end of chain */
+		    }
+		  else if ((desc_table[desc_current].flags &
+			    VIRTQ_DESC_F_NEXT) && n_descs <= rxvq->qsz_mask)
+		    {
+		      desc_current = (desc_current + 1) & rxvq->qsz_mask;
+		      n_descs++;
+		    }
+		  else
+		    break;	/* end of chain */
+		  dst = desc_table[desc_current].addr;
+		  dst_len = desc_table[desc_current].len;
+		  continue;
+		}
+
+	      if (PREDICT_FALSE (copy_len == VHOST_USER_COPY_ARRAY_N))
+		{
+		  error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOMRG;
+		  goto rollback;
+		}
+
+	      // Prepare a copy order executed later
+	      vhost_copy_t *cpy = &cpu->copy[copy_len];
+	      copy_len++;
+	      cpy->len = clib_min (bytes_left, dst_len);
+	      cpy->dst = dst;
+	      cpy->src = src;
+
+	      src += cpy->len;
+	      bytes_left -= cpy->len;
+	      dst += cpy->len;
+	      dst_len -= cpy->len;
+	      chain_len += cpy->len;
+	    }
+
+	  /* The whole chain is used, its id is in its last descriptor */
+	  if (!n_indirect)
+	    {
+	      desc_current =
+		vhost_user_packed_chain_end (rxvq, desc_current, &n_descs);
+	      chains[n_chains].id = desc_table[desc_current].id;
+	    }
+	  chains[n_chains].n_descs = n_descs;
+	  chains[n_chains].len = chain_len;
+	  n_chains++;
+	  hdr->num_buffers++;
+	  vhost_user_packed_advance_avail (rxvq, n_descs);
+
+	  if (bytes_left == 0)
+	    break;
+
+	  if (PREDICT_FALSE (!is_mrg))
+	    {
+	      error = VHOST_USER_TX_FUNC_ERROR_PKT_DROP_NOMRG;
+	      goto rollback;
+	    }
+	}
+
+      for (i = 0; i < n_chains; i++)
+	vhost_user_packed_put_used (vui, rxvq, chains[i].id, chains[i].len,
+				    chains[i].n_descs, VIRTQ_DESC_F_WRITE,
+				    &first_used);
+
+      if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	cpu->current_trace->hdr = *hdr;
+
+      n_left--;			//At the end for error counting when 'goto done' is invoked
+      buffers++;
+
+      /*
+       * Do the copy periodically to prevent
+       * vum->cpus[thread_index].copy array overflow and corrupt memory
+       */
+      if (PREDICT_FALSE (copy_len >= VHOST_USER_TX_COPY_THRESHOLD))
+	{
+	  if (PREDICT_FALSE
+	      (vhost_user_tx_copy (vui, cpu->copy, copy_len, &map_hint)))
+	    {
+	      vlib_error_count (vm, node->node_index,
+				VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
+	    }
+	  copy_len = 0;
+
+	  /* give buffers back to driver */
+	  vhost_user_packed_flush_used (vui, rxvq, first_used);
+	  first_used = ~0;
+	}
+      continue;
+
+    rollback:
+      /* Nothing of this packet was given back, forget about it */
+      rxvq->last_avail_idx = avail_idx;
+      rxvq->avail_wrap_counter = avail_wrap_counter;
+      copy_len = packet_copy_len;
+      tx_headers_len--;
+      break;
+    }
+
+  //Do the memory copies
+  if (PREDICT_FALSE
+      (vhost_user_tx_copy (vui, cpu->copy, copy_len, &map_hint)))
+    {
+      vlib_error_count (vm, node->node_index,
+			VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
+    }
+  rxvq->map_hint = map_hint;
+
+  vhost_user_packed_flush_used (vui, rxvq, first_used);
+
+  /* interrupt (call) handling */
+  if ((rxvq->callfd_idx != ~0) &&
+      (rxvq->avail_event->flags != VRING_EVENT_F_DISABLE))
+    {
+      rxvq->n_since_last_int += frame->n_vectors - n_left;
+
+      if (rxvq->n_since_last_int > vum->coalesce_frames)
+	vhost_user_send_call (vm, rxvq);
+    }
+
+  vhost_user_vring_unlock (vui, qid);
+
+done3:
+  if (PREDICT_FALSE (n_left && error != VHOST_USER_TX_FUNC_ERROR_NONE))
+    {
+      vlib_error_count (vm, node->node_index, error, n_left);
+      vlib_increment_simple_counter
+	(vnet_main.interface_main.sw_if_counters
+	 + VNET_INTERFACE_COUNTER_DROP,
+	 thread_index, vui->sw_if_index, n_left);
+    }
+
+  vlib_buffer_free (vm, vlib_frame_args (frame), frame->n_vectors);
+  return frame->n_vectors;
+}
+
+static uword
+vhost_user_tx (vlib_main_t * vm,
 	       vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
   u32 *buffers = vlib_frame_args (frame);
@@ -1991,11 +3114,15 @@ vhost_user_tx (vlib_main_t * vm,
   vhost_user_vring_t *rxvq;
   u8 error;
   u32 thread_index = vlib_get_thread_index ();
-  u32 map_hint = 0;
+  u32 map_hint;
   u8 retry = 8;
+  u16 n_avail;
   u16 copy_len;
   u16 tx_headers_len;
 
+  if (vui->is_packed)
+    return vhost_user_tx_packed (vm, node, frame, vui);
+
   if (PREDICT_FALSE (!vui->admin_up))
     {
       error = VHOST_USER_TX_FUNC_ERROR_DOWN;
@@ -2014,11 +3141,14 @@ vhost_user_tx (vlib_main_t * vm,
   rxvq = &vui->vrings[qid];
   if (PREDICT_FALSE (vui->use_tx_spinlock))
     vhost_user_vring_lock (vui, qid);
+  map_hint = rxvq->map_hint;
 
 retry:
   error = VHOST_USER_TX_FUNC_ERROR_NONE;
   tx_headers_len = 0;
   copy_len = 0;
+  n_avail = rxvq->avail->idx - rxvq->last_avail_idx;
+  vhost_user_prefetch_avail (rxvq, clib_min (n_avail, n_left));
   while (n_left > 0)
     {
       vlib_buffer_t *b0, *current_b0;
@@ -2051,6 +3181,9 @@ retry:
       desc_table = rxvq->desc;
       desc_head = desc_index =
 	rxvq->avail->ring[rxvq->last_avail_idx & rxvq->qsz_mask];
+      if (PREDICT_TRUE ((u16) (rxvq->avail->idx - rxvq->last_avail_idx) >
+			VHOST_USER_DESC_PREFETCH_AHEAD))
+	vhost_user_prefetch_desc (rxvq, VHOST_USER_DESC_PREFETCH_AHEAD);
 
       /* Go deeper in case of indirect descriptor
        * I don't know of any driver providing indirect for RX. */
@@ -2085,6 +3218,8 @@ retry:
 	hdr->hdr.flags = 0;
 	hdr->hdr.gso_type = 0;
 	hdr->num_buffers = 1;	//This is local, no need to check
+	if (PREDICT_FALSE (b0->flags & VHOST_USER_TX_OFFLOAD_BUFFER_FLAGS))
+	  vhost_user_handle_tx_offload (vm, vui, b0, &hdr->hdr);
 
 	// Prepare a copy order executed later for the header
 	vhost_copy_t *cpy = &vum->cpus[thread_index].copy[copy_len];
@@ -2255,6 +3390,7 @@ done:
       vlib_error_count (vm, node->node_index,
 			VHOST_USER_TX_FUNC_ERROR_MMAP_FAIL, 1);
     }
+  rxvq->map_hint = map_hint;
 
   CLIB_MEMORY_BARRIER ();
   rxvq->used->idx = rxvq->last_used_idx;
@@ -2450,10 +3586,20 @@ vhost_user_interface_rx_mode_change (vnet_main_t * vnm, u32 hw_if_index,
 
   txvq->mode = mode;
   if (mode == VNET_HW_INTERFACE_RX_MODE_POLLING)
-    txvq->used->flags = VRING_USED_F_NO_NOTIFY;
+    {
+      if (vui->is_packed)
+	txvq->used_event->flags = VRING_EVENT_F_DISABLE;
+      else
+	txvq->used->flags = VRING_USED_F_NO_NOTIFY;
+    }
   else if ((mode == VNET_HW_INTERFACE_RX_MODE_ADAPTIVE) ||
 	   (mode == VNET_HW_INTERFACE_RX_MODE_INTERRUPT))
-    txvq->used->flags = 0;
+    {
+      if (vui->is_packed)
+	txvq->used_event->flags = VRING_EVENT_F_ENABLE;
+      else
+	txvq->used->flags = 0;
+    }
   else
     {
       clib_warning ("BUG: unhandled mode %d changed for if %d queue %d", mode,
@@ -2802,7 +3948,7 @@ vhost_user_vui_init (vnet_main_t * vnm,
 		     vhost_user_intf_t * vui,
 		     int server_sock_fd,
 		     const char *sock_filename,
-		     u64 feature_mask, u32 * sw_if_index)
+		     u64 feature_mask, u32 * sw_if_index, u8 enable_gso)
 {
   vnet_sw_interface_t *sw;
   int q;
@@ -2830,6 +3976,8 @@ vhost_user_vui_init (vnet_main_t * vnm,
   vui->sock_errno = 0;
   vui->is_up = 0;
   vui->feature_mask = feature_mask;
+  vui->enable_gso = enable_gso;
+  vui->features = 0;
   vui->clib_file_index = ~0;
   vui->log_base_addr = 0;
   vui->if_index = vui - vum->vhost_user_interfaces;
@@ -2840,6 +3988,7 @@ vhost_user_vui_init (vnet_main_t * vnm,
     vhost_user_vring_init (vui, q);
 
   hw->flags |= VNET_HW_INTERFACE_FLAG_SUPPORTS_INT_MODE;
+  vhost_user_update_offload_flags (vnm, vui);
   vnet_hw_interface_set_flags (vnm, vui->hw_if_index, 0);
 
   if (sw_if_index)
@@ -2863,7 +4012,8 @@ vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 		      u8 is_server,
 		      u32 * sw_if_index,
 		      u64 feature_mask,
-		      u8 renumber, u32 custom_dev_instance, u8 * hwaddr)
+		      u8 renumber, u32 custom_dev_instance, u8 * hwaddr,
+		      u8 enable_gso)
 {
   vhost_user_intf_t *vui = NULL;
   u32 sw_if_idx = ~0;
@@ -2901,7 +4051,7 @@ vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 
   vhost_user_create_ethernet (vnm, vm, vui, hwaddr);
   vhost_user_vui_init (vnm, vui, server_sock_fd, sock_filename,
-		       feature_mask, &sw_if_idx);
+		       feature_mask, &sw_if_idx, enable_gso);
 
   if (renumber)
     vnet_interface_name_renumber (sw_if_idx, custom_dev_instance);
@@ -2920,7 +4070,8 @@ vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 		      const char *sock_filename,
 		      u8 is_server,
 		      u32 sw_if_index,
-		      u64 feature_mask, u8 renumber, u32 custom_dev_instance)
+		      u64 feature_mask, u8 renumber, u32 custom_dev_instance,
+		      u8 enable_gso)
 {
   vhost_user_main_t *vum = &vhost_user_main;
   vhost_user_intf_t *vui = NULL;
@@ -2955,7 +4106,7 @@ vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 
   vhost_user_term_if (vui);
   vhost_user_vui_init (vnm, vui, server_sock_fd,
-		       sock_filename, feature_mask, &sw_if_idx);
+		       sock_filename, feature_mask, &sw_if_idx, enable_gso);
 
   if (renumber)
     vnet_interface_name_renumber (sw_if_idx, custom_dev_instance);
@@ -2980,6 +4131,7 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   u32 custom_dev_instance = ~0;
   u8 hwaddr[6];
   u8 *hw = NULL;
+  u8 enable_gso = 0;
   clib_error_t *error = NULL;
 
   /* Get a line of input. */
@@ -3002,6 +4154,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
 	{
 	  renumber = 1;
 	}
+      else if (unformat (line_input, "gso"))
+	enable_gso = 1;
       else
 	{
 	  error = clib_error_return (0, "unknown input `%U'",
@@ -3015,7 +4169,8 @@ vhost_user_connect_command_fn (vlib_main_t * vm,
   int rv;
   if ((rv = vhost_user_create_if (vnm, vm, (char *) sock_filename,
 				  is_server, &sw_if_index, feature_mask,
-				  renumber, custom_dev_instance, hw)))
+				  renumber, custom_dev_instance, hw,
+				  enable_gso)))
     {
       error = clib_error_return (0, "vhost_user_create_if returned %d", rv);
       goto done;
@@ -3300,7 +4455,15 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 			   vui->vrings[q].last_avail_idx,
 			   vui->vrings[q].last_used_idx);
 
-	  if (vui->vrings[q].avail && vui->vrings[q].used)
+	  if (vui->is_packed && vui->vrings[q].avail_event &&
+	      vui->vrings[q].used_event)
+	    vlib_cli_output (vm,
+			     "  avail_wrap %d used_wrap %d driver_event.flags %x device_event.flags %x\n",
+			     vui->vrings[q].avail_wrap_counter,
+			     vui->vrings[q].used_wrap_counter,
+			     vui->vrings[q].avail_event->flags,
+			     vui->vrings[q].used_event->flags);
+	  else if (vui->vrings[q].avail && vui->vrings[q].used)
 	    vlib_cli_output (vm,
 			     "  avail.flags %x avail.idx %d used.flags %x used.idx %d\n",
 			     vui->vrings[q].avail->flags,
@@ -3313,7 +4476,26 @@ show_vhost_user_command_fn (vlib_main_t * vm,
 	  vlib_cli_output (vm, "  kickfd %d callfd %d errfd %d\n",
 			   kickfd, callfd, vui->vrings[q].errfd);
 
-	  if (show_descr)
+	  if (show_descr && vui->is_packed)
+	    {
+	      vlib_cli_output (vm, "\n  descriptor table:\n");
+	      vlib_cli_output (vm,
+			       "   id          addr         len  flags  bid       user_addr\n");
+	      vlib_cli_output (vm,
+			       "  ===== ================== ===== ====== ===== ==================\n");
+	      for (j = 0; j < vui->vrings[q].qsz_mask + 1; j++)
+		{
+		  vring_packed_desc_t *d = &vui->vrings[q].packed_desc[j];
+		  u32 mem_hint = 0;
+		  vlib_cli_output (vm,
+				   "  %-5d 0x%016lx %-5d 0x%04x %-5d 0x%016lx\n",
+				   j, d->addr, d->len, d->flags, d->id,
+				   pointer_to_uword (map_guest_mem
+						     (vui, d->addr,
+						      &mem_hint)));
+		}
+	    }
+	  else if (show_descr)
 	    {
 	      vlib_cli_output (vm, "\n  descriptor table:\n");
 	      vlib_cli_output (vm,
@@ -3364,6 +4546,12 @@ done:
  * - <b>feature-mask <hex></b> - Optional virtio/vhost feature set negotiated at
  * startup. By default, all supported features will be advertised. Otherwise,
  * provide the set of features desired.
+ *   - 0x000000001 (0)  - VIRTIO_NET_F_CSUM (with gso)
+ *   - 0x000000002 (1)  - VIRTIO_NET_F_GUEST_CSUM (with gso)
+ *   - 0x000000080 (7)  - VIRTIO_NET_F_GUEST_TSO4 (with gso)
+ *   - 0x000000100 (8)  - VIRTIO_NET_F_GUEST_TSO6 (with gso)
+ *   - 0x000000800 (11) - VIRTIO_NET_F_HOST_TSO4 (with gso)
+ *   - 0x000001000 (12) - VIRTIO_NET_F_HOST_TSO6 (with gso)
  *   - 0x000008000 (15) - VIRTIO_NET_F_MRG_RXBUF
  *   - 0x000020000 (17) - VIRTIO_NET_F_CTRL_VQ
  *   - 0x000200000 (21) - VIRTIO_NET_F_GUEST_ANNOUNCE
@@ -3374,6 +4562,11 @@ done:
  *   - 0x040000000 (30) - VHOST_USER_F_PROTOCOL_FEATURES
  *   - 0x100000000 (32) - VIRTIO_F_VERSION_1
  *
+ * - <b>gso</b> - Optional flag to also offer checksum and TCP segmentation
+ * offload (VIRTIO_NET_F_CSUM, GUEST_CSUM, GUEST/HOST_TSO4/6) to the
+ * guest. Large TCP packets then cross the interface unsegmented, and are
+ * only segmented on output to an interface that can't take them whole.
+ *
  * - <b>hwaddr <mac-addr></b> - Optional ethernet address, can be in either
  * X:X:X:X:X:X unix or X.X.X cisco format.
  *
@@ -3401,7 +4594,8 @@ done:
 VLIB_CLI_COMMAND (vhost_user_connect_command, static) = {
     .path = "create vhost-user",
     .short_help = "create vhost-user socket <socket-filename> [server] "
-    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] ",
+    "[feature-mask <hex>] [hwaddr <mac-addr>] [renumber <dev_instance>] "
+    "[gso]",
     .function = vhost_user_connect_command_fn,
 };
 /* *INDENT-ON* */
@@ -3566,6 +4760,374 @@ VLIB_CLI_COMMAND (show_vhost_user_command, static) = {
 };
 /* *INDENT-ON* */
 
+/*
+ * Unit test of the rx offload header parsing. A fake interface has one
+ * memory region backed by a local array standing in for guest memory,
+ * where the virtio header and the frame are written before each call.
+ */
+#define VHOST_USER_TEST_GUEST_ADDR 0x10000
+#define VHOST_USER_TEST_NEXT_OFFSET 2048
+#define VHOST_USER_TEST_PAYLOAD 100
+
+#define VHOST_USER_TEST(_cond, _comment, _args...)			\
+{									\
+  if (!(_cond))								\
+    {									\
+      vlib_cli_output (vm, "FAIL:%d: " _comment, __LINE__, ##_args);	\
+      return 1;								\
+    }									\
+}
+
+/* An ethernet frame with up to 2 vlan tags, an ip and a tcp or udp
+ * header, followed by some payload. Returns its length. */
+static u32
+vhost_user_test_mk_frame (u8 * f, u16 ethertype, int n_tags, u8 proto,
+			  u8 tcp_len, u16 * l3_offset, u16 * l4_offset)
+{
+  u32 type_offset = STRUCT_OFFSET_OF (ethernet_header_t, type);
+  u32 len = sizeof (ethernet_header_t);
+  ip4_header_t *ip4;
+  ip6_header_t *ip6;
+  tcp_header_t *tcp;
+  int i;
+
+  memset (f, 0, VHOST_USER_TEST_NEXT_OFFSET);
+  for (i = 0; i < n_tags; i++)
+    {
+      clib_mem_unaligned (f + type_offset, u16) =
+	clib_host_to_net_u16 (i ? ETHERNET_TYPE_VLAN : ETHERNET_TYPE_DOT1AD);
+      type_offset = len + STRUCT_OFFSET_OF (ethernet_vlan_header_t, type);
+      len += sizeof (ethernet_vlan_header_t);
+    }
+  clib_mem_unaligned (f + type_offset, u16) = clib_host_to_net_u16 (ethertype);
+
+  *l3_offset = len;
+  if (ethertype == ETHERNET_TYPE_IP6)
+    {
+      ip6 = (ip6_header_t *) (f + len);
+      ip6->ip_version_traffic_class_and_flow_label =
+	clib_host_to_net_u32 (0x60000000);
+      ip6->protocol = proto;
+      len += sizeof (ip6_header_t);
+    }
+  else
+    {
+      ip4 = (ip4_header_t *) (f + len);
+      ip4->ip_version_and_header_length = 0x45;
+      ip4->protocol = proto;
+      len += sizeof (ip4_header_t);
+    }
+
+  *l4_offset = len;
+  if (proto == IP_PROTOCOL_TCP)
+    {
+      tcp = (tcp_header_t *) (f + len);
+      tcp->data_offset_and_reserved = (tcp_len / 4) << 4;
+      len += tcp_len;
+    }
+  else
+    len += sizeof (udp_header_t);
+
+  return len + VHOST_USER_TEST_PAYLOAD;
+}
+
+/* Write the header and the frame to guest memory, in one descriptor or
+ * in two, and parse them into a clean buffer */
+static int
+vhost_user_test_rx_offload_run (vhost_user_intf_t * vui, vlib_buffer_t * b,
+				virtio_net_hdr_t * hdr, u8 * frame,
+				u32 frame_len, int split)
+{
+  u8 *mem = vui->region_mmap_addr[0];
+  u64 addr = VHOST_USER_TEST_GUEST_ADDR;
+  u32 hdr_sz = vui->virtio_net_hdr_sz;
+  u32 hint = 0;
+
+  memset (mem, 0, vui->regions[0].memory_size);
+  clib_memcpy (mem, hdr, sizeof (*hdr));
+
+  b->flags = 0;
+  b->current_data = 0;
+  memset (vnet_buffer (b), 0, sizeof (vnet_buffer_opaque_t));
+  memset (vnet_buffer2 (b), 0, sizeof (vnet_buffer_opaque2_t));
+
+  if (split)
+    {
+      clib_memcpy (mem + VHOST_USER_TEST_NEXT_OFFSET, frame, frame_len);
+      return vhost_user_handle_rx_offload (vui, b, addr, hdr_sz,
+					   addr + VHOST_USER_TEST_NEXT_OFFSET,
+					   frame_len, &hint);
+    }
+
+  clib_memcpy (mem + hdr_sz, frame, frame_len);
+  return vhost_user_handle_rx_offload (vui, b, addr, hdr_sz + frame_len,
+				       0, 0, &hint);
+}
+
+static int
+vhost_user_test_rx_offload (vlib_main_t * vm, vhost_user_intf_t * vui,
+			    vlib_buffer_t * b)
+{
+  u8 frame[VHOST_USER_TEST_NEXT_OFFSET];
+  virtio_net_hdr_t hdr;
+  u32 len, hint = 0, csum_flags;
+  u16 l3, l4;
+  int split;
+
+  csum_flags = VNET_BUFFER_F_L4_CHECKSUM_COMPUTED |
+    VNET_BUFFER_F_L4_CHECKSUM_CORRECT;
+
+  for (split = 0; split < 2; split++)
+    {
+      /* No partial checksum: nothing to do */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP4, 0,
+				      IP_PROTOCOL_TCP, 20, &l3, &l4);
+      memset (&hdr, 0, sizeof (hdr));
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "no offload accepted, split %d", split);
+      VHOST_USER_TEST (b->flags == 0, "no offload flags, split %d", split);
+
+      /* ip4 tcp checksum */
+      hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+      hdr.csum_start = l4;
+      hdr.csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "ip4 tcp accepted, split %d", split);
+      VHOST_USER_TEST (b->flags == (VNET_BUFFER_F_IS_IP4 |
+				    VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+				    csum_flags),
+		       "ip4 tcp flags 0x%x, split %d", b->flags, split);
+      VHOST_USER_TEST (vnet_buffer (b)->l2_hdr_offset == 0 &&
+		       vnet_buffer (b)->l3_hdr_offset == 14 &&
+		       vnet_buffer (b)->l4_hdr_offset == 34,
+		       "ip4 tcp offsets %d %d %d, split %d",
+		       vnet_buffer (b)->l2_hdr_offset,
+		       vnet_buffer (b)->l3_hdr_offset,
+		       vnet_buffer (b)->l4_hdr_offset, split);
+
+      /* ip6 udp checksum */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP6, 0,
+				      IP_PROTOCOL_UDP, 0, &l3, &l4);
+      hdr.csum_start = l4;
+      hdr.csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "ip6 udp accepted, split %d", split);
+      VHOST_USER_TEST (b->flags == (VNET_BUFFER_F_IS_IP6 |
+				    VNET_BUFFER_F_OFFLOAD_UDP_CKSUM |
+				    csum_flags),
+		       "ip6 udp flags 0x%x, split %d", b->flags, split);
+      VHOST_USER_TEST (vnet_buffer (b)->l3_hdr_offset == 14 &&
+		       vnet_buffer (b)->l4_hdr_offset == 54,
+		       "ip6 udp offsets %d %d, split %d",
+		       vnet_buffer (b)->l3_hdr_offset,
+		       vnet_buffer (b)->l4_hdr_offset, split);
+
+      /* dot1q and qinq tags are skipped to find the ethertype */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP4, 1,
+				      IP_PROTOCOL_TCP, 20, &l3, &l4);
+      hdr.csum_start = l4;
+      hdr.csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "dot1q accepted, split %d", split);
+      VHOST_USER_TEST ((b->flags & VNET_BUFFER_F_IS_IP4) &&
+		       vnet_buffer (b)->l3_hdr_offset == 18 &&
+		       vnet_buffer (b)->l4_hdr_offset == 38,
+		       "dot1q offsets %d %d, split %d",
+		       vnet_buffer (b)->l3_hdr_offset,
+		       vnet_buffer (b)->l4_hdr_offset, split);
+
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP6, 2,
+				      IP_PROTOCOL_TCP, 20, &l3, &l4);
+      hdr.csum_start = l4;
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "qinq accepted, split %d", split);
+      VHOST_USER_TEST ((b->flags & VNET_BUFFER_F_IS_IP6) &&
+		       vnet_buffer (b)->l3_hdr_offset == 22 &&
+		       vnet_buffer (b)->l4_hdr_offset == 62,
+		       "qinq offsets %d %d, split %d",
+		       vnet_buffer (b)->l3_hdr_offset,
+		       vnet_buffer (b)->l4_hdr_offset, split);
+
+      /* TSO, with tcp options: the l4 header size comes from the tcp
+       * data offset */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP4, 0,
+				      IP_PROTOCOL_TCP, 32, &l3, &l4);
+      hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+      hdr.gso_size = 1448;
+      hdr.hdr_len = l4 + 32;
+      hdr.csum_start = l4;
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "tso4 accepted, split %d", split);
+      VHOST_USER_TEST (b->flags == (VNET_BUFFER_F_IS_IP4 |
+				    VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+				    VNET_BUFFER_F_GSO | csum_flags),
+		       "tso4 flags 0x%x, split %d", b->flags, split);
+      VHOST_USER_TEST (vnet_buffer2 (b)->gso_size == 1448 &&
+		       vnet_buffer2 (b)->gso_l4_hdr_sz == 32,
+		       "tso4 gso size %d l4 header %d, split %d",
+		       vnet_buffer2 (b)->gso_size,
+		       vnet_buffer2 (b)->gso_l4_hdr_sz, split);
+
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP6, 0,
+				      IP_PROTOCOL_TCP, 20, &l3, &l4);
+      hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV6;
+      hdr.gso_size = 1428;
+      hdr.csum_start = l4;
+      VHOST_USER_TEST (!vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							 len, split),
+		       "tso6 accepted, split %d", split);
+      VHOST_USER_TEST (b->flags == (VNET_BUFFER_F_IS_IP6 |
+				    VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+				    VNET_BUFFER_F_GSO | csum_flags),
+		       "tso6 flags 0x%x, split %d", b->flags, split);
+      VHOST_USER_TEST (vnet_buffer2 (b)->gso_size == 1428 &&
+		       vnet_buffer2 (b)->gso_l4_hdr_sz == 20 &&
+		       vnet_buffer (b)->l4_hdr_offset == 54,
+		       "tso6 gso size %d l4 header %d offset %d, split %d",
+		       vnet_buffer2 (b)->gso_size,
+		       vnet_buffer2 (b)->gso_l4_hdr_sz,
+		       vnet_buffer (b)->l4_hdr_offset, split);
+
+      /* TSO needs a tcp checksum and a segment size */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP4, 0,
+				      IP_PROTOCOL_UDP, 0, &l3, &l4);
+      hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+      hdr.csum_start = l4;
+      hdr.csum_offset = STRUCT_OFFSET_OF (udp_header_t, checksum);
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							len, split),
+		       "gso with a udp checksum dropped, split %d", split);
+
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP4, 0,
+				      IP_PROTOCOL_TCP, 20, &l3, &l4);
+      hdr.csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+      hdr.gso_size = 0;
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							len, split),
+		       "gso size 0 dropped, split %d", split);
+
+      /* a tcp header running past the first buffer */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_IP4, 0,
+				      IP_PROTOCOL_TCP, 60, &l3, &l4);
+      hdr.gso_size = 1448;
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							l4 + 20, split),
+		       "truncated tcp header dropped, split %d", split);
+
+      /* bad checksum locations */
+      hdr.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+      hdr.gso_size = 0;
+      hdr.csum_offset = 4;
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							len, split),
+		       "csum offset 4 dropped, split %d", split);
+
+      hdr.csum_offset = STRUCT_OFFSET_OF (tcp_header_t, checksum);
+      hdr.csum_start = sizeof (ethernet_header_t);
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							len, split),
+		       "csum start in l2 dropped, split %d", split);
+
+      hdr.csum_start = len - hdr.csum_offset - 1;
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							len, split),
+		       "csum past the frame dropped, split %d", split);
+
+      /* neither ip4 nor ip6 */
+      len = vhost_user_test_mk_frame (frame, ETHERNET_TYPE_ARP, 0,
+				      IP_PROTOCOL_TCP, 20, &l3, &l4);
+      hdr.csum_start = l4;
+      VHOST_USER_TEST (vhost_user_test_rx_offload_run (vui, b, &hdr, frame,
+							len, split),
+		       "arp dropped, split %d", split);
+    }
+
+  /* The header alone, with no next descriptor, or not even that */
+  hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+  VHOST_USER_TEST (vhost_user_handle_rx_offload (vui, b,
+						 VHOST_USER_TEST_GUEST_ADDR,
+						 vui->virtio_net_hdr_sz,
+						 0, 0, &hint),
+		   "header without a frame dropped");
+  VHOST_USER_TEST (vhost_user_handle_rx_offload (vui, b,
+						 VHOST_USER_TEST_GUEST_ADDR,
+						 vui->virtio_net_hdr_sz - 1,
+						 0, 0, &hint),
+		   "short header dropped");
+
+  /* Outside guest memory */
+  VHOST_USER_TEST (vhost_user_handle_rx_offload (vui, b,
+						 VHOST_USER_TEST_GUEST_ADDR +
+						 vui->regions[0].memory_size,
+						 vui->virtio_net_hdr_sz + 64,
+						 0, 0, &hint),
+		   "unmapped header dropped");
+
+  return 0;
+}
+
+static clib_error_t *
+test_vhost_user_command_fn (vlib_main_t * vm,
+			    unformat_input_t * input,
+			    vlib_cli_command_t * cmd)
+{
+  vhost_user_intf_t *vui;
+  vlib_buffer_t *b;
+  u8 *mem = 0;
+  u32 bi;
+  int res = 0;
+
+  if (!unformat (input, "rx-offload"))
+    return clib_error_return (0, "unknown input `%U'",
+			      format_unformat_error, input);
+
+  if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+    return clib_error_return (0, "buffer allocation failure");
+  b = vlib_get_buffer (vm, bi);
+
+  vui = clib_mem_alloc (sizeof (*vui));
+  memset (vui, 0, sizeof (*vui));
+  vec_validate (mem, 2 * VHOST_USER_TEST_NEXT_OFFSET - 1);
+
+  vui->nregions = 1;
+  vui->regions[0].guest_phys_addr = VHOST_USER_TEST_GUEST_ADDR;
+  vui->regions[0].memory_size = vec_len (mem);
+  vui->region_mmap_addr[0] = mem;
+  vui->region_guest_addr_lo[0] = vui->regions[0].guest_phys_addr;
+  vui->region_guest_addr_hi[0] = vui->regions[0].guest_phys_addr +
+    vui->regions[0].memory_size;
+
+  /* With and without the mergeable rx buffers' num_buffers field */
+  vui->virtio_net_hdr_sz = sizeof (virtio_net_hdr_mrg_rxbuf_t);
+  res += vhost_user_test_rx_offload (vm, vui, b);
+  vui->virtio_net_hdr_sz = sizeof (virtio_net_hdr_t);
+  res += vhost_user_test_rx_offload (vm, vui, b);
+
+  vec_free (mem);
+  clib_mem_free (vui);
+  vlib_buffer_free_one (vm, bi);
+
+  if (res)
+    return clib_error_return (0, "vhost-user rx-offload unit test Failed");
+
+  vlib_cli_output (vm, "vhost-user rx-offload unit test OK");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_vhost_user_command, static) = {
+  .path = "test vhost-user",
+  .short_help = "test vhost-user rx-offload",
+  .function = test_vhost_user_command_fn,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 debug_vhost_user_command_fn (vlib_main_t * vm,
 			     unformat_input_t * input,
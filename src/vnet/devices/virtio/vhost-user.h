@@ -25,7 +25,10 @@
 
 #define VHOST_USER_VRING_NOFD_MASK      0x100
 #define VIRTQ_DESC_F_NEXT               1
+#define VIRTQ_DESC_F_WRITE              2
 #define VIRTQ_DESC_F_INDIRECT           4
+#define VIRTQ_DESC_F_AVAIL              (1 << 7)
+#define VIRTQ_DESC_F_USED               (1 << 15)
 #define VHOST_USER_REPLY_MASK       (0x1 << 2)
 
 #define VHOST_USER_PROTOCOL_F_MQ   0
@@ -45,7 +48,26 @@
 #define VRING_USED_F_NO_NOTIFY  1
 #define VRING_AVAIL_F_NO_INTERRUPT 1
 
+/* Packed ring event suppression flags */
+#define VRING_EVENT_F_ENABLE  0x0
+#define VRING_EVENT_F_DISABLE 0x1
+
+/* Packed ring wrap counter in VHOST_USER_[GS]ET_VRING_BASE num */
+#define VHOST_VRING_IDX_WRAP_COUNTER    (1 << 15)
+
+/* virtio_net_hdr_t flags and gso_type */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM     1
+#define VIRTIO_NET_HDR_GSO_NONE         0
+#define VIRTIO_NET_HDR_GSO_TCPV4        1
+#define VIRTIO_NET_HDR_GSO_TCPV6        4
+
 #define foreach_virtio_net_feature      \
+ _ (VIRTIO_NET_F_CSUM, 0)               \
+ _ (VIRTIO_NET_F_GUEST_CSUM, 1)         \
+ _ (VIRTIO_NET_F_GUEST_TSO4, 7)         \
+ _ (VIRTIO_NET_F_GUEST_TSO6, 8)         \
+ _ (VIRTIO_NET_F_HOST_TSO4, 11)         \
+ _ (VIRTIO_NET_F_HOST_TSO6, 12)         \
  _ (VIRTIO_NET_F_MRG_RXBUF, 15)         \
  _ (VIRTIO_NET_F_CTRL_VQ, 17)           \
  _ (VIRTIO_NET_F_GUEST_ANNOUNCE, 21)    \
@@ -54,7 +76,9 @@
  _ (VIRTIO_F_ANY_LAYOUT, 27)            \
  _ (VIRTIO_F_INDIRECT_DESC, 28)         \
  _ (VHOST_USER_F_PROTOCOL_FEATURES, 30) \
- _ (VIRTIO_F_VERSION_1, 32)
+ _ (VIRTIO_F_VERSION_1, 32)            \
+ _ (VIRTIO_F_RING_PACKED, 34)           \
+ _ (VIRTIO_F_IN_ORDER, 35)
 
 
 typedef enum
@@ -67,11 +91,13 @@ typedef enum
 int vhost_user_create_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 * sw_if_index, u64 feature_mask,
-			  u8 renumber, u32 custom_dev_instance, u8 * hwaddr);
+			  u8 renumber, u32 custom_dev_instance, u8 * hwaddr,
+			  u8 enable_gso);
 int vhost_user_modify_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  const char *sock_filename, u8 is_server,
 			  u32 sw_if_index, u64 feature_mask,
-			  u8 renumber, u32 custom_dev_instance);
+			  u8 renumber, u32 custom_dev_instance,
+			  u8 enable_gso);
 int vhost_user_delete_if (vnet_main_t * vnm, vlib_main_t * vm,
 			  u32 sw_if_index);
 
@@ -141,6 +167,22 @@ typedef struct
   uint16_t next;  // optional index next descriptor in chain
 } __attribute ((packed)) vring_desc_t;
 
+// packed ring descriptor, the single ring shared by driver and device
+typedef struct
+{
+  uint64_t addr;  // packet data buffer address
+  uint32_t len;   // packet data buffer size
+  uint16_t id;    // buffer id, valid in the last descriptor of a chain
+  uint16_t flags; // (see below)
+} __attribute ((packed)) vring_packed_desc_t;
+
+// packed ring driver and device event suppression areas
+typedef struct
+{
+  uint16_t off_wrap;
+  volatile uint16_t flags;
+} __attribute ((packed)) vring_desc_event_t;
+
 typedef struct
 {
   uint16_t flags;
@@ -196,18 +238,41 @@ typedef struct
   u16 last_avail_idx;
   u16 last_used_idx;
   u16 n_since_last_int;
-  vring_desc_t *desc;
-  vring_avail_t *avail;
-  vring_used_t *used;
+  /*
+   * With a packed ring, desc is the descriptor ring, avail the driver
+   * event suppression area and used the device one. last_avail_idx
+   * and last_used_idx are then ring positions, each paired with a wrap
+   * counter.
+   */
+  union
+  {
+    vring_desc_t *desc;
+    vring_packed_desc_t *packed_desc;
+  };
+  union
+  {
+    vring_avail_t *avail;
+    vring_desc_event_t *avail_event;
+  };
+  union
+  {
+    vring_used_t *used;
+    vring_desc_event_t *used_event;
+  };
   f64 int_deadline;
   u8 started;
   u8 enabled;
   u8 log_used;
+  u8 avail_wrap_counter;
+  u8 used_wrap_counter;
+  /* Memory region of the last guest address translated on this vring */
+  u32 map_hint;
   //Put non-runtime in a different cache line
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline1);
   int errfd;
   u32 callfd_idx;
   u32 kickfd_idx;
+  /* Guest address of the used ring, or of the descriptor ring if packed */
   u64 log_guest_addr;
 
   /* The rx queue policy (interrupt/adaptive/polling) for this queue */
@@ -248,6 +313,10 @@ typedef struct
 
   int virtio_net_hdr_sz;
   int is_any_layout;
+  u8 is_packed;
+
+  /* Offer checksum and TSO offload to the guest */
+  u8 enable_gso;
 
   void *log_base_addr;
   u64 log_size;
@@ -432,6 +432,38 @@ fib_entry_src_collect_forwarding (fib_node_index_t pl_index,
     return (FIB_PATH_LIST_WALK_CONTINUE);
 }
 
+/**
+ * @brief Should the entry's load-balance stack on the PIC load-balance of
+ * its path-list. Not if the entry's forwarding differs from that of the
+ * path-list, i.e. it has path extensions, is exclusive or is multicast.
+ * Nor if the path-list has no resolved paths, so the entry's load-balance
+ * is seen as a drop by those that recurse through it.
+ */
+static int
+fib_entry_src_use_pic (const fib_entry_t *fib_entry,
+                       const fib_entry_src_t *esrc,
+                       fib_forward_chain_type_t fct)
+{
+    dpo_id_t tmp = DPO_INVALID;
+    int use;
+
+    if ((FIB_FORW_CHAIN_TYPE_UNICAST_IP4 != fct &&
+         FIB_FORW_CHAIN_TYPE_UNICAST_IP6 != fct) ||
+        (esrc->fes_entry_flags & (FIB_ENTRY_FLAG_EXCLUSIVE |
+                                  FIB_ENTRY_FLAG_MULTICAST)) ||
+        0 != vec_len(esrc->fes_path_exts.fpel_exts) ||
+        !fib_path_list_is_pic(esrc->fes_pl))
+    {
+        return (0);
+    }
+
+    fib_path_list_contribute_pic_forwarding(esrc->fes_pl, fct, &tmp);
+    use = !load_balance_is_drop(&tmp);
+    dpo_reset(&tmp);
+
+    return (use);
+}
+
 void
 fib_entry_src_mk_lb (fib_entry_t *fib_entry,
 		     const fib_entry_src_t *esrc,
@@ -464,9 +496,26 @@ fib_entry_src_mk_lb (fib_entry_t *fib_entry,
 
     lb_proto = fib_forw_chain_type_to_dpo_proto(fct);
 
-    fib_path_list_walk(esrc->fes_pl,
-                       fib_entry_src_collect_forwarding,
-                       &ctx);
+    if (fib_entry_src_use_pic(fib_entry, esrc, fct))
+    {
+        load_balance_path_t *nh;
+
+        /*
+         * stack on the path-list's load-balance; when the paths change it
+         * is updated in place and this entry follows without a walk.
+         */
+        vec_add2(ctx.next_hops, nh, 1);
+        nh->path_index = FIB_NODE_INDEX_INVALID;
+        nh->path_weight = 1;
+        fib_path_list_contribute_pic_forwarding(esrc->fes_pl, fct,
+                                                &nh->path_dpo);
+    }
+    else
+    {
+        fib_path_list_walk(esrc->fes_pl,
+                           fib_entry_src_collect_forwarding,
+                           &ctx);
+    }
 
     if (esrc->fes_entry_flags & FIB_ENTRY_FLAG_EXCLUSIVE)
     {
@@ -24,6 +24,7 @@
 #include <vnet/fib/fib_node_list.h>
 #include <vnet/fib/fib_walk.h>
 #include <vnet/fib/fib_urpf_list.h>
+#include <vnet/fib/fib_table.h>
 
 /**
  * The magic number of child entries that make a path-list popular.
@@ -65,6 +66,12 @@ typedef struct fib_path_list_t_ {
      * Hash table of paths. valid only with INDEXED flag
      */
     uword *fpl_db;
+
+    /**
+     * Load-balances, indexed by chain type, that the children of a PIC
+     * path-list link to. They are updated in place as paths go up or down.
+     */
+    dpo_id_t *fpl_pic_lbs;
 } fib_path_list_t;
 
 /*
@@ -82,6 +89,13 @@ static fib_path_list_t * fib_path_list_pool;
  */
 static uword *fib_path_list_db;
 
+/*
+ * Prefix Independent Convergence. When enabled the children of popular
+ * shared path-lists stack on a load-balance owned by the path-list, so a
+ * path failure is a single in-place update rather than one per child.
+ */
+static int fib_path_list_pic;
+
 /*
  * Debug macro
  */
@@ -310,6 +324,7 @@ static void
 fib_path_list_destroy (fib_path_list_t *path_list)
 {
     fib_node_index_t *path_index;
+    dpo_id_t *dpo;
 
     FIB_PATH_LIST_DBG(path_list, "destroy");
 
@@ -317,6 +332,11 @@ fib_path_list_destroy (fib_path_list_t *path_list)
     {
 	fib_path_destroy(*path_index);
     }
+    vec_foreach (dpo, path_list->fpl_pic_lbs)
+    {
+        dpo_reset(dpo);
+    }
+    vec_free(path_list->fpl_pic_lbs);
 
     vec_free(path_list->fpl_paths);
     fib_urpf_list_unlock(path_list->fpl_urpf);
@@ -391,6 +411,68 @@ fib_path_list_mk_lb (fib_path_list_t *path_list,
     vec_free(nhs);
 }
 
+/*
+ * fib_path_list_mk_pic_lb
+ *
+ * update the load-balance a PIC path-list's children stack on. Only the
+ * resolved paths of the best preference contribute, as they would to each
+ * child's own load-balance; the paths are sorted by preference.
+ */
+static void
+fib_path_list_mk_pic_lb (fib_path_list_t *path_list,
+                         fib_forward_chain_type_t fct,
+                         dpo_id_t *dpo)
+{
+    load_balance_path_t *nhs;
+    fib_node_index_t *path_index;
+    dpo_proto_t lb_proto;
+    u16 preference;
+
+    nhs = NULL;
+    preference = 0xffff;
+    lb_proto = fib_forw_chain_type_to_dpo_proto(fct);
+
+    if (!dpo_id_is_valid(dpo))
+    {
+        /*
+         * first time create. The children share it, whatever table they
+         * are in, so use the default flow-hash.
+         */
+        dpo_set(dpo,
+                DPO_LOAD_BALANCE,
+                lb_proto,
+                load_balance_create(0,
+                                    lb_proto,
+                                    fib_table_get_default_flow_hash_config(
+                                        dpo_proto_to_fib(lb_proto))));
+    }
+
+    vec_foreach (path_index, path_list->fpl_paths)
+    {
+        if (!fib_path_is_resolved(*path_index))
+        {
+            continue;
+        }
+        if (0xffff == preference)
+        {
+            preference = fib_path_get_preference(*path_index);
+        }
+        else if (preference != fib_path_get_preference(*path_index))
+        {
+            break;
+        }
+	nhs = fib_path_append_nh_for_multipath_hash(*path_index,
+                                                    fct,
+                                                    nhs);
+    }
+
+    load_balance_multipath_update(dpo, nhs, LOAD_BALANCE_FLAG_NONE);
+
+    FIB_PATH_LIST_DBG(path_list, "mk pic lb: %d", dpo->dpoi_index);
+
+    vec_free(nhs);
+}
+
 /**
  * @brief [re]build the path list's uRPF list
  */
@@ -456,11 +538,26 @@ fib_path_list_back_walk (fib_node_index_t path_list_index,
 			 fib_node_back_walk_ctx_t *ctx)
 {
     fib_path_list_t *path_list;
+    fib_forward_chain_type_t fct;
 
     path_list = fib_path_list_get(path_list_index);
 
     fib_path_list_mk_urpf(path_list);
 
+    /*
+     * the PIC load-balances are updated now, this is what switches all
+     * the children at once. The children themselves can then take their
+     * time to re-evaluate.
+     */
+    vec_foreach_index (fct, path_list->fpl_pic_lbs)
+    {
+        if (dpo_id_is_valid(&path_list->fpl_pic_lbs[fct]))
+        {
+            fib_path_list_mk_pic_lb(path_list, fct,
+                                    &path_list->fpl_pic_lbs[fct]);
+        }
+    }
+
     /*
      * propagate the backwalk further
      */
@@ -650,6 +747,28 @@ fib_path_list_is_popular (fib_node_index_t path_list_index)
     return (path_list->fpl_flags & FIB_PATH_LIST_FLAG_POPULAR);
 }
 
+/**
+ * @brief Do the path-list's children stack on its PIC load-balance.
+ * Only shared path-lists are candidates, since the sharing is what makes
+ * the single update worthwhile, and only once they are popular; below
+ * that the extra level of indirection in the switch path is not worth it.
+ */
+int
+fib_path_list_is_pic (fib_node_index_t path_list_index)
+{
+    fib_path_list_t *path_list;
+
+    if (!fib_path_list_pic)
+    {
+        return (0);
+    }
+
+    path_list = fib_path_list_get(path_list_index);
+
+    return ((path_list->fpl_flags & FIB_PATH_LIST_FLAG_POPULAR) &&
+            (path_list->fpl_flags & FIB_PATH_LIST_FLAG_SHARED));
+}
+
 static fib_path_list_flags_t
 fib_path_list_flags_fixup (fib_path_list_flags_t flags)
 {
@@ -1157,6 +1276,82 @@ fib_path_list_contribute_forwarding (fib_node_index_t path_list_index,
     fib_path_list_mk_lb(path_list, fct, dpo);
 }
 
+/*
+ * fib_path_list_contribute_pic_forwarding
+ *
+ * Return the path-list's own load-balance for the chain type, creating it
+ * on first use. Unlike the one from fib_path_list_contribute_forwarding
+ * this is kept and updated in place when the paths change.
+ */
+void
+fib_path_list_contribute_pic_forwarding (fib_node_index_t path_list_index,
+                                         fib_forward_chain_type_t fct,
+                                         dpo_id_t *dpo)
+{
+    fib_path_list_t *path_list;
+
+    path_list = fib_path_list_get(path_list_index);
+
+    vec_validate(path_list->fpl_pic_lbs, fct);
+
+    if (!dpo_id_is_valid(&path_list->fpl_pic_lbs[fct]))
+    {
+        fib_path_list_mk_pic_lb(path_list, fct,
+                                &path_list->fpl_pic_lbs[fct]);
+    }
+
+    dpo_copy(dpo, &path_list->fpl_pic_lbs[fct]);
+}
+
+/**
+ * @brief Enable or disable PIC. The children of the popular path-lists
+ * are re-evaluated so they stack on, or move off, the PIC load-balances.
+ */
+void
+fib_path_list_pic_enable (int enable)
+{
+    fib_node_back_walk_ctx_t ctx = {
+        .fnbw_reason = FIB_NODE_BW_REASON_FLAG_EVALUATE,
+    };
+    fib_node_index_t *pls, *pli;
+    fib_path_list_t *path_list;
+    dpo_id_t *dpo;
+
+    if (fib_path_list_pic == !!enable)
+    {
+        return;
+    }
+
+    fib_path_list_pic = !!enable;
+    pls = NULL;
+
+    pool_foreach(path_list, fib_path_list_pool,
+    ({
+        if (path_list->fpl_flags & FIB_PATH_LIST_FLAG_POPULAR)
+        {
+            vec_add1(pls, fib_path_list_get_index(path_list));
+        }
+    }));
+
+    vec_foreach(pli, pls)
+    {
+	fib_walk_sync(FIB_NODE_TYPE_PATH_LIST, *pli, &ctx);
+
+        if (!enable)
+        {
+            path_list = fib_path_list_get(*pli);
+
+            vec_foreach (dpo, path_list->fpl_pic_lbs)
+            {
+                dpo_reset(dpo);
+            }
+            vec_free(path_list->fpl_pic_lbs);
+        }
+    }
+
+    vec_free(pls);
+}
+
 /*
  * fib_path_list_get_adj
  *
@@ -1383,3 +1578,32 @@ VLIB_CLI_COMMAND (show_fib_path_list, static) = {
   .function = show_fib_path_list_command,
   .short_help = "show fib path-lists",
 };
+
+static clib_error_t *
+set_fib_pic_command (vlib_main_t * vm,
+		     unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+    fib_path_list_pic_enable(!unformat (input, "disable"));
+
+    return (NULL);
+}
+
+/*?
+ * Enable or disable Prefix Independent Convergence. With PIC the prefixes
+ * that share a popular path-list, typically BGP routes via the same set of
+ * next-hops, forward through a load-balance owned by the path-list. When a
+ * next-hop fails that one load-balance is updated and all the prefixes move
+ * to the remaining paths, or to the next preference, at once; each prefix's
+ * own forwarding is then updated in the background. The cost is an extra
+ * load-balance in the switch path for those prefixes.
+ *
+ * @cliexpar
+ * @cliexcmd{set fib pic}
+ * @cliexcmd{set fib pic disable}
+ ?*/
+VLIB_CLI_COMMAND (set_fib_pic, static) = {
+  .path = "set fib pic",
+  .function = set_fib_pic_command,
+  .short_help = "set fib pic [disable]",
+};
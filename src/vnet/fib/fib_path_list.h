@@ -130,6 +130,10 @@ extern u32 fib_path_list_get_n_paths(fib_node_index_t pl_index);
 extern void fib_path_list_contribute_forwarding(fib_node_index_t path_list_index,
 						fib_forward_chain_type_t type,
 						dpo_id_t *dpo);
+extern void fib_path_list_contribute_pic_forwarding(
+    fib_node_index_t path_list_index,
+    fib_forward_chain_type_t type,
+    dpo_id_t *dpo);
 extern void fib_path_list_contribute_urpf(fib_node_index_t path_index,
 					  index_t urpf);
 extern index_t fib_path_list_get_urpf(fib_node_index_t path_list_index);
@@ -150,6 +154,8 @@ extern int fib_path_list_recursive_loop_detect(fib_node_index_t path_list_index,
 extern u32 fib_path_list_get_resolving_interface(fib_node_index_t path_list_index);
 extern int fib_path_list_is_looped(fib_node_index_t path_list_index);
 extern int fib_path_list_is_popular(fib_node_index_t path_list_index);
+extern int fib_path_list_is_pic(fib_node_index_t path_list_index);
+extern void fib_path_list_pic_enable(int enable);
 extern dpo_proto_t fib_path_list_get_proto(fib_node_index_t path_list_index);
 extern u8 * fib_path_list_format(fib_node_index_t pl_index,
 				 u8 * s);
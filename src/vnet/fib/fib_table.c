@@ -19,10 +19,48 @@
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_entry_cover.h>
 #include <vnet/fib/fib_internal.h>
+#include <vnet/fib/fib_walk.h>
 #include <vnet/fib/ip4_fib.h>
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/fib/mpls_fib.h>
 
+/**
+ * An IP forwarding update deferred by batch mode
+ */
+typedef struct fib_table_batch_fwd_t_
+{
+    u32 ftbf_fib_index;
+    /**
+     * order of arrival; the last update for a prefix is the one applied
+     */
+    u32 ftbf_seq;
+    fib_prefix_t ftbf_prefix;
+    dpo_id_t ftbf_dpo;
+} fib_table_batch_fwd_t;
+
+/**
+ * Batch mode state. see fib_table_batch_begin()
+ */
+typedef struct fib_table_batch_t_
+{
+    /**
+     * nesting depth of fib_table_batch_begin()
+     */
+    u32 ftb_depth;
+
+    /**
+     * set of locked covers that have had a more specific inserted
+     */
+    uword *ftb_covers;
+
+    /**
+     * deferred IP forwarding updates
+     */
+    fib_table_batch_fwd_t *ftb_fwds;
+} fib_table_batch_t;
+
+static fib_table_batch_t fib_table_batch;
+
 fib_table_t *
 fib_table_get (fib_node_index_t index,
 	       fib_protocol_t proto)
@@ -190,8 +228,24 @@ fib_table_post_insert_actions (fib_table_t *fib_table,
      */
     if (fib_entry_cover_index != fib_entry_index)
     {
-	fib_entry_cover_change_notify(fib_entry_cover_index,
-				      fib_entry_index);
+        if (fib_table_batch.ftb_depth)
+        {
+            /*
+             * the cover's dependents are told at commit, once.
+             */
+            if (NULL == hash_get(fib_table_batch.ftb_covers,
+                                 fib_entry_cover_index))
+            {
+                fib_entry_lock(fib_entry_cover_index);
+                hash_set(fib_table_batch.ftb_covers,
+                         fib_entry_cover_index, 1);
+            }
+        }
+        else
+        {
+            fib_entry_cover_change_notify(fib_entry_cover_index,
+                                          fib_entry_index);
+        }
     }
 }
 
@@ -230,13 +284,11 @@ fib_table_entry_insert (fib_table_t *fib_table,
     fib_table_post_insert_actions(fib_table, prefix, fib_entry_index);
 }
 
-void
-fib_table_fwding_dpo_update (u32 fib_index,
-			     const fib_prefix_t *prefix,
-			     const dpo_id_t *dpo)
+static void
+fib_table_fwding_dpo_update_i (u32 fib_index,
+                               const fib_prefix_t *prefix,
+                               const dpo_id_t *dpo)
 {
-    vlib_smp_unsafe_warning();
-
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
@@ -257,6 +309,85 @@ fib_table_fwding_dpo_update (u32 fib_index,
     }
 }
 
+static int
+fib_table_batch_fwd_cmp (void *v1,
+                         void *v2)
+{
+    fib_table_batch_fwd_t *f1 = v1, *f2 = v2;
+    int res;
+
+    res = (f1->ftbf_fib_index - f2->ftbf_fib_index);
+
+    if (0 == res)
+    {
+        res = fib_prefix_cmp(&f1->ftbf_prefix, &f2->ftbf_prefix);
+    }
+    if (0 == res)
+    {
+        res = (f1->ftbf_seq - f2->ftbf_seq);
+    }
+    return (res);
+}
+
+/*
+ * Apply the deferred forwarding updates, the least specific prefixes
+ * first; the mtrie then fills each ply once rather than re-pushing
+ * leaves under a later, shorter prefix.
+ */
+static void
+fib_table_batch_fwding_flush (void)
+{
+    fib_table_batch_fwd_t *fwd, *fwds;
+    u32 ii, n_fwds;
+
+    fwds = fib_table_batch.ftb_fwds;
+    n_fwds = vec_len(fwds);
+
+    vec_sort_with_function(fwds, fib_table_batch_fwd_cmp);
+
+    for (ii = 0; ii < n_fwds; ii++)
+    {
+        fwd = &fwds[ii];
+
+        if (ii + 1 == n_fwds ||
+            fwd->ftbf_fib_index != fwds[ii + 1].ftbf_fib_index ||
+            0 != fib_prefix_cmp(&fwd->ftbf_prefix, &fwds[ii + 1].ftbf_prefix))
+        {
+            fib_table_fwding_dpo_update_i(fwd->ftbf_fib_index,
+                                          &fwd->ftbf_prefix,
+                                          &fwd->ftbf_dpo);
+        }
+        dpo_reset(&fwd->ftbf_dpo);
+    }
+
+    vec_reset_length(fib_table_batch.ftb_fwds);
+}
+
+void
+fib_table_fwding_dpo_update (u32 fib_index,
+			     const fib_prefix_t *prefix,
+			     const dpo_id_t *dpo)
+{
+    vlib_smp_unsafe_warning();
+
+    if (fib_table_batch.ftb_depth &&
+        FIB_PROTOCOL_MPLS != prefix->fp_proto)
+    {
+        fib_table_batch_fwd_t *fwd;
+
+        vec_add2(fib_table_batch.ftb_fwds, fwd, 1);
+        memset(fwd, 0, sizeof(*fwd));
+
+        fwd->ftbf_fib_index = fib_index;
+        fwd->ftbf_seq = vec_len(fib_table_batch.ftb_fwds);
+        fwd->ftbf_prefix = *prefix;
+        dpo_copy(&fwd->ftbf_dpo, dpo);
+        return;
+    }
+
+    fib_table_fwding_dpo_update_i(fib_index, prefix, dpo);
+}
+
 void
 fib_table_fwding_dpo_remove (u32 fib_index,
 			     const fib_prefix_t *prefix,
@@ -264,6 +395,15 @@ fib_table_fwding_dpo_remove (u32 fib_index,
 {
     vlib_smp_unsafe_warning();
 
+    /*
+     * removes are not deferred; the mtrie removes a prefix by the value
+     * it holds for it, so the updates before this one must be in.
+     */
+    if (0 != vec_len(fib_table_batch.ftb_fwds))
+    {
+        fib_table_batch_fwding_flush();
+    }
+
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
@@ -277,7 +417,9 @@ fib_table_fwding_dpo_remove (u32 fib_index,
 	return (ip6_fib_table_fwding_dpo_remove(fib_index,
 						&prefix->fp_addr.ip6,
 						prefix->fp_len,
-						dpo));
+						dpo,
+                                                fib_table_get_less_specific(fib_index,
+                                                                            prefix)));
     case FIB_PROTOCOL_MPLS:
 	return (mpls_fib_forwarding_table_reset(mpls_fib_get(fib_index),
 						prefix->fp_label,
@@ -1156,6 +1298,50 @@ fib_table_destroy (fib_table_t *fib_table)
     }
 }
 
+void
+fib_table_batch_begin (void)
+{
+    if (0 == fib_table_batch.ftb_depth++)
+    {
+        fib_walk_defer_begin();
+    }
+}
+
+void
+fib_table_batch_end (void)
+{
+    fib_node_index_t *covers, *cover;
+    hash_pair_t *hp;
+
+    ASSERT(fib_table_batch.ftb_depth);
+
+    if (0 != --fib_table_batch.ftb_depth)
+        return;
+
+    fib_table_batch_fwding_flush();
+
+    /*
+     * each cover's dependents re-evaluate their cover once, against
+     * the table as it is now, however many more specifics went in.
+     * Walks stay deferred so they merge.
+     */
+    covers = NULL;
+    hash_foreach_pair(hp, fib_table_batch.ftb_covers,
+    ({
+        vec_add1(covers, hp->key);
+    }));
+    hash_free(fib_table_batch.ftb_covers);
+
+    vec_foreach(cover, covers)
+    {
+        fib_entry_cover_change_notify(*cover, FIB_NODE_INDEX_INVALID);
+        fib_entry_unlock(*cover);
+    }
+    vec_free(covers);
+
+    fib_walk_defer_end();
+}
+
 void
 fib_table_walk (u32 fib_index,
                 fib_protocol_t proto,
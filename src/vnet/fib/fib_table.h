@@ -572,6 +572,25 @@ extern void fib_table_flush(u32 fib_index,
 			    fib_protocol_t proto,
 			    fib_source_t source);
 
+/**
+ * @brief
+ *  Start a batch of route changes, for all tables.
+ *  Until the matching fib_table_batch_end() the costs of a change that a
+ *  batch can share are deferred: back-walks are queued, and merge;
+ *  covers' dependents are told of new more specifics once per cover, not
+ *  once per insert; and IP forwarding updates are held, then applied
+ *  least specific first and once per prefix. Calls nest, the batch
+ *  commits when the outermost ends. The forwarding plane may be behind
+ *  the FIB until then.
+ */
+extern void fib_table_batch_begin(void);
+
+/**
+ * @brief
+ *  End a batch of route changes. see fib_table_batch_begin()
+ */
+extern void fib_table_batch_end(void);
+
 /**
  * @brief
  *  Get the index of the FIB bound to the interface
@@ -40,6 +40,9 @@
 #include <vnet/fib/fib_node_list.h>
 #include <vnet/fib/fib_urpf_list.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 /*
  * Add debugs for passing tests
  */
@@ -8781,6 +8784,784 @@ lfib_test (void)
     return (0);
 }
 
+/*
+ * IPv6 forwarding lookup benchmark: the per prefix length hash probes
+ * against the mtrie, on a full table. The prefixes are read from a
+ * file with one <address>/<length> per line (a 'show ip6 fib' dump of
+ * a BGP full table will do, other lines are skipped); without one, a
+ * table with a BGP like spread of prefix lengths is made up.
+ */
+static int
+fib_test_perf_v6 (vlib_main_t *vm,
+                  char *file_name,
+                  u32 n_routes,
+                  u32 n_lookups)
+{
+    /* length, weight in 1/1000th: roughly a 2018 IPv6 BGP table */
+    static const u16 lengths[][2] = {
+        {48, 432}, {32, 180}, {44, 60}, {40, 60}, {29, 50}, {36, 40},
+        {46, 30}, {47, 25}, {45, 20}, {42, 15}, {33, 10}, {34, 10},
+        {35, 10}, {38, 10}, {28, 5}, {30, 5}, {31, 5}, {37, 3}, {39, 3},
+        {41, 3}, {43, 3}, {56, 2}, {64, 2}, {24, 1}, {27, 1}, {26, 1},
+        {25, 1}, {23, 1}, {22, 1}, {21, 1}, {20, 1}, {19, 1}, {52, 1},
+        {60, 1}, {49, 1}, {50, 1}, {51, 1}, {62, 1}, {63, 1}, {127, 1},
+    };
+    ip46_address_t nh = {
+	.ip6 = {
+	    .as_u64 = {
+		[0] = clib_host_to_net_u64(0x2001000000000001),
+		[1] = clib_host_to_net_u64(0x0000000000000002),
+	    },
+	},
+    };
+    f64 t_hash, t_mtrie, t0;
+    fib_prefix_t *pfxs = NULL, pfx = {
+        .fp_proto = FIB_PROTOCOL_IP6,
+    };
+    ip6_address_t *dsts = NULL, *dst;
+    u32 fib_index, seed, ii, n_plies, lbi;
+    uword sum = 0;
+    test_main_t *tm;
+    int res = 0;
+
+    tm = &test_main;
+    seed = 0xdeadbeef;
+
+    fib_index = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP6, 12,
+                                                  FIB_SOURCE_API);
+    n_plies = pool_elts(ip6_ply_pool);
+
+    if (file_name)
+    {
+        unformat_input_t input, line;
+        int fd;
+
+        fd = open(file_name, O_RDONLY);
+        FIB_TEST((fd >= 0), "open %s", file_name);
+
+        unformat_init_clib_file(&input, fd);
+        while (unformat_user(&input, unformat_line_input, &line))
+        {
+            if (unformat(&line, "%U/%d", unformat_ip6_address,
+                         &pfx.fp_addr.ip6, &pfx.fp_len) &&
+                pfx.fp_len <= 128)
+                vec_add1(pfxs, pfx);
+            unformat_free(&line);
+        }
+        unformat_free(&input);
+        close(fd);
+    }
+    else
+    {
+        while (vec_len(pfxs) < n_routes)
+        {
+            u32 w = random_u32(&seed) % 1000;
+
+            for (ii = 0; ii < ARRAY_LEN(lengths) - 1; ii++)
+            {
+                if (w < lengths[ii][1])
+                    break;
+                w -= lengths[ii][1];
+            }
+            pfx.fp_len = lengths[ii][0];
+            pfx.fp_addr.ip6.as_u32[0] = random_u32(&seed);
+            pfx.fp_addr.ip6.as_u32[1] = random_u32(&seed);
+            pfx.fp_addr.ip6.as_u32[2] = random_u32(&seed);
+            pfx.fp_addr.ip6.as_u32[3] = random_u32(&seed);
+            /* all global unicast */
+            pfx.fp_addr.ip6.as_u8[0] = 0x20 | (pfx.fp_addr.ip6.as_u8[0] & 0xf);
+            vec_add1(pfxs, pfx);
+        }
+    }
+
+    /* add them, skipping duplicates, so each can be deleted once */
+    for (ii = 0; ii < vec_len(pfxs); ii++)
+    {
+        ip6_address_t addr = pfxs[ii].fp_addr.ip6;
+
+        /* the prefix's address is packed, mask a copy */
+        ip6_address_mask(&addr, &ip6_main.fib_masks[pfxs[ii].fp_len]);
+        pfxs[ii].fp_addr.ip6 = addr;
+        if (FIB_NODE_INDEX_INVALID !=
+            fib_table_lookup_exact_match(fib_index, &pfxs[ii]))
+        {
+            vec_del1(pfxs, ii);
+            ii--;
+            continue;
+        }
+        fib_table_entry_path_add(fib_index, &pfxs[ii],
+                                 FIB_SOURCE_API,
+                                 FIB_ENTRY_FLAG_NONE,
+                                 DPO_PROTO_IP6,
+                                 &nh,
+                                 tm->hw[0]->sw_if_index,
+                                 ~0,
+                                 1,
+                                 NULL,
+                                 FIB_ROUTE_PATH_FLAG_NONE);
+    }
+
+    /*
+     * Destinations: most within a random route, with random host
+     * bits, so they also land on more specifics; the rest anywhere.
+     */
+    vec_validate(dsts, n_lookups - 1);
+    vec_foreach(dst, dsts)
+    {
+        dst->as_u32[0] = random_u32(&seed);
+        dst->as_u32[1] = random_u32(&seed);
+        dst->as_u32[2] = random_u32(&seed);
+        dst->as_u32[3] = random_u32(&seed);
+        if (vec_len(pfxs) && (random_u32(&seed) % 8))
+        {
+            ip6_address_t a, *m;
+
+            pfx = pfxs[random_u32(&seed) % vec_len(pfxs)];
+            a = pfx.fp_addr.ip6;
+            m = &ip6_main.fib_masks[pfx.fp_len];
+            dst->as_u64[0] = (a.as_u64[0] | (dst->as_u64[0] & ~m->as_u64[0]));
+            dst->as_u64[1] = (a.as_u64[1] | (dst->as_u64[1] & ~m->as_u64[1]));
+        }
+    }
+
+    vec_foreach(dst, dsts)
+    {
+        lbi = ip6_fib_table_fwding_lookup(&ip6_main, fib_index, dst);
+        FIB_TEST((lbi == ip6_fib_table_fwding_lookup_hash(&ip6_main,
+                                                          fib_index, dst)),
+                 "%U: mtrie and hash lookups match",
+                 format_ip6_address, dst);
+    }
+
+    t0 = vlib_time_now(vm);
+    vec_foreach(dst, dsts)
+        sum += ip6_fib_table_fwding_lookup_hash(&ip6_main, fib_index, dst);
+    t_hash = vlib_time_now(vm) - t0;
+
+    t0 = vlib_time_now(vm);
+    vec_foreach(dst, dsts)
+        sum -= ip6_fib_table_fwding_lookup(&ip6_main, fib_index, dst);
+    t_mtrie = vlib_time_now(vm) - t0;
+
+    FIB_TEST((0 == sum), "lookup sums match");
+
+    n_plies = pool_elts(ip6_ply_pool) - n_plies;
+    vlib_cli_output(vm, "%d routes, %d distinct prefix lengths, %d lookups",
+                    vec_len(pfxs),
+                    vec_len(ip6_main.ip6_table[IP6_FIB_TABLE_FWDING].
+                            prefix_lengths_in_search_order),
+                    n_lookups);
+    vlib_cli_output(vm, "  hash:  %.2e lookups/sec",
+                    n_lookups / t_hash);
+    vlib_cli_output(vm, "  mtrie: %.2e lookups/sec, %d plies %U",
+                    n_lookups / t_mtrie, n_plies,
+                    format_memory_size,
+                    (uword) n_plies * sizeof(ip6_fib_mtrie_8_ply_t));
+
+    for (ii = 0; ii < vec_len(pfxs); ii++)
+    {
+        fib_table_entry_delete(fib_index, &pfxs[ii], FIB_SOURCE_API);
+    }
+    fib_table_unlock(fib_index, FIB_PROTOCOL_IP6, FIB_SOURCE_API);
+
+    vec_free(pfxs);
+    vec_free(dsts);
+
+    return (res);
+}
+
+/*
+ * FIB batch mode: the same routes added and removed one at a time and
+ * then as a batch, checking the batch converges to the same forwarding,
+ * and timing both.
+ */
+static int
+fib_test_batch (vlib_main_t *vm,
+                u32 n_routes)
+{
+    static const u8 lengths[] = {8, 16, 20, 22, 24, 24, 24, 24, 28, 32};
+    ip46_address_t nh = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    ip46_address_t nh_rec = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x01010101),
+    };
+    fib_prefix_t pfx_rec = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = nh_rec,
+    };
+    fib_prefix_t pfx_via_rec = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x02020202),
+    };
+    fib_prefix_t *pfxs = NULL, pfx = {
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+    fib_prefix_t *pfx_ptr;
+    fib_node_index_t fei;
+    u32 fib_index, seed, ii, batch;
+    ip4_address_t dst;
+    test_main_t *tm;
+    f64 t0, t[2];
+    int res = 0;
+
+    tm = &test_main;
+    seed = 0xdeadbeef;
+
+    fib_index = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP4, 13,
+                                                  FIB_SOURCE_API);
+
+    /*
+     * the first of the routes covers the recursive route's next-hop
+     */
+    pfx.fp_len = 16;
+    pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01010000);
+    vec_add1(pfxs, pfx);
+
+    while (vec_len(pfxs) < n_routes)
+    {
+        pfx.fp_len = lengths[random_u32(&seed) % ARRAY_LEN(lengths)];
+        pfx.fp_addr.ip4.as_u32 = (random_u32(&seed) &
+                                  ip4_main.fib_masks[pfx.fp_len]);
+        vec_add1(pfxs, pfx);
+    }
+
+    fib_table_entry_path_add(fib_index, &pfx_via_rec,
+                             FIB_SOURCE_API,
+                             FIB_ENTRY_FLAG_NONE,
+                             DPO_PROTO_IP4,
+                             &nh_rec,
+                             ~0,
+                             fib_index,
+                             1,
+                             NULL,
+                             FIB_ROUTE_PATH_FLAG_NONE);
+    fei = fib_table_lookup_exact_match(fib_index, &pfx_rec);
+    FIB_TEST((~0 == fib_entry_get_resolving_interface(fei)),
+             "1.1.1.1/32 unresolved");
+
+    for (batch = 0; batch < 2; batch++)
+    {
+        t0 = vlib_time_now(vm);
+        if (batch)
+            fib_table_batch_begin();
+
+        for (ii = 0; ii < vec_len(pfxs); ii++)
+        {
+            /* skip duplicates, so each can be deleted once */
+            if (!batch &&
+                FIB_NODE_INDEX_INVALID !=
+                fib_table_lookup_exact_match(fib_index, &pfxs[ii]))
+            {
+                vec_del1(pfxs, ii);
+                ii--;
+                continue;
+            }
+            fib_table_entry_path_add(fib_index, &pfxs[ii],
+                                     FIB_SOURCE_API,
+                                     FIB_ENTRY_FLAG_NONE,
+                                     DPO_PROTO_IP4,
+                                     &nh,
+                                     tm->hw[0]->sw_if_index,
+                                     ~0,
+                                     1,
+                                     NULL,
+                                     FIB_ROUTE_PATH_FLAG_NONE);
+        }
+
+        if (batch)
+            fib_table_batch_end();
+        t[batch] = vlib_time_now(vm) - t0;
+
+        /*
+         * the recursive route's next-hop has moved to its new cover
+         */
+        fei = fib_table_lookup_exact_match(fib_index, &pfx_rec);
+        FIB_TEST((tm->hw[0]->sw_if_index ==
+                  fib_entry_get_resolving_interface(fei)),
+                 "1.1.1.1/32 resolves via 1.1.0.0/16");
+
+        /*
+         * forwarding matches the FIB at a random address in each route
+         */
+        vec_foreach(pfx_ptr, pfxs)
+        {
+            fib_prefix_t host = {
+                .fp_len = 32,
+                .fp_proto = FIB_PROTOCOL_IP4,
+            };
+
+            dst.as_u32 = (pfx_ptr->fp_addr.ip4.as_u32 |
+                          (random_u32(&seed) &
+                           ~ip4_main.fib_masks[pfx_ptr->fp_len]));
+            host.fp_addr.ip4 = dst;
+            fei = fib_table_lookup(fib_index, &host);
+
+            FIB_TEST((fib_entry_contribute_ip_forwarding(fei)->dpoi_index ==
+                      ip4_fib_forwarding_lookup(fib_index, &dst)),
+                     "%U: forwarding matches the FIB",
+                     format_ip4_address, &dst);
+        }
+
+        if (batch)
+            fib_table_batch_begin();
+        for (ii = 0; ii < vec_len(pfxs); ii++)
+        {
+            fib_table_entry_delete(fib_index, &pfxs[ii], FIB_SOURCE_API);
+        }
+        if (batch)
+            fib_table_batch_end();
+
+        fei = fib_table_lookup_exact_match(fib_index, &pfx_rec);
+        FIB_TEST((~0 == fib_entry_get_resolving_interface(fei)),
+                 "1.1.1.1/32 unresolved");
+    }
+
+    vlib_cli_output(vm, "%d routes", vec_len(pfxs));
+    vlib_cli_output(vm, "  one at a time: %.2e routes/sec",
+                    vec_len(pfxs) / t[0]);
+    vlib_cli_output(vm, "  batched:       %.2e routes/sec",
+                    vec_len(pfxs) / t[1]);
+
+    fib_table_entry_delete(fib_index, &pfx_via_rec, FIB_SOURCE_API);
+    fib_table_unlock(fib_index, FIB_PROTOCOL_IP4, FIB_SOURCE_API);
+
+    vec_free(pfxs);
+
+    return (res);
+}
+
+/*
+ * The ip4 mtrie on its own, against a brute force longest prefix match.
+ * Routes with overlapping prefixes are added and deleted at random, and
+ * the test addresses are picked from inside, and just outside, existing
+ * routes. Run once with a full mtrie and once compact, with a low
+ * promotion threshold so that the compact mtrie is promoted half way.
+ * The routes left at the end are deleted covers first in one run and
+ * more specifics first in the other, with the lookups checked after
+ * every delete.
+ */
+typedef struct fib_test_mtrie_route_t_
+{
+    ip4_address_t addr;
+    u32 len;
+    u32 lbi;
+} fib_test_mtrie_route_t;
+
+static fib_test_mtrie_route_t *
+fib_test_mtrie_lpm (fib_test_mtrie_route_t *routes,
+                    const ip4_address_t *dst,
+                    u32 max_len,
+                    const fib_test_mtrie_route_t *skip)
+{
+    fib_test_mtrie_route_t *r, *best = NULL;
+
+    vec_foreach(r, routes)
+    {
+        if (r != skip && r->len <= max_len &&
+            (dst->as_u32 & ip4_main.fib_masks[r->len]) == r->addr.as_u32 &&
+            (NULL == best || r->len > best->len))
+            best = r;
+    }
+    return (best);
+}
+
+static int
+fib_test_mtrie_check (ip4_fib_mtrie_t *m,
+                      fib_test_mtrie_route_t *routes,
+                      u32 *seed,
+                      u32 n_lookups)
+{
+    fib_test_mtrie_route_t *r, *exp;
+    ip4_fib_mtrie_leaf_t leaf;
+    ip4_address_t dst;
+    u32 ii, lbi;
+
+    for (ii = 0; ii < n_lookups; ii++)
+    {
+        r = &routes[random_u32(seed) % vec_len(routes)];
+        dst.as_u32 = (r->addr.as_u32 |
+                      (random_u32(seed) & ~ip4_main.fib_masks[r->len]));
+        /* every other address falls just outside the route, if it can */
+        if (ii & 1)
+            dst.as_u8[3] ^= 1;
+
+        leaf = ip4_fib_mtrie_lookup_step_one(m, &dst);
+        leaf = ip4_fib_mtrie_lookup_step(m, leaf, &dst, 2);
+        leaf = ip4_fib_mtrie_lookup_step(m, leaf, &dst, 3);
+        lbi = ip4_fib_mtrie_leaf_get_adj_index(leaf);
+
+        exp = fib_test_mtrie_lpm(routes, &dst, 32, NULL);
+        FIB_TEST((exp->lbi == lbi),
+                 "%U via %U/%d: lb %d, expected %d",
+                 format_ip4_address, &dst,
+                 format_ip4_address, &exp->addr, exp->len,
+                 lbi, exp->lbi);
+    }
+    return (0);
+}
+
+static int
+fib_test_mtrie_del (ip4_fib_mtrie_t *m,
+                    fib_test_mtrie_route_t **routes,
+                    u32 ii)
+{
+    fib_test_mtrie_route_t *r, *cover;
+
+    r = vec_elt_at_index(*routes, ii);
+    cover = fib_test_mtrie_lpm(*routes, &r->addr,
+                               (r->len ? r->len - 1 : 0), r);
+    ip4_fib_mtrie_route_del(m, &r->addr, r->len, r->lbi,
+                            cover->len, cover->lbi);
+    vec_del1(*routes, ii);
+
+    return (0);
+}
+
+static int
+fib_test_mtrie_one (u8 compact,
+                    u32 n_iterations,
+                    u32 seed,
+                    u8 covers_first)
+{
+    /*
+     * lengths either side of the ply boundaries. The addresses are
+     * squashed into a few /8s and /16s so the prefixes overlap.
+     */
+    static const u8 lengths[] = {1, 4, 7, 8, 9, 12, 15, 16, 17,
+                                 20, 24, 25, 28, 31, 32};
+    fib_test_mtrie_route_t *routes = NULL, *r, route;
+    u32 ii, jj, n_plies, lbi = 2;
+    ip4_fib_mtrie_t m;
+    int res = 0;
+
+    n_plies = pool_elts(ip4_ply_pool);
+    ip4_main.mtrie_compact = compact;
+    ip4_main.mtrie_compact_max_plys = 8;
+    ip4_mtrie_init(&m);
+
+    FIB_TEST(((NULL == m.root_ply) == compact),
+             "mtrie is %s", (compact ? "compact" : "full"));
+
+    /*
+     * the default route is always present, it's the cover of last resort
+     */
+    memset(&route, 0, sizeof(route));
+    route.lbi = 1;
+    vec_add1(routes, route);
+    ip4_fib_mtrie_route_add(&m, &route.addr, 0, route.lbi);
+
+    for (ii = 0; ii < n_iterations; ii++)
+    {
+        if (vec_len(routes) > 1 && 0 == random_u32(&seed) % 3)
+        {
+            res += fib_test_mtrie_del(&m, &routes,
+                                      1 + (random_u32(&seed) %
+                                           (vec_len(routes) - 1)));
+        }
+        else
+        {
+            route.len = lengths[random_u32(&seed) % ARRAY_LEN(lengths)];
+            route.addr.as_u32 = random_u32(&seed);
+            route.addr.as_u8[0] &= 0x7f;
+            route.addr.as_u8[1] &= 0x3;
+            route.addr.as_u8[2] &= 0x3;
+            route.addr.as_u32 &= ip4_main.fib_masks[route.len];
+            route.lbi = lbi++;
+
+            /* an update of an existing route replaces its lb */
+            vec_foreach(r, routes)
+            {
+                if (r->len == route.len && r->addr.as_u32 == route.addr.as_u32)
+                    break;
+            }
+            if (r == vec_end(routes))
+                vec_add1(routes, route);
+            else
+                r->lbi = route.lbi;
+
+            ip4_fib_mtrie_route_add(&m, &route.addr, route.len, route.lbi);
+        }
+        res += fib_test_mtrie_check(&m, routes, &seed, 32);
+        if (res)
+            goto done;
+    }
+
+    FIB_TEST((NULL != m.root_ply),
+             "%s mtrie has a 16 bit root after %d routes",
+             (compact ? "promoted" : "full"), vec_len(routes));
+
+    while (vec_len(routes) > 1)
+    {
+        /*
+         * the next to go is the shortest, or longest, of the routes left
+         */
+        jj = 1;
+        for (ii = 2; ii < vec_len(routes); ii++)
+        {
+            if (covers_first ?
+                routes[ii].len < routes[jj].len :
+                routes[ii].len > routes[jj].len)
+                jj = ii;
+        }
+        res += fib_test_mtrie_del(&m, &routes, jj);
+        res += fib_test_mtrie_check(&m, routes, &seed, 32);
+        if (res)
+            goto done;
+    }
+
+    ip4_mtrie_free(&m);
+    FIB_TEST((n_plies == pool_elts(ip4_ply_pool)),
+             "all plies freed: %d, expected %d",
+             pool_elts(ip4_ply_pool), n_plies);
+
+done:
+    vec_free(routes);
+    return (res);
+}
+
+static int
+fib_test_mtrie (u32 n_iterations)
+{
+    u32 max_plys;
+    u8 compact;
+    int res = 0;
+
+    compact = ip4_main.mtrie_compact;
+    max_plys = ip4_main.mtrie_compact_max_plys;
+
+    res += fib_test_mtrie_one(0, n_iterations, 0xdeadbeef, 1);
+    res += fib_test_mtrie_one(1, n_iterations, 0xcafef00d, 0);
+
+    ip4_main.mtrie_compact = compact;
+    ip4_main.mtrie_compact_max_plys = max_plys;
+
+    return (res);
+}
+
+/*
+ * Does the address forward, through any number of single bucket
+ * load-balances, via the given load-balance
+ */
+static int
+fib_test_forwards_via (u32 fib_index,
+                       const ip4_address_t *dst,
+                       index_t via_lbi)
+{
+    const load_balance_t *lb;
+    const dpo_id_t *dpo;
+    index_t lbi;
+
+    lbi = ip4_fib_forwarding_lookup(fib_index, dst);
+
+    while (lbi != via_lbi)
+    {
+        lb = load_balance_get(lbi);
+        dpo = load_balance_get_bucket_i(lb, 0);
+
+        if (1 != lb->lb_n_buckets || DPO_LOAD_BALANCE != dpo->dpoi_type)
+            return (0);
+        lbi = dpo->dpoi_index;
+    }
+    return (1);
+}
+
+/*
+ * PIC: routes recursive via a primary and a backup next-hop. The primary
+ * is withdrawn and the time taken for all routes to forward via the
+ * backup is measured, with and without PIC and for two route counts.
+ * With PIC that time should not depend on the number of routes.
+ * The walk process must be disabled, so the routes only converge when
+ * this test says so.
+ */
+static int
+fib_test_pic (vlib_main_t *vm,
+              u32 n_routes)
+{
+    ip46_address_t nh_10_10_10_1 = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    ip46_address_t nh_10_10_11_1 = {
+	.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0b01),
+    };
+    fib_prefix_t pfx_1_1_1_1_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01010101),
+    };
+    fib_prefix_t pfx_1_1_1_2_s_32 = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01010102),
+    };
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+    fib_route_path_t r_path_primary = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_sw_if_index = ~0,
+        .frp_weight = 1,
+        .frp_preference = 0,
+        .frp_flags = FIB_ROUTE_PATH_RESOLVE_VIA_HOST,
+        .frp_addr = pfx_1_1_1_1_s_32.fp_addr,
+    };
+    fib_route_path_t r_path_backup = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_sw_if_index = ~0,
+        .frp_weight = 1,
+        .frp_preference = 1,
+        .frp_flags = FIB_ROUTE_PATH_RESOLVE_VIA_HOST,
+        .frp_addr = pfx_1_1_1_2_s_32.fp_addr,
+    };
+    fib_route_path_t *r_paths = NULL;
+    u32 fib_index, ii, pic, size, n, n_bad, sizes[2];
+    dpo_id_t dpo_primary = DPO_INVALID, dpo_backup = DPO_INVALID;
+    f64 t0, t_switch[2][2], t_converge[2][2];
+    fib_node_index_t fei;
+    ip4_address_t dst;
+    test_main_t *tm;
+    int res = 0;
+
+    tm = &test_main;
+    sizes[0] = clib_max(n_routes / 10, 64);
+    sizes[1] = clib_max(n_routes, 64);
+
+    fib_index = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP4, 14,
+                                                  FIB_SOURCE_API);
+    r_path_primary.frp_fib_index = fib_index;
+    r_path_backup.frp_fib_index = fib_index;
+    vec_add1(r_paths, r_path_primary);
+    vec_add1(r_paths, r_path_backup);
+
+    for (pic = 0; pic < 2; pic++)
+    {
+        fib_path_list_pic_enable(pic);
+
+        for (size = 0; size < 2; size++)
+        {
+            n = sizes[size];
+
+            fei = fib_table_entry_path_add(fib_index, &pfx_1_1_1_1_s_32,
+                                           FIB_SOURCE_API,
+                                           FIB_ENTRY_FLAG_NONE,
+                                           DPO_PROTO_IP4,
+                                           &nh_10_10_10_1,
+                                           tm->hw[0]->sw_if_index,
+                                           ~0,
+                                           1,
+                                           NULL,
+                                           FIB_ROUTE_PATH_FLAG_NONE);
+            fib_entry_contribute_forwarding(fei,
+                                            FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+                                            &dpo_primary);
+            fei = fib_table_entry_path_add(fib_index, &pfx_1_1_1_2_s_32,
+                                           FIB_SOURCE_API,
+                                           FIB_ENTRY_FLAG_NONE,
+                                           DPO_PROTO_IP4,
+                                           &nh_10_10_11_1,
+                                           tm->hw[1]->sw_if_index,
+                                           ~0,
+                                           1,
+                                           NULL,
+                                           FIB_ROUTE_PATH_FLAG_NONE);
+            fib_entry_contribute_forwarding(fei,
+                                            FIB_FORW_CHAIN_TYPE_UNICAST_IP4,
+                                            &dpo_backup);
+
+            for (ii = 0; ii < n; ii++)
+            {
+                pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x03000000 + ii);
+                fib_table_entry_path_add2(fib_index, &pfx,
+                                          FIB_SOURCE_API,
+                                          FIB_ENTRY_FLAG_NONE,
+                                          r_paths);
+            }
+            fib_walk_process_queues(vm, 1e6);
+
+            n_bad = 0;
+            for (ii = 0; ii < n; ii++)
+            {
+                dst.as_u32 = clib_host_to_net_u32(0x03000000 + ii);
+                n_bad += !fib_test_forwards_via(fib_index, &dst,
+                                                dpo_primary.dpoi_index);
+            }
+            FIB_TEST((0 == n_bad), "%d routes via the primary", n);
+
+            /*
+             * withdraw the primary. With PIC the routes are via the backup
+             * as soon as that returns, without they are updated by the walk
+             * so have failed over only once it is done.
+             */
+            t0 = vlib_time_now(vm);
+            fib_table_entry_delete(fib_index, &pfx_1_1_1_1_s_32,
+                                   FIB_SOURCE_API);
+            t_switch[pic][size] = vlib_time_now(vm) - t0;
+
+            n_bad = 0;
+            for (ii = 0; pic && ii < n; ii++)
+            {
+                dst.as_u32 = clib_host_to_net_u32(0x03000000 + ii);
+                n_bad += !fib_test_forwards_via(fib_index, &dst,
+                                                dpo_backup.dpoi_index);
+            }
+            FIB_TEST((0 == n_bad), "%d routes via the backup before the walk",
+                     n);
+
+            t0 = vlib_time_now(vm);
+            fib_walk_process_queues(vm, 1e6);
+            fib_walk_process_queues(vm, 1e6);
+            t_converge[pic][size] = (t_switch[pic][size] +
+                                     vlib_time_now(vm) - t0);
+
+            if (!pic)
+            {
+                t_switch[pic][size] = t_converge[pic][size];
+            }
+
+            n_bad = 0;
+            for (ii = 0; ii < n; ii++)
+            {
+                dst.as_u32 = clib_host_to_net_u32(0x03000000 + ii);
+                n_bad += !fib_test_forwards_via(fib_index, &dst,
+                                                dpo_backup.dpoi_index);
+            }
+            FIB_TEST((0 == n_bad), "%d routes via the backup", n);
+
+            for (ii = 0; ii < n; ii++)
+            {
+                pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x03000000 + ii);
+                fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+            }
+            fib_table_entry_delete(fib_index, &pfx_1_1_1_2_s_32,
+                                   FIB_SOURCE_API);
+            fib_walk_process_queues(vm, 1e6);
+            dpo_reset(&dpo_primary);
+            dpo_reset(&dpo_backup);
+        }
+    }
+    fib_path_list_pic_enable(0);
+
+    for (pic = 0; pic < 2; pic++)
+    {
+        vlib_cli_output(vm, "%s:", (pic ? "PIC" : "no PIC"));
+        for (size = 0; size < 2; size++)
+        {
+            vlib_cli_output(vm, "  %8d routes: failover %.2e sec, "
+                            "converged %.2e sec",
+                            sizes[size], t_switch[pic][size],
+                            t_converge[pic][size]);
+        }
+    }
+
+    fib_table_unlock(fib_index, FIB_PROTOCOL_IP4, FIB_SOURCE_API);
+    vec_free(r_paths);
+
+    return (res);
+}
+
 static clib_error_t *
 fib_test (vlib_main_t * vm, 
 	  unformat_input_t * input,
@@ -8825,6 +9606,52 @@ fib_test (vlib_main_t * vm,
     {
 	res += fib_test_bfd();
     }
+    else if (unformat (input, "perf6"))
+    {
+        char *file_name = NULL;
+        u32 n_routes = 100000, n_lookups = 1000000;
+
+        while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+        {
+            if (unformat (input, "file %s", &file_name))
+                ;
+            else if (unformat (input, "routes %d", &n_routes))
+                ;
+            else if (unformat (input, "lookups %d", &n_lookups))
+                ;
+            else
+                break;
+        }
+        /* unformat's %s doesn't terminate the string */
+        if (file_name)
+            vec_add1(file_name, 0);
+	res += fib_test_perf_v6(vm, file_name, n_routes, n_lookups);
+        vec_free(file_name);
+    }
+    else if (unformat (input, "batch"))
+    {
+        u32 n_routes = 100000;
+
+        unformat (input, "routes %d", &n_routes);
+	res += fib_test_batch(vm, n_routes);
+    }
+    else if (unformat (input, "mtrie"))
+    {
+        u32 n_iterations = 4000;
+
+        unformat (input, "iterations %d", &n_iterations);
+	res += fib_test_mtrie(n_iterations);
+    }
+    else if (unformat (input, "pic"))
+    {
+        u32 n_routes = 10000;
+
+        unformat (input, "routes %d", &n_routes);
+
+        fib_walk_process_disable();
+	res += fib_test_pic(vm, n_routes);
+        fib_walk_process_enable();
+    }
     else
     {
 	res += fib_test_v4();
@@ -8834,6 +9661,7 @@ fib_test (vlib_main_t * vm,
 	res += fib_test_pref();
 	res += fib_test_label();
 	res += lfib_test();
+	res += fib_test_mtrie(4000);
 
         /*
          * fib-walk process must be disabled in order for the walk tests to work
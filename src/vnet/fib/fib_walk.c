@@ -95,6 +95,11 @@ typedef struct fib_walk_t_
  */
 static fib_walk_t *fib_walk_pool;
 
+/**
+ * @brief Non-zero whilst sync walks are deferred. see fib_walk_defer_begin()
+ */
+static u32 fib_walk_defer_depth;
+
 /**
  * Statistics maintained per-walk queue
  */
@@ -732,6 +737,16 @@ fib_walk_sync (fib_node_type_t parent_type,
     fib_node_index_t fwi;
     fib_walk_t *fwalk;
 
+    if (fib_walk_defer_depth &&
+        !(ctx->fnbw_flags & FIB_NODE_BW_FLAG_FORCE_SYNC))
+    {
+        /*
+         * deferred. queue the walk so it can merge with the others
+         * against the same parent and have them all run once, at the end.
+         */
+        return (fib_walk_async(parent_type, parent_index,
+                               FIB_WALK_PRIORITY_HIGH, ctx));
+    }
     if (FIB_NODE_GRAPH_MAX_DEPTH < ++ctx->fnbw_depth)
     {
 	/*
@@ -831,6 +846,40 @@ fib_walk_sync (fib_node_type_t parent_type,
     }
 }
 
+void
+fib_walk_defer_begin (void)
+{
+    fib_walk_defer_depth++;
+}
+
+void
+fib_walk_defer_end (void)
+{
+    fib_walk_priority_t prio;
+    u32 n_queued;
+
+    ASSERT(fib_walk_defer_depth);
+
+    if (0 != --fib_walk_defer_depth)
+        return;
+
+    /*
+     * run the queued walks to completion now, rather than leave them
+     * to the walk process, so the caller sees a converged FIB on return.
+     * walks can queue more walks, of any priority.
+     */
+    do
+    {
+        fib_walk_process_queues(vlib_get_main(), 1e6);
+
+        n_queued = 0;
+        FOR_EACH_FIB_WALK_PRIORITY(prio)
+        {
+            n_queued += fib_walk_queue_get_size(prio);
+        }
+    } while (n_queued);
+}
+
 static fib_node_t *
 fib_walk_get_node (fib_node_index_t index)
 {
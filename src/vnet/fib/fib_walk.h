@@ -54,6 +54,16 @@ extern void fib_walk_sync(fib_node_type_t parent_type,
 
 extern u8* format_fib_walk_priority(u8 *s, va_list *ap);
 
+/**
+ * @brief Defer sync walks.
+ * Until the matching fib_walk_defer_end(), sync walks that are not
+ * FORCE_SYNC are queued as async walks, where those against the same
+ * parent merge. fib_walk_defer_end() then runs them all to completion.
+ * Calls nest.
+ */
+extern void fib_walk_defer_begin(void);
+extern void fib_walk_defer_end(void);
+
 extern void fib_walk_process_enable(void);
 extern void fib_walk_process_disable(void);
 
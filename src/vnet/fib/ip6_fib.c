@@ -61,6 +61,7 @@ create_fib_with_table_id (u32 table_id,
 
     memset(fib_table, 0, sizeof(*fib_table));
     memset(v6_fib, 0, sizeof(*v6_fib));
+    ip6_mtrie_init(&v6_fib->mtrie);
 
     ASSERT((fib_table - ip6_main.fibs) ==
            (v6_fib - ip6_main.v6_fibs));
@@ -193,6 +194,7 @@ ip6_fib_table_destroy (u32 fib_index)
     {
 	hash_unset (ip6_main.fib_index_by_table_id, fib_table->ft_table_id);
     }
+    ip6_mtrie_free(&ip6_fib_get(fib_index)->mtrie);
     pool_put_index(ip6_main.v6_fibs, fib_table->ft_index);
     pool_put(ip6_main.fibs, fib_table);
 }
@@ -389,6 +391,9 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
 
     table->dst_address_length_refcounts[len]++;
 
+    ip6_fib_mtrie_route_add(&ip6_fib_get(fib_index)->mtrie,
+                            addr, len, dpo->dpoi_index);
+
     table->non_empty_dst_address_length_bitmap =
         clib_bitmap_set (table->non_empty_dst_address_length_bitmap, 
 			 128 - len, 1);
@@ -399,11 +404,16 @@ void
 ip6_fib_table_fwding_dpo_remove (u32 fib_index,
 				 const ip6_address_t *addr,
 				 u32 len,
-				 const dpo_id_t *dpo)
+				 const dpo_id_t *dpo,
+                                 u32 cover_index)
 {
     ip6_fib_table_instance_t *table;
     BVT(clib_bihash_kv) kv;
     ip6_address_t *mask;
+    fib_prefix_t cover_prefix = {
+        .fp_len = 0,
+    };
+    const dpo_id_t *cover_dpo;
     u64 fib;
 
     table = &ip6_main.ip6_table[IP6_FIB_TABLE_FWDING];
@@ -426,6 +436,18 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
                              128 - len, 0);
 	compute_prefix_lengths_in_search_order (table);
     }
+
+    /*
+     * As for the IPv4 mtrie, the slots the entry occupied are refilled
+     * with the covering prefix's LB.
+     */
+    fib_entry_get_prefix(cover_index, &cover_prefix);
+    cover_dpo = fib_entry_contribute_ip_forwarding(cover_index);
+
+    ip6_fib_mtrie_route_del(&ip6_fib_get(fib_index)->mtrie,
+                            addr, len, dpo->dpoi_index,
+                            cover_prefix.fp_len,
+                            cover_dpo->dpoi_index);
 }
 
 /**
@@ -553,7 +575,7 @@ ip6_show_fib (vlib_main_t * vm,
     ip6_main_t * im6 = &ip6_main;
     fib_table_t *fib_table;
     ip6_fib_t * fib;
-    int verbose, matching;
+    int verbose, matching, mtrie;
     ip6_address_t matching_address;
     u32 mask_len  = 128;
     int table_id = -1, fib_index = ~0;
@@ -561,6 +583,7 @@ ip6_show_fib (vlib_main_t * vm,
 
     verbose = 1;
     matching = 0;
+    mtrie = 0;
 
     while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -584,6 +607,8 @@ ip6_show_fib (vlib_main_t * vm,
 	    ;
 	else if (unformat (input, "index %d", &fib_index))
 	    ;
+	else if (unformat (input, "mtrie"))
+	    mtrie = 1;
 	else
 	    break;
     }
@@ -641,6 +666,12 @@ ip6_show_fib (vlib_main_t * vm,
 	    continue;
 	}
 
+	if (mtrie)
+	{
+	    vlib_cli_output (vm, "%U", format_ip6_fib_mtrie, &fib->mtrie);
+	    continue;
+	}
+
 	if (!matching)
 	{
 	    ip6_fib_table_show_all(fib, vm);
@@ -746,12 +777,15 @@ ip6_show_fib (vlib_main_t * vm,
  *          10                 1
  *           0                 1
  * @cliexend
+ *
+ * The <em>mtrie</em> option displays the forwarding mtrie's plys and
+ * memory usage instead of the routes.
  * @endparblock
  ?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip6_show_fib_command, static) = {
     .path = "show ip6 fib",
-    .short_help = "show ip6 fib [summary] [table <table-id>] [index <fib-id>] [<ip6-addr>[/<width>]] [detail]",
+    .short_help = "show ip6 fib [summary] [table <table-id>] [index <fib-id>] [<ip6-addr>[/<width>]] [mtrie] [detail]",
     .function = ip6_show_fib,
 };
 /* *INDENT-ON* */
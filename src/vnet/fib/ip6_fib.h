@@ -48,7 +48,8 @@ extern void ip6_fib_table_fwding_dpo_update(u32 fib_index,
 extern void ip6_fib_table_fwding_dpo_remove(u32 fib_index,
 					    const ip6_address_t *addr,
 					    u32 len,
-					    const dpo_id_t *dpo);
+					    const dpo_id_t *dpo,
+                                            u32 cover_index);
 
 u32 ip6_fib_table_fwding_lookup_with_if_index(ip6_main_t * im,
 					      u32 sw_if_index,
@@ -63,10 +64,15 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief Forwarding lookup in the hash of the forwarding table; one
+ * probe per distinct prefix length present. The data-plane uses the
+ * mtrie, see ip6_fib_table_fwding_lookup().
+ */
 always_inline u32
-ip6_fib_table_fwding_lookup (ip6_main_t * im,
-                             u32 fib_index,
-                             const ip6_address_t * dst)
+ip6_fib_table_fwding_lookup_hash (ip6_main_t * im,
+                                  u32 fib_index,
+                                  const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
     int i, len;
@@ -102,6 +108,19 @@ ip6_fib_table_fwding_lookup (ip6_main_t * im,
     return 0;
 }
 
+/**
+ * @brief Forwarding lookup, returns the LB index.
+ */
+always_inline u32
+ip6_fib_table_fwding_lookup (ip6_main_t * im,
+                             u32 fib_index,
+                             const ip6_address_t * dst)
+{
+    return (ip6_fib_mtrie_lookup(&pool_elt_at_index(im->v6_fibs,
+                                                    fib_index)->mtrie,
+                                 dst));
+}
+
 /**
  * @brief return the DPO that the LB stacks on.
  */
@@ -26,6 +26,18 @@ typedef struct
   u32 *workers;
 } per_inteface_handoff_data_t;
 
+typedef struct
+{
+  /* buffers bound for each worker, built up over one frame */
+  u32 **buffers_by_worker;
+  /* workers with buffers in this frame */
+  u32 *active_workers;
+
+  /* per destination worker statistics */
+  u64 *n_handoff_by_worker;
+  u64 *n_congestion_drops_by_worker;
+} handoff_per_thread_data_t;
+
 typedef struct
 {
   u32 cached_next_index;
@@ -37,6 +49,12 @@ typedef struct
   /* Worker handoff index */
   u32 frame_queue_index;
 
+  /* Frame queue congestion settings, 0 / ~0 for the defaults */
+  u32 queue_hi_thresh;
+  u32 congestion_policy;
+
+  handoff_per_thread_data_t *per_thread_data;
+
   /* convenience variables */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -68,32 +86,44 @@ format_worker_handoff_trace (u8 * s, va_list * args)
   return s;
 }
 
+#define foreach_worker_handoff_error \
+_(CONGESTION_DROP, "congestion drop")
+
+typedef enum
+{
+#define _(sym,str) WORKER_HANDOFF_ERROR_##sym,
+  foreach_worker_handoff_error
+#undef _
+    WORKER_HANDOFF_N_ERROR,
+} worker_handoff_error_t;
+
+static char *worker_handoff_error_strings[] = {
+#define _(sym,string) string,
+  foreach_worker_handoff_error
+#undef _
+};
+
 vlib_node_registration_t handoff_node;
 
+/*
+ * Packets are first sorted into one vector per destination worker, then
+ * each vector is shipped whole in a single frame queue element, so the
+ * shared queue is touched once per worker per frame rather than once per
+ * packet. The enqueue does not block: what a congested worker's queue
+ * does not take, per the frame queue's congestion policy, is dropped
+ * here.
+ */
 static uword
 worker_handoff_node_fn (vlib_main_t * vm,
 			vlib_node_runtime_t * node, vlib_frame_t * frame)
 {
   handoff_main_t *hm = &handoff_main;
-  vlib_thread_main_t *tm = vlib_get_thread_main ();
-  u32 n_left_from, *from;
-  static __thread vlib_frame_queue_elt_t **handoff_queue_elt_by_worker_index;
-  static __thread vlib_frame_queue_t **congested_handoff_queue_by_worker_index
-    = 0;
-  vlib_frame_queue_elt_t *hf = 0;
+  handoff_per_thread_data_t *ptd;
+  u32 n_left_from, *from, *to_next, n_left_to_next;
+  u32 n_drops = 0;
   int i;
-  u32 n_left_to_next_worker = 0, *to_next_worker = 0;
-  u32 next_worker_index = 0;
-  u32 current_worker_index = ~0;
 
-  if (PREDICT_FALSE (handoff_queue_elt_by_worker_index == 0))
-    {
-      vec_validate (handoff_queue_elt_by_worker_index, tm->n_vlib_mains - 1);
-
-      vec_validate_init_empty (congested_handoff_queue_by_worker_index,
-			       hm->first_worker_index + hm->num_workers - 1,
-			       (vlib_frame_queue_t *) (~0));
-    }
+  ptd = vec_elt_at_index (hm->per_thread_data, vm->thread_index);
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
@@ -106,7 +136,14 @@ worker_handoff_node_fn (vlib_main_t * vm,
       u32 hash;
       u64 hash_key;
       per_inteface_handoff_data_t *ihd0;
-      u32 index0;
+      u32 index0, worker0;
+
+      if (n_left_from > 2)
+	{
+	  vlib_buffer_t *p2 = vlib_get_buffer (vm, from[2]);
+	  vlib_prefetch_buffer_header (p2, LOAD);
+	  CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, LOAD);
+	}
 
       bi0 = from[0];
       from += 1;
@@ -117,8 +154,6 @@ worker_handoff_node_fn (vlib_main_t * vm,
       ASSERT (hm->if_data);
       ihd0 = vec_elt_at_index (hm->if_data, sw_if_index0);
 
-      next_worker_index = hm->first_worker_index;
-
       /*
        * Force unknown traffic onto worker 0,
        * and into ethernet-input. $$$$ add more hashes.
@@ -146,35 +181,11 @@ worker_handoff_node_fn (vlib_main_t * vm,
       else
 	index0 = hash % vec_len (ihd0->workers);
 
-      next_worker_index += ihd0->workers[index0];
-
-      if (next_worker_index != current_worker_index)
-	{
-	  if (hf)
-	    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
-
-	  hf = vlib_get_worker_handoff_queue_elt (hm->frame_queue_index,
-						  next_worker_index,
-						  handoff_queue_elt_by_worker_index);
-
-	  n_left_to_next_worker = VLIB_FRAME_SIZE - hf->n_vectors;
-	  to_next_worker = &hf->buffer_index[hf->n_vectors];
-	  current_worker_index = next_worker_index;
-	}
-
-      /* enqueue to correct worker thread */
-      to_next_worker[0] = bi0;
-      to_next_worker++;
-      n_left_to_next_worker--;
+      worker0 = ihd0->workers[index0];
 
-      if (n_left_to_next_worker == 0)
-	{
-	  hf->n_vectors = VLIB_FRAME_SIZE;
-	  vlib_put_frame_queue_elt (hf);
-	  current_worker_index = ~0;
-	  handoff_queue_elt_by_worker_index[next_worker_index] = 0;
-	  hf = 0;
-	}
+      if (vec_len (ptd->buffers_by_worker[worker0]) == 0)
+	vec_add1 (ptd->active_workers, worker0);
+      vec_add1 (ptd->buffers_by_worker[worker0], bi0);
 
       if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
 			 && (b0->flags & VLIB_BUFFER_IS_TRACED)))
@@ -182,38 +193,52 @@ worker_handoff_node_fn (vlib_main_t * vm,
 	  worker_handoff_trace_t *t =
 	    vlib_add_trace (vm, node, b0, sizeof (*t));
 	  t->sw_if_index = sw_if_index0;
-	  t->next_worker_index = next_worker_index - hm->first_worker_index;
+	  t->next_worker_index = worker0;
 	  t->buffer_index = bi0;
 	}
-
     }
 
-  if (hf)
-    hf->n_vectors = VLIB_FRAME_SIZE - n_left_to_next_worker;
-
-  /* Ship frames to the worker nodes */
-  for (i = 0; i < vec_len (handoff_queue_elt_by_worker_index); i++)
+  /* Ship one frame queue element to each worker, or drop */
+  for (i = 0; i < vec_len (ptd->active_workers); i++)
     {
-      if (handoff_queue_elt_by_worker_index[i])
+      u32 worker = ptd->active_workers[i];
+      u32 thread = hm->first_worker_index + worker;
+      u32 *buffers = ptd->buffers_by_worker[worker];
+      u32 n_buffers = vec_len (buffers), n;
+
+      n = vlib_frame_queue_enqueue_buffers (vm, hm->frame_queue_index,
+					    thread, buffers, n_buffers);
+      ptd->n_handoff_by_worker[worker] += n;
+      buffers += n;
+      n_buffers -= n;
+
+      if (PREDICT_FALSE (n_buffers))
 	{
-	  hf = handoff_queue_elt_by_worker_index[i];
-	  /*
-	   * It works better to let the handoff node
-	   * rate-adapt, always ship the handoff queue element.
-	   */
-	  if (1 || hf->n_vectors == hf->last_n_vectors)
+	  ptd->n_congestion_drops_by_worker[worker] += n_buffers;
+	  n_drops += n_buffers;
+	  for (n = 0; n < n_buffers; n++)
+	    vlib_get_buffer (vm, buffers[n])->error =
+	      node->errors[WORKER_HANDOFF_ERROR_CONGESTION_DROP];
+	  while (n_buffers)
 	    {
-	      vlib_put_frame_queue_elt (hf);
-	      handoff_queue_elt_by_worker_index[i] = 0;
+	      vlib_get_next_frame (vm, node, 0, to_next, n_left_to_next);
+	      n = clib_min (n_buffers, n_left_to_next);
+	      clib_memcpy (to_next, buffers, n * sizeof (u32));
+	      buffers += n;
+	      n_buffers -= n;
+	      vlib_put_next_frame (vm, node, 0, n_left_to_next - n);
 	    }
-	  else
-	    hf->last_n_vectors = hf->n_vectors;
 	}
-      congested_handoff_queue_by_worker_index[i] =
-	(vlib_frame_queue_t *) (~0);
+
+      _vec_len (ptd->buffers_by_worker[worker]) = 0;
     }
-  hf = 0;
-  current_worker_index = ~0;
+  _vec_len (ptd->active_workers) = 0;
+
+  if (n_drops)
+    vlib_node_increment_counter (vm, node->node_index,
+				 WORKER_HANDOFF_ERROR_CONGESTION_DROP,
+				 n_drops);
+
   return frame->n_vectors;
 }
 
@@ -225,6 +250,9 @@ VLIB_REGISTER_NODE (worker_handoff_node) = {
   .format_trace = format_worker_handoff_trace,
   .type = VLIB_NODE_TYPE_INTERNAL,
 
+  .n_errors = ARRAY_LEN(worker_handoff_error_strings),
+  .error_strings = worker_handoff_error_strings,
+
   .n_next_nodes = 1,
   .next_nodes = {
     [0] = "error-drop",
@@ -234,14 +262,35 @@ VLIB_REGISTER_NODE (worker_handoff_node) = {
 VLIB_NODE_FUNCTION_MULTIARCH (worker_handoff_node, worker_handoff_node_fn)
 /* *INDENT-ON* */
 
+/* Push the configured congestion settings to the frame queue */
+static void
+handoff_apply_congestion_config (handoff_main_t * hm)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  u32 nelts;
+
+  if (hm->frame_queue_index == ~0)
+    return;
+
+  fqm = vec_elt_at_index (tm->frame_queue_mains, hm->frame_queue_index);
+  nelts = fqm->vlib_frame_queues[0]->nelts;
+  if (hm->queue_hi_thresh)
+    fqm->queue_hi_thresh = clib_min (hm->queue_hi_thresh, nelts);
+  if (hm->congestion_policy != ~0)
+    fqm->congestion_policy = hm->congestion_policy;
+}
+
 int
 interface_handoff_enable_disable (vlib_main_t * vm, u32 sw_if_index,
 				  uword * bitmap, int enable_disable)
 {
   handoff_main_t *hm = &handoff_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
   vnet_sw_interface_t *sw;
   vnet_main_t *vnm = vnet_get_main ();
   per_inteface_handoff_data_t *d;
+  handoff_per_thread_data_t *ptd;
   int i, rv = 0;
 
   if (pool_is_free_index (vnm->interface_main.sw_interfaces, sw_if_index))
@@ -255,8 +304,41 @@ interface_handoff_enable_disable (vlib_main_t * vm, u32 sw_if_index,
     return VNET_API_ERROR_INVALID_WORKER;
 
   if (hm->frame_queue_index == ~0)
-    hm->frame_queue_index =
-      vlib_frame_queue_main_init (handoff_dispatch_node.index, 0);
+    {
+      vlib_frame_queue_main_t *fqm;
+      u32 nelts;
+
+      hm->frame_queue_index =
+	vlib_frame_queue_main_init (handoff_dispatch_node.index, 0);
+
+      /*
+       * By default, drop rather than wait, and leave room for one
+       * element from every thread.
+       */
+      fqm = vec_elt_at_index (tm->frame_queue_mains, hm->frame_queue_index);
+      nelts = fqm->vlib_frame_queues[0]->nelts;
+      fqm->congestion_policy = VLIB_FRAME_QUEUE_CONGESTION_DROP;
+      fqm->queue_hi_thresh = nelts > tm->n_vlib_mains ?
+	nelts - tm->n_vlib_mains : 1;
+
+      vec_validate (hm->per_thread_data, tm->n_vlib_mains - 1);
+      vec_foreach (ptd, hm->per_thread_data)
+      {
+	vec_validate (ptd->buffers_by_worker, hm->num_workers - 1);
+	for (i = 0; i < hm->num_workers; i++)
+	  {
+	    vec_validate (ptd->buffers_by_worker[i], VLIB_FRAME_SIZE - 1);
+	    _vec_len (ptd->buffers_by_worker[i]) = 0;
+	  }
+	vec_validate (ptd->active_workers, hm->num_workers - 1);
+	_vec_len (ptd->active_workers) = 0;
+	vec_validate (ptd->n_handoff_by_worker, hm->num_workers - 1);
+	vec_validate (ptd->n_congestion_drops_by_worker,
+		      hm->num_workers - 1);
+      }
+    }
+
+  handoff_apply_congestion_config (hm);
 
   vec_validate (hm->if_data, sw_if_index);
   d = vec_elt_at_index (hm->if_data, sw_if_index);
@@ -290,6 +372,8 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
   int enable_disable = 1;
   uword *bitmap = 0;
   u32 sym = ~0;
+  u32 queue_hi_thresh = 0;
+  u32 policy = ~0;
 
   int rv = 0;
 
@@ -302,8 +386,16 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
       else if (unformat (input, "%U", unformat_vnet_sw_interface,
 			 vnet_get_main (), &sw_if_index))
 	;
+      else if (unformat (input, "symmetrical-5-tuple"))
+	sym = 2;
       else if (unformat (input, "symmetrical"))
 	sym = 1;
+      else if (unformat (input, "queue-hi-thresh %u", &queue_hi_thresh))
+	;
+      else if (unformat (input, "congestion %U",
+			 unformat_vlib_frame_queue_congestion_policy,
+			 &policy))
+	;
       else if (unformat (input, "asymmetrical"))
 	sym = 0;
       else
@@ -316,6 +408,11 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
   if (bitmap == 0)
     return clib_error_return (0, "Please specify list of workers...");
 
+  if (queue_hi_thresh)
+    hm->queue_hi_thresh = queue_hi_thresh;
+  if (policy != ~0)
+    hm->congestion_policy = policy;
+
   rv =
     interface_handoff_enable_disable (vm, sw_if_index, bitmap,
 				      enable_disable);
@@ -342,7 +439,9 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
       return clib_error_return (0, "unknown return value %d", rv);
     }
 
-  if (sym == 1)
+  if (sym == 2)
+    hm->hash_fn = eth_get_sym_5tuple_key;
+  else if (sym == 1)
     hm->hash_fn = eth_get_sym_key;
   else if (sym == 0)
     hm->hash_fn = eth_get_key;
@@ -350,15 +449,101 @@ set_interface_handoff_command_fn (vlib_main_t * vm,
   return 0;
 }
 
+/*?
+ * Hand packets received on an interface off to a set of worker
+ * threads, by flow hash. <em>symmetrical</em> hashes the address pair
+ * and protocol so that both directions of a flow reach the same worker;
+ * <em>symmetrical-5-tuple</em> also hashes the TCP/UDP ports, for an
+ * even spread of many flows between few hosts. A worker whose frame
+ * queue holds <em>queue-hi-thresh</em> elements is congested. By
+ * default (<em>congestion drop</em>) packets for it are then dropped,
+ * and counted, instead of stalling the sending thread;
+ * <em>congestion defer</em> holds a bounded number back and retries
+ * them on the next pass of the sending thread's main loop, and
+ * <em>congestion wait</em> blocks until the queue drains. The hash and
+ * congestion settings apply to all interfaces.
+ *
+ * @cliexpar
+ * @cliexcmd{set interface handoff GigabitEthernet2/0/0 workers 0-3 symmetrical-5-tuple congestion defer}
+?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (set_interface_handoff_command, static) = {
   .path = "set interface handoff",
   .short_help =
-  "set interface handoff <interface-name> workers <workers-list> [symmetrical|asymmetrical]",
+  "set interface handoff <interface-name> workers <workers-list> "
+  "[symmetrical|symmetrical-5-tuple|asymmetrical] [queue-hi-thresh <n>] "
+  "[congestion drop|defer|wait]",
   .function = set_interface_handoff_command_fn,
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+show_handoff_command_fn (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  handoff_main_t *hm = &handoff_main;
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_frame_queue_main_t *fqm;
+  handoff_per_thread_data_t *ptd;
+  u64 n_handoff, n_drops;
+  char *hash;
+  int i;
+
+  if (hm->hash_fn == eth_get_sym_5tuple_key)
+    hash = "symmetrical-5-tuple";
+  else if (hm->hash_fn == eth_get_sym_key)
+    hash = "symmetrical";
+  else
+    hash = "asymmetrical";
+
+  if (hm->frame_queue_index == ~0)
+    {
+      vlib_cli_output (vm, "hash %s", hash);
+      return 0;
+    }
+
+  fqm = vec_elt_at_index (tm->frame_queue_mains, hm->frame_queue_index);
+  vlib_cli_output (vm, "hash %s, queue-hi-thresh %u, congestion %U", hash,
+		   fqm->queue_hi_thresh,
+		   format_vlib_frame_queue_congestion_policy,
+		   fqm->congestion_policy);
+
+  vlib_cli_output (vm, "%-10s%20s%20s", "worker", "handed off",
+		   "congestion drops");
+  for (i = 0; i < hm->num_workers; i++)
+    {
+      n_handoff = n_drops = 0;
+      vec_foreach (ptd, hm->per_thread_data)
+      {
+	n_handoff += ptd->n_handoff_by_worker[i];
+	n_drops += ptd->n_congestion_drops_by_worker[i];
+      }
+      vlib_cli_output (vm, "%-10d%20lu%20lu", i, n_handoff, n_drops);
+    }
+
+  return 0;
+}
+
+/*?
+ * Show the worker handoff settings, and for each worker the packets
+ * handed off to it and those dropped because its queue was congested.
+ *
+ * @cliexpar
+ * @cliexstart{show handoff}
+ * hash symmetrical-5-tuple, queue-hi-thresh 27, congestion drop
+ * worker              handed off    congestion drops
+ * 0                       102400                   0
+ * 1                        98304                 512
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_handoff_command, static) = {
+  .path = "show handoff",
+  .short_help = "show handoff",
+  .function = show_handoff_command_fn,
+};
+/* *INDENT-ON* */
+
 typedef struct
 {
   u32 buffer_index;
@@ -579,6 +764,7 @@ handoff_init (vlib_main_t * vm)
   hm->vnet_main = &vnet_main;
 
   hm->frame_queue_index = ~0;
+  hm->congestion_policy = ~0;
 
   return 0;
 }
@@ -20,6 +20,7 @@
 #include <vnet/ethernet/ethernet.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/ip/ip6_packet.h>
+#include <vnet/udp/udp_packet.h>
 #include <vnet/mpls/packet.h>
 
 typedef enum
@@ -196,6 +197,70 @@ eth_get_sym_key (ethernet_header_t * h0)
   return hash_key;
 }
 
+/*
+ * Symmetric 5-tuple keys: both addresses and both ports are combined
+ * with xor, so a flow and its reply hash the same. Fragments and
+ * protocols without ports hash on the addresses alone.
+ */
+static inline u64
+ipv4_get_sym_5tuple_key (ip4_header_t * ip)
+{
+  u64 hash_key;
+
+  hash_key = ip->src_address.as_u32 ^ ip->dst_address.as_u32;
+  if ((ip->protocol == IP_PROTOCOL_TCP || ip->protocol == IP_PROTOCOL_UDP)
+      && !ip4_is_fragment (ip))
+    {
+      udp_header_t *udp = ip4_next_header (ip);
+      hash_key |= (u64) (udp->src_port ^ udp->dst_port) << 32;
+    }
+
+  return hash_key ^ ((u64) ip->protocol << 48);
+}
+
+static inline u64
+ipv6_get_sym_5tuple_key (ip6_header_t * ip)
+{
+  u64 hash_key;
+
+  hash_key = ip->src_address.as_u64[0] ^ ip->src_address.as_u64[1] ^
+    ip->dst_address.as_u64[0] ^ ip->dst_address.as_u64[1];
+  if (ip->protocol == IP_PROTOCOL_TCP || ip->protocol == IP_PROTOCOL_UDP)
+    {
+      udp_header_t *udp = ip6_next_header (ip);
+      hash_key ^= rotate_left ((u64) (udp->src_port ^ udp->dst_port), 17);
+    }
+
+  return hash_key ^ ip->protocol;
+}
+
+static inline u64
+eth_get_sym_5tuple_key (ethernet_header_t * h0)
+{
+  u16 type = h0->type;
+  void *l3 = h0 + 1;
+
+  if (type == clib_host_to_net_u16 (ETHERNET_TYPE_VLAN) ||
+      type == clib_host_to_net_u16 (ETHERNET_TYPE_DOT1AD))
+    {
+      ethernet_vlan_header_t *outer = l3;
+
+      outer = (outer->type == clib_host_to_net_u16 (ETHERNET_TYPE_VLAN)) ?
+	outer + 1 : outer;
+      type = outer->type;
+      l3 = outer + 1;
+    }
+
+  if (PREDICT_TRUE (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP4)))
+    return ipv4_get_sym_5tuple_key (l3);
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_IP6))
+    return ipv6_get_sym_5tuple_key (l3);
+  else if (type == clib_host_to_net_u16 (ETHERNET_TYPE_MPLS))
+    return mpls_get_key (l3);
+
+  return type;
+}
+
 static inline u64
 eth_get_key (ethernet_header_t * h0)
 {
@@ -422,6 +422,9 @@ typedef struct vnet_hw_interface_t
   /* tx checksum offload */
 #define VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD (1 << 11)
 
+  /* takes VNET_BUFFER_F_GSO packets as they are, and segments them */
+#define VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO (1 << 12)
+
   /* Hardware address as vector.  Zero (e.g. zero-length vector) if no
      address for this class (e.g. PPP). */
   u8 *hw_address;
@@ -639,6 +642,15 @@ typedef struct
   u32 tx_node_index;
 } vnet_hw_interface_nodes_t;
 
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+
+  /* Buffers allocated for, and segments of, a GSO packet */
+  u32 *gso_buffers;
+  u32 *gso_segments;
+} vnet_interface_per_thread_data_t;
+
 typedef struct
 {
   /* Hardware interfaces. */
@@ -669,6 +681,9 @@ typedef struct
 
   vnet_hw_interface_nodes_t *deleted_hw_interface_nodes;
 
+  /* Per-thread scratch for the output nodes */
+  vnet_interface_per_thread_data_t *per_thread_data;
+
   /* pcap drop tracing */
   int drop_pcap_enable;
   pcap_main_t pcap_main;
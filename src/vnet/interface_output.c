@@ -42,6 +42,7 @@
 #include <vnet/ip/ip4.h>
 #include <vnet/ip/ip6.h>
 #include <vnet/udp/udp_packet.h>
+#include <vnet/tcp/tcp_packet.h>
 #include <vnet/feature/feature.h>
 
 typedef struct
@@ -170,11 +171,24 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
 
   ASSERT (!(is_ip4 && is_ip6));
 
+  /* Checksummed per segment, by the output node or the hardware */
+  if (b->flags & VNET_BUFFER_F_GSO)
+    return;
+
   ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
   ip6 = (ip6_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
   th = (tcp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
   uh = (udp_header_t *) (b->data + vnet_buffer (b)->l4_hdr_offset);
 
+  /*
+   * The checksum field may hold a partial (pseudo-header) sum, e.g. when
+   * the packet came from a vhost-user guest.
+   */
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_TCP_CKSUM)
+    th->checksum = 0;
+  if (b->flags & VNET_BUFFER_F_OFFLOAD_UDP_CKSUM)
+    uh->checksum = 0;
+
   if (is_ip4)
     {
       ip4 = (ip4_header_t *) (b->data + vnet_buffer (b)->l3_hdr_offset);
@@ -199,12 +213,279 @@ calc_checksums (vlib_main_t * vm, vlib_buffer_t * b)
   b->flags &= ~VNET_BUFFER_F_OFFLOAD_IP_CKSUM;
 }
 
+/*
+ * Software segmentation of VNET_BUFFER_F_GSO packets, for interfaces
+ * without VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO. Nodes before the output
+ * node handle one large TCP packet instead of many MSS sized ones.
+ *
+ * Each segment gets a copy of the L2 to L4 headers and gso_size bytes
+ * of the payload, copied and summed in one pass. The TCP checksum of
+ * the headers is computed once per packet; each segment adds its
+ * sequence number, flags, length and payload to it.
+ */
+
+/*
+ * Copy n_bytes and add their sum to sum. The sum is taken over the
+ * addresses of dst; odd is the parity the bytes have in the checksummed
+ * region, and a region starting at the other parity sums to the byte
+ * swapped value.
+ */
+static_always_inline ip_csum_t
+gso_csum_and_memcpy (ip_csum_t sum, u8 * dst, u8 * src, u32 n_bytes,
+		     uword odd)
+{
+  ip_csum_t s = ip_csum_and_memcpy (0, dst, src, n_bytes);
+
+  if ((pointer_to_uword (dst) ^ odd) & 1)
+    {
+      s = ip_csum_fold (s);
+      s = ((s & 0xff) << 8) | (s >> 8);
+    }
+  return ip_csum_with_carry (sum, s);
+}
+
+/* Buffers needed for a segment of n_payload bytes */
+static_always_inline u32
+gso_n_buffers (u32 n_payload, i32 first_space)
+{
+  if (n_payload <= first_space)
+    return 1;
+  return 1 + (n_payload - first_space + VLIB_BUFFER_DATA_SIZE - 1) /
+    VLIB_BUFFER_DATA_SIZE;
+}
+
+/*
+ * Segment b0 into buffers whose indices are added to *segs, the
+ * checksums done in software if do_csum. Returns the number of
+ * segments, or 0 and sets *error; b0 is left for the caller to free.
+ */
+static_always_inline u32
+gso_segment_buffer (vlib_main_t * vm, vlib_buffer_t * b0, u32 ** bufs,
+		    u32 ** segs, int do_csum, u32 * error)
+{
+  u16 gso_size = vnet_buffer2 (b0)->gso_size;
+  i32 l3_off = vnet_buffer (b0)->l3_hdr_offset - b0->current_data;
+  i32 l4_off = vnet_buffer (b0)->l4_hdr_offset - b0->current_data;
+  u32 l4_hdr_sz = vnet_buffer2 (b0)->gso_l4_hdr_sz;
+  u32 hdr_sz = l4_off + l4_hdr_sz;
+  i32 first_space = VLIB_BUFFER_DATA_SIZE - b0->current_data - hdr_sz;
+  int is_ip4 = (b0->flags & VNET_BUFFER_F_IS_IP4) != 0;
+  u8 *hdr0 = vlib_buffer_get_current (b0);
+  tcp_header_t *th0 = (tcp_header_t *) (hdr0 + l4_off);
+  u32 n_payload, n_segs, n_bufs, n_last, i, next_buf = 0;
+  u32 seq0, flags_mask;
+  vlib_buffer_t *src;
+  u32 src_off;
+  ip_csum_t hdr_sum = 0;
+  u16 ip_id0 = 0;
+
+  if (PREDICT_FALSE (l3_off < 0 || l4_off <= l3_off || gso_size == 0 ||
+		     hdr_sz > b0->current_length || first_space <= 0 ||
+		     !(b0->flags & (VNET_BUFFER_F_IS_IP4 |
+				    VNET_BUFFER_F_IS_IP6))))
+    {
+      *error = VNET_INTERFACE_OUTPUT_ERROR_BAD_GSO_HEADERS;
+      return 0;
+    }
+
+  n_payload = vlib_buffer_length_in_chain (vm, b0) - hdr_sz;
+  if (PREDICT_FALSE (n_payload == 0))
+    {
+      *error = VNET_INTERFACE_OUTPUT_ERROR_BAD_GSO_HEADERS;
+      return 0;
+    }
+  n_segs = (n_payload + gso_size - 1) / gso_size;
+  n_last = n_payload - (n_segs - 1) * gso_size;
+  n_bufs = (n_segs - 1) * gso_n_buffers (gso_size, first_space) +
+    gso_n_buffers (n_last, first_space);
+
+  vec_validate (*bufs, n_bufs - 1);
+  if (PREDICT_FALSE ((i = vlib_buffer_alloc (vm, *bufs, n_bufs)) != n_bufs))
+    {
+      if (i)
+	vlib_buffer_free (vm, *bufs, i);
+      *error = VNET_INTERFACE_OUTPUT_ERROR_NO_BUFFERS_FOR_GSO;
+      return 0;
+    }
+
+  seq0 = clib_net_to_host_u32 (th0->seq_number);
+  if (is_ip4)
+    ip_id0 = clib_net_to_host_u16 (((ip4_header_t *)
+				    (hdr0 + l3_off))->fragment_id);
+
+  /* The part of the TCP checksum common to all segments */
+  if (do_csum)
+    {
+      th0->checksum = 0;
+      if (is_ip4)
+	{
+	  ip4_header_t *ip4 = (ip4_header_t *) (hdr0 + l3_off);
+	  hdr_sum = ip_csum_with_carry (hdr_sum,
+					clib_mem_unaligned
+					(&ip4->src_address, u32));
+	  hdr_sum = ip_csum_with_carry (hdr_sum,
+					clib_mem_unaligned
+					(&ip4->dst_address, u32));
+	}
+      else
+	{
+	  ip6_header_t *ip6 = (ip6_header_t *) (hdr0 + l3_off);
+	  for (i = 0; i < ARRAY_LEN (ip6->src_address.as_uword); i++)
+	    {
+	      hdr_sum = ip_csum_with_carry (hdr_sum,
+					    ip6->src_address.as_uword[i]);
+	      hdr_sum = ip_csum_with_carry (hdr_sum,
+					    ip6->dst_address.as_uword[i]);
+	    }
+	}
+      /* Less the fields that change per segment. The add/sub_even
+         names are from the point of view of the complemented checksum,
+         so add_even takes x out of a sum. */
+      hdr_sum = ip_incremental_checksum (hdr_sum, th0, l4_hdr_sz);
+      hdr_sum = ip_csum_add_even (hdr_sum, th0->seq_number);
+      hdr_sum = ip_csum_add_even (hdr_sum,
+				  clib_mem_unaligned
+				  (&th0->data_offset_and_reserved, u16));
+    }
+
+  src = b0;
+  src_off = hdr_sz;
+
+  for (i = 0; i < n_segs; i++)
+    {
+      u32 n_seg_payload = (i == n_segs - 1) ? n_last : gso_size;
+      u32 n_left = n_seg_payload, dst_space = first_space;
+      u32 bi = (*bufs)[next_buf++];
+      vlib_buffer_t *b = vlib_get_buffer (vm, bi), *dst = b;
+      u8 *hdr = b->data + b0->current_data;
+      u8 *dst_ptr = hdr + hdr_sz;
+      tcp_header_t *th = (tcp_header_t *) (hdr + l4_off);
+      ip_csum_t sum = 0;
+
+      vec_add1 (*segs, bi);
+
+      /* The segment inherits the metadata, headers at the same offsets */
+      b->flags = (b->flags & VLIB_BUFFER_FREE_LIST_INDEX_MASK) |
+	(b0->flags & ~(VLIB_BUFFER_FREE_LIST_INDEX_MASK |
+		       VLIB_BUFFER_IS_TRACED | VLIB_BUFFER_NEXT_PRESENT |
+		       VNET_BUFFER_F_GSO));
+      b->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+      b->current_data = b0->current_data;
+      b->current_length = hdr_sz;
+      b->total_length_not_including_first_buffer = 0;
+      b->error = b0->error;
+      b->feature_arc_index = b0->feature_arc_index;
+      b->current_config_index = b0->current_config_index;
+      clib_memcpy (b->opaque, b0->opaque, sizeof (b0->opaque));
+      clib_memcpy (b->opaque2, b0->opaque2, sizeof (b0->opaque2));
+      clib_memcpy (hdr, hdr0, hdr_sz);
+
+      while (n_left)
+	{
+	  u32 n;
+
+	  if (src_off == src->current_length)
+	    {
+	      ASSERT (src->flags & VLIB_BUFFER_NEXT_PRESENT);
+	      src = vlib_get_buffer (vm, src->next_buffer);
+	      src_off = 0;
+	      continue;
+	    }
+	  if (dst_space == 0)
+	    {
+	      u32 next_bi = (*bufs)[next_buf++];
+	      vlib_buffer_t *next = vlib_get_buffer (vm, next_bi);
+
+	      next->flags &= VLIB_BUFFER_FREE_LIST_INDEX_MASK;
+	      next->current_data = 0;
+	      next->current_length = 0;
+	      dst->next_buffer = next_bi;
+	      dst->flags |= VLIB_BUFFER_NEXT_PRESENT;
+	      dst = next;
+	      dst_ptr = vlib_buffer_get_current (next);
+	      dst_space = VLIB_BUFFER_DATA_SIZE;
+	    }
+
+	  n = clib_min (n_left, src->current_length - src_off);
+	  n = clib_min (n, dst_space);
+	  if (do_csum)
+	    sum = gso_csum_and_memcpy (sum, dst_ptr,
+				       vlib_buffer_get_current (src) +
+				       src_off, n,
+				       pointer_to_uword (th) + l4_hdr_sz +
+				       n_seg_payload - n_left);
+	  else
+	    clib_memcpy (dst_ptr, vlib_buffer_get_current (src) + src_off, n);
+
+	  dst->current_length += n;
+	  if (dst != b)
+	    b->total_length_not_including_first_buffer += n;
+	  dst_ptr += n;
+	  dst_space -= n;
+	  src_off += n;
+	  n_left -= n;
+	}
+
+      /* FIN and PSH on the last segment only, CWR on the first */
+      flags_mask = 0;
+      if (i != n_segs - 1)
+	flags_mask |= TCP_FLAG_FIN | TCP_FLAG_PSH;
+      if (i != 0)
+	flags_mask |= TCP_FLAG_CWR;
+      th->flags &= ~flags_mask;
+      th->seq_number = clib_host_to_net_u32 (seq0 + i * gso_size);
+
+      if (is_ip4)
+	{
+	  ip4_header_t *ip4 = (ip4_header_t *) (hdr + l3_off);
+	  ip4->length =
+	    clib_host_to_net_u16 (hdr_sz - l3_off + n_seg_payload);
+	  ip4->fragment_id = clib_host_to_net_u16 (ip_id0 + i);
+	  if (do_csum || !(b0->flags & VNET_BUFFER_F_OFFLOAD_IP_CKSUM))
+	    ip4->checksum = ip4_header_checksum (ip4);
+	}
+      else
+	{
+	  ip6_header_t *ip6 = (ip6_header_t *) (hdr + l3_off);
+	  ip6->payload_length =
+	    clib_host_to_net_u16 (hdr_sz - l3_off - sizeof (ip6_header_t) +
+				  n_seg_payload);
+	}
+
+      if (do_csum)
+	{
+	  u32 l4_len = l4_hdr_sz + n_seg_payload;
+
+	  sum = ip_csum_with_carry (sum, hdr_sum);
+	  sum = ip_csum_with_carry (sum, th->seq_number);
+	  sum = ip_csum_with_carry (sum,
+				    clib_mem_unaligned
+				    (&th->data_offset_and_reserved, u16));
+	  sum = ip_csum_with_carry (sum,
+				    clib_host_to_net_u32 (l4_len +
+							  (IP_PROTOCOL_TCP
+							   << 16)));
+	  th->checksum = ~ip_csum_fold (sum);
+	  b->flags &= ~(VNET_BUFFER_F_OFFLOAD_TCP_CKSUM |
+			VNET_BUFFER_F_OFFLOAD_IP_CKSUM);
+	}
+      else
+	{
+	  th->checksum = 0;
+	  b->flags |= VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+	}
+    }
+
+  ASSERT (next_buf == n_bufs);
+  return n_segs;
+}
+
 static_always_inline uword
 vnet_interface_output_node_inline (vlib_main_t * vm,
 				   vlib_node_runtime_t * node,
 				   vlib_frame_t * frame, vnet_main_t * vnm,
 				   vnet_hw_interface_t * hi,
-				   int do_tx_offloads)
+				   int do_tx_offloads, int do_segmentation)
 {
   vnet_interface_output_runtime_t *rt = (void *) node->runtime_data;
   vnet_sw_interface_t *si;
@@ -216,6 +497,8 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
   u32 next_index = VNET_INTERFACE_OUTPUT_NEXT_TX;
   u32 current_config_index = ~0;
   u8 arc = im->output_feature_arc_index;
+  vnet_interface_per_thread_data_t *ptd =
+    vec_elt_at_index (im->per_thread_data, thread_index);
 
   n_buffers = frame->n_vectors;
 
@@ -306,6 +589,18 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 	  b2 = vlib_get_buffer (vm, bi2);
 	  b3 = vlib_get_buffer (vm, bi3);
 
+	  /* Leave GSO packets, and the rest of the frame, to the single
+	     loop */
+	  if (do_segmentation &&
+	      PREDICT_FALSE ((b0->flags | b1->flags | b2->flags | b3->flags) &
+			     VNET_BUFFER_F_GSO))
+	    {
+	      from -= 4;
+	      to_tx -= 4;
+	      n_left_to_tx += 4;
+	      break;
+	    }
+
 	  /* Be grumpy about zero length buffers for benefit of
 	     driver tx function. */
 	  ASSERT (b0->current_length > 0);
@@ -408,6 +703,63 @@ vnet_interface_output_node_inline (vlib_main_t * vm,
 	     driver tx function. */
 	  ASSERT (b0->current_length > 0);
 
+	  if (do_segmentation && PREDICT_FALSE (b0->flags & VNET_BUFFER_F_GSO))
+	    {
+	      u32 n_segs, *seg;
+	      u32 error0 = VNET_INTERFACE_OUTPUT_ERROR_BAD_GSO_HEADERS;
+
+	      /* The segments go instead */
+	      to_tx -= 1;
+	      n_left_to_tx += 1;
+
+	      n_segs = gso_segment_buffer (vm, b0, &ptd->gso_buffers,
+					   &ptd->gso_segments,
+					   do_tx_offloads, &error0);
+	      if (PREDICT_FALSE (n_segs == 0))
+		{
+		  vlib_error_drop_buffers (vm, node, &bi0,
+					   /* buffer stride */ 1, 1,
+					   VNET_INTERFACE_OUTPUT_NEXT_DROP,
+					   node->node_index, error0);
+		  continue;
+		}
+
+	      vec_foreach (seg, ptd->gso_segments)
+	      {
+		vlib_buffer_t *s0 = vlib_get_buffer (vm, seg[0]);
+
+		if (PREDICT_FALSE (n_left_to_tx == 0))
+		  {
+		    vlib_put_next_frame (vm, node, next_index, n_left_to_tx);
+		    vlib_get_new_next_frame (vm, node, next_index, to_tx,
+					     n_left_to_tx);
+		  }
+		to_tx[0] = seg[0];
+		to_tx += 1;
+		n_left_to_tx -= 1;
+
+		n_bytes_b0 = vlib_buffer_length_in_chain (vm, s0);
+		n_bytes += n_bytes_b0;
+		n_packets += 1;
+
+		if (PREDICT_FALSE (current_config_index != ~0))
+		  {
+		    s0->feature_arc_index = arc;
+		    s0->current_config_index = current_config_index;
+		  }
+
+		tx_swif0 = vnet_buffer (s0)->sw_if_index[VLIB_TX];
+		if (PREDICT_FALSE (tx_swif0 != rt->sw_if_index))
+		  vlib_increment_combined_counter (im->combined_sw_if_counters
+						   + VNET_INTERFACE_COUNTER_TX,
+						   thread_index, tx_swif0, 1,
+						   n_bytes_b0);
+	      }
+	      vec_reset_length (ptd->gso_segments);
+	      vlib_buffer_free_one (vm, bi0);
+	      continue;
+	    }
+
 	  n_bytes_b0 = vlib_buffer_length_in_chain (vm, b0);
 	  tx_swif0 = vnet_buffer (b0)->sw_if_index[VLIB_TX];
 	  n_bytes += n_bytes_b0;
@@ -452,12 +804,26 @@ vnet_interface_output_node (vlib_main_t * vm, vlib_node_runtime_t * node,
   vnet_interface_output_runtime_t *rt = (void *) node->runtime_data;
   hi = vnet_get_sup_hw_interface (vnm, rt->sw_if_index);
 
+  /* GSO packets are segmented for interfaces that can't take them */
+  if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_GSO)
+    {
+      if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD)
+	return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
+						  /* do_tx_offloads */ 0,
+						  /* do_segmentation */ 0);
+      else
+	return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
+						  /* do_tx_offloads */ 1,
+						  /* do_segmentation */ 0);
+    }
   if (hi->flags & VNET_HW_INTERFACE_FLAG_SUPPORTS_TX_L4_CKSUM_OFFLOAD)
     return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
-					      /* do_tx_offloads */ 0);
+					      /* do_tx_offloads */ 0,
+					      /* do_segmentation */ 1);
   else
     return vnet_interface_output_node_inline (vm, node, frame, vnm, hi,
-					      /* do_tx_offloads */ 1);
+					      /* do_tx_offloads */ 1,
+					      /* do_segmentation */ 1);
 }
 
 VLIB_NODE_FUNCTION_MULTIARCH_CLONE (vnet_interface_output_node);
@@ -1251,6 +1617,163 @@ VLIB_CLI_COMMAND (pcap_trace_command, static) = {
 };
 /* *INDENT-ON* */
 
+/*
+ * Send one GSO packet to an interface's output node, for the tests. The
+ * TCP payload of <size> bytes is chained in buffers of <chunk> bytes.
+ */
+static clib_error_t *
+test_gso_command_fn (vlib_main_t * vm, unformat_input_t * input,
+		     vlib_cli_command_t * cmd)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, size = 8000, mss = 1448, chunk = 1001;
+  u32 *bis = 0, n_bufs, n_alloc, i, j, n, l4_off, offset;
+  int is_ip6 = 0;
+  vnet_hw_interface_t *hi;
+  vlib_buffer_t *b, *b0;
+  ethernet_header_t *eh;
+  tcp_header_t *th;
+  vlib_frame_t *f;
+  u8 *data;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "ip6"))
+	is_ip6 = 1;
+      else if (unformat (input, "size %u", &size))
+	;
+      else if (unformat (input, "mss %u", &mss))
+	;
+      else if (unformat (input, "chunk %u", &chunk))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sw_if_index == ~0)
+    return clib_error_return (0, "interface required");
+  if (size == 0 || size > 65000 || mss == 0 || mss > 0xffff || chunk == 0
+      || chunk > VLIB_BUFFER_DATA_SIZE)
+    return clib_error_return (0, "bad size, mss or chunk");
+
+  l4_off = sizeof (ethernet_header_t) +
+    (is_ip6 ? sizeof (ip6_header_t) : sizeof (ip4_header_t));
+  n_bufs = 1 + (size + chunk - 1) / chunk;
+  vec_validate (bis, n_bufs - 1);
+  if ((n_alloc = vlib_buffer_alloc (vm, bis, n_bufs)) != n_bufs)
+    {
+      if (n_alloc)
+	vlib_buffer_free (vm, bis, n_alloc);
+      vec_free (bis);
+      return clib_error_return (0, "buffer allocation failure");
+    }
+
+  /* The headers alone in the first buffer */
+  b0 = vlib_get_buffer (vm, bis[0]);
+  b0->flags &= VLIB_BUFFER_FREE_LIST_INDEX_MASK;
+  b0->current_data = 0;
+  b0->current_length = l4_off + sizeof (tcp_header_t);
+  data = vlib_buffer_get_current (b0);
+  memset (data, 0, b0->current_length);
+
+  eh = (ethernet_header_t *) data;
+  eh->dst_address[0] = eh->src_address[0] = 0x02;
+  eh->dst_address[5] = 0x02;
+  eh->src_address[5] = 0x01;
+  if (is_ip6)
+    {
+      ip6_header_t *ip6 = (ip6_header_t *) (eh + 1);
+
+      eh->type = clib_host_to_net_u16 (ETHERNET_TYPE_IP6);
+      ip6->ip_version_traffic_class_and_flow_label =
+	clib_host_to_net_u32 (6 << 28);
+      ip6->payload_length =
+	clib_host_to_net_u16 (sizeof (tcp_header_t) + size);
+      ip6->protocol = IP_PROTOCOL_TCP;
+      ip6->hop_limit = 64;
+      ip6->src_address.as_u16[0] = clib_host_to_net_u16 (0x2001);
+      ip6->src_address.as_u8[15] = 1;
+      ip6->dst_address.as_u16[0] = clib_host_to_net_u16 (0x2001);
+      ip6->dst_address.as_u8[15] = 2;
+      b0->flags |= VNET_BUFFER_F_IS_IP6;
+    }
+  else
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) (eh + 1);
+
+      eh->type = clib_host_to_net_u16 (ETHERNET_TYPE_IP4);
+      ip4->ip_version_and_header_length = 0x45;
+      ip4->length = clib_host_to_net_u16 (sizeof (ip4_header_t) +
+					  sizeof (tcp_header_t) + size);
+      ip4->fragment_id = clib_host_to_net_u16 (1);
+      ip4->ttl = 64;
+      ip4->protocol = IP_PROTOCOL_TCP;
+      ip4->src_address.as_u32 = clib_host_to_net_u32 (0x0a000001);
+      ip4->dst_address.as_u32 = clib_host_to_net_u32 (0x0a000002);
+      ip4->checksum = ip4_header_checksum (ip4);
+      b0->flags |= VNET_BUFFER_F_IS_IP4;
+    }
+
+  th = (tcp_header_t *) (data + l4_off);
+  th->src_port = clib_host_to_net_u16 (1234);
+  th->dst_port = clib_host_to_net_u16 (80);
+  th->seq_number = clib_host_to_net_u32 (1000);
+  th->ack_number = clib_host_to_net_u32 (1);
+  th->data_offset_and_reserved = (sizeof (tcp_header_t) / 4) << 4;
+  th->flags = TCP_FLAG_ACK | TCP_FLAG_PSH;
+  th->window = clib_host_to_net_u16 (1000);
+
+  /* The payload, numbered by its offset */
+  b = b0;
+  for (i = 1, offset = 0; i < n_bufs; i++, offset += n)
+    {
+      vlib_buffer_t *next = vlib_get_buffer (vm, bis[i]);
+
+      n = clib_min (chunk, size - offset);
+      next->flags &= VLIB_BUFFER_FREE_LIST_INDEX_MASK;
+      next->current_data = 0;
+      next->current_length = n;
+      data = vlib_buffer_get_current (next);
+      for (j = 0; j < n; j++)
+	data[j] = offset + j;
+      b->next_buffer = bis[i];
+      b->flags |= VLIB_BUFFER_NEXT_PRESENT;
+      b = next;
+    }
+
+  b0->total_length_not_including_first_buffer = size;
+  b0->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID | VNET_BUFFER_F_GSO |
+    VNET_BUFFER_F_OFFLOAD_TCP_CKSUM;
+  vnet_buffer (b0)->sw_if_index[VLIB_RX] = 0;
+  vnet_buffer (b0)->sw_if_index[VLIB_TX] = sw_if_index;
+  vnet_buffer (b0)->l2_hdr_offset = 0;
+  vnet_buffer (b0)->l3_hdr_offset = sizeof (ethernet_header_t);
+  vnet_buffer (b0)->l4_hdr_offset = l4_off;
+  vnet_buffer2 (b0)->gso_size = mss;
+  vnet_buffer2 (b0)->gso_l4_hdr_sz = sizeof (tcp_header_t);
+
+  hi = vnet_get_sup_hw_interface (vnm, sw_if_index);
+  f = vlib_get_frame_to_node (vm, hi->output_node_index);
+  ((u32 *) vlib_frame_vector_args (f))[0] = bis[0];
+  f->n_vectors = 1;
+  vlib_put_frame_to_node (vm, hi->output_node_index, f);
+
+  vec_free (bis);
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_gso_command, static) = {
+  .path = "test gso",
+  .short_help = "test gso <intfc> [ip6] [size <n>] [mss <n>] [chunk <n>]",
+  .function = test_gso_command_fn,
+};
+/* *INDENT-ON* */
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -148,6 +148,12 @@ typedef struct ip4_main_t
 
     u8 pad[2];
   } host_config;
+
+  /** Start FIBs with a compact mtrie; see ip4_fib_mtrie_t. */
+  u8 mtrie_compact;
+
+  /** Number of second byte PLYs at which a compact mtrie is promoted. */
+  u32 mtrie_compact_max_plys;
 } ip4_main_t;
 
 /** Global ip4 main structure. */
@@ -2438,12 +2438,12 @@ ip4_rewrite_inline (vlib_main_t * vm,
 
 	  /* Check MTU of outgoing interface. */
 	  error0 =
-	    (vlib_buffer_length_in_chain (vm, p0) >
+	    (vnet_buffer_mtu_length (vm, p0) >
 	     adj0[0].
 	     rewrite_header.max_l3_packet_bytes ? IP4_ERROR_MTU_EXCEEDED :
 	     error0);
 	  error1 =
-	    (vlib_buffer_length_in_chain (vm, p1) >
+	    (vnet_buffer_mtu_length (vm, p1) >
 	     adj1[0].
 	     rewrite_header.max_l3_packet_bytes ? IP4_ERROR_MTU_EXCEEDED :
 	     error1);
@@ -2604,7 +2604,7 @@ ip4_rewrite_inline (vlib_main_t * vm,
 	       vlib_buffer_length_in_chain (vm, p0) + rw_len0);
 
 	  /* Check MTU of outgoing interface. */
-	  error0 = (vlib_buffer_length_in_chain (vm, p0)
+	  error0 = (vnet_buffer_mtu_length (vm, p0)
 		    > adj0[0].rewrite_header.max_l3_packet_bytes
 		    ? IP4_ERROR_MTU_EXCEEDED : error0);
 
@@ -3143,6 +3143,36 @@ VLIB_CLI_COMMAND (set_ip_classify_command, static) =
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+ip4_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  ip4_main_t *im = &ip4_main;
+  u32 tmp;
+
+  im->mtrie_compact_max_plys = IP4_MTRIE_COMPACT_MAX_PLYS_DEFAULT;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "mtrie-compact-max-plys %d", &tmp))
+	im->mtrie_compact_max_plys = tmp;
+      else if (unformat (input, "mtrie-compact"))
+	im->mtrie_compact = 1;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+/*
+ * ip4 { mtrie-compact [mtrie-compact-max-plys <n>] }
+ *
+ * mtrie-compact starts each FIB's mtrie with an 8 bit root, for
+ * deployments with many sparse VRFs; see ip4_fib_mtrie_t.
+ */
+VLIB_EARLY_CONFIG_FUNCTION (ip4_config, "ip4");
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
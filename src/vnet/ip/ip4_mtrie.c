@@ -195,23 +195,122 @@ get_next_ply_for_leaf (ip4_fib_mtrie_t * m, ip4_fib_mtrie_leaf_t l)
 void
 ip4_mtrie_free (ip4_fib_mtrie_t * m)
 {
-  /* the root ply is embedded so the is nothing to do,
-   * the assumption being that the IP4 FIB table has emptied the trie
-   * before deletion.
+  /* the assumption is that the IP4 FIB table has emptied the trie
+   * before deletion, so only the root is left.
    */
 #if CLIB_DEBUG > 0
-  int i;
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+  ip4_fib_mtrie_leaf_t *leaves;
+  int i, n_leaves;
+
+  if (m->root_ply)
+    {
+      leaves = m->root_ply->leaves;
+      n_leaves = ARRAY_LEN (m->root_ply->leaves);
+    }
+  else
+    {
+      leaves = ip4_ply_pool[m->root_ply8_index].leaves;
+      n_leaves = ARRAY_LEN (ip4_ply_pool[0].leaves);
+    }
+  for (i = 0; i < n_leaves; i++)
     {
-      ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (m->root_ply.leaves[i]));
+      ASSERT (!ip4_fib_mtrie_leaf_is_next_ply (leaves[i]));
     }
 #endif
+
+  if (m->root_ply)
+    clib_mem_free (m->root_ply);
+  else
+    pool_put_index (ip4_ply_pool, m->root_ply8_index);
+  m->root_ply = 0;
 }
 
 void
 ip4_mtrie_init (ip4_fib_mtrie_t * m)
 {
-  ply_16_init (&m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+  ip4_fib_mtrie_8_ply_t *p;
+
+  if (ip4_main.mtrie_compact)
+    {
+      pool_get_aligned (ip4_ply_pool, p, CLIB_CACHE_LINE_BYTES);
+      ply_8_init (p, IP4_FIB_MTRIE_LEAF_EMPTY, 0, 0);
+      m->root_ply8_index = p - ip4_ply_pool;
+      m->root_ply = 0;
+    }
+  else
+    {
+      m->root_ply = clib_mem_alloc_aligned (sizeof (*m->root_ply),
+					    CLIB_CACHE_LINE_BYTES);
+      ply_16_init (m->root_ply, IP4_FIB_MTRIE_LEAF_EMPTY, 0);
+    }
+}
+
+/*
+ * Replace a compact mtrie's 8 bit root, and the PLYs for the second
+ * byte, with a 16 bit root. The PLYs further down stay as they are.
+ */
+static void
+ip4_mtrie_promote (ip4_fib_mtrie_t * m)
+{
+  ip4_fib_mtrie_16_ply_t *root;
+  ip4_fib_mtrie_8_ply_t *p0, *p1;
+  ip4_fib_mtrie_leaf_t l0;
+  ip4_address_t a;
+  u32 i, j;
+
+  root = clib_mem_alloc_aligned (sizeof (*root), CLIB_CACHE_LINE_BYTES);
+  p0 = pool_elt_at_index (ip4_ply_pool, m->root_ply8_index);
+
+  for (i = 0; i < ARRAY_LEN (p0->leaves); i++)
+    {
+      a.as_u8[0] = i;
+      l0 = p0->leaves[i];
+
+      if (ip4_fib_mtrie_leaf_is_terminal (l0))
+	{
+	  for (j = 0; j < 256; j++)
+	    {
+	      a.as_u8[1] = j;
+	      root->leaves[a.as_u16[0]] = l0;
+	      root->dst_address_bits_of_leaves[a.as_u16[0]] =
+		p0->dst_address_bits_of_leaves[i];
+	    }
+	}
+      else
+	{
+	  p1 = get_next_ply_for_leaf (m, l0);
+	  for (j = 0; j < 256; j++)
+	    {
+	      a.as_u8[1] = j;
+	      root->leaves[a.as_u16[0]] = p1->leaves[j];
+	      root->dst_address_bits_of_leaves[a.as_u16[0]] =
+		p1->dst_address_bits_of_leaves[j];
+	    }
+	}
+    }
+
+  /* the new root is complete before the data-plane sees it */
+  CLIB_MEMORY_BARRIER ();
+  m->root_ply = root;
+
+  for (i = 0; i < ARRAY_LEN (p0->leaves); i++)
+    if (ip4_fib_mtrie_leaf_is_next_ply (p0->leaves[i]))
+      pool_put (ip4_ply_pool, get_next_ply_for_leaf (m, p0->leaves[i]));
+  pool_put (ip4_ply_pool, p0);
+}
+
+static void
+ip4_mtrie_maybe_promote (ip4_fib_mtrie_t * m)
+{
+  ip4_fib_mtrie_8_ply_t *p0;
+  u32 i, n_plys = 0;
+
+  p0 = pool_elt_at_index (ip4_ply_pool, m->root_ply8_index);
+  for (i = 0; i < ARRAY_LEN (p0->leaves); i++)
+    n_plys += ip4_fib_mtrie_leaf_is_next_ply (p0->leaves[i]);
+
+  if (n_plys >= ip4_main.mtrie_compact_max_plys)
+    ip4_mtrie_promote (m);
 }
 
 typedef struct
@@ -367,8 +466,7 @@ set_leaf (ip4_fib_mtrie_t * m,
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, dst_byte);
 
 	  new_leaf = ply_create (m, old_leaf,
-				 clib_max (old_ply->dst_address_bits_of_leaves
-					   [dst_byte], ply_base_len),
+				 old_ply->dst_address_bits_of_leaves[dst_byte],
 				 ply_base_len);
 	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
@@ -400,7 +498,14 @@ set_root_leaf (ip4_fib_mtrie_t * m,
   i32 n_dst_bits_next_plies;
   u16 dst_byte;
 
-  old_ply = &m->root_ply;
+  if (!m->root_ply)
+    {
+      set_leaf (m, a, m->root_ply8_index, 0);
+      ip4_mtrie_maybe_promote (m);
+      return;
+    }
+
+  old_ply = m->root_ply;
 
   ASSERT (a->dst_address_length <= 32);
 
@@ -490,8 +595,7 @@ set_root_leaf (ip4_fib_mtrie_t * m,
 	{
 	  /* There is a leaf occupying the slot. Replace it with a new ply */
 	  new_leaf = ply_create (m, old_leaf,
-				 clib_max (old_ply->dst_address_bits_of_leaves
-					   [dst_byte], ply_base_len),
+				 old_ply->dst_address_bits_of_leaves[dst_byte],
 				 ply_base_len);
 	  new_ply = get_next_ply_for_leaf (m, new_leaf);
 
@@ -548,9 +652,7 @@ unset_leaf (ip4_fib_mtrie_t * m,
 
 	  old_ply->leaves[i] =
 	    ip4_fib_mtrie_leaf_set_adj_index (a->cover_adj_index);
-	  old_ply->dst_address_bits_of_leaves[i] =
-	    clib_max (old_ply->dst_address_bits_base,
-		      a->cover_address_length);
+	  old_ply->dst_address_bits_of_leaves[i] = a->cover_address_length;
 
 	  old_ply->n_non_empty_leafs +=
 	    ip4_fib_mtrie_leaf_is_non_empty (old_ply, i);
@@ -592,7 +694,14 @@ unset_root_leaf (ip4_fib_mtrie_t * m,
 
   ASSERT (a->dst_address_length <= 32);
 
-  old_ply = &m->root_ply;
+  if (!m->root_ply)
+    {
+      unset_leaf (m, a, pool_elt_at_index (ip4_ply_pool,
+					   m->root_ply8_index), 0);
+      return;
+    }
+
+  old_ply = m->root_ply;
   n_dst_bits_next_plies = a->dst_address_length - BITS (u16);
 
   dst_byte = a->dst_address.as_u16[0];
@@ -689,9 +798,15 @@ mtrie_memory_usage (ip4_fib_mtrie_t * m)
   uword bytes, i;
 
   bytes = sizeof (*m);
-  for (i = 0; i < ARRAY_LEN (m->root_ply.leaves); i++)
+  if (!m->root_ply)
+    return bytes + mtrie_ply_memory_usage (m, pool_elt_at_index
+					   (ip4_ply_pool,
+					    m->root_ply8_index));
+
+  bytes += sizeof (*m->root_ply);
+  for (i = 0; i < ARRAY_LEN (m->root_ply->leaves); i++)
     {
-      ip4_fib_mtrie_leaf_t l = m->root_ply.leaves[i];
+      ip4_fib_mtrie_leaf_t l = m->root_ply->leaves[i];
       if (ip4_fib_mtrie_leaf_is_next_ply (l))
 	bytes += mtrie_ply_memory_usage (m, get_next_ply_for_leaf (m, l));
     }
@@ -771,8 +886,12 @@ format_ip4_fib_mtrie (u8 * s, va_list * va)
   s = format (s, "%d plies, memory usage %U\n",
 	      pool_elts (ip4_ply_pool),
 	      format_memory_size, mtrie_memory_usage (m));
+  if (!m->root_ply)
+    return format (s, "compact root-ply %U", format_ip4_fib_mtrie_ply, m,
+		   base_address, m->root_ply8_index);
+
   s = format (s, "root-ply");
-  p = &m->root_ply;
+  p = m->root_ply;
 
   for (i = 0; i < ARRAY_LEN (p->leaves); i++)
     {
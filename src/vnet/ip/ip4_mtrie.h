@@ -124,20 +124,31 @@ STATIC_ASSERT (0 == sizeof (ip4_fib_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
 
 /**
  * @brief The mutiway-TRIE.
- * There is no data associated with the mtrie apart from the top PLY
+ * The root is either a 16 bit stride PLY or, for a compact mtrie, an 8
+ * bit PLY from the pool whose PLY leaves lead to 8 bit PLYs for the
+ * second byte. A 16 bit root is 320KB whatever the number of routes; a
+ * compact root is a few KB for a VRF with a handful of them, for one
+ * more memory access in the first lookup step. A compact mtrie is
+ * promoted to a 16 bit root once it has mtrie_compact_max_plys second
+ * byte PLYs, so a full table keeps the 16-8-8 lookup.
  */
+#define IP4_MTRIE_COMPACT_MAX_PLYS_DEFAULT 32
+
 typedef struct
 {
   /**
-   * Embed the PLY with the mtrie struct. This means that the Data-plane
-   * 'get me the mtrie' returns the first ply, and not an indirect 'pointer'
-   * to it. therefore no cachline misses in the data-path.
+   * The 16 bit root PLY, NULL while the mtrie is compact.
    */
-  ip4_fib_mtrie_16_ply_t root_ply;
+  ip4_fib_mtrie_16_ply_t *root_ply;
+
+  /**
+   * Compact mtrie: pool index of the 8 bit root PLY.
+   */
+  u32 root_ply8_index;
 } ip4_fib_mtrie_t;
 
 /**
- * @brief Initialise an mtrie
+ * @brief Initialise an mtrie, compact if so configured
  */
 void ip4_mtrie_init (ip4_fib_mtrie_t * m);
 
@@ -221,9 +232,13 @@ ip4_fib_mtrie_lookup_step_one (const ip4_fib_mtrie_t * m,
 {
   ip4_fib_mtrie_leaf_t next_leaf;
 
-  next_leaf = m->root_ply.leaves[dst_address->as_u16[0]];
+  if (PREDICT_TRUE (m->root_ply != 0))
+    return m->root_ply->leaves[dst_address->as_u16[0]];
+
+  /* compact mtrie: one byte at a time */
+  next_leaf = ip4_ply_pool[m->root_ply8_index].leaves[dst_address->as_u8[0]];
 
-  return next_leaf;
+  return ip4_fib_mtrie_lookup_step (m, next_leaf, dst_address, 1);
 }
 
 #endif /* included_ip_ip4_fib_h */
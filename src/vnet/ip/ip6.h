@@ -50,6 +50,7 @@
 #include <vppinfra/bihash_24_8.h>
 #include <vppinfra/bihash_template.h>
 #include <vnet/util/radix.h>
+#include <vnet/ip/ip6_mtrie.h>
 
 /*
  * Default size of the ip6 fib hash table
@@ -66,6 +67,12 @@ typedef struct
 
 typedef struct
 {
+  /**
+   * Mtrie for forwarding lookups. First member so it's in the first
+   * cacheline.
+   */
+  ip6_fib_mtrie_t mtrie;
+
   /* Table ID (hash key) for this FIB. */
   u32 table_id;
 
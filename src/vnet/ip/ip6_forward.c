@@ -2182,12 +2182,12 @@ ip6_rewrite_inline (vlib_main_t * vm,
 
 	  /* Check MTU of outgoing interface. */
 	  error0 =
-	    (vlib_buffer_length_in_chain (vm, p0) >
+	    (vnet_buffer_mtu_length (vm, p0) >
 	     adj0[0].
 	     rewrite_header.max_l3_packet_bytes ? IP6_ERROR_MTU_EXCEEDED :
 	     error0);
 	  error1 =
-	    (vlib_buffer_length_in_chain (vm, p1) >
+	    (vnet_buffer_mtu_length (vm, p1) >
 	     adj1[0].
 	     rewrite_header.max_l3_packet_bytes ? IP6_ERROR_MTU_EXCEEDED :
 	     error1);
@@ -2315,7 +2315,7 @@ ip6_rewrite_inline (vlib_main_t * vm,
 
 	  /* Check MTU of outgoing interface. */
 	  error0 =
-	    (vlib_buffer_length_in_chain (vm, p0) >
+	    (vnet_buffer_mtu_length (vm, p0) >
 	     adj0[0].
 	     rewrite_header.max_l3_packet_bytes ? IP6_ERROR_MTU_EXCEEDED :
 	     error0);
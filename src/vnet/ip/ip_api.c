@@ -45,6 +45,11 @@
 
 #include <vnet/vnet_msg_enum.h>
 
+#define vl_api_ip_route_bulk_entry_t_endian vl_noop_handler
+#define vl_api_ip_route_bulk_entry_t_print vl_noop_handler
+#define vl_api_ip_add_del_route_bulk_t_endian vl_noop_handler
+#define vl_api_ip_add_del_route_bulk_t_print vl_noop_handler
+
 #define vl_typedefs		/* define message structures */
 #include <vnet/vnet_all_api_h.h>
 #undef vl_typedefs
@@ -80,6 +85,7 @@ _(PROXY_ARP_ADD_DEL, proxy_arp_add_del)                                 \
 _(PROXY_ARP_INTFC_ENABLE_DISABLE, proxy_arp_intfc_enable_disable)       \
 _(RESET_FIB, reset_fib)							\
 _(IP_ADD_DEL_ROUTE, ip_add_del_route)                                   \
+_(IP_ADD_DEL_ROUTE_BULK, ip_add_del_route_bulk)                         \
 _(IP_TABLE_ADD_DEL, ip_table_add_del)                                   \
 _(IP_PUNT_POLICE, ip_punt_police)                                       \
 _(IP_PUNT_REDIRECT, ip_punt_redirect)                                   \
@@ -1233,6 +1239,102 @@ vl_api_ip_add_del_route_t_handler (vl_api_ip_add_del_route_t * mp)
   REPLY_MACRO (VL_API_IP_ADD_DEL_ROUTE_REPLY);
 }
 
+static int
+ip_add_del_route_bulk_one (vl_api_ip_add_del_route_bulk_t * mp,
+			   vl_api_ip_route_bulk_entry_t * route,
+			   u32 fib_index, u32 next_hop_fib_index)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 next_hop_sw_if_index;
+  ip46_address_t nh;
+  fib_prefix_t pfx;
+
+  memset (&pfx, 0, sizeof (pfx));
+  memset (&nh, 0, sizeof (nh));
+  pfx.fp_len = route->dst_address_length;
+
+  if (mp->is_ipv6)
+    {
+      if (pfx.fp_len > 128)
+	return VNET_API_ERROR_INVALID_VALUE;
+      pfx.fp_proto = FIB_PROTOCOL_IP6;
+      clib_memcpy (&pfx.fp_addr.ip6, route->dst_address,
+		   sizeof (pfx.fp_addr.ip6));
+      clib_memcpy (&nh.ip6, route->next_hop_address, sizeof (nh.ip6));
+    }
+  else
+    {
+      if (pfx.fp_len > 32)
+	return VNET_API_ERROR_INVALID_VALUE;
+      pfx.fp_proto = FIB_PROTOCOL_IP4;
+      clib_memcpy (&pfx.fp_addr.ip4, route->dst_address,
+		   sizeof (pfx.fp_addr.ip4));
+      clib_memcpy (&nh.ip4, route->next_hop_address, sizeof (nh.ip4));
+    }
+
+  next_hop_sw_if_index = ntohl (route->next_hop_sw_if_index);
+  if (~0 != next_hop_sw_if_index &&
+      pool_is_free_index (vnm->interface_main.sw_interfaces,
+			  next_hop_sw_if_index))
+    return VNET_API_ERROR_NO_MATCHING_INTERFACE;
+
+  return (add_del_route_t_handler (0, mp->is_add, 0, 0, 0, 0, 0, 0, ~0,
+				   0, 0, 0, 0, 0, 0, 0,
+				   fib_index, &pfx,
+				   fib_proto_to_dpo (pfx.fp_proto),
+				   &nh, ~0, next_hop_sw_if_index,
+				   next_hop_fib_index,
+				   route->next_hop_weight,
+				   route->next_hop_preference,
+				   MPLS_LABEL_INVALID, NULL));
+}
+
+void
+vl_api_ip_add_del_route_bulk_t_handler (vl_api_ip_add_del_route_bulk_t * mp)
+{
+  vl_api_ip_add_del_route_bulk_reply_t *rmp;
+  u32 fib_index, next_hop_fib_index, n_routes, count;
+  vnet_main_t *vnm = vnet_get_main ();
+  fib_protocol_t fproto;
+  int rv;
+
+  vnm->api_errno = 0;
+  n_routes = 0;
+  count = ntohl (mp->count);
+  fproto = (mp->is_ipv6 ? FIB_PROTOCOL_IP6 : FIB_PROTOCOL_IP4);
+
+  rv = add_del_route_check (fproto,
+			    mp->table_id,
+			    ~0,
+			    fib_proto_to_dpo (fproto),
+			    mp->next_hop_table_id,
+			    0, &fib_index, &next_hop_fib_index);
+  if (0 != rv)
+    goto done;
+
+  fib_table_batch_begin ();
+
+  while (n_routes < count)
+    {
+      rv = ip_add_del_route_bulk_one (mp, &mp->routes[n_routes],
+				      fib_index, next_hop_fib_index);
+      rv = (rv == 0) ? vnm->api_errno : rv;
+      if (0 != rv)
+	break;
+      n_routes++;
+    }
+
+  fib_table_batch_end ();
+
+done:
+  /* *INDENT-OFF* */
+  REPLY_MACRO2 (VL_API_IP_ADD_DEL_ROUTE_BULK_REPLY,
+  ({
+    rmp->n_routes = htonl (n_routes);
+  }));
+  /* *INDENT-ON* */
+}
+
 void
 ip_table_create (fib_protocol_t fproto,
 		 u32 table_id, u8 is_api, const u8 * name)
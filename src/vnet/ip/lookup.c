@@ -368,7 +368,7 @@ vnet_ip_route_cmd (vlib_main_t * vm,
   unformat_input_t _line_input, *line_input = &_line_input;
   fib_route_path_t *rpaths = NULL, rpath;
   dpo_id_t dpo = DPO_INVALID, *dpos = NULL;
-  u32 table_id, is_del, udp_encap_id;
+  u32 table_id, is_del, is_batch, udp_encap_id;
   fib_prefix_t *prefixs = NULL, pfx;
   mpls_label_t out_label, via_label;
   clib_error_t *error = NULL;
@@ -380,6 +380,7 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
   vnm = vnet_get_main ();
   is_del = 0;
+  is_batch = 0;
   table_id = 0;
   count = 1;
   memset (&pfx, 0, sizeof (pfx));
@@ -443,6 +444,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	}
       else if (unformat (line_input, "count %f", &count))
 	;
+      else if (unformat (line_input, "batch"))
+	is_batch = 1;
 
       else if (unformat (line_input, "%U/%d",
 			 unformat_ip4_address, &pfx.fp_addr.ip4, &pfx.fp_len))
@@ -630,6 +633,9 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	  incr = 1 << ((FIB_PROTOCOL_IP4 == prefixs[0].fp_proto ? 32 : 128) -
 		       prefixs[i].fp_len);
 
+	  if (is_batch)
+	    fib_table_batch_begin ();
+
 	  for (k = 0; k < n; k++)
 	    {
 	      for (j = 0; j < vec_len (rpaths); j++)
@@ -646,6 +652,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 		      error =
 			clib_error_return (0, "Via table %d does not exist",
 					   rpaths[i].frp_fib_index);
+		      if (is_batch)
+			fib_table_batch_end ();
 		      goto done;
 		    }
 		  rpaths[i].frp_fib_index = fi;
@@ -685,6 +693,10 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 
 		}
 	    }
+
+	  if (is_batch)
+	    fib_table_batch_end ();
+
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
 	    vlib_cli_output (vm, "%.6e routes/sec", count / (t[1] - t[0]));
@@ -824,6 +836,9 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
  * Mainly for route add/del performance testing, one can add or delete
  * multiple routes by adding 'count N' to the previous item:
  * @cliexcmd{ip route add count 10 7.0.0.0/24 via 6.0.0.1 GigabitEthernet2/0/0}
+ * Adding 'batch' programs them as one FIB batch, as the bulk route API
+ * does, and the rate reported includes committing the batch:
+ * @cliexcmd{ip route add count 100000 batch 7.0.0.0/24 via 6.0.0.1 GigabitEthernet2/0/0}
  * Add multiple routes for the same destination to create equal-cost multipath:
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.1 GigabitEthernet2/0/0}
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.2 GigabitEthernet2/0/0}
@@ -838,7 +853,7 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip_route_command, static) = {
   .path = "ip route",
-  .short_help = "ip route [add|del] [count <n>] <dst-ip-addr>/<width> [table <table-id>] [via <next-hop-ip-addr> [<interface>] [weight <weight>]] | [via arp <interface> <adj-hop-ip-addr>] | [via drop|punt|local<id>|arp|classify <classify-idx>] [lookup in table <out-table-id>]",
+  .short_help = "ip route [add|del] [count <n> [batch]] <dst-ip-addr>/<width> [table <table-id>] [via <next-hop-ip-addr> [<interface>] [weight <weight>]] | [via arp <interface> <adj-hop-ip-addr>] | [via drop|punt|local<id>|arp|classify <classify-idx>] [lookup in table <out-table-id>]",
   .function = vnet_ip_route_cmd,
   .is_mp_safe = 1,
 };
@@ -17,6 +17,7 @@
 
 #include <vnet/ip/ip.h>
 #include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/esp_native.h>
 
 #include <openssl/hmac.h>
 #include <openssl/rand.h>
@@ -83,6 +84,8 @@ typedef struct
   ipsec_crypto_alg_t last_encrypt_alg;
   ipsec_crypto_alg_t last_decrypt_alg;
   ipsec_integ_alg_t last_integ_alg;
+  /* native engine work deferred to the end of the frame */
+  esp_native_job_t *native_jobs;
 } esp_main_per_thread_data_t;
 
 typedef struct
@@ -90,6 +93,8 @@ typedef struct
   esp_crypto_alg_t *esp_crypto_algs;
   esp_integ_alg_t *esp_integ_algs;
   esp_main_per_thread_data_t *per_thread_data;
+  /* native engine SA contexts, by SA index */
+  esp_native_sa_t *native_sa;
 } esp_main_t;
 
 extern esp_main_t esp_main;
@@ -97,6 +102,18 @@ extern esp_main_t esp_main;
 #define ESP_WINDOW_SIZE		(64)
 #define ESP_SEQ_MAX 		(4294967295UL)
 
+/* AES-GCM (RFC 4106): explicit IV, and ICV (the GCM tag) */
+#define ESP_GCM_IV_SIZE		(8)
+#define ESP_GCM_ICV_SIZE	(16)
+
+/* combined mode cipher; integrity comes with it */
+always_inline int
+esp_crypto_alg_is_aead (ipsec_crypto_alg_t alg)
+{
+  return alg >= IPSEC_CRYPTO_ALG_AES_GCM_128 &&
+    alg <= IPSEC_CRYPTO_ALG_AES_GCM_256;
+}
+
 u8 *format_esp_header (u8 * s, va_list * args);
 
 always_inline int
@@ -255,6 +272,9 @@ esp_init ()
   em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_128].type = EVP_aes_128_cbc ();
   em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_192].type = EVP_aes_192_cbc ();
   em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_CBC_256].type = EVP_aes_256_cbc ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_128].type = EVP_aes_128_gcm ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_192].type = EVP_aes_192_gcm ();
+  em->esp_crypto_algs[IPSEC_CRYPTO_ALG_AES_GCM_256].type = EVP_aes_256_gcm ();
 
   vec_validate (em->esp_integ_algs, IPSEC_INTEG_N_ALG - 1);
   esp_integ_alg_t *i;
@@ -283,7 +303,7 @@ esp_init ()
 			CLIB_CACHE_LINE_BYTES);
   int thread_id;
 
-  for (thread_id = 0; thread_id < tm->n_vlib_mains - 1; thread_id++)
+  for (thread_id = 0; thread_id < tm->n_vlib_mains; thread_id++)
     {
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
       em->per_thread_data[thread_id].encrypt_ctx = EVP_CIPHER_CTX_new ();
@@ -335,6 +355,83 @@ hmac_calc (ipsec_integ_alg_t alg,
   return em->esp_integ_algs[alg].trunc_size;
 }
 
+/*
+ * AES-GCM encrypt or decrypt in_len bytes, authenticating aad as well.
+ * The nonce is salt || IV. When encrypting the tag is written to tag;
+ * when decrypting it is checked against it. Returns 0, or -1 if the
+ * tag does not match.
+ */
+always_inline int
+esp_aes_gcm (ipsec_crypto_alg_t alg, int is_encrypt, u8 * in, u8 * out,
+	     int in_len, u8 * key, u8 * nonce, u8 * aad, int aad_len,
+	     u8 * tag)
+{
+  esp_main_t *em = &esp_main;
+  u32 thread_index = vlib_get_thread_index ();
+  esp_main_per_thread_data_t *ptd = &em->per_thread_data[thread_index];
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  EVP_CIPHER_CTX *ctx = is_encrypt ? ptd->encrypt_ctx : ptd->decrypt_ctx;
+#else
+  EVP_CIPHER_CTX *ctx = is_encrypt ? &ptd->encrypt_ctx : &ptd->decrypt_ctx;
+#endif
+  ipsec_crypto_alg_t *last_alg = is_encrypt ?
+    &ptd->last_encrypt_alg : &ptd->last_decrypt_alg;
+  const EVP_CIPHER *cipher = NULL;
+  int out_len;
+
+  ASSERT (esp_crypto_alg_is_aead (alg));
+
+  if (PREDICT_FALSE (alg != *last_alg))
+    {
+      cipher = em->esp_crypto_algs[alg].type;
+      *last_alg = alg;
+    }
+
+  EVP_CipherInit_ex (ctx, cipher, NULL, key, nonce, is_encrypt);
+
+  EVP_CipherUpdate (ctx, NULL, &out_len, aad, aad_len);
+  EVP_CipherUpdate (ctx, out, &out_len, in, in_len);
+  if (!is_encrypt)
+    EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_SET_TAG, ESP_GCM_ICV_SIZE, tag);
+  if (EVP_CipherFinal_ex (ctx, out + out_len, &out_len) <= 0)
+    return -1;
+  if (is_encrypt)
+    EVP_CIPHER_CTX_ctrl (ctx, EVP_CTRL_GCM_GET_TAG, ESP_GCM_ICV_SIZE, tag);
+
+  return 0;
+}
+
+/* ESP IV and ICV bytes added to each packet */
+always_inline u32
+esp_iv_icv_size (ipsec_sa_t * sa)
+{
+  if (esp_crypto_alg_is_aead (sa->crypto_alg))
+    return ESP_GCM_IV_SIZE + ESP_GCM_ICV_SIZE;
+  return 16 /* aes-cbc IV */  +
+    esp_main.esp_integ_algs[sa->integ_alg].trunc_size;
+}
+
+/*
+ * AES-GCM additional authenticated data: SPI and sequence number, with
+ * the high order sequence bits in between when ESN is on (RFC 4106
+ * section 5). Returns its length.
+ */
+always_inline u32
+esp_gcm_aad (u8 * aad, esp_header_t * esp, u8 use_esn, u32 seq_hi)
+{
+  u32 *p = (u32 *) aad;
+
+  p[0] = esp->spi;
+  if (use_esn)
+    {
+      p[1] = clib_host_to_net_u32 (seq_hi);
+      p[2] = esp->seq;
+      return 12;
+    }
+  p[1] = esp->seq;
+  return 8;
+}
+
 #endif /* __ESP_H__ */
 
 /*
@@ -207,9 +207,15 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 		icv_size;
 	      i_b0->current_length -= icv_size;
 
-	      hmac_calc (sa0->integ_alg, sa0->integ_key, sa0->integ_key_len,
-			 (u8 *) esp0, i_b0->current_length, sig, sa0->use_esn,
-			 sa0->seq_hi);
+	      if (sa0->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE)
+		esp_native_hmac (vec_elt_at_index (em->native_sa, sa_index0),
+				 (u8 *) esp0, i_b0->current_length, sa0->use_esn,
+				 sa0->seq_hi, sig);
+	      else
+		hmac_calc (sa0->integ_alg, sa0->integ_key,
+			   sa0->integ_key_len, (u8 *) esp0,
+			   i_b0->current_length, sig, sa0->use_esn,
+			   sa0->seq_hi);
 
 	      if (PREDICT_FALSE (memcmp (icv, sig, icv_size)))
 		{
@@ -223,7 +229,9 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 		}
 	    }
 
-	  if (PREDICT_TRUE (sa0->use_anti_replay))
+	  /* AEAD packets are only authenticated once decrypted, below */
+	  if (PREDICT_TRUE (sa0->use_anti_replay) &&
+	      !esp_crypto_alg_is_aead (sa0->crypto_alg))
 	    {
 	      if (PREDICT_TRUE (sa0->use_esn))
 		esp_replay_advance_esn (sa0, seq);
@@ -245,8 +253,9 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 	  /* add old buffer to the recycle list */
 	  vec_add1 (recycle, i_bi0);
 
-	  if (sa0->crypto_alg >= IPSEC_CRYPTO_ALG_AES_CBC_128 &&
-	      sa0->crypto_alg <= IPSEC_CRYPTO_ALG_AES_CBC_256)
+	  if ((sa0->crypto_alg >= IPSEC_CRYPTO_ALG_AES_CBC_128 &&
+	       sa0->crypto_alg <= IPSEC_CRYPTO_ALG_AES_CBC_256) ||
+	      esp_crypto_alg_is_aead (sa0->crypto_alg))
 	    {
 	      const int BLOCK_SIZE = 16;
 	      const int IV_SIZE = 16;
@@ -297,13 +306,86 @@ esp_decrypt_node_fn (vlib_main_t * vm,
 		    }
 		}
 
-	      esp_decrypt_aes_cbc (sa0->crypto_alg,
-				   esp0->data + IV_SIZE,
-				   (u8 *) vlib_buffer_get_current (o_b0) +
-				   ip_hdr_size, BLOCK_SIZE * blocks,
-				   sa0->crypto_key, esp0->data);
+	      if (esp_crypto_alg_is_aead (sa0->crypto_alg))
+		{
+		  /* decrypt and authenticate in one pass */
+		  u8 aad[12], *icv0;
+		  u32 aad_len;
+		  int len0 = i_b0->current_length - sizeof (esp_header_t) -
+		    ESP_GCM_IV_SIZE - ESP_GCM_ICV_SIZE;
+		  int rv;
+
+		  if (PREDICT_FALSE (len0 < (int) sizeof (esp_footer_t)))
+		    {
+		      vlib_node_increment_counter (vm, esp_decrypt_node.index,
+						   ESP_DECRYPT_ERROR_DECRYPTION_FAILED,
+						   1);
+		      o_b0 = 0;
+		      goto trace;
+		    }
+
+		  icv0 = esp0->data + ESP_GCM_IV_SIZE + len0;
+		  aad_len = esp_gcm_aad (aad, esp0, sa0->use_esn,
+					 sa0->seq_hi);
+
+		  if (sa0->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE)
+		    rv = esp_native_gcm_decrypt (vec_elt_at_index
+						 (em->native_sa, sa_index0),
+						 esp0->data + ESP_GCM_IV_SIZE,
+						 (u8 *)
+						 vlib_buffer_get_current
+						 (o_b0) + ip_hdr_size, len0,
+						 esp0->data, aad, aad_len,
+						 icv0);
+		  else
+		    {
+		      u8 nonce[12];
+		      clib_memcpy (nonce, &sa0->salt, 4);
+		      clib_memcpy (nonce + 4, esp0->data, ESP_GCM_IV_SIZE);
+		      rv = esp_aes_gcm (sa0->crypto_alg, 0,
+					esp0->data + ESP_GCM_IV_SIZE,
+					(u8 *) vlib_buffer_get_current (o_b0)
+					+ ip_hdr_size, len0, sa0->crypto_key,
+					nonce, aad, aad_len, icv0);
+		    }
+
+		  if (PREDICT_FALSE (rv))
+		    {
+		      vlib_node_increment_counter (vm, esp_decrypt_node.index,
+						   ESP_DECRYPT_ERROR_INTEG_ERROR,
+						   1);
+		      o_b0 = 0;
+		      goto trace;
+		    }
+
+		  if (PREDICT_TRUE (sa0->use_anti_replay))
+		    {
+		      if (PREDICT_TRUE (sa0->use_esn))
+			esp_replay_advance_esn (sa0, seq);
+		      else
+			esp_replay_advance (sa0, seq);
+		    }
 
-	      o_b0->current_length = (blocks * 16) - 2 + ip_hdr_size;
+		  o_b0->current_length = len0 - 2 + ip_hdr_size;
+		}
+	      else
+		{
+		  if (sa0->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE)
+		    esp_native_cbc_decrypt (vec_elt_at_index (em->native_sa,
+							      sa_index0),
+					    esp0->data + IV_SIZE,
+					    (u8 *)
+					    vlib_buffer_get_current (o_b0) +
+					    ip_hdr_size, blocks, esp0->data);
+		  else
+		    esp_decrypt_aes_cbc (sa0->crypto_alg,
+					 esp0->data + IV_SIZE,
+					 (u8 *) vlib_buffer_get_current (o_b0)
+					 + ip_hdr_size, BLOCK_SIZE * blocks,
+					 sa0->crypto_key, esp0->data);
+
+		  o_b0->current_length = (blocks * 16) - 2 + ip_hdr_size;
+		}
 	      o_b0->flags = VLIB_BUFFER_TOTAL_LENGTH_VALID;
 	      f0 =
 		(esp_footer_t *) ((u8 *) vlib_buffer_get_current (o_b0) +
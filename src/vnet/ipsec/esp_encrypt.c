@@ -124,8 +124,10 @@ esp_encrypt_node_fn (vlib_main_t * vm,
   from = vlib_frame_vector_args (from_frame);
   n_left_from = from_frame->n_vectors;
   ipsec_main_t *im = &ipsec_main;
+  esp_main_t *em = &esp_main;
   u32 *recycle = 0;
   u32 thread_index = vlib_get_thread_index ();
+  esp_main_per_thread_data_t *ptd = &em->per_thread_data[thread_index];
 
   ipsec_alloc_empty_buffers (vm, im);
 
@@ -163,6 +165,7 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 	  u8 next_hdr_type;
 	  u32 ip_proto = 0;
 	  u8 transport_mode = 0;
+	  esp_native_job_t *job0 = 0;
 
 	  i_bi0 = from[0];
 	  from += 1;
@@ -302,7 +305,55 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 
 	  ASSERT (sa0->crypto_alg < IPSEC_CRYPTO_N_ALG);
 
-	  if (PREDICT_TRUE (sa0->crypto_alg != IPSEC_CRYPTO_ALG_NONE))
+	  if (esp_crypto_alg_is_aead (sa0->crypto_alg))
+	    {
+	      /* encrypt and authenticate in one pass; pad to 4 bytes */
+	      u32 len0 = (i_b0->current_length + 2 + 3) & ~3;
+	      u8 pad_bytes = len0 - 2 - i_b0->current_length;
+	      u8 i, aad[12], *iv0, *icv0;
+	      u32 aad_len;
+	      u8 *padding =
+		vlib_buffer_get_current (i_b0) + i_b0->current_length;
+	      i_b0->current_length = len0;
+	      for (i = 0; i < pad_bytes; ++i)
+		{
+		  padding[i] = i + 1;
+		}
+	      f0 = vlib_buffer_get_current (i_b0) + len0 - 2;
+	      f0->pad_length = pad_bytes;
+	      f0->next_header = next_hdr_type;
+
+	      vnet_buffer (o_b0)->sw_if_index[VLIB_RX] =
+		vnet_buffer (i_b0)->sw_if_index[VLIB_RX];
+
+	      /* the IV only has to be unique: use the sequence number */
+	      iv0 = (u8 *) o_esp0 + sizeof (esp_header_t);
+	      clib_memcpy (iv0, &sa0->seq, sizeof (sa0->seq));
+	      clib_memcpy (iv0 + 4, &sa0->seq_hi, sizeof (sa0->seq_hi));
+	      icv0 = iv0 + ESP_GCM_IV_SIZE + len0;
+	      aad_len = esp_gcm_aad (aad, o_esp0, sa0->use_esn, sa0->seq_hi);
+
+	      if (sa0->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE)
+		esp_native_gcm_encrypt (vec_elt_at_index (em->native_sa,
+							  sa_index0),
+					vlib_buffer_get_current (i_b0),
+					iv0 + ESP_GCM_IV_SIZE, len0, iv0,
+					aad, aad_len, icv0);
+	      else
+		{
+		  u8 nonce[12];
+		  clib_memcpy (nonce, &sa0->salt, 4);
+		  clib_memcpy (nonce + 4, iv0, ESP_GCM_IV_SIZE);
+		  esp_aes_gcm (sa0->crypto_alg, 1,
+			       vlib_buffer_get_current (i_b0),
+			       iv0 + ESP_GCM_IV_SIZE, len0, sa0->crypto_key,
+			       nonce, aad, aad_len, icv0);
+		}
+
+	      o_b0->current_length = ip_hdr_size + sizeof (esp_header_t) +
+		ESP_GCM_IV_SIZE + len0 + ESP_GCM_ICV_SIZE;
+	    }
+	  else if (PREDICT_TRUE (sa0->crypto_alg != IPSEC_CRYPTO_ALG_NONE))
 	    {
 
 	      const int BLOCK_SIZE = 16;
@@ -335,22 +386,53 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 	      clib_memcpy ((u8 *) vlib_buffer_get_current (o_b0) +
 			   ip_hdr_size + sizeof (esp_header_t), iv, 16);
 
-	      esp_encrypt_aes_cbc (sa0->crypto_alg,
-				   (u8 *) vlib_buffer_get_current (i_b0),
-				   (u8 *) vlib_buffer_get_current (o_b0) +
-				   ip_hdr_size + sizeof (esp_header_t) +
-				   IV_SIZE, BLOCK_SIZE * blocks,
-				   sa0->crypto_key, iv);
+	      if (sa0->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE)
+		{
+		  /* encrypted with the rest of the frame, below */
+		  vec_add2 (ptd->native_jobs, job0, 1);
+		  memset (job0, 0, sizeof (*job0));
+		  job0->sa = vec_elt_at_index (em->native_sa, sa_index0);
+		  job0->src = vlib_buffer_get_current (i_b0);
+		  job0->iv = (u8 *) o_esp0 + sizeof (esp_header_t);
+		  job0->dst = job0->iv + IV_SIZE;
+		  job0->n_blocks = blocks;
+		}
+	      else
+		esp_encrypt_aes_cbc (sa0->crypto_alg,
+				     (u8 *) vlib_buffer_get_current (i_b0),
+				     (u8 *) vlib_buffer_get_current (o_b0) +
+				     ip_hdr_size + sizeof (esp_header_t) +
+				     IV_SIZE, BLOCK_SIZE * blocks,
+				     sa0->crypto_key, iv);
 	    }
 
-	  o_b0->current_length += hmac_calc (sa0->integ_alg, sa0->integ_key,
-					     sa0->integ_key_len,
-					     (u8 *) o_esp0,
-					     o_b0->current_length -
-					     ip_hdr_size,
-					     vlib_buffer_get_current (o_b0) +
-					     o_b0->current_length,
-					     sa0->use_esn, sa0->seq_hi);
+	  if (sa0->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE)
+	    {
+	      esp_native_sa_t *nsa0 = vec_elt_at_index (em->native_sa,
+							sa_index0);
+	      if (nsa0->icv_size)
+		{
+		  if (job0 == 0)
+		    {
+		      vec_add2 (ptd->native_jobs, job0, 1);
+		      memset (job0, 0, sizeof (*job0));
+		      job0->sa = nsa0;
+		    }
+		  job0->hmac_data = (u8 *) o_esp0;
+		  job0->hmac_len = o_b0->current_length - ip_hdr_size;
+		  job0->icv = vlib_buffer_get_current (o_b0) +
+		    o_b0->current_length;
+		  job0->use_esn = sa0->use_esn;
+		  job0->seq_hi = sa0->seq_hi;
+		}
+	      o_b0->current_length += nsa0->icv_size;
+	    }
+	  else
+	    o_b0->current_length +=
+	      hmac_calc (sa0->integ_alg, sa0->integ_key, sa0->integ_key_len,
+			 (u8 *) o_esp0, o_b0->current_length - ip_hdr_size,
+			 vlib_buffer_get_current (o_b0) +
+			 o_b0->current_length, sa0->use_esn, sa0->seq_hi);
 
 
 	  if (PREDICT_FALSE (is_ipv6))
@@ -391,6 +473,14 @@ esp_encrypt_node_fn (vlib_main_t * vm,
 	}
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
+
+  /* before the input buffers are recycled */
+  if (vec_len (ptd->native_jobs))
+    {
+      esp_native_encrypt_jobs (ptd->native_jobs, vec_len (ptd->native_jobs));
+      _vec_len (ptd->native_jobs) = 0;
+    }
+
   vlib_node_increment_counter (vm, esp_encrypt_node.index,
 			       ESP_ENCRYPT_ERROR_RX_PKTS,
 			       from_frame->n_vectors);
@@ -424,6 +514,218 @@ VLIB_REGISTER_NODE (esp_encrypt_node) = {
 /* *INDENT-ON* */
 
 VLIB_NODE_FUNCTION_MULTIARCH (esp_encrypt_node, esp_encrypt_node_fn)
+
+/*
+ * Benchmark: encrypt and sign a frame's worth of packets with the
+ * OpenSSL engine, then with the native engine, and compare results.
+ * AES-GCM packets are sealed in one pass, with an 8 byte AAD.
+ */
+static clib_error_t *
+test_esp_encrypt_command_fn (vlib_main_t * vm,
+			     unformat_input_t * input,
+			     vlib_cli_command_t * cmd)
+{
+  ipsec_crypto_alg_t crypto_alg = IPSEC_CRYPTO_ALG_AES_CBC_128;
+  ipsec_integ_alg_t integ_alg = IPSEC_INTEG_ALG_SHA1_96;
+  u32 size = 1024, count = 1000, n_packets = VLIB_FRAME_SIZE;
+  int is_aead, IV_SIZE = 16;
+  u8 nonce[12], aad[8] = { 0 };
+  u8 **src = 0, **dst = 0, **native_dst = 0;
+  esp_native_job_t *jobs = 0, *j;
+  esp_native_sa_t *nsa = 0;
+  ipsec_sa_t sa;
+  u32 i, c, n_blocks, out_size;
+  u64 t0, clocks[2] = { 0 };
+  f64 n_bytes;
+  int engine;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "crypto-alg %U", unformat_ipsec_crypto_alg,
+		    &crypto_alg))
+	;
+      else if (unformat (input, "integ-alg %U", unformat_ipsec_integ_alg,
+			 &integ_alg))
+	;
+      else if (unformat (input, "size %u", &size))
+	;
+      else if (unformat (input, "count %u", &count))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  is_aead = esp_crypto_alg_is_aead (crypto_alg);
+  if (is_aead)
+    {
+      integ_alg = IPSEC_INTEG_ALG_NONE;
+      IV_SIZE = ESP_GCM_IV_SIZE;
+    }
+  else if (crypto_alg < IPSEC_CRYPTO_ALG_AES_CBC_128 ||
+	   crypto_alg > IPSEC_CRYPTO_ALG_AES_CBC_256)
+    return clib_error_return (0, "unsupported crypto-alg %U",
+			      format_ipsec_crypto_alg, crypto_alg);
+  else if (integ_alg < IPSEC_INTEG_ALG_SHA1_96)
+    return clib_error_return (0, "unsupported integ-alg %U",
+			      format_ipsec_integ_alg, integ_alg);
+  if (size == 0 || size > 9000)
+    return clib_error_return (0, "size must be 1 to 9000 bytes");
+
+  memset (&sa, 0, sizeof (sa));
+  sa.crypto_alg = crypto_alg;
+  if (is_aead)
+    {
+      /* key and salt */
+      sa.crypto_key_len =
+	20 + 8 * (crypto_alg - IPSEC_CRYPTO_ALG_AES_GCM_128);
+      RAND_bytes (sa.crypto_key, sa.crypto_key_len);
+      clib_memcpy (&sa.salt, &sa.crypto_key[sa.crypto_key_len - 4], 4);
+      clib_memcpy (nonce, &sa.salt, 4);
+    }
+  else
+    {
+      sa.crypto_key_len =
+	16 + 8 * (crypto_alg - IPSEC_CRYPTO_ALG_AES_CBC_128);
+      RAND_bytes (sa.crypto_key, sa.crypto_key_len);
+    }
+  sa.integ_alg = integ_alg;
+  sa.integ_key_len = 32;
+  RAND_bytes (sa.integ_key, sa.integ_key_len);
+
+  n_blocks = (size + 15) / 16;
+  out_size = IV_SIZE + 16 * n_blocks + 64;
+
+  for (i = 0; i < n_packets; i++)
+    {
+      vec_add1 (src, clib_mem_alloc (16 * n_blocks));
+      vec_add1 (dst, clib_mem_alloc (out_size));
+      vec_add1 (native_dst, clib_mem_alloc (out_size));
+      RAND_bytes (src[i], 16 * n_blocks);
+      RAND_bytes (dst[i], IV_SIZE);
+      clib_memcpy (native_dst[i], dst[i], IV_SIZE);
+    }
+
+  if (esp_native_is_supported ())
+    {
+      nsa = clib_mem_alloc_aligned (sizeof (*nsa), CLIB_CACHE_LINE_BYTES);
+      esp_native_sa_init (nsa, &sa);
+    }
+
+  for (engine = 0; engine < (nsa ? 2 : 1); engine++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (c = 0; c < count; c++)
+	{
+	  if (is_aead)
+	    {
+	      for (i = 0; i < n_packets; i++)
+		{
+		  u8 *d = engine ? native_dst[i] : dst[i];
+		  if (engine)
+		    esp_native_gcm_encrypt (nsa, src[i], d + IV_SIZE,
+					    16 * n_blocks, d, aad,
+					    sizeof (aad),
+					    d + IV_SIZE + 16 * n_blocks);
+		  else
+		    {
+		      clib_memcpy (nonce + 4, d, IV_SIZE);
+		      esp_aes_gcm (crypto_alg, 1, src[i], d + IV_SIZE,
+				   16 * n_blocks, sa.crypto_key, nonce, aad,
+				   sizeof (aad), d + IV_SIZE + 16 * n_blocks);
+		    }
+		}
+	      continue;
+	    }
+
+	  if (engine == 0)
+	    {
+	      for (i = 0; i < n_packets; i++)
+		{
+		  esp_encrypt_aes_cbc (crypto_alg, src[i], dst[i] + IV_SIZE,
+				       16 * n_blocks, sa.crypto_key, dst[i]);
+		  hmac_calc (integ_alg, sa.integ_key, sa.integ_key_len,
+			     dst[i], IV_SIZE + 16 * n_blocks,
+			     dst[i] + IV_SIZE + 16 * n_blocks, 0, 0);
+		}
+	      continue;
+	    }
+
+	  vec_reset_length (jobs);
+	  for (i = 0; i < n_packets; i++)
+	    {
+	      vec_add2 (jobs, j, 1);
+	      memset (j, 0, sizeof (*j));
+	      j->sa = nsa;
+	      j->src = src[i];
+	      j->iv = native_dst[i];
+	      j->dst = native_dst[i] + IV_SIZE;
+	      j->n_blocks = n_blocks;
+	      j->hmac_data = native_dst[i];
+	      j->hmac_len = IV_SIZE + 16 * n_blocks;
+	      j->icv = native_dst[i] + IV_SIZE + 16 * n_blocks;
+	    }
+	  esp_native_encrypt_jobs (jobs, n_packets);
+	}
+      clocks[engine] = clib_cpu_time_now () - t0;
+    }
+
+  n_bytes = (f64) count *n_packets * 16 * n_blocks;
+  vlib_cli_output (vm, "%U %U, %u byte packets, %u frames of %u",
+		   format_ipsec_crypto_alg, crypto_alg,
+		   format_ipsec_integ_alg, integ_alg, 16 * n_blocks, count,
+		   n_packets);
+  for (engine = 0; engine < (nsa ? 2 : 1); engine++)
+    vlib_cli_output (vm, "  %-8s %8.2f clocks/byte",
+		     engine ? "native" : "openssl", clocks[engine] / n_bytes);
+
+  if (nsa == 0)
+    vlib_cli_output (vm, "  native engine needs AES-NI");
+  else
+    {
+      for (i = 0; i < n_packets; i++)
+	if (memcmp (dst[i], native_dst[i], IV_SIZE + 16 * n_blocks +
+		    (is_aead ? ESP_GCM_ICV_SIZE : nsa->icv_size)))
+	  break;
+      vlib_cli_output (vm, "  results %s", i < n_packets ?
+		       "DIFFER" : "match");
+      clib_mem_free (nsa);
+    }
+
+  for (i = 0; i < n_packets; i++)
+    {
+      clib_mem_free (src[i]);
+      clib_mem_free (dst[i]);
+      clib_mem_free (native_dst[i]);
+    }
+  vec_free (src);
+  vec_free (dst);
+  vec_free (native_dst);
+  vec_free (jobs);
+  return 0;
+}
+
+/*?
+ * Measure ESP encryption and integrity throughput of the OpenSSL and
+ * native crypto engines over a frame of equal sized packets. The
+ * integ-alg is ignored for the aes-gcm crypto-algs.
+ *
+ * @cliexpar
+ * @cliexstart{test ipsec esp-encrypt crypto-alg aes-cbc-128 integ-alg sha1-96 size 1024}
+ * aes-cbc-128 sha1-96, 1024 byte packets, 1000 frames of 256
+ *   openssl      9.33 clocks/byte
+ *   native       3.58 clocks/byte
+ *   results match
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_esp_encrypt_command, static) = {
+  .path = "test ipsec esp-encrypt",
+  .short_help = "test ipsec esp-encrypt [crypto-alg <alg>] "
+    "[integ-alg <alg>] [size <bytes>] [count <frames>]",
+  .function = test_esp_encrypt_command_fn,
+};
+/* *INDENT-ON* */
 /*
  * fd.io coding-style-patch-verification: ON
  *
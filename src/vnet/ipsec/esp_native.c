@@ -0,0 +1,890 @@
+/*
+ * esp_native.c : native AES-NI ESP crypto engine
+ *
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/esp_native.h>
+
+/*
+ * HMAC with precomputed ipad / opad digest states
+ */
+
+static void
+esp_native_hmac_init (esp_native_sa_t * nsa, ipsec_sa_t * sa)
+{
+  u8 key[SHA512_CBLOCK], pad[SHA512_CBLOCK];
+  u32 i, block_size, key_len = sa->integ_key_len;
+
+  memset (key, 0, sizeof (key));
+
+  switch (sa->integ_alg)
+    {
+    case IPSEC_INTEG_ALG_SHA1_96:
+      nsa->icv_size = 12;
+      block_size = SHA_CBLOCK;
+      if (key_len > block_size)
+	{
+	  SHA1 (sa->integ_key, key_len, key);
+	  key_len = SHA_DIGEST_LENGTH;
+	}
+      break;
+    case IPSEC_INTEG_ALG_SHA_256_96:
+    case IPSEC_INTEG_ALG_SHA_256_128:
+      nsa->icv_size = sa->integ_alg == IPSEC_INTEG_ALG_SHA_256_96 ? 12 : 16;
+      block_size = SHA256_CBLOCK;
+      if (key_len > block_size)
+	{
+	  SHA256 (sa->integ_key, key_len, key);
+	  key_len = SHA256_DIGEST_LENGTH;
+	}
+      break;
+    case IPSEC_INTEG_ALG_SHA_384_192:
+      nsa->icv_size = 24;
+      block_size = SHA512_CBLOCK;
+      if (key_len > block_size)
+	{
+	  SHA384 (sa->integ_key, key_len, key);
+	  key_len = SHA384_DIGEST_LENGTH;
+	}
+      break;
+    case IPSEC_INTEG_ALG_SHA_512_256:
+      nsa->icv_size = 32;
+      block_size = SHA512_CBLOCK;
+      if (key_len > block_size)
+	{
+	  SHA512 (sa->integ_key, key_len, key);
+	  key_len = SHA512_DIGEST_LENGTH;
+	}
+      break;
+    default:
+      /* the OpenSSL path has no MD5 either */
+      nsa->icv_size = 0;
+      return;
+    }
+
+  if (sa->integ_key_len <= block_size)
+    clib_memcpy (key, sa->integ_key, key_len);
+
+  for (i = 0; i < 2; i++)
+    {
+      esp_native_hmac_state_t *st = i ? &nsa->hmac_opad : &nsa->hmac_ipad;
+      u8 xor = i ? 0x5c : 0x36;
+      u32 j;
+
+      for (j = 0; j < block_size; j++)
+	pad[j] = key[j] ^ xor;
+
+      switch (sa->integ_alg)
+	{
+	case IPSEC_INTEG_ALG_SHA1_96:
+	  SHA1_Init (&st->sha1);
+	  SHA1_Update (&st->sha1, pad, block_size);
+	  break;
+	case IPSEC_INTEG_ALG_SHA_256_96:
+	case IPSEC_INTEG_ALG_SHA_256_128:
+	  SHA256_Init (&st->sha256);
+	  SHA256_Update (&st->sha256, pad, block_size);
+	  break;
+	case IPSEC_INTEG_ALG_SHA_384_192:
+	  SHA384_Init (&st->sha512);
+	  SHA384_Update (&st->sha512, pad, block_size);
+	  break;
+	default:
+	  SHA512_Init (&st->sha512);
+	  SHA512_Update (&st->sha512, pad, block_size);
+	  break;
+	}
+    }
+
+  memset (key, 0, sizeof (key));
+  memset (pad, 0, sizeof (pad));
+}
+
+u32
+esp_native_hmac (esp_native_sa_t * nsa, u8 * data, u32 len,
+		 u8 use_esn, u32 seq_hi, u8 * icv)
+{
+  esp_native_hmac_state_t st;
+  u8 md[SHA512_DIGEST_LENGTH];
+
+  /* seq_hi is hashed in host byte order, as hmac_calc() does */
+  switch (nsa->integ_alg)
+    {
+    case IPSEC_INTEG_ALG_SHA1_96:
+      st.sha1 = nsa->hmac_ipad.sha1;
+      SHA1_Update (&st.sha1, data, len);
+      if (use_esn)
+	SHA1_Update (&st.sha1, &seq_hi, sizeof (seq_hi));
+      SHA1_Final (md, &st.sha1);
+      st.sha1 = nsa->hmac_opad.sha1;
+      SHA1_Update (&st.sha1, md, SHA_DIGEST_LENGTH);
+      SHA1_Final (md, &st.sha1);
+      break;
+    case IPSEC_INTEG_ALG_SHA_256_96:
+    case IPSEC_INTEG_ALG_SHA_256_128:
+      st.sha256 = nsa->hmac_ipad.sha256;
+      SHA256_Update (&st.sha256, data, len);
+      if (use_esn)
+	SHA256_Update (&st.sha256, &seq_hi, sizeof (seq_hi));
+      SHA256_Final (md, &st.sha256);
+      st.sha256 = nsa->hmac_opad.sha256;
+      SHA256_Update (&st.sha256, md, SHA256_DIGEST_LENGTH);
+      SHA256_Final (md, &st.sha256);
+      break;
+    case IPSEC_INTEG_ALG_SHA_384_192:
+      st.sha512 = nsa->hmac_ipad.sha512;
+      SHA384_Update (&st.sha512, data, len);
+      if (use_esn)
+	SHA384_Update (&st.sha512, &seq_hi, sizeof (seq_hi));
+      SHA384_Final (md, &st.sha512);
+      st.sha512 = nsa->hmac_opad.sha512;
+      SHA384_Update (&st.sha512, md, SHA384_DIGEST_LENGTH);
+      SHA384_Final (md, &st.sha512);
+      break;
+    case IPSEC_INTEG_ALG_SHA_512_256:
+      st.sha512 = nsa->hmac_ipad.sha512;
+      SHA512_Update (&st.sha512, data, len);
+      if (use_esn)
+	SHA512_Update (&st.sha512, &seq_hi, sizeof (seq_hi));
+      SHA512_Final (md, &st.sha512);
+      st.sha512 = nsa->hmac_opad.sha512;
+      SHA512_Update (&st.sha512, md, SHA512_DIGEST_LENGTH);
+      SHA512_Final (md, &st.sha512);
+      break;
+    default:
+      return 0;
+    }
+
+  clib_memcpy (icv, md, nsa->icv_size);
+  return nsa->icv_size;
+}
+
+#if defined (__x86_64__)
+
+#pragma GCC push_options
+#pragma GCC target ("aes,pclmul,sse4.1")
+
+#include <x86intrin.h>
+
+int
+esp_native_is_supported (void)
+{
+  return clib_cpu_supports_aes () && clib_cpu_supports_pclmulqdq ();
+}
+
+/*
+ * AES key expansion, as in the Intel AES-NI white paper
+ */
+
+static_always_inline __m128i
+aes128_key_assist (__m128i t1, __m128i t2)
+{
+  __m128i t3;
+
+  t2 = _mm_shuffle_epi32 (t2, 0xff);
+  t3 = _mm_slli_si128 (t1, 4);
+  t1 ^= t3;
+  t3 = _mm_slli_si128 (t3, 4);
+  t1 ^= t3;
+  t3 = _mm_slli_si128 (t3, 4);
+  t1 ^= t3;
+  return t1 ^ t2;
+}
+
+static void
+aes128_key_expand (__m128i * k, u8 * key)
+{
+  k[0] = _mm_loadu_si128 ((__m128i *) key);
+#define _(i, rcon) \
+  k[i] = aes128_key_assist (k[i - 1], _mm_aeskeygenassist_si128 (k[i - 1], rcon));
+  _(1, 0x01) _(2, 0x02) _(3, 0x04) _(4, 0x08) _(5, 0x10)
+  _(6, 0x20) _(7, 0x40) _(8, 0x80) _(9, 0x1b) _(10, 0x36)
+#undef _
+}
+
+static_always_inline void
+aes192_key_assist (__m128i * t1, __m128i * t2, __m128i * t3)
+{
+  __m128i t4;
+
+  *t2 = _mm_shuffle_epi32 (*t2, 0x55);
+  t4 = _mm_slli_si128 (*t1, 4);
+  *t1 ^= t4;
+  t4 = _mm_slli_si128 (t4, 4);
+  *t1 ^= t4;
+  t4 = _mm_slli_si128 (t4, 4);
+  *t1 ^= t4;
+  *t1 ^= *t2;
+  *t2 = _mm_shuffle_epi32 (*t1, 0xff);
+  t4 = _mm_slli_si128 (*t3, 4);
+  *t3 ^= t4;
+  *t3 ^= *t2;
+}
+
+static_always_inline __m128i
+aes192_key_lo (__m128i a, __m128i b)
+{
+  return (__m128i) _mm_shuffle_pd ((__m128d) a, (__m128d) b, 0);
+}
+
+static_always_inline __m128i
+aes192_key_hi (__m128i a, __m128i b)
+{
+  return (__m128i) _mm_shuffle_pd ((__m128d) a, (__m128d) b, 1);
+}
+
+static void
+aes192_key_expand (__m128i * k, u8 * key)
+{
+  __m128i t1, t2, t3;
+
+  /* reads 8 bytes past the key; sa->crypto_key is 128 bytes long */
+  k[0] = t1 = _mm_loadu_si128 ((__m128i *) key);
+  k[1] = t3 = _mm_loadu_si128 ((__m128i *) (key + 16));
+
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x1);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[1] = aes192_key_lo (k[1], t1);
+  k[2] = aes192_key_hi (t1, t3);
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x2);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[3] = t1;
+  k[4] = t3;
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x4);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[4] = aes192_key_lo (k[4], t1);
+  k[5] = aes192_key_hi (t1, t3);
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x8);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[6] = t1;
+  k[7] = t3;
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x10);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[7] = aes192_key_lo (k[7], t1);
+  k[8] = aes192_key_hi (t1, t3);
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x20);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[9] = t1;
+  k[10] = t3;
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x40);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[10] = aes192_key_lo (k[10], t1);
+  k[11] = aes192_key_hi (t1, t3);
+  t2 = _mm_aeskeygenassist_si128 (t3, 0x80);
+  aes192_key_assist (&t1, &t2, &t3);
+  k[12] = t1;
+}
+
+static_always_inline void
+aes256_key_assist1 (__m128i * t1, __m128i t2)
+{
+  __m128i t4;
+
+  t2 = _mm_shuffle_epi32 (t2, 0xff);
+  t4 = _mm_slli_si128 (*t1, 4);
+  *t1 ^= t4;
+  t4 = _mm_slli_si128 (t4, 4);
+  *t1 ^= t4;
+  t4 = _mm_slli_si128 (t4, 4);
+  *t1 ^= t4;
+  *t1 ^= t2;
+}
+
+static_always_inline void
+aes256_key_assist2 (__m128i t1, __m128i * t3)
+{
+  __m128i t2, t4;
+
+  t4 = _mm_aeskeygenassist_si128 (t1, 0x0);
+  t2 = _mm_shuffle_epi32 (t4, 0xaa);
+  t4 = _mm_slli_si128 (*t3, 4);
+  *t3 ^= t4;
+  t4 = _mm_slli_si128 (t4, 4);
+  *t3 ^= t4;
+  t4 = _mm_slli_si128 (t4, 4);
+  *t3 ^= t4;
+  *t3 ^= t2;
+}
+
+static void
+aes256_key_expand (__m128i * k, u8 * key)
+{
+  __m128i t1, t3;
+
+  k[0] = t1 = _mm_loadu_si128 ((__m128i *) key);
+  k[1] = t3 = _mm_loadu_si128 ((__m128i *) (key + 16));
+#define _(i, rcon)                                                      \
+  aes256_key_assist1 (&t1, _mm_aeskeygenassist_si128 (t3, rcon));       \
+  k[i] = t1;                                                            \
+  if (i < 14)                                                           \
+    {                                                                   \
+      aes256_key_assist2 (t1, &t3);                                     \
+      k[i + 1] = t3;                                                    \
+    }
+  _(2, 0x01) _(4, 0x02) _(6, 0x04) _(8, 0x08)
+  _(10, 0x10) _(12, 0x20) _(14, 0x40)
+#undef _
+}
+
+static_always_inline __m128i
+aes_encrypt_block (__m128i x, __m128i * k, int rounds)
+{
+  int r;
+
+  x ^= k[0];
+  for (r = 1; r < rounds; r++)
+    x = _mm_aesenc_si128 (x, k[r]);
+  return _mm_aesenclast_si128 (x, k[rounds]);
+}
+
+/*
+ * GHASH, as in the Intel carry-less multiplication white paper: blocks
+ * are byte reversed so that the field multiply is a 128 x 128 bit
+ * carry-less product, shifted left by one, then reduced modulo
+ * x^128 + x^7 + x^2 + x + 1. Products are accumulated unreduced, so a
+ * group of blocks only pays for one reduction.
+ */
+
+static_always_inline __m128i
+ghash_bswap (__m128i x)
+{
+  return _mm_shuffle_epi8 (x, _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+					    10, 11, 12, 13, 14, 15));
+}
+
+static_always_inline void
+ghash_mul_acc (__m128i a, __m128i b, __m128i * lo, __m128i * hi)
+{
+  __m128i mid;
+
+  mid = _mm_clmulepi64_si128 (a, b, 0x10) ^ _mm_clmulepi64_si128 (a, b, 0x01);
+  *lo ^= _mm_clmulepi64_si128 (a, b, 0x00) ^ _mm_slli_si128 (mid, 8);
+  *hi ^= _mm_clmulepi64_si128 (a, b, 0x11) ^ _mm_srli_si128 (mid, 8);
+}
+
+static_always_inline __m128i
+ghash_reduce (__m128i lo, __m128i hi)
+{
+  __m128i t0, t1, t2;
+
+  /* shift the 256 bit product left by one */
+  t0 = _mm_srli_epi32 (lo, 31);
+  t1 = _mm_srli_epi32 (hi, 31);
+  lo = _mm_slli_epi32 (lo, 1);
+  hi = _mm_slli_epi32 (hi, 1);
+  t2 = _mm_srli_si128 (t0, 12);
+  t1 = _mm_slli_si128 (t1, 4);
+  t0 = _mm_slli_si128 (t0, 4);
+  lo |= t0;
+  hi |= t1 | t2;
+
+  /* reduce */
+  t0 = _mm_slli_epi32 (lo, 31) ^ _mm_slli_epi32 (lo, 30) ^
+    _mm_slli_epi32 (lo, 25);
+  t1 = _mm_srli_si128 (t0, 4);
+  lo ^= _mm_slli_si128 (t0, 12);
+  t2 = _mm_srli_epi32 (lo, 1) ^ _mm_srli_epi32 (lo, 2) ^
+    _mm_srli_epi32 (lo, 7) ^ t1;
+  return hi ^ lo ^ t2;
+}
+
+static_always_inline __m128i
+ghash_mul (__m128i a, __m128i b)
+{
+  __m128i lo = _mm_setzero_si128 (), hi = _mm_setzero_si128 ();
+
+  ghash_mul_acc (a, b, &lo, &hi);
+  return ghash_reduce (lo, hi);
+}
+
+int
+esp_native_sa_init (esp_native_sa_t * nsa, ipsec_sa_t * sa)
+{
+  __m128i k[ESP_NATIVE_MAX_ROUNDS + 1];
+  int i;
+
+  memset (nsa, 0, sizeof (*nsa));
+  nsa->integ_alg = sa->integ_alg;
+
+  switch (sa->crypto_alg)
+    {
+    case IPSEC_CRYPTO_ALG_NONE:
+      break;
+    case IPSEC_CRYPTO_ALG_AES_CBC_128:
+    case IPSEC_CRYPTO_ALG_AES_GCM_128:
+      nsa->n_rounds = 10;
+      aes128_key_expand (k, sa->crypto_key);
+      break;
+    case IPSEC_CRYPTO_ALG_AES_CBC_192:
+    case IPSEC_CRYPTO_ALG_AES_GCM_192:
+      nsa->n_rounds = 12;
+      aes192_key_expand (k, sa->crypto_key);
+      break;
+    case IPSEC_CRYPTO_ALG_AES_CBC_256:
+    case IPSEC_CRYPTO_ALG_AES_GCM_256:
+      nsa->n_rounds = 14;
+      aes256_key_expand (k, sa->crypto_key);
+      break;
+    default:
+      return -1;
+    }
+
+  if (sa->crypto_alg >= IPSEC_CRYPTO_ALG_AES_GCM_128 &&
+      sa->crypto_alg <= IPSEC_CRYPTO_ALG_AES_GCM_256)
+    {
+      __m128i h, hn;
+
+      nsa->salt = sa->salt;
+      h = hn = ghash_bswap (aes_encrypt_block (_mm_setzero_si128 (), k,
+					       nsa->n_rounds));
+      for (i = 0; i < 4; i++)
+	{
+	  _mm_storeu_si128 ((__m128i *) nsa->ghash_key[i], hn);
+	  hn = ghash_mul (hn, h);
+	}
+    }
+
+  if (nsa->n_rounds)
+    {
+      /* equivalent inverse cipher keys for aesdec */
+      for (i = 0; i <= nsa->n_rounds; i++)
+	_mm_storeu_si128 ((__m128i *) nsa->encrypt_key[i], k[i]);
+      _mm_storeu_si128 ((__m128i *) nsa->decrypt_key[0], k[nsa->n_rounds]);
+      for (i = 1; i < nsa->n_rounds; i++)
+	_mm_storeu_si128 ((__m128i *) nsa->decrypt_key[i],
+			  _mm_aesimc_si128 (k[nsa->n_rounds - i]));
+      _mm_storeu_si128 ((__m128i *) nsa->decrypt_key[nsa->n_rounds], k[0]);
+    }
+
+  esp_native_hmac_init (nsa, sa);
+  return 0;
+}
+
+/*
+ * Multi-buffer CBC encryption. Each lane holds one job; every step
+ * encrypts the next block of all lanes, interleaving their independent
+ * aesenc chains. A lane whose job is done takes the next job with the
+ * same key size; idle lanes spin on a scratch block.
+ */
+static_always_inline void
+aes_cbc_encrypt_lanes (esp_native_job_t * jobs, u32 n_jobs, int rounds)
+{
+  const int n_lanes = ESP_NATIVE_N_LANES;
+  __m128i x[ESP_NATIVE_N_LANES], k[ESP_NATIVE_N_LANES][15];
+  u8 *src[ESP_NATIVE_N_LANES], *dst[ESP_NATIVE_N_LANES];
+  u32 left[ESP_NATIVE_N_LANES], stride[ESP_NATIVE_N_LANES];
+  u8 scratch[16] = { 0 };
+  u32 next = 0, n_active = 0, n, i;
+  int l, r;
+
+  for (l = 0; l < n_lanes; l++)
+    {
+      src[l] = dst[l] = scratch;
+      stride[l] = 0;
+      left[l] = ~0;
+      x[l] = _mm_setzero_si128 ();
+      for (r = 0; r <= rounds; r++)
+	k[l][r] = _mm_setzero_si128 ();
+    }
+
+  while (1)
+    {
+      /* (re)load lanes that have no work */
+      for (l = 0; l < n_lanes; l++)
+	{
+	  if (left[l] != ~0)
+	    continue;
+
+	  while (next < n_jobs && (jobs[next].n_blocks == 0 ||
+				   jobs[next].sa->n_rounds != rounds))
+	    next++;
+
+	  if (next == n_jobs)
+	    {
+	      src[l] = dst[l] = scratch;
+	      stride[l] = 0;
+	      continue;
+	    }
+
+	  esp_native_job_t *j = jobs + next++;
+	  for (r = 0; r <= rounds; r++)
+	    k[l][r] = _mm_loadu_si128 ((__m128i *) j->sa->encrypt_key[r]);
+	  x[l] = _mm_loadu_si128 ((__m128i *) j->iv);
+	  src[l] = j->src;
+	  dst[l] = j->dst;
+	  left[l] = j->n_blocks;
+	  stride[l] = 16;
+	  n_active++;
+	}
+
+      if (n_active == 0)
+	break;
+
+      /* run until the first lane runs dry */
+      n = ~0;
+      for (l = 0; l < n_lanes; l++)
+	n = clib_min (n, left[l]);
+
+      for (i = 0; i < n; i++)
+	{
+	  for (l = 0; l < n_lanes; l++)
+	    x[l] ^= _mm_loadu_si128 ((__m128i *) src[l]) ^ k[l][0];
+	  for (r = 1; r < rounds; r++)
+	    for (l = 0; l < n_lanes; l++)
+	      x[l] = _mm_aesenc_si128 (x[l], k[l][r]);
+	  for (l = 0; l < n_lanes; l++)
+	    {
+	      x[l] = _mm_aesenclast_si128 (x[l], k[l][rounds]);
+	      _mm_storeu_si128 ((__m128i *) dst[l], x[l]);
+	      src[l] += stride[l];
+	      dst[l] += stride[l];
+	    }
+	}
+
+      for (l = 0; l < n_lanes; l++)
+	if (left[l] != ~0 && (left[l] -= n) == 0)
+	  {
+	    left[l] = ~0;
+	    n_active--;
+	  }
+    }
+}
+
+void
+esp_native_encrypt_jobs (esp_native_job_t * jobs, u32 n_jobs)
+{
+  esp_native_job_t *j;
+
+  aes_cbc_encrypt_lanes (jobs, n_jobs, 10);
+  aes_cbc_encrypt_lanes (jobs, n_jobs, 12);
+  aes_cbc_encrypt_lanes (jobs, n_jobs, 14);
+
+  /* encrypt-then-MAC */
+  for (j = jobs; j < jobs + n_jobs; j++)
+    if (j->icv)
+      esp_native_hmac (j->sa, j->hmac_data, j->hmac_len, j->use_esn,
+		       j->seq_hi, j->icv);
+}
+
+static_always_inline void
+aes_cbc_decrypt_inline (esp_native_sa_t * nsa, u8 * src, u8 * dst,
+			u32 n_blocks, u8 * iv, int rounds)
+{
+  __m128i k[15], prev, c0, c1, c2, c3, x0, x1, x2, x3;
+  int r;
+
+  for (r = 0; r <= rounds; r++)
+    k[r] = _mm_loadu_si128 ((__m128i *) nsa->decrypt_key[r]);
+  prev = _mm_loadu_si128 ((__m128i *) iv);
+
+  while (n_blocks >= 4)
+    {
+      c0 = _mm_loadu_si128 ((__m128i *) src);
+      c1 = _mm_loadu_si128 ((__m128i *) (src + 16));
+      c2 = _mm_loadu_si128 ((__m128i *) (src + 32));
+      c3 = _mm_loadu_si128 ((__m128i *) (src + 48));
+      x0 = c0 ^ k[0];
+      x1 = c1 ^ k[0];
+      x2 = c2 ^ k[0];
+      x3 = c3 ^ k[0];
+      for (r = 1; r < rounds; r++)
+	{
+	  x0 = _mm_aesdec_si128 (x0, k[r]);
+	  x1 = _mm_aesdec_si128 (x1, k[r]);
+	  x2 = _mm_aesdec_si128 (x2, k[r]);
+	  x3 = _mm_aesdec_si128 (x3, k[r]);
+	}
+      x0 = _mm_aesdeclast_si128 (x0, k[rounds]) ^ prev;
+      x1 = _mm_aesdeclast_si128 (x1, k[rounds]) ^ c0;
+      x2 = _mm_aesdeclast_si128 (x2, k[rounds]) ^ c1;
+      x3 = _mm_aesdeclast_si128 (x3, k[rounds]) ^ c2;
+      _mm_storeu_si128 ((__m128i *) dst, x0);
+      _mm_storeu_si128 ((__m128i *) (dst + 16), x1);
+      _mm_storeu_si128 ((__m128i *) (dst + 32), x2);
+      _mm_storeu_si128 ((__m128i *) (dst + 48), x3);
+      prev = c3;
+      src += 64;
+      dst += 64;
+      n_blocks -= 4;
+    }
+
+  while (n_blocks)
+    {
+      c0 = _mm_loadu_si128 ((__m128i *) src);
+      x0 = c0 ^ k[0];
+      for (r = 1; r < rounds; r++)
+	x0 = _mm_aesdec_si128 (x0, k[r]);
+      x0 = _mm_aesdeclast_si128 (x0, k[rounds]) ^ prev;
+      _mm_storeu_si128 ((__m128i *) dst, x0);
+      prev = c0;
+      src += 16;
+      dst += 16;
+      n_blocks--;
+    }
+}
+
+void
+esp_native_cbc_decrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst,
+			u32 n_blocks, u8 * iv)
+{
+  switch (nsa->n_rounds)
+    {
+    case 10:
+      aes_cbc_decrypt_inline (nsa, src, dst, n_blocks, iv, 10);
+      break;
+    case 12:
+      aes_cbc_decrypt_inline (nsa, src, dst, n_blocks, iv, 12);
+      break;
+    case 14:
+      aes_cbc_decrypt_inline (nsa, src, dst, n_blocks, iv, 14);
+      break;
+    }
+}
+
+static_always_inline __m128i
+aes_gcm_counter (__m128i y, u32 ctr)
+{
+  return _mm_insert_epi32 (y, clib_host_to_net_u32 (ctr), 3);
+}
+
+static_always_inline __m128i
+aes_gcm_ghash_bytes (__m128i x, __m128i h, u8 * data, u32 len)
+{
+  u8 buf[16];
+  u32 n;
+
+  while (len)
+    {
+      n = clib_min (len, 16);
+      memset (buf, 0, sizeof (buf));
+      clib_memcpy (buf, data, n);
+      x = ghash_mul (x ^ ghash_bswap (_mm_loadu_si128 ((__m128i *) buf)), h);
+      data += n;
+      len -= n;
+    }
+  return x;
+}
+
+/*
+ * Encrypt or decrypt len bytes and compute the tag over aad and the
+ * ciphertext (RFC 4106: nonce is salt || iv). Returns 0, or -1 when
+ * decrypting and the tag does not match.
+ */
+static_always_inline int
+aes_gcm_inline (esp_native_sa_t * nsa, u8 * src, u8 * dst, u32 len,
+		u8 * iv, u8 * aad, u32 aad_len, u8 * tag, int is_encrypt,
+		int rounds)
+{
+  __m128i k[15], h[4], y0, x, t, lo, hi;
+  __m128i b0, b1, b2, b3, c0, c1, c2, c3;
+  u32 ctr = 2, n_bytes = len, n;
+  u8 buf[16];
+  int r;
+
+  for (r = 0; r <= rounds; r++)
+    k[r] = _mm_loadu_si128 ((__m128i *) nsa->encrypt_key[r]);
+  for (r = 0; r < 4; r++)
+    h[r] = _mm_loadu_si128 ((__m128i *) nsa->ghash_key[r]);
+
+  memset (buf, 0, sizeof (buf));
+  clib_memcpy (buf, &nsa->salt, 4);
+  clib_memcpy (buf + 4, iv, 8);
+  y0 = _mm_loadu_si128 ((__m128i *) buf);
+
+  x = aes_gcm_ghash_bytes (_mm_setzero_si128 (), h[0], aad, aad_len);
+
+  while (len >= 64)
+    {
+      b0 = aes_gcm_counter (y0, ctr) ^ k[0];
+      b1 = aes_gcm_counter (y0, ctr + 1) ^ k[0];
+      b2 = aes_gcm_counter (y0, ctr + 2) ^ k[0];
+      b3 = aes_gcm_counter (y0, ctr + 3) ^ k[0];
+      for (r = 1; r < rounds; r++)
+	{
+	  b0 = _mm_aesenc_si128 (b0, k[r]);
+	  b1 = _mm_aesenc_si128 (b1, k[r]);
+	  b2 = _mm_aesenc_si128 (b2, k[r]);
+	  b3 = _mm_aesenc_si128 (b3, k[r]);
+	}
+      c0 = _mm_loadu_si128 ((__m128i *) src);
+      c1 = _mm_loadu_si128 ((__m128i *) (src + 16));
+      c2 = _mm_loadu_si128 ((__m128i *) (src + 32));
+      c3 = _mm_loadu_si128 ((__m128i *) (src + 48));
+      b0 = _mm_aesenclast_si128 (b0, k[rounds]) ^ c0;
+      b1 = _mm_aesenclast_si128 (b1, k[rounds]) ^ c1;
+      b2 = _mm_aesenclast_si128 (b2, k[rounds]) ^ c2;
+      b3 = _mm_aesenclast_si128 (b3, k[rounds]) ^ c3;
+      _mm_storeu_si128 ((__m128i *) dst, b0);
+      _mm_storeu_si128 ((__m128i *) (dst + 16), b1);
+      _mm_storeu_si128 ((__m128i *) (dst + 32), b2);
+      _mm_storeu_si128 ((__m128i *) (dst + 48), b3);
+
+      /* hash the ciphertext */
+      if (is_encrypt)
+	{
+	  c0 = b0;
+	  c1 = b1;
+	  c2 = b2;
+	  c3 = b3;
+	}
+      lo = hi = _mm_setzero_si128 ();
+      ghash_mul_acc (ghash_bswap (c0) ^ x, h[3], &lo, &hi);
+      ghash_mul_acc (ghash_bswap (c1), h[2], &lo, &hi);
+      ghash_mul_acc (ghash_bswap (c2), h[1], &lo, &hi);
+      ghash_mul_acc (ghash_bswap (c3), h[0], &lo, &hi);
+      x = ghash_reduce (lo, hi);
+
+      ctr += 4;
+      src += 64;
+      dst += 64;
+      len -= 64;
+    }
+
+  while (len)
+    {
+      n = clib_min (len, 16);
+      b0 = aes_encrypt_block (aes_gcm_counter (y0, ctr++), k, rounds);
+      if (n == 16)
+	{
+	  c0 = _mm_loadu_si128 ((__m128i *) src);
+	  b0 ^= c0;
+	  _mm_storeu_si128 ((__m128i *) dst, b0);
+	}
+      else
+	{
+	  /* partial last block; GHASH takes it zero padded */
+	  memset (buf, 0, sizeof (buf));
+	  clib_memcpy (buf, src, n);
+	  c0 = _mm_loadu_si128 ((__m128i *) buf);
+	  b0 ^= c0;
+	  _mm_storeu_si128 ((__m128i *) buf, b0);
+	  clib_memcpy (dst, buf, n);
+	  memset (buf + n, 0, sizeof (buf) - n);
+	  b0 = _mm_loadu_si128 ((__m128i *) buf);
+	}
+      x = ghash_mul (x ^ ghash_bswap (is_encrypt ? b0 : c0), h[0]);
+      src += n;
+      dst += n;
+      len -= n;
+    }
+
+  /* lengths in bits, then the tag */
+  t = _mm_set_epi64x ((u64) aad_len * 8, (u64) n_bytes * 8);
+  x = ghash_mul (x ^ t, h[0]);
+  t = ghash_bswap (x) ^ aes_encrypt_block (aes_gcm_counter (y0, 1), k,
+					   rounds);
+
+  if (is_encrypt)
+    {
+      _mm_storeu_si128 ((__m128i *) tag, t);
+      return 0;
+    }
+
+  t ^= _mm_loadu_si128 ((__m128i *) tag);
+  return _mm_testz_si128 (t, t) ? 0 : -1;
+}
+
+void
+esp_native_gcm_encrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst, u32 len,
+			u8 * iv, u8 * aad, u32 aad_len, u8 * tag)
+{
+  switch (nsa->n_rounds)
+    {
+    case 10:
+      aes_gcm_inline (nsa, src, dst, len, iv, aad, aad_len, tag, 1, 10);
+      break;
+    case 12:
+      aes_gcm_inline (nsa, src, dst, len, iv, aad, aad_len, tag, 1, 12);
+      break;
+    case 14:
+      aes_gcm_inline (nsa, src, dst, len, iv, aad, aad_len, tag, 1, 14);
+      break;
+    }
+}
+
+int
+esp_native_gcm_decrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst, u32 len,
+			u8 * iv, u8 * aad, u32 aad_len, u8 * tag)
+{
+  switch (nsa->n_rounds)
+    {
+    case 10:
+      return aes_gcm_inline (nsa, src, dst, len, iv, aad, aad_len, tag, 0,
+			     10);
+    case 12:
+      return aes_gcm_inline (nsa, src, dst, len, iv, aad, aad_len, tag, 0,
+			     12);
+    case 14:
+      return aes_gcm_inline (nsa, src, dst, len, iv, aad, aad_len, tag, 0,
+			     14);
+    }
+  return -1;
+}
+
+#pragma GCC pop_options
+
+#else /* __x86_64__ */
+
+int
+esp_native_is_supported (void)
+{
+  return 0;
+}
+
+int
+esp_native_sa_init (esp_native_sa_t * nsa, ipsec_sa_t * sa)
+{
+  return -1;
+}
+
+void
+esp_native_encrypt_jobs (esp_native_job_t * jobs, u32 n_jobs)
+{
+  ASSERT (0);
+}
+
+void
+esp_native_cbc_decrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst,
+			u32 n_blocks, u8 * iv)
+{
+  ASSERT (0);
+}
+
+void
+esp_native_gcm_encrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst, u32 len,
+			u8 * iv, u8 * aad, u32 aad_len, u8 * tag)
+{
+  ASSERT (0);
+}
+
+int
+esp_native_gcm_decrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst, u32 len,
+			u8 * iv, u8 * aad, u32 aad_len, u8 * tag)
+{
+  ASSERT (0);
+  return -1;
+}
+
+#endif /* __x86_64__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
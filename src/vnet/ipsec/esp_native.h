@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __ESP_NATIVE_H__
+#define __ESP_NATIVE_H__
+
+#include <vnet/ipsec/ipsec.h>
+
+#include <openssl/sha.h>
+
+/*
+ * Native ESP crypto engine
+ *
+ * AES is done with AES-NI on key schedules expanded once per SA. CBC
+ * encryption is serial within a packet, so esp_native_encrypt_jobs()
+ * runs ESP_NATIVE_N_LANES packets side by side, one block of each per
+ * step, which keeps the AES unit busy while each lane waits on its
+ * previous block. CBC decryption has no such dependency and is
+ * pipelined across the blocks of a single packet.
+ *
+ * HMAC uses digest states precomputed from the key's ipad and opad
+ * blocks, which saves two compression rounds and all the EVP/HMAC
+ * context setup per packet.
+ *
+ * AES-GCM is done in a single pass: counter mode has no chaining, so
+ * four blocks are encrypted at a time and their ciphertext is folded
+ * into the GHASH (PCLMULQDQ) while still in registers.
+ */
+
+#define ESP_NATIVE_N_LANES 4
+#define ESP_NATIVE_MAX_ROUNDS 14
+
+typedef union
+{
+  SHA_CTX sha1;
+  SHA256_CTX sha256;
+  SHA512_CTX sha512;
+} esp_native_hmac_state_t;
+
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u8 encrypt_key[ESP_NATIVE_MAX_ROUNDS + 1][16];
+  u8 decrypt_key[ESP_NATIVE_MAX_ROUNDS + 1][16];
+  u8 n_rounds;			/* 0 if no cipher */
+  u8 icv_size;			/* 0 if no integrity */
+  ipsec_integ_alg_t integ_alg;
+  esp_native_hmac_state_t hmac_ipad;
+  esp_native_hmac_state_t hmac_opad;
+  /* AES-GCM: salt and H, H^2, H^3, H^4, byte reversed */
+  u32 salt;
+  u8 ghash_key[4][16];
+} esp_native_sa_t;
+
+/* One packet's worth of outbound work */
+typedef struct
+{
+  esp_native_sa_t *sa;
+
+  /* CBC encrypt n_blocks from src to dst, chained from iv */
+  u8 *src;
+  u8 *dst;
+  u8 *iv;
+  u32 n_blocks;
+
+  /* ICV of [hmac_data, hmac_data + hmac_len), done after encryption */
+  u8 *hmac_data;
+  u8 *icv;
+  u32 hmac_len;
+  u32 seq_hi;
+  u8 use_esn;
+} esp_native_job_t;
+
+int esp_native_is_supported (void);
+int esp_native_sa_init (esp_native_sa_t * nsa, ipsec_sa_t * sa);
+void esp_native_encrypt_jobs (esp_native_job_t * jobs, u32 n_jobs);
+void esp_native_cbc_decrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst,
+			     u32 n_blocks, u8 * iv);
+u32 esp_native_hmac (esp_native_sa_t * nsa, u8 * data, u32 len,
+		     u8 use_esn, u32 seq_hi, u8 * icv);
+void esp_native_gcm_encrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst,
+			     u32 len, u8 * iv, u8 * aad, u32 aad_len,
+			     u8 * tag);
+int esp_native_gcm_decrypt (esp_native_sa_t * nsa, u8 * src, u8 * dst,
+			    u32 len, u8 * iv, u8 * aad, u32 aad_len,
+			    u8 * tag);
+
+#endif /* __ESP_NATIVE_H__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -450,6 +450,7 @@ ipsec_add_del_sa (vlib_main_t * vm, ipsec_sa_t * new_sa, int is_add)
       clib_memcpy (sa, new_sa, sizeof (*sa));
       sa_index = sa - im->sad;
       hash_set (im->sa_index_by_sa_id, sa->id, sa_index);
+      ipsec_sa_crypto_init (sa_index);
       if (im->cb.add_del_sa_sess_cb)
 	{
 	  err = im->cb.add_del_sa_sess_cb (sa_index, 1);
@@ -494,6 +495,7 @@ ipsec_set_sa_key (vlib_main_t * vm, ipsec_sa_t * sa_update)
 
   if (0 < sa_update->crypto_key_len || 0 < sa_update->integ_key_len)
     {
+      ipsec_sa_crypto_init (sa_index);
       if (im->cb.add_del_sa_sess_cb)
 	{
 	  err = im->cb.add_del_sa_sess_cb (sa_index, 0);
@@ -505,6 +507,33 @@ ipsec_set_sa_key (vlib_main_t * vm, ipsec_sa_t * sa_update)
   return 0;
 }
 
+/*
+ * Derive per-key crypto state: the AES-GCM salt, the SA's crypto engine
+ * if left to the default, and the native engine context. Called
+ * whenever an SA is added or rekeyed.
+ */
+void
+ipsec_sa_crypto_init (u32 sa_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  esp_main_t *em = &esp_main;
+  ipsec_sa_t *sa = pool_elt_at_index (im->sad, sa_index);
+
+  /* RFC 4106: the last 4 bytes of the keying material are the salt */
+  if (esp_crypto_alg_is_aead (sa->crypto_alg) && sa->crypto_key_len > 4)
+    clib_memcpy (&sa->salt, &sa->crypto_key[sa->crypto_key_len - 4], 4);
+
+  if (sa->crypto_engine == IPSEC_CRYPTO_ENGINE_DEFAULT)
+    sa->crypto_engine = im->crypto_engine;
+
+  if (sa->crypto_engine != IPSEC_CRYPTO_ENGINE_NATIVE)
+    return;
+
+  vec_validate_aligned (em->native_sa, sa_index, CLIB_CACHE_LINE_BYTES);
+  if (esp_native_sa_init (vec_elt_at_index (em->native_sa, sa_index), sa))
+    sa->crypto_engine = IPSEC_CRYPTO_ENGINE_OPENSSL;
+}
+
 static void
 ipsec_rand_seed (void)
 {
@@ -525,10 +554,23 @@ ipsec_rand_seed (void)
 static clib_error_t *
 ipsec_check_support (ipsec_sa_t * sa)
 {
-  if (sa->crypto_alg == IPSEC_CRYPTO_ALG_AES_GCM_128)
-    return clib_error_return (0, "unsupported aes-gcm-128 crypto-alg");
-  if (sa->integ_alg == IPSEC_INTEG_ALG_NONE)
+  if (esp_crypto_alg_is_aead (sa->crypto_alg))
+    {
+      /* key and 4 byte salt */
+      u32 key_len = 16 + 8 * (sa->crypto_alg - IPSEC_CRYPTO_ALG_AES_GCM_128);
+      if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
+	return clib_error_return (0, "%U needs none integ-alg",
+				  format_ipsec_crypto_alg, sa->crypto_alg);
+      if (sa->crypto_key_len != key_len + 4)
+	return clib_error_return (0, "%U needs a %u byte key and salt",
+				  format_ipsec_crypto_alg, sa->crypto_alg,
+				  key_len + 4);
+    }
+  else if (sa->integ_alg == IPSEC_INTEG_ALG_NONE)
     return clib_error_return (0, "unsupported none integ-alg");
+  if (sa->crypto_engine == IPSEC_CRYPTO_ENGINE_NATIVE &&
+      !esp_native_is_supported ())
+    return clib_error_return (0, "native crypto engine needs AES-NI");
 
   return 0;
 }
@@ -580,6 +622,9 @@ ipsec_init (vlib_main_t * vm)
 
   esp_init ();
 
+  im->crypto_engine = esp_native_is_supported () ?
+    IPSEC_CRYPTO_ENGINE_NATIVE : IPSEC_CRYPTO_ENGINE_OPENSSL;
+
   if ((error = ikev2_init (vm)))
     return error;
 
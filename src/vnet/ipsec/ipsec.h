@@ -98,6 +98,25 @@ typedef enum
     IPSEC_INTEG_N_ALG,
 } ipsec_integ_alg_t;
 
+/*
+ * Software ESP crypto engines: OpenSSL EVP/HMAC one packet at a time,
+ * or the native AES-NI engine (esp_native.c), which encrypts a frame's
+ * worth of packets in interleaved lanes. "default" picks the engine
+ * from ipsec_main_t when the SA is set up.
+ */
+#define foreach_ipsec_crypto_engine \
+  _(0, DEFAULT, "default")          \
+  _(1, OPENSSL, "openssl")          \
+  _(2, NATIVE, "native")
+
+typedef enum
+{
+#define _(v,f,s) IPSEC_CRYPTO_ENGINE_##f = v,
+  foreach_ipsec_crypto_engine
+#undef _
+    IPSEC_CRYPTO_N_ENGINE,
+} ipsec_crypto_engine_t;
+
 typedef enum
 {
   IPSEC_PROTOCOL_AH = 0,
@@ -128,6 +147,8 @@ typedef struct
 
   u32 salt;
 
+  ipsec_crypto_engine_t crypto_engine;
+
   /* runtime */
   u32 seq;
   u32 seq_hi;
@@ -282,6 +303,9 @@ typedef struct
   u32 esp_encrypt_next_index;
   u32 esp_decrypt_next_index;
 
+  /* engine used by SAs with the default engine */
+  ipsec_crypto_engine_t crypto_engine;
+
   /* callbacks */
   ipsec_main_callbacks_t cb;
 } ipsec_main_t;
@@ -304,6 +328,7 @@ int ipsec_add_del_policy (vlib_main_t * vm, ipsec_policy_t * policy,
 			  int is_add);
 int ipsec_add_del_sa (vlib_main_t * vm, ipsec_sa_t * new_sa, int is_add);
 int ipsec_set_sa_key (vlib_main_t * vm, ipsec_sa_t * sa_update);
+void ipsec_sa_crypto_init (u32 sa_index);
 
 u32 ipsec_get_sa_index_by_sa_id (u32 sa_id);
 u8 ipsec_is_sa_used (u32 sa_index);
@@ -312,9 +337,12 @@ u8 *format_ipsec_policy_action (u8 * s, va_list * args);
 u8 *format_ipsec_crypto_alg (u8 * s, va_list * args);
 u8 *format_ipsec_integ_alg (u8 * s, va_list * args);
 u8 *format_ipsec_replay_window (u8 * s, va_list * args);
+u8 *format_ipsec_crypto_engine (u8 * s, va_list * args);
 uword unformat_ipsec_policy_action (unformat_input_t * input, va_list * args);
 uword unformat_ipsec_crypto_alg (unformat_input_t * input, va_list * args);
 uword unformat_ipsec_integ_alg (unformat_input_t * input, va_list * args);
+uword unformat_ipsec_crypto_engine (unformat_input_t * input,
+				    va_list * args);
 
 int ipsec_add_del_tunnel_if_internal (vnet_main_t * vnm,
 				      ipsec_add_del_tunnel_args_t * args,
@@ -21,6 +21,7 @@
 #include <vnet/interface.h>
 
 #include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/esp_native.h>
 
 static clib_error_t *
 set_interface_spd_command_fn (vlib_main_t * vm,
@@ -150,6 +151,9 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
 	  sa.is_tunnel = 1;
 	  sa.is_tunnel_ip6 = 1;
 	}
+      else if (unformat (line_input, "crypto-engine %U",
+			 unformat_ipsec_crypto_engine, &sa.crypto_engine))
+	;
       else
 	{
 	  error = clib_error_return (0, "parse error: '%U'",
@@ -449,6 +453,8 @@ show_ipsec_command_fn (vlib_main_t * vm,
                         format_ipsec_integ_alg, sa->integ_alg,
                         sa->integ_alg ? " key " : "",
                         format_hex_bytes, sa->integ_key, sa->integ_key_len);
+        vlib_cli_output(vm, "  crypto engine %U",
+                        format_ipsec_crypto_engine, sa->crypto_engine);
       }
       if (sa->is_tunnel && sa->is_tunnel_ip6) {
         vlib_cli_output(vm, "  tunnel src %U dst %U",
@@ -845,6 +851,42 @@ VLIB_CLI_COMMAND (set_interface_key_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+set_ipsec_crypto_engine_command_fn (vlib_main_t * vm,
+				    unformat_input_t * input,
+				    vlib_cli_command_t * cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_crypto_engine_t engine;
+
+  if (!unformat (input, "%U", unformat_ipsec_crypto_engine, &engine) ||
+      engine == IPSEC_CRYPTO_ENGINE_DEFAULT)
+    return clib_error_return (0, "expected openssl or native, got `%U'",
+			      format_unformat_error, input);
+
+  if (engine == IPSEC_CRYPTO_ENGINE_NATIVE && !esp_native_is_supported ())
+    return clib_error_return (0, "native crypto engine needs AES-NI");
+
+  im->crypto_engine = engine;
+  return 0;
+}
+
+/*?
+ * Select the software ESP crypto engine used by SAs added afterwards
+ * without an explicit crypto-engine. The native engine is the default
+ * on CPUs with AES-NI.
+ *
+ * @cliexpar
+ * @cliexcmd{set ipsec crypto-engine openssl}
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (set_ipsec_crypto_engine_command, static) = {
+    .path = "set ipsec crypto-engine",
+    .short_help = "set ipsec crypto-engine [openssl|native]",
+    .function = set_ipsec_crypto_engine_command_fn,
+};
+/* *INDENT-ON* */
+
 clib_error_t *
 ipsec_cli_init (vlib_main_t * vm)
 {
@@ -118,6 +118,38 @@ unformat_ipsec_integ_alg (unformat_input_t * input, va_list * args)
   return 1;
 }
 
+u8 *
+format_ipsec_crypto_engine (u8 * s, va_list * args)
+{
+  u32 i = va_arg (*args, u32);
+  u8 *t = 0;
+
+  switch (i)
+    {
+#define _(v,f,str) case IPSEC_CRYPTO_ENGINE_##f: t = (u8 *) str; break;
+      foreach_ipsec_crypto_engine
+#undef _
+    default:
+      s = format (s, "unknown");
+    }
+  s = format (s, "%s", t);
+  return s;
+}
+
+uword
+unformat_ipsec_crypto_engine (unformat_input_t * input, va_list * args)
+{
+  u32 *r = va_arg (*args, u32 *);
+
+  if (0);
+#define _(v,f,s) else if (unformat (input, s)) *r = IPSEC_CRYPTO_ENGINE_##f;
+  foreach_ipsec_crypto_engine
+#undef _
+    else
+    return 0;
+  return 1;
+}
+
 u8 *
 format_ipsec_replay_window (u8 * s, va_list * args)
 {
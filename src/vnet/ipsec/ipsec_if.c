@@ -61,6 +61,8 @@ ipsec_admin_up_down_function (vnet_main_t * vnm, u32 hw_if_index, u32 flags)
       if (err)
 	return err;
 
+      ipsec_sa_crypto_init (t->input_sa_index);
+
       if (im->cb.add_del_sa_sess_cb)
 	{
 	  err = im->cb.add_del_sa_sess_cb (t->input_sa_index, 1);
@@ -74,6 +76,8 @@ ipsec_admin_up_down_function (vnet_main_t * vnm, u32 hw_if_index, u32 flags)
       if (err)
 	return err;
 
+      ipsec_sa_crypto_init (t->output_sa_index);
+
       if (im->cb.add_del_sa_sess_cb)
 	{
 	  err = im->cb.add_del_sa_sess_cb (t->output_sa_index, 1);
@@ -65,12 +65,11 @@ ipsec_if_input_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   ipsec_main_t *im = &ipsec_main;
   vnet_main_t *vnm = im->vnet_main;
   vnet_interface_main_t *vim = &vnm->interface_main;
-  esp_main_t *em = &esp_main;
   u32 *from, *to_next = 0, next_index;
   u32 n_left_from, last_sw_if_index = ~0;
   u32 thread_index = vlib_get_thread_index ();
   u64 n_bytes = 0, n_packets = 0;
-  u8 icv_len;
+  u8 iv_icv_len;
   ipsec_tunnel_if_t *last_t = NULL;
   ipsec_sa_t *sa0;
 
@@ -130,13 +129,13 @@ ipsec_if_input_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
 		  else
 		    {
 		      sa0 = pool_elt_at_index (im->sad, t->input_sa_index);
-		      icv_len = em->esp_integ_algs[sa0->integ_alg].trunc_size;
+		      iv_icv_len = esp_iv_icv_size (sa0);
 
 		      /* length = packet length - ESP/tunnel overhead */
 		      n_bytes -= n_packets * (sizeof (ip4_header_t) +
 					      sizeof (esp_header_t) +
 					      sizeof (esp_footer_t) +
-					      16 /* aes-cbc IV */  + icv_len);
+					      iv_icv_len);
 
 		      if (last_t)
 			{
@@ -178,11 +177,10 @@ ipsec_if_input_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
   if (last_t)
     {
       sa0 = pool_elt_at_index (im->sad, last_t->input_sa_index);
-      icv_len = em->esp_integ_algs[sa0->integ_alg].trunc_size;
+      iv_icv_len = esp_iv_icv_size (sa0);
 
       n_bytes -= n_packets * (sizeof (ip4_header_t) + sizeof (esp_header_t) +
-			      sizeof (esp_footer_t) + 16 /* aes-cbc IV */  +
-			      icv_len);
+			      sizeof (esp_footer_t) + iv_icv_len);
       vlib_increment_combined_counter (vim->combined_sw_if_counters
 				       + VNET_INTERFACE_COUNTER_RX,
 				       thread_index,
@@ -276,14 +276,18 @@ application_init (application_t * app, u32 api_client_index, u64 * options,
   app->ns_index = options[APP_OPTIONS_NAMESPACE];
   app->listeners_table = hash_create (0, sizeof (u64));
   app->proxied_transports = options[APP_OPTIONS_PROXY_TRANSPORT];
+  app->tcp_cc_algo = options[APP_OPTIONS_TCP_CC_ALGO];
 
   /* If no scope enabled, default to global */
   if (!application_has_global_scope (app)
       && !application_has_local_scope (app))
     app->flags |= APP_OPTIONS_FLAGS_USE_GLOBAL_SCOPE;
 
-  /* Allocate app event queue in the first shared-memory segment */
-  app->event_queue = segment_manager_alloc_queue (sm, app_evt_queue_size);
+  /* Allocate app event queue in the first shared-memory segment. Events
+   * are posted by the threads that own the app's sessions, so without
+   * workers there's only one producer and the queue can be lock-free */
+  app->event_queue = segment_manager_alloc_queue (sm, app_evt_queue_size,
+						  vlib_num_workers () == 0);
 
   /* Check that the obvious things are properly set up */
   application_verify_cb_fns (cb_fns);
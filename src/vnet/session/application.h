@@ -71,6 +71,9 @@ typedef struct _application
   /** Namespace the application belongs to */
   u32 ns_index;
 
+  /** TCP congestion control algorithm + 1, 0 for the namespace's */
+  u8 tcp_cc_algo;
+
   /** Application listens for events on this svm queue */
   unix_shared_memory_queue_t *event_queue;
 
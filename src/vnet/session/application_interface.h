@@ -115,6 +115,7 @@ typedef enum
   SESSION_OPTIONS_TX_FIFO_SIZE,
   SESSION_OPTIONS_PREALLOCATED_FIFO_PAIRS,
   SESSION_OPTIONS_ACCEPT_COOKIE,
+  APP_OPTIONS_TCP_CC_ALGO,
   SESSION_OPTIONS_N_OPTIONS
 } app_attach_options_index_t;
 
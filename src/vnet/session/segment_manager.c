@@ -536,9 +536,12 @@ segment_manager_dealloc_fifos (u32 svm_segment_index, svm_fifo_t * rx_fifo,
 
 /**
  * Allocates shm queue in the first segment
+ *
+ * @param is_spsc Queue has a single producer thread, so it can be lock-free
  */
 unix_shared_memory_queue_t *
-segment_manager_alloc_queue (segment_manager_t * sm, u32 queue_size)
+segment_manager_alloc_queue (segment_manager_t * sm, u32 queue_size,
+			     u8 is_spsc)
 {
   ssvm_shared_header_t *sh;
   svm_fifo_segment_private_t *segment;
@@ -551,10 +554,14 @@ segment_manager_alloc_queue (segment_manager_t * sm, u32 queue_size)
   sh = segment->ssvm.sh;
 
   oldheap = ssvm_push_heap (sh);
-  q = unix_shared_memory_queue_init (queue_size,
-				     sizeof (session_fifo_event_t),
-				     0 /* consumer pid */ ,
-				     0 /* signal when queue non-empty */ );
+  if (is_spsc)
+    q = unix_shared_memory_queue_init_spsc (queue_size,
+					    sizeof (session_fifo_event_t));
+  else
+    q = unix_shared_memory_queue_init (queue_size,
+				       sizeof (session_fifo_event_t),
+				       0 /* consumer pid */ ,
+				       0 /* signal when queue non-empty */ );
   ssvm_pop_heap (oldheap);
   return q;
 }
@@ -115,7 +115,8 @@ void
 segment_manager_dealloc_fifos (u32 svm_segment_index, svm_fifo_t * rx_fifo,
 			       svm_fifo_t * tx_fifo);
 unix_shared_memory_queue_t *segment_manager_alloc_queue (segment_manager_t *
-							 sm, u32 queue_size);
+							 sm, u32 queue_size,
+							 u8 is_spsc);
 void segment_manager_dealloc_queue (segment_manager_t * sm,
 				    unix_shared_memory_queue_t * q);
 void segment_manager_app_detach (segment_manager_t * sm);
@@ -101,12 +101,16 @@ session_alloc (u32 thread_index)
   memset (s, 0, sizeof (*s));
   s->session_index = s - session_manager_main.sessions[thread_index];
   s->thread_index = thread_index;
+  s->pacer_handle = ~0;
   return s;
 }
 
 static void
 session_free (stream_session_t * s)
 {
+  if (s->pacer_handle != ~0)
+    tw_timer_stop_1t_3w_1024sl_ov (&session_manager_main.pacer_wheels
+				   [s->thread_index], s->pacer_handle);
   pool_put (session_manager_main.sessions[s->thread_index], s);
   if (CLIB_DEBUG)
     memset (s, 0xFA, sizeof (*s));
@@ -427,7 +431,44 @@ u32
 stream_session_dequeue_drop (transport_connection_t * tc, u32 max_bytes)
 {
   stream_session_t *s = session_get (tc->s_index, tc->thread_index);
-  return svm_fifo_dequeue_drop (s->server_tx_fifo, max_bytes);
+  u32 rv;
+
+  rv = svm_fifo_dequeue_drop (s->server_tx_fifo, max_bytes);
+  if (PREDICT_FALSE (svm_fifo_want_tx_evt (s->server_tx_fifo)))
+    session_dequeue_notify (s);
+  return rv;
+}
+
+/**
+ * Notify session peer that space was freed in its tx fifo. Only done if
+ * the app asked for it, i.e., it found the fifo full and waits to write.
+ *
+ * @param s Stream session for which the event is to be generated.
+ *
+ * @return 0 on succes or negative number if failed to send notification.
+ */
+int
+session_dequeue_notify (stream_session_t * s)
+{
+  application_t *app;
+  session_fifo_event_t evt;
+  unix_shared_memory_queue_t *q;
+
+  app = application_get_if_valid (s->app_index);
+  if (PREDICT_FALSE (app == 0 || app->event_queue == 0))
+    return -1;
+
+  /* Leave the request pending and retry on the next dequeue */
+  q = app->event_queue;
+  if (PREDICT_FALSE (q->cursize >= q->maxsize))
+    return -1;
+
+  svm_fifo_unset_want_tx_evt (s->server_tx_fifo);
+  evt.fifo = s->server_tx_fifo;
+  evt.event_type = FIFO_EVENT_APP_TX;
+  unix_shared_memory_queue_add (q, (u8 *) & evt, 0 /* do wait for mutex */ );
+
+  return 0;
 }
 
 /**
@@ -1095,6 +1136,20 @@ session_manager_main_enable (vlib_main_t * vm)
   vec_validate (smm->last_event_poll_by_thread, num_threads - 1);
 #endif
 
+  if (smm->tx_pacing)
+    {
+      tw_timer_wheel_1t_3w_1024sl_ov_t *tw;
+      vec_validate (smm->pacer_wheels, num_threads - 1);
+      /* *INDENT-OFF* */
+      foreach_vlib_main (({
+	tw = &smm->pacer_wheels[ii];
+	tw_timer_wheel_init_1t_3w_1024sl_ov (tw, 0 /* no callback */ ,
+					     SESSION_PACER_TICK, ~0);
+	tw->last_run_time = vlib_time_now (this_vlib_main);
+      }));
+      /* *INDENT-ON* */
+    }
+
   /* Allocate vpp event queues */
   for (i = 0; i < vec_len (smm->vpp_event_queues); i++)
     session_vpp_event_queue_allocate (smm, i);
@@ -1195,6 +1250,8 @@ session_config_fn (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "preallocated-sessions %d",
 			 &smm->preallocated_sessions))
 	;
+      else if (unformat (input, "tx-pacing"))
+	smm->tx_pacing = 1;
       else if (unformat (input, "v4-session-table-buckets %d",
 			 &smm->configured_v4_session_table_buckets))
 	;
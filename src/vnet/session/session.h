@@ -21,6 +21,7 @@
 #include <vlibmemory/unix_shared_memory_queue.h>
 #include <vnet/session/session_debug.h>
 #include <vnet/session/segment_manager.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 
 #define HALF_OPEN_LOOKUP_INVALID_VALUE ((u64)~0)
 #define INVALID_INDEX ((u32)~0)
@@ -28,6 +29,10 @@
 /* TODO decide how much since we have pre-data as well */
 #define MAX_HDRS_LEN    100	/* Max number of bytes for headers */
 
+#define SESSION_PACER_TICK 100e-6	/* Pacer timer wheel period (s) */
+#define SESSION_PACER_BURST_TICKS 2	/* Max credit, in ticks of rate */
+#define SESSION_PACER_MIN_BURST_SEGS 2	/* Min credit, in segments */
+
 typedef enum
 {
   FIFO_EVENT_APP_RX,
@@ -184,6 +189,13 @@ struct _session_manager_main
   /** Preallocate session config parameter */
   u32 preallocated_sessions;
 
+  /** Pace tx of connections whose transport provides a rate */
+  u8 tx_pacing;
+
+  /** Per worker-thread tx pacer timer wheels. A session whose pacer
+   *  credit runs out is rescheduled, not polled */
+  tw_timer_wheel_1t_3w_1024sl_ov_t *pacer_wheels;
+
 #if SESSION_DBG
   /**
    * last event poll time by thread
@@ -389,6 +401,8 @@ session_clone_safe (u32 session_index, u32 thread_index)
   session_pool_remove_peeker (thread_index);
   new_s->thread_index = current_thread_index;
   new_s->session_index = session_get_index (new_s);
+  /* The original's pacer timer, if any, is on its thread's wheel */
+  new_s->pacer_handle = ~0;
   return new_s;
 }
 
@@ -397,6 +411,11 @@ transport_connection_t *session_get_transport (stream_session_t * s);
 u32 stream_session_tx_fifo_max_dequeue (transport_connection_t * tc);
 
 stream_session_t *session_alloc (u32 thread_index);
+u32 session_tx_pacer_credit (vlib_main_t * vm, session_manager_main_t * smm,
+			     stream_session_t * s, u64 rate, u32 max_bytes,
+			     u16 snd_mss);
+void session_tx_pacer_expire (session_manager_main_t * smm, u32 thread_index,
+			      f64 now);
 int
 session_enqueue_stream_connection (transport_connection_t * tc,
 				   vlib_buffer_t * b, u32 offset,
@@ -406,6 +425,7 @@ int session_enqueue_dgram_connection (stream_session_t * s, vlib_buffer_t * b,
 int stream_session_peek_bytes (transport_connection_t * tc, u8 * buffer,
 			       u32 offset, u32 max_bytes);
 u32 stream_session_dequeue_drop (transport_connection_t * tc, u32 max_bytes);
+int session_dequeue_notify (stream_session_t * s);
 
 int session_stream_connect_notify (transport_connection_t * tc, u8 is_fail);
 int session_dgram_connect_notify (transport_connection_t * tc,
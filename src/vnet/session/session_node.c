@@ -48,7 +48,9 @@ vlib_node_registration_t session_queue_node;
 #define foreach_session_queue_error		\
 _(TX, "Packets transmitted")                  	\
 _(TIMER, "Timer events")			\
-_(NO_BUFFER, "Out of buffers")
+_(NO_BUFFER, "Out of buffers")			\
+_(TX_BYTES_NOW, "Paced bytes sent immediately")	\
+_(TX_BYTES_PACED, "Paced bytes sent after delay")
 
 typedef enum
 {
@@ -71,17 +73,49 @@ static u32 session_type_to_next[] = {
   SESSION_QUEUE_NEXT_IP6_LOOKUP,
 };
 
+/*
+ * The fifo data sent on an event, referenced in place. It is copied
+ * straight into the buffers, without going through the fifo for each
+ * of them; in dequeue mode it is dropped from the fifo once, when done.
+ */
+typedef struct
+{
+  svm_fifo_seg_t segs[2];
+  u32 seg_index;
+  u32 seg_offset;
+} session_tx_fifo_cursor_t;
+
+always_inline void
+session_tx_fifo_copy (session_tx_fifo_cursor_t * c, u8 * dst, u32 n_bytes)
+{
+  while (n_bytes)
+    {
+      svm_fifo_seg_t *fs = &c->segs[c->seg_index];
+      u32 n = clib_min (n_bytes, fs->len - c->seg_offset);
+
+      ASSERT (c->seg_index < ARRAY_LEN (c->segs));
+      clib_memcpy (dst, fs->data + c->seg_offset, n);
+      dst += n;
+      n_bytes -= n;
+      c->seg_offset += n;
+      if (c->seg_offset == fs->len)
+	{
+	  c->seg_index++;
+	  c->seg_offset = 0;
+	}
+    }
+}
+
 always_inline void
 session_tx_fifo_chain_tail (session_manager_main_t * smm, vlib_main_t * vm,
-			    u8 thread_index, svm_fifo_t * fifo,
+			    u8 thread_index, session_tx_fifo_cursor_t * c,
 			    vlib_buffer_t * b0, u32 bi0, u8 n_bufs_per_seg,
 			    u32 left_from_seg, u32 * left_to_snd0,
-			    u16 * n_bufs, u32 * tx_offset, u16 deq_per_buf,
-			    u8 peek_data)
+			    u16 * n_bufs, u16 deq_per_buf)
 {
   vlib_buffer_t *chain_b0, *prev_b0;
   u32 chain_bi0, to_deq;
-  u16 len_to_deq0, n_bytes_read;
+  u16 len_to_deq0;
   u8 *data0, j;
 
   b0->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
@@ -102,17 +136,8 @@ session_tx_fifo_chain_tail (session_manager_main_t * smm, vlib_main_t * vm,
       chain_b0 = vlib_get_buffer (vm, chain_bi0);
       chain_b0->current_data = 0;
       data0 = vlib_buffer_get_current (chain_b0);
-      if (peek_data)
-	{
-	  n_bytes_read = svm_fifo_peek (fifo, *tx_offset, len_to_deq0, data0);
-	  *tx_offset += n_bytes_read;
-	}
-      else
-	{
-	  n_bytes_read = svm_fifo_dequeue_nowait (fifo, len_to_deq0, data0);
-	}
-      ASSERT (n_bytes_read == len_to_deq0);
-      chain_b0->current_length = n_bytes_read;
+      session_tx_fifo_copy (c, data0, len_to_deq0);
+      chain_b0->current_length = len_to_deq0;
       b0->total_length_not_including_first_buffer += chain_b0->current_length;
 
       /* update previous buffer */
@@ -122,7 +147,7 @@ session_tx_fifo_chain_tail (session_manager_main_t * smm, vlib_main_t * vm,
       /* update current buffer */
       chain_b0->next_buffer = 0;
 
-      to_deq -= n_bytes_read;
+      to_deq -= len_to_deq0;
       if (to_deq == 0)
 	break;
     }
@@ -131,6 +156,77 @@ session_tx_fifo_chain_tail (session_manager_main_t * smm, vlib_main_t * vm,
   *left_to_snd0 -= left_from_seg;
 }
 
+/**
+ * Tx pacer. A token bucket per session that fills at the transport's
+ * pacing rate, up to SESSION_PACER_BURST_TICKS worth of it.
+ *
+ * Returns how much of max_bytes can be sent now. If that's less than a
+ * segment, arms the session's pacer timer and returns 0. The session's
+ * fifo keeps its event flag set, so apps don't post new events, and the
+ * timer re-posts one when credit is available.
+ */
+u32
+session_tx_pacer_credit (vlib_main_t * vm, session_manager_main_t * smm,
+			 stream_session_t * s, u64 rate, u32 max_bytes,
+			 u16 snd_mss)
+{
+  f64 now = vlib_time_now (vm), credit, burst, wait;
+  u32 n_bytes, ticks;
+
+  burst = clib_max (rate * SESSION_PACER_TICK * SESSION_PACER_BURST_TICKS,
+		    SESSION_PACER_MIN_BURST_SEGS * snd_mss);
+  credit = s->tx_credit + rate * (now - s->tx_credit_time);
+  s->tx_credit = clib_min (credit, burst);
+  s->tx_credit_time = now;
+
+  n_bytes = clib_min (max_bytes, s->tx_credit);
+  if (n_bytes < max_bytes && n_bytes < snd_mss)
+    {
+      if (s->pacer_handle == ~0)
+	{
+	  wait = (f64) (clib_min (max_bytes, snd_mss) - s->tx_credit) / rate;
+	  ticks = clib_max (ceil (wait / SESSION_PACER_TICK), 1);
+	  s->pacer_handle = tw_timer_start_1t_3w_1024sl_ov
+	    (&smm->pacer_wheels[s->thread_index], s->session_index, 0, ticks);
+	}
+      s->tx_deferred = 1;
+      return 0;
+    }
+
+  /* Full segments only, unless it's all we have */
+  if (n_bytes > snd_mss)
+    n_bytes -= n_bytes % snd_mss;
+  s->tx_credit -= n_bytes;
+  return n_bytes;
+}
+
+/**
+ * Post tx events for the sessions whose pacer timer expired
+ */
+void
+session_tx_pacer_expire (session_manager_main_t * smm, u32 thread_index,
+			 f64 now)
+{
+  session_fifo_event_t *e;
+  stream_session_t *s;
+  u32 *expired;
+  int i;
+
+  expired = tw_timer_expire_timers_1t_3w_1024sl_ov (&smm->pacer_wheels
+						    [thread_index], now);
+  for (i = 0; i < vec_len (expired); i++)
+    {
+      s = session_get_if_valid (expired[i], thread_index);
+      if (PREDICT_FALSE (!s))
+	continue;
+      s->pacer_handle = ~0;
+      vec_add2 (smm->pending_event_vector[thread_index], e, 1);
+      e->fifo = s->server_tx_fifo;
+      e->event_type = FIFO_EVENT_APP_TX;
+      e->postponed = 0;
+    }
+}
+
 always_inline int
 session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
 				session_manager_main_t * smm,
@@ -148,9 +244,12 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
   u32 tx_offset = 0, max_dequeue0, n_bytes_per_seg, left_for_seg;
   u16 snd_mss0, n_bufs_per_seg, n_bufs;
   u8 *data0;
-  int i, n_bytes_read;
+  int i;
   u32 n_bytes_per_buf, deq_per_buf, deq_per_first_buf;
   u32 buffers_allocated, buffers_allocated_this_call;
+  session_tx_fifo_cursor_t _c, *c = &_c;
+  u8 is_paced = 0;
+  u64 rate;
 
   next_index = next0 = session_type_to_next[s0->session_type];
 
@@ -202,6 +301,22 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
       max_len_to_snd0 = snd_space0;
     }
 
+  /* Send only what the pacer allows, the timer brings us back for more */
+  if (smm->tx_pacing && transport_vft->tx_pacing_rate
+      && (rate = transport_vft->tx_pacing_rate (tc0)))
+    {
+      max_len_to_snd0 = session_tx_pacer_credit (vm, smm, s0, rate,
+						 max_len_to_snd0, snd_mss0);
+      if (max_len_to_snd0 == 0)
+	return 0;
+      is_paced = 1;
+    }
+
+  /* Reference what we're about to send */
+  c->seg_index = c->seg_offset = 0;
+  max_len_to_snd0 = svm_fifo_segments (s0->server_tx_fifo, tx_offset,
+				       max_len_to_snd0, c->segs);
+
   n_bytes_per_buf = vlib_buffer_free_list_buffer_size
     (vm, VLIB_BUFFER_DEFAULT_FREE_LIST_INDEX);
   ASSERT (n_bytes_per_buf > MAX_HDRS_LEN);
@@ -244,6 +359,9 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  if (PREDICT_FALSE (n_bufs < n_bufs_per_frame))
 	    {
+	      if (!peek_data)
+		svm_fifo_dequeue_drop (s0->server_tx_fifo,
+				       max_len_to_snd0 - left_to_snd0);
 	      vec_add1 (smm->pending_event_vector[thread_index], *e0);
 	      return -1;
 	    }
@@ -277,27 +395,11 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  len_to_deq0 = clib_min (left_to_snd0, deq_per_first_buf);
 	  data0 = vlib_buffer_make_headroom (b0, MAX_HDRS_LEN);
-	  if (peek_data)
-	    {
-	      n_bytes_read = svm_fifo_peek (s0->server_tx_fifo, tx_offset,
-					    len_to_deq0, data0);
-	      if (n_bytes_read <= 0)
-		goto dequeue_fail;
-	      /* Keep track of progress locally, transport is also supposed to
-	       * increment it independently when pushing the header */
-	      tx_offset += n_bytes_read;
-	    }
-	  else
-	    {
-	      n_bytes_read = svm_fifo_dequeue_nowait (s0->server_tx_fifo,
-						      len_to_deq0, data0);
-	      if (n_bytes_read <= 0)
-		goto dequeue_fail;
-	    }
+	  session_tx_fifo_copy (c, data0, len_to_deq0);
 
-	  b0->current_length = n_bytes_read;
+	  b0->current_length = len_to_deq0;
 
-	  left_to_snd0 -= n_bytes_read;
+	  left_to_snd0 -= len_to_deq0;
 	  *n_tx_packets = *n_tx_packets + 1;
 
 	  /*
@@ -305,12 +407,11 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
 	   */
 	  if (PREDICT_FALSE (n_bufs_per_seg > 1 && left_to_snd0))
 	    {
-	      left_for_seg = clib_min (snd_mss0 - n_bytes_read, left_to_snd0);
-	      session_tx_fifo_chain_tail (smm, vm, thread_index,
-					  s0->server_tx_fifo, b0, bi0,
+	      left_for_seg = clib_min (snd_mss0 - len_to_deq0, left_to_snd0);
+	      session_tx_fifo_chain_tail (smm, vm, thread_index, c, b0, bi0,
 					  n_bufs_per_seg, left_for_seg,
-					  &left_to_snd0, &n_bufs, &tx_offset,
-					  deq_per_buf, peek_data);
+					  &left_to_snd0, &n_bufs,
+					  deq_per_buf);
 	    }
 
 	  /* Ask transport to push header after current_length and
@@ -348,6 +449,24 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
 
+  /* All the data referenced is in buffers now */
+  if (!peek_data)
+    {
+      svm_fifo_dequeue_drop (s0->server_tx_fifo,
+			     max_len_to_snd0 - left_to_snd0);
+      if (PREDICT_FALSE (svm_fifo_want_tx_evt (s0->server_tx_fifo)))
+	session_dequeue_notify (s0);
+    }
+
+  if (is_paced)
+    {
+      vlib_node_increment_counter (vm, node->node_index, s0->tx_deferred ?
+				   SESSION_QUEUE_ERROR_TX_BYTES_PACED :
+				   SESSION_QUEUE_ERROR_TX_BYTES_NOW,
+				   max_len_to_snd0 - left_to_snd0);
+      s0->tx_deferred = 0;
+    }
+
   /* If we couldn't dequeue all bytes mark as partially read */
   if (max_len_to_snd0 < max_dequeue0)
     {
@@ -358,22 +477,6 @@ session_tx_fifo_read_and_snd_i (vlib_main_t * vm, vlib_node_runtime_t * node,
 	}
     }
   return 0;
-
-dequeue_fail:
-  /*
-   * Can't read from fifo. If we don't already have an event, save as partially
-   * read, return buff to free list and return
-   */
-  clib_warning ("dequeue fail");
-
-  if (svm_fifo_set_event (s0->server_tx_fifo))
-    {
-      vec_add1 (smm->pending_event_vector[thread_index], *e0);
-    }
-  vlib_put_next_frame (vm, node, next_index, n_left_to_next + 1);
-  _vec_len (smm->tx_buffers[thread_index]) += 1;
-
-  return 0;
 }
 
 int
@@ -557,6 +660,9 @@ session_queue_node_fn (vlib_main_t * vm, vlib_node_runtime_t * node,
    */
   tcp_update_time (now, my_thread_index);
 
+  if (smm->tx_pacing)
+    session_tx_pacer_expire (smm, my_thread_index, now);
+
   /*
    * Get vpp queue events
    */
@@ -1241,6 +1241,89 @@ session_test_proxy (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+static int
+session_test_pacer (vlib_main_t * vm, unformat_input_t * input)
+{
+  session_manager_main_t _smm, *smm = &_smm;
+  u32 thread_index = vlib_get_thread_index (), session_index;
+  u32 n_bytes, sent = 0, n_wakeups = 0, n_unarmed = 0, mss = 1000;
+  f64 start, now, rate = 2e6, duration = 0.1, burst, max_sent;
+  tw_timer_wheel_1t_3w_1024sl_ov_t *tw;
+  stream_session_t *s, *clone;
+  u8 has_event = 1;
+
+  /* Own wheel, pacing may not be enabled */
+  memset (smm, 0, sizeof (*smm));
+  vec_validate (smm->pacer_wheels, thread_index);
+  vec_validate (smm->pending_event_vector, thread_index);
+  tw = &smm->pacer_wheels[thread_index];
+  tw_timer_wheel_init_1t_3w_1024sl_ov (tw, 0 /* no callback */ ,
+				       SESSION_PACER_TICK, ~0);
+  tw->last_run_time = vlib_time_now (vm);
+
+  s = session_alloc (thread_index);
+  session_index = s->session_index;
+  start = s->tx_credit_time = vlib_time_now (vm);
+
+  /*
+   * Like the session queue node, try to send while the session has a tx
+   * event. There's always more data than the pacer allows, so the event
+   * is only dropped when the pacer arms the session's timer and posted
+   * again when the timer expires.
+   */
+  while ((now = vlib_time_now (vm)) < start + duration)
+    {
+      session_tx_pacer_expire (smm, thread_index, now);
+      if (vec_len (smm->pending_event_vector[thread_index]))
+	{
+	  vec_reset_length (smm->pending_event_vector[thread_index]);
+	  has_event = 1;
+	  n_wakeups++;
+	}
+      if (!has_event)
+	continue;
+
+      n_bytes = session_tx_pacer_credit (vm, smm, s, rate, 100 * mss, mss);
+      if (n_bytes == 0)
+	{
+	  n_unarmed += s->pacer_handle == ~0;
+	  has_event = 0;
+	}
+      sent += n_bytes;
+    }
+
+  burst = clib_max (rate * SESSION_PACER_TICK * SESSION_PACER_BURST_TICKS,
+		    SESSION_PACER_MIN_BURST_SEGS * mss);
+  max_sent = rate * (vlib_time_now (vm) - start) + burst;
+  SESSION_TEST ((n_unarmed == 0), "pacer timer armed whenever tx stops");
+  SESSION_TEST ((sent <= max_sent), "sent %u at most %.0f", sent, max_sent);
+  SESSION_TEST ((sent >= 0.75 * rate * duration), "sent %u at least %.0f",
+		sent, 0.75 * rate * duration);
+  SESSION_TEST ((n_wakeups * mss >= sent - burst), "%u timer wakeups for "
+		"%u bytes, past the first burst", n_wakeups, sent);
+
+  /*
+   * A clone doesn't own the original's timer
+   */
+  s->tx_credit = 0;
+  s->tx_credit_time = vlib_time_now (vm);
+  session_tx_pacer_credit (vm, smm, s, rate, 100 * mss, mss);
+  SESSION_TEST ((s->pacer_handle != ~0), "pacer timer armed");
+  clone = session_clone_safe (session_index, thread_index);
+  SESSION_TEST ((clone->pacer_handle == ~0), "clone's pacer timer unarmed");
+
+  /* Timers are on the test's wheel, don't let session free stop them */
+  s = session_get (session_index, thread_index);
+  tw_timer_stop_1t_3w_1024sl_ov (tw, s->pacer_handle);
+  pool_put (session_manager_main.sessions[thread_index], clone);
+  pool_put (session_manager_main.sessions[thread_index], s);
+  tw_timer_wheel_free_1t_3w_1024sl_ov (tw);
+  vec_free (smm->pacer_wheels);
+  vec_free (smm->pending_event_vector);
+
+  return 0;
+}
+
 static clib_error_t *
 session_test (vlib_main_t * vm,
 	      unformat_input_t * input, vlib_cli_command_t * cmd_arg)
@@ -1261,6 +1344,8 @@ session_test (vlib_main_t * vm,
 	res = session_test_rules (vm, input);
       else if (unformat (input, "proxy"))
 	res = session_test_proxy (vm, input);
+      else if (unformat (input, "pacer"))
+	res = session_test_pacer (vm, input);
       else if (unformat (input, "all"))
 	{
 	  if ((res = session_test_basic (vm, input)))
@@ -1273,6 +1358,8 @@ session_test (vlib_main_t * vm,
 	    goto done;
 	  if ((res = session_test_proxy (vm, input)))
 	    goto done;
+	  if ((res = session_test_pacer (vm, input)))
+	    goto done;
 	}
       else
 	break;
@@ -80,6 +80,16 @@ typedef struct _stream_session_t
   /** Parent listener session if the result of an accept */
   u32 listener_index;
 
+  /** Tx pacer credit, in bytes, and when it was last updated */
+  u32 tx_credit;
+  f64 tx_credit_time;
+
+  /** Tx pacer timer handle, ~0 if not armed */
+  u32 pacer_handle;
+
+  /** Tx was deferred by the pacer and hasn't resumed yet */
+  u8 tx_deferred;
+
     CLIB_CACHE_LINE_ALIGN_MARK (pad);
 } stream_session_t;
 
@@ -40,6 +40,8 @@ typedef struct _transport_proto_vft
     u16 (*send_mss) (transport_connection_t * tc);
     u32 (*send_space) (transport_connection_t * tc);
     u32 (*tx_fifo_offset) (transport_connection_t * tc);
+    u64 (*tx_pacing_rate) (transport_connection_t * tc);	/**< B/s, 0 if
+								   unknown */
 
   /*
    * Connection retrieval
@@ -18,6 +18,7 @@
 #include <vnet/vnet.h>
 #include <vnet/plugin/plugin.h>
 #include <vnet/tcp/builtin_client.h>
+#include <vnet/tcp/tcp.h>
 
 #include <vlibapi/api.h>
 #include <vlibmemory/api.h>
@@ -455,6 +456,7 @@ attach_builtin_test_clients_app (u8 * appns_id, u64 appns_flags,
   options[APP_OPTIONS_PRIVATE_SEGMENT_COUNT] = tm->private_segment_count;
   options[APP_OPTIONS_PRIVATE_SEGMENT_SIZE] = tm->private_segment_size;
   options[APP_OPTIONS_PREALLOC_FIFO_PAIRS] = prealloc_fifos;
+  options[APP_OPTIONS_TCP_CC_ALGO] = tm->cc_algo;
 
   options[APP_OPTIONS_FLAGS] = APP_OPTIONS_FLAGS_IS_BUILTIN;
   if (appns_id)
@@ -539,6 +541,7 @@ test_tcp_clients_command_fn (vlib_main_t * vm,
   u8 *default_connect_uri = (u8 *) "tcp://6.0.1.1/1234", *uri, *appns_id;
   u64 tmp, total_bytes, appns_flags = 0, appns_secret = 0;
   f64 test_timeout = 20.0, syn_timeout = 20.0, delta;
+  tcp_cc_algorithm_type_e cc_algo;
   f64 time_before_connects;
   u32 n_clients = 1;
   int preallocate_sessions = 0;
@@ -552,6 +555,7 @@ test_tcp_clients_command_fn (vlib_main_t * vm,
   tm->connections_per_batch = 1000;
   tm->private_segment_count = 0;
   tm->private_segment_size = 0;
+  tm->cc_algo = 0;
   tm->vlib_main = vm;
   if (thread_main->n_vlib_mains > 1)
     clib_spinlock_init (&tm->sessions_lock);
@@ -606,6 +610,9 @@ test_tcp_clients_command_fn (vlib_main_t * vm,
 	appns_flags = APP_OPTIONS_FLAGS_USE_GLOBAL_SCOPE;
       else if (unformat (input, "secret %lu", &appns_secret))
 	;
+      else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
+			 &cc_algo))
+	tm->cc_algo = cc_algo + 1;
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -773,7 +780,7 @@ VLIB_CLI_COMMAND (test_clients_command, static) =
       "[test-timeout <time>][syn-timeout <time>][no-return][fifo-size <size>]"
       "[private-segment-count <count>][private-segment-size <bytes>[m|g]]"
       "[preallocate-fifos][preallocate-sessions][client-batch <batch-size>]"
-      "[uri <tcp://ip/port>]",
+      "[uri <tcp://ip/port>][cc-algo <newreno|cubic|bbr>]",
   .function = test_tcp_clients_command_fn,
   .is_mp_safe = 1,
 };
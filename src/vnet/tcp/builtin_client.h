@@ -65,6 +65,7 @@ typedef struct
   u32 connections_per_batch;		/**< Connections to rx/tx at once */
   u32 private_segment_count;		/**< Number of private fifo segs */
   u32 private_segment_size;		/**< size of private fifo segs */
+  u8 cc_algo;				/**< TCP cc algorithm + 1, 0 default */
 
   /*
    * Test state variables
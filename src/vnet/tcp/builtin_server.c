@@ -17,6 +17,7 @@
 #include <vlibmemory/api.h>
 #include <vnet/session/application.h>
 #include <vnet/session/application_interface.h>
+#include <vnet/tcp/tcp.h>
 
 typedef struct
 {
@@ -39,6 +40,7 @@ typedef struct
   u32 prealloc_fifos;		/**< Preallocate fifos */
   u32 private_segment_count;	/**< Number of private segments  */
   u32 private_segment_size;	/**< Size of private segments  */
+  u8 cc_algo;			/**< TCP cc algorithm + 1, 0 default */
   char *server_uri;		/**< Server URI */
 
   /*
@@ -293,6 +295,7 @@ server_attach (u8 * appns_id, u64 appns_flags, u64 appns_secret)
   a->options[SESSION_OPTIONS_TX_FIFO_SIZE] = bsm->fifo_size;
   a->options[APP_OPTIONS_PRIVATE_SEGMENT_COUNT] = bsm->private_segment_count;
   a->options[APP_OPTIONS_PRIVATE_SEGMENT_SIZE] = bsm->private_segment_size;
+  a->options[APP_OPTIONS_TCP_CC_ALGO] = bsm->cc_algo;
   a->options[APP_OPTIONS_PREALLOC_FIFO_PAIRS] =
     bsm->prealloc_fifos ? bsm->prealloc_fifos : 1;
 
@@ -372,6 +375,7 @@ server_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   builtin_server_main_t *bsm = &builtin_server_main;
   u8 server_uri_set = 0, *appns_id = 0;
   u64 tmp, appns_flags = 0, appns_secret = 0;
+  tcp_cc_algorithm_type_e cc_algo;
   int rv;
 
   bsm->no_echo = 0;
@@ -380,6 +384,7 @@ server_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
   bsm->prealloc_fifos = 0;
   bsm->private_segment_count = 0;
   bsm->private_segment_size = 0;
+  bsm->cc_algo = 0;
   vec_free (bsm->server_uri);
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
@@ -416,6 +421,9 @@ server_create_command_fn (vlib_main_t * vm, unformat_input_t * input,
 	appns_flags |= APP_OPTIONS_FLAGS_USE_GLOBAL_SCOPE;
       else if (unformat (input, "secret %lu", &appns_secret))
 	;
+      else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
+			 &cc_algo))
+	bsm->cc_algo = cc_algo + 1;
       else
 	return clib_error_return (0, "unknown input `%U'",
 				  format_unformat_error, input);
@@ -446,7 +454,7 @@ VLIB_CLI_COMMAND (server_create_command, static) =
   .short_help = "test tcp server [no echo][fifo-size <mbytes>] "
       "[rcv-buf-size <bytes>][prealloc-fifos <count>]"
       "[private-segment-count <count>][private-segment-size <bytes[m|g]>]"
-      "[uri <tcp://ip/port>]",
+      "[uri <tcp://ip/port>][cc-algo <newreno|cubic|bbr>]",
   .function = server_create_command_fn,
 };
 /* *INDENT-ON* */
@@ -20,6 +20,8 @@
 
 #include <vnet/tcp/tcp.h>
 #include <vnet/session/session.h>
+#include <vnet/session/application.h>
+#include <vnet/session/application_namespace.h>
 #include <vnet/fib/fib.h>
 #include <vnet/dpo/load_balance.h>
 #include <vnet/dpo/receive_dpo.h>
@@ -672,6 +674,37 @@ format_tcp_congestion_status (u8 * s, va_list * args)
   return s;
 }
 
+static const char *tcp_cc_algo_strings[] = {
+#define _(sym, str) str,
+  foreach_tcp_cc_algorithm
+#undef _
+};
+
+u8 *
+format_tcp_cc_algo (u8 * s, va_list * args)
+{
+  tcp_cc_algorithm_type_e type = va_arg (*args, tcp_cc_algorithm_type_e);
+
+  if (type >= TCP_CC_N_ALGOS)
+    return format (s, "unknown");
+  return format (s, "%s", tcp_cc_algo_strings[type]);
+}
+
+uword
+unformat_tcp_cc_algo (unformat_input_t * input, va_list * args)
+{
+  tcp_cc_algorithm_type_e *result = va_arg (*args, tcp_cc_algorithm_type_e *);
+  int i;
+
+  for (i = 0; i < TCP_CC_N_ALGOS; i++)
+    if (unformat (input, tcp_cc_algo_strings[i]))
+      {
+	*result = i;
+	return 1;
+      }
+  return 0;
+}
+
 u8 *
 format_tcp_vars (u8 * s, va_list * args)
 {
@@ -689,7 +722,9 @@ format_tcp_vars (u8 * s, va_list * args)
   s = format (s, " flight size %u send space %u rcv_wnd_av %d\n",
 	      tcp_flight_size (tc), tcp_available_output_snd_space (tc),
 	      tcp_rcv_wnd_available (tc));
-  s = format (s, " cong %U ", format_tcp_congestion_status, tc);
+  s = format (s, " cc %U cong %U ", format_tcp_cc_algo,
+	      tc->cc_algo - tcp_main.cc_algos, format_tcp_congestion_status,
+	      tc);
   s = format (s, "cwnd %u ssthresh %u rtx_bytes %u bytes_acked %u\n",
 	      tc->cwnd, tc->ssthresh, tc->snd_rxt_bytes, tc->bytes_acked);
   s = format (s, " prev_ssthresh %u snd_congestion %u dupack %u",
@@ -1008,6 +1043,27 @@ tcp_session_tx_fifo_offset (transport_connection_t * trans_conn)
   return (tc->snd_nxt - tc->snd_una);
 }
 
+/**
+ * Rate at which to pace transmissions, in bytes/s. The congestion control
+ * algorithm's if it has one, otherwise cwnd per srtt, doubled in slow
+ * start to leave room for growth and with 20% headroom in congestion
+ * avoidance.
+ */
+u64
+tcp_session_tx_pacing_rate (transport_connection_t * trans_conn)
+{
+  tcp_connection_t *tc = (tcp_connection_t *) trans_conn;
+  u64 rate = 0;
+
+  if (tc->cc_algo->pacing_rate)
+    rate = tc->cc_algo->pacing_rate (tc);
+  if (rate || !tc->srtt)
+    return rate;
+
+  return (tcp_in_slowstart (tc) ? 2 : 1.2) * tc->cwnd
+    / (tc->srtt * TCP_TICK);
+}
+
 /* *INDENT-OFF* */
 const static transport_proto_vft_t tcp_proto = {
   .bind = tcp_session_bind,
@@ -1022,6 +1078,7 @@ const static transport_proto_vft_t tcp_proto = {
   .send_mss = tcp_session_send_mss,
   .send_space = tcp_session_send_space,
   .tx_fifo_offset = tcp_session_tx_fifo_offset,
+  .tx_pacing_rate = tcp_session_tx_pacing_rate,
   .format_connection = format_tcp_session,
   .format_listener = format_tcp_listener_session,
   .format_half_open = format_tcp_half_open_session,
@@ -1315,6 +1372,9 @@ tcp_config_fn (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "local-endpoints-table-buckets %d",
 			 &tm->local_endpoints_table_buckets))
 	;
+      else if (unformat (input, "cc-algo %U", unformat_tcp_cc_algo,
+			 &tm->cc_algo))
+	;
 
 
       else
@@ -1589,6 +1649,81 @@ VLIB_CLI_COMMAND (tcp_src_address_command, static) =
 };
 /* *INDENT-ON* */
 
+/**
+ * Congestion control algorithm for an app's new connections: the one
+ * the app asked for when it attached, else its namespace's, else the
+ * default
+ */
+tcp_cc_algorithm_t *
+tcp_cc_algo_for_app (u32 app_index)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_cc_algorithm_type_e type = tm->cc_algo;
+  application_t *app;
+
+  app = application_get_if_valid (app_index);
+  if (app)
+    {
+      if (app->tcp_cc_algo && app->tcp_cc_algo <= TCP_CC_N_ALGOS)
+	type = app->tcp_cc_algo - 1;
+      else if (app->ns_index < vec_len (tm->appns_cc_algo)
+	       && tm->appns_cc_algo[app->ns_index] != (u8) ~ 0)
+	type = tm->appns_cc_algo[app->ns_index];
+    }
+  return tcp_cc_algo_get (type);
+}
+
+static clib_error_t *
+tcp_set_cc_algo_fn (vlib_main_t * vm, unformat_input_t * input,
+		    vlib_cli_command_t * cmd_arg)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  tcp_cc_algorithm_type_e type = TCP_CC_N_ALGOS;
+  app_namespace_t *app_ns = 0;
+  u8 *ns_id = 0, is_default = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_tcp_cc_algo, &type))
+	;
+      else if (unformat (input, "default"))
+	is_default = 1;
+      else if (unformat (input, "app-ns %_%v%_", &ns_id))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (type == TCP_CC_N_ALGOS && !(is_default && ns_id))
+    return clib_error_return (0, "congestion control algorithm required");
+
+  if (!ns_id)
+    {
+      tm->cc_algo = type;
+      return 0;
+    }
+
+  app_ns = app_namespace_get_from_id (ns_id);
+  vec_free (ns_id);
+  if (!app_ns)
+    return clib_error_return (0, "namespace not found");
+
+  vec_validate_init_empty (tm->appns_cc_algo, app_namespace_index (app_ns),
+			   ~0);
+  tm->appns_cc_algo[app_namespace_index (app_ns)] = is_default ? ~0 : type;
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (tcp_set_cc_algo_command, static) =
+{
+  .path = "set tcp cc-algo",
+  .short_help = "set tcp cc-algo <newreno|cubic|bbr|default> [app-ns <id>]",
+  .function = tcp_set_cc_algo_fn,
+};
+/* *INDENT-ON* */
+
 static u8 *
 tcp_scoreboard_dump_trace (u8 * s, sack_scoreboard_t * sb)
 {
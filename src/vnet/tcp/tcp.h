@@ -225,13 +225,40 @@ typedef struct _sack_scoreboard
 #define tcp_scoreboard_trace_add(_tc, _ack)
 #endif
 
+#define foreach_tcp_cc_algorithm		\
+  _(NEWRENO, "newreno")				\
+  _(CUBIC, "cubic")				\
+  _(BBR, "bbr")
+
 typedef enum _tcp_cc_algorithm_type
 {
-  TCP_CC_NEWRENO,
+#define _(sym, str) TCP_CC_##sym,
+  foreach_tcp_cc_algorithm
+#undef _
+  TCP_CC_N_ALGOS,
 } tcp_cc_algorithm_type_e;
 
 typedef struct _tcp_cc_algorithm tcp_cc_algorithm_t;
 
+/** Size, in u64s, of the per connection congestion control data */
+#define TCP_CC_DATA_SZ 24
+
+/**
+ * Delivery rate sample, as in draft-cheng-iccrg-delivery-rate-estimation.
+ *
+ * One segment per round trip is tracked. When it is acked, the bytes
+ * delivered (acked or sacked) since it was sent, over the time elapsed
+ * since the delivery that preceded its transmission, give the rate.
+ */
+typedef struct _tcp_rate_sample
+{
+  u64 delivered;	/**< Bytes delivered during the interval */
+  f64 interval;		/**< Sample interval (s) */
+  f64 rtt;		/**< RTT of tracked segment (s), 0 if ambiguous */
+  u64 prior_delivered;	/**< Total delivered when tracked seg was sent */
+  u8 is_app_limited;	/**< Sender ran out of data during the interval */
+} tcp_rate_sample_t;
+
 typedef enum _tcp_cc_ack_t
 {
   TCP_CC_ACK,
@@ -292,6 +319,17 @@ typedef struct _tcp_connection
   u32 tsecr_last_ack;	/**< Timestamp echoed to us in last healthy ACK */
   u32 snd_congestion;	/**< snd_una_max when congestion is detected */
   tcp_cc_algorithm_t *cc_algo;	/**< Congestion control algorithm */
+  u64 cc_data[TCP_CC_DATA_SZ];	/**< Congestion control algo private data */
+
+  /* Delivery rate estimation */
+  u64 delivered;	/**< Total bytes delivered, i.e., acked or sacked */
+  f64 delivered_time;	/**< Time of last delivery */
+  u64 rs_prior_delivered; /**< delivered when tracked segment was sent */
+  f64 rs_prior_time;	/**< delivered_time when tracked segment was sent */
+  f64 rs_tx_time;	/**< Time tracked segment was sent */
+  u32 rs_seq;		/**< End sequence number of tracked segment */
+  u8 rs_tracking;	/**< A segment is tracked */
+  u8 rs_app_limited;	/**< Sender was app limited when tracking started */
 
   /* RTT and RTO */
   u32 rto;		/**< Retransmission timeout */
@@ -313,6 +351,10 @@ struct _tcp_cc_algorithm
   void (*congestion) (tcp_connection_t * tc);
   void (*recovered) (tcp_connection_t * tc);
   void (*init) (tcp_connection_t * tc);
+  /** Optional. If set, delivery rate is sampled once per round trip */
+  void (*rcv_rate_sample) (tcp_connection_t * tc, tcp_rate_sample_t * rs);
+  /** Optional. Tx pacing rate in bytes/s, 0 to use the default */
+  u64 (*pacing_rate) (tcp_connection_t * tc);
 };
 
 #define tcp_fastrecovery_on(tc) (tc)->flags |= TCP_CONN_FAST_RECOVERY
@@ -388,6 +430,13 @@ typedef struct _tcp_main
   /* Congestion control algorithms registered */
   tcp_cc_algorithm_t *cc_algos;
 
+  /** Algorithm used by new connections */
+  tcp_cc_algorithm_type_e cc_algo;
+
+  /** Per app namespace algorithm overrides, by namespace index. ~0 if
+   *  none */
+  u8 *appns_cc_algo;
+
   /* Flag that indicates if stack is on or off */
   u8 is_enabled;
 
@@ -642,6 +691,7 @@ fib_node_index_t tcp_lookup_rmt_in_fib (tcp_connection_t * tc);
 
 /* Made public for unit testing only */
 void tcp_update_sack_list (tcp_connection_t * tc, u32 start, u32 end);
+void tcp_rate_sample_update (tcp_connection_t * tc);
 
 always_inline u32
 tcp_time_now (void)
@@ -901,7 +951,27 @@ tcp_cc_algo_get (tcp_cc_algorithm_type_e type)
   return &tm->cc_algos[type];
 }
 
+always_inline void *
+tcp_cc_data (tcp_connection_t * tc)
+{
+  return (void *) tc->cc_data;
+}
+
 void tcp_cc_init (tcp_connection_t * tc);
+tcp_cc_algorithm_t *tcp_cc_algo_for_app (u32 app_index);
+void newreno_rcv_cong_ack (tcp_connection_t * tc, tcp_cc_ack_t ack_type);
+format_function_t format_tcp_cc_algo;
+unformat_function_t unformat_tcp_cc_algo;
+
+/**
+ * Time, in seconds, with the precision of the cpu clock. Used for
+ * delivery rate estimation where the tcp tick is too coarse.
+ */
+always_inline f64
+tcp_time_now_precise (void)
+{
+  return vlib_time_now (vlib_get_main ());
+}
 
 /**
  * Push TCP header to buffer
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * BBR congestion control, as in draft-cardwell-iccrg-bbr-congestion-control.
+ *
+ * Instead of reacting to loss, the sender models the path: the bottleneck
+ * bandwidth is the max delivery rate seen over the last BBR_BW_WINDOW
+ * rounds and the propagation delay is the min rtt seen over the last
+ * BBR_MIN_RTT_WINDOW seconds. cwnd is kept at a gain times their product.
+ *
+ * The stack hands us one delivery rate sample per round trip, so rounds
+ * are counted in samples and each PROBE_BW gain phase lasts one round.
+ */
+
+#include <vnet/tcp/tcp.h>
+
+#define BBR_HIGH_GAIN 2.885	/* 2/ln(2) */
+#define BBR_BW_WINDOW 10	/* Rounds */
+#define BBR_MIN_RTT_WINDOW 10.0	/* Seconds */
+#define BBR_PROBE_RTT_TIME 0.2	/* Seconds */
+#define BBR_FULL_BW_THRESH 1.25
+#define BBR_FULL_BW_ROUNDS 3
+#define BBR_MIN_CWND_SEGS 4
+#define BBR_CYCLE_LEN 8
+
+typedef enum bbr_mode_
+{
+  BBR_STARTUP,
+  BBR_DRAIN,
+  BBR_PROBE_BW,
+  BBR_PROBE_RTT,
+} bbr_mode_t;
+
+static const f64 bbr_pacing_gain_cycle[BBR_CYCLE_LEN] = {
+  1.25, 0.75, 1, 1, 1, 1, 1, 1
+};
+
+typedef struct bbr_data_
+{
+  f64 bw[BBR_BW_WINDOW];	/**< Delivery rate (B/s) sampled per round */
+  f64 min_rtt;			/**< Min rtt (s) in window */
+  f64 min_rtt_stamp;		/**< When min_rtt was sampled */
+  f64 full_bw;			/**< Bw at last startup growth check */
+  f64 probe_rtt_done;		/**< When PROBE_RTT ends, 0 if not known */
+  f64 pacing_rate;		/**< Target send rate (B/s) */
+  f64 pacing_gain;
+  f64 cwnd_gain;
+  u32 round;			/**< Rounds, i.e., rate samples, seen */
+  u32 prior_cwnd;		/**< cwnd before recovery or PROBE_RTT */
+  u8 mode;			/**< bbr_mode_t */
+  u8 cycle_index;		/**< PROBE_BW gain phase */
+  u8 full_bw_cnt;		/**< Rounds without bw growth in startup */
+  u8 full_bw_reached;		/**< Startup found the bottleneck bw */
+} bbr_data_t;
+
+STATIC_ASSERT (sizeof (bbr_data_t) <= TCP_CC_DATA_SZ * sizeof (u64),
+	       "bbr data len");
+
+static f64
+bbr_max_bw (bbr_data_t * bd)
+{
+  f64 bw = 0;
+  int i;
+
+  for (i = 0; i < BBR_BW_WINDOW; i++)
+    bw = clib_max (bw, bd->bw[i]);
+  return bw;
+}
+
+/**
+ * cwnd needed to keep gain times the bandwidth-delay product in flight,
+ * plus some headroom for delayed and stretched acks
+ */
+static u32
+bbr_target_cwnd (tcp_connection_t * tc, bbr_data_t * bd, f64 gain)
+{
+  f64 bw = bbr_max_bw (bd);
+  u32 target;
+
+  if (bw == 0 || bd->min_rtt == 0)
+    return tcp_initial_cwnd (tc);
+
+  target = gain * bw * bd->min_rtt + 3 * tc->snd_mss;
+  return clib_max (target, BBR_MIN_CWND_SEGS * tc->snd_mss);
+}
+
+static void
+bbr_save_cwnd (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  if (tcp_in_cong_recovery (tc) || bd->mode == BBR_PROBE_RTT)
+    bd->prior_cwnd = clib_max (bd->prior_cwnd, tc->cwnd);
+  else
+    bd->prior_cwnd = tc->cwnd;
+}
+
+static void
+bbr_enter_startup (bbr_data_t * bd)
+{
+  bd->mode = BBR_STARTUP;
+  bd->pacing_gain = BBR_HIGH_GAIN;
+  bd->cwnd_gain = BBR_HIGH_GAIN;
+}
+
+static void
+bbr_enter_probe_bw (tcp_connection_t * tc, bbr_data_t * bd)
+{
+  u32 seed = tcp_time_now () ^ tc->c_c_index;
+
+  bd->mode = BBR_PROBE_BW;
+  bd->cwnd_gain = 2;
+  /* Start at a random phase, but not the one that drains the queue */
+  bd->cycle_index = BBR_CYCLE_LEN - 1 - random_u32 (&seed)
+    % (BBR_CYCLE_LEN - 1);
+  bd->pacing_gain = bbr_pacing_gain_cycle[bd->cycle_index];
+}
+
+static void
+bbr_rcv_rate_sample (tcp_connection_t * tc, tcp_rate_sample_t * rs)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  f64 bw, max_bw, now = tcp_time_now_precise ();
+  u8 min_rtt_expired;
+  u32 slot;
+
+  bd->round++;
+
+  /* Windowed max filter. App limited samples underestimate the path, so
+   * they only count if they raise the max */
+  bw = rs->delivered / rs->interval;
+  slot = bd->round % BBR_BW_WINDOW;
+  bd->bw[slot] = 0;
+  if (!rs->is_app_limited || bw >= bbr_max_bw (bd))
+    bd->bw[slot] = bw;
+  max_bw = bbr_max_bw (bd);
+
+  min_rtt_expired = now > bd->min_rtt_stamp + BBR_MIN_RTT_WINDOW;
+  if (rs->rtt && (rs->rtt < bd->min_rtt || bd->min_rtt == 0
+		  || min_rtt_expired))
+    {
+      bd->min_rtt = rs->rtt;
+      bd->min_rtt_stamp = now;
+    }
+
+  /* Pipe is full when bw stops growing by 25% for 3 rounds */
+  if (!bd->full_bw_reached && !rs->is_app_limited)
+    {
+      if (max_bw >= bd->full_bw * BBR_FULL_BW_THRESH)
+	{
+	  bd->full_bw = max_bw;
+	  bd->full_bw_cnt = 0;
+	}
+      else if (++bd->full_bw_cnt >= BBR_FULL_BW_ROUNDS)
+	bd->full_bw_reached = 1;
+    }
+
+  switch (bd->mode)
+    {
+    case BBR_STARTUP:
+      if (bd->full_bw_reached)
+	{
+	  bd->mode = BBR_DRAIN;
+	  bd->pacing_gain = 1 / BBR_HIGH_GAIN;
+	  bd->cwnd_gain = BBR_HIGH_GAIN;
+	}
+      break;
+    case BBR_PROBE_BW:
+      bd->cycle_index = (bd->cycle_index + 1) % BBR_CYCLE_LEN;
+      bd->pacing_gain = bbr_pacing_gain_cycle[bd->cycle_index];
+      break;
+    default:
+      break;
+    }
+
+  /* Drain the queue startup built before probing */
+  if (bd->mode == BBR_DRAIN
+      && tcp_flight_size (tc) <= bbr_target_cwnd (tc, bd, 1))
+    bbr_enter_probe_bw (tc, bd);
+
+  /* Haven't seen a lower rtt in a while. Drain the pipe to measure it */
+  if (min_rtt_expired && bd->mode != BBR_PROBE_RTT)
+    {
+      bbr_save_cwnd (tc, bd);
+      bd->mode = BBR_PROBE_RTT;
+      bd->pacing_gain = 1;
+      bd->cwnd_gain = 1;
+      bd->probe_rtt_done = 0;
+    }
+
+  if (bd->mode == BBR_PROBE_RTT)
+    {
+      if (!bd->probe_rtt_done
+	  && tcp_flight_size (tc) <= BBR_MIN_CWND_SEGS * tc->snd_mss)
+	bd->probe_rtt_done = now + BBR_PROBE_RTT_TIME;
+      else if (bd->probe_rtt_done && now >= bd->probe_rtt_done)
+	{
+	  bd->min_rtt_stamp = now;
+	  tc->cwnd = clib_max (tc->cwnd, bd->prior_cwnd);
+	  if (bd->full_bw_reached)
+	    bbr_enter_probe_bw (tc, bd);
+	  else
+	    bbr_enter_startup (bd);
+	}
+    }
+
+  if (max_bw)
+    bd->pacing_rate = bd->pacing_gain * max_bw;
+}
+
+static void
+bbr_rcv_ack (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  u32 target, min_cwnd = BBR_MIN_CWND_SEGS * tc->snd_mss;
+
+  target = bbr_target_cwnd (tc, bd, bd->cwnd_gain);
+
+  /* Once the pipe is full, cwnd tracks the model. Before that, grow like
+   * slow start but don't overshoot the model */
+  if (bd->full_bw_reached)
+    tc->cwnd = clib_min (tc->cwnd + tc->bytes_acked, target);
+  else if (tc->cwnd < target)
+    tc->cwnd += tc->bytes_acked;
+
+  tc->cwnd = clib_max (tc->cwnd, min_cwnd);
+  if (bd->mode == BBR_PROBE_RTT)
+    tc->cwnd = clib_min (tc->cwnd, min_cwnd);
+}
+
+/**
+ * Loss is not a congestion signal for the model, but while recovering
+ * send only as much as was delivered (packet conservation).
+ */
+static void
+bbr_congestion (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  bbr_save_cwnd (tc, bd);
+  tc->ssthresh = clib_max (tcp_flight_size (tc),
+			   BBR_MIN_CWND_SEGS * tc->snd_mss);
+}
+
+static void
+bbr_recovered (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  tc->cwnd = clib_max (tc->cwnd, bd->prior_cwnd);
+}
+
+static void
+bbr_rcv_cong_ack (tcp_connection_t * tc, tcp_cc_ack_t ack_type)
+{
+  if (ack_type == TCP_CC_PARTIALACK)
+    tc->cwnd = clib_max (tcp_flight_size (tc) + tc->bytes_acked,
+			 BBR_MIN_CWND_SEGS * tc->snd_mss);
+  else
+    newreno_rcv_cong_ack (tc, ack_type);
+}
+
+static u64
+bbr_pacing_rate (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+  return bd->pacing_rate;
+}
+
+static void
+bbr_conn_init (tcp_connection_t * tc)
+{
+  bbr_data_t *bd = (bbr_data_t *) tcp_cc_data (tc);
+
+  tc->ssthresh = tc->snd_wnd;
+  tc->cwnd = tcp_initial_cwnd (tc);
+  bd->min_rtt_stamp = tcp_time_now_precise ();
+  bbr_enter_startup (bd);
+}
+
+const static tcp_cc_algorithm_t tcp_bbr = {
+  .congestion = bbr_congestion,
+  .recovered = bbr_recovered,
+  .rcv_ack = bbr_rcv_ack,
+  .rcv_cong_ack = bbr_rcv_cong_ack,
+  .init = bbr_conn_init,
+  .rcv_rate_sample = bbr_rcv_rate_sample,
+  .pacing_rate = bbr_pacing_rate,
+};
+
+clib_error_t *
+bbr_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_BBR, &tcp_bbr);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (bbr_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
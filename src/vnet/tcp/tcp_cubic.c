@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * CUBIC congestion control as per RFC8312. Windows are kept in bytes by
+ * the connection and converted to snd_mss sized segments here.
+ */
+
+#include <vnet/tcp/tcp.h>
+#include <math.h>
+
+#define beta_cubic 0.7
+#define cubic_c 0.4
+#define west_const (3 * (1 - beta_cubic) / (1 + beta_cubic))
+
+typedef struct cubic_data_
+{
+  /** Time period (in seconds) needed to increase the current window
+   *  size to W_max if there are no further congestion events */
+  f64 K;
+
+  /** Time (in seconds) when the current congestion avoidance epoch
+   *  started */
+  f64 t_start;
+
+  /** Inflection point of the cubic function (in snd_mss segments) */
+  f64 w_max;
+
+  /** Congestion avoidance epoch started */
+  u8 in_epoch;
+} cubic_data_t;
+
+STATIC_ASSERT (sizeof (cubic_data_t) <= TCP_CC_DATA_SZ * sizeof (u64),
+	       "cubic data len");
+
+static inline f64
+cubic_time (void)
+{
+  return tcp_time_now () * TCP_TICK;
+}
+
+/**
+ * RFC 8312 Eq. 1
+ *
+ * CUBIC window increase function. Time and K need to be provided in seconds.
+ */
+static inline f64
+W_cubic (cubic_data_t * cd, f64 t)
+{
+  f64 diff = t - cd->K;
+
+  /* W_cubic(t) = C*(t-K)^3 + W_max */
+  return cubic_c * diff * diff * diff + cd->w_max;
+}
+
+/**
+ * RFC 8312 Eq. 2, generalized to epochs that start with window w instead
+ * of W_max*beta_cubic, e.g., after an RTO or when slow start ends.
+ */
+static inline f64
+K_cubic (cubic_data_t * cd, f64 w)
+{
+  /* K = cubic_root((W_max - w)/C) */
+  if (cd->w_max <= w)
+    return 0;
+  return cbrt ((cd->w_max - w) / cubic_c);
+}
+
+/**
+ * RFC 8312 Eq. 4
+ *
+ * Estimates the window size of a standard TCP. Time and rtt in seconds.
+ */
+static inline f64
+W_est (cubic_data_t * cd, f64 t, f64 rtt)
+{
+  /* W_est(t) = W_max*beta_cubic+[3*(1-beta_cubic)/(1+beta_cubic)]*(t/RTT) */
+  return cd->w_max * beta_cubic + west_const * (t / rtt);
+}
+
+static void
+cubic_congestion (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  f64 w = (f64) tc->cwnd / tc->snd_mss;
+
+  /* Fast convergence, RFC 8312 Sec. 4.6. If the window didn't get back
+   * to W_max since the last loss, release bandwidth to new flows */
+  if (w < cd->w_max)
+    cd->w_max = w * (1 + beta_cubic) / 2;
+  else
+    cd->w_max = w;
+
+  tc->ssthresh = clib_max (tc->cwnd * beta_cubic, 2 * tc->snd_mss);
+  cd->in_epoch = 0;
+}
+
+static void
+cubic_recovered (tcp_connection_t * tc)
+{
+  tc->cwnd = tc->ssthresh;
+}
+
+static void
+cubic_epoch_start (tcp_connection_t * tc, cubic_data_t * cd)
+{
+  f64 w = (f64) tc->cwnd / tc->snd_mss;
+
+  /* No loss yet or window already beyond last W_max, probe from here */
+  if (cd->w_max < w)
+    cd->w_max = w;
+
+  cd->K = K_cubic (cd, w);
+  cd->t_start = cubic_time ();
+  cd->in_epoch = 1;
+}
+
+static void
+cubic_rcv_ack (tcp_connection_t * tc)
+{
+  cubic_data_t *cd = (cubic_data_t *) tcp_cc_data (tc);
+  f64 t, rtt, target;
+  u64 inc;
+
+  if (tcp_in_slowstart (tc))
+    {
+      tc->cwnd += clib_min (tc->snd_mss, tc->bytes_acked);
+      return;
+    }
+
+  if (!cd->in_epoch)
+    cubic_epoch_start (tc, cd);
+
+  t = cubic_time () - cd->t_start;
+  rtt = clib_max (tc->srtt, 1) * TCP_TICK;
+
+  /* Target window one rtt from now, or what a standard TCP would have if
+   * that's larger (TCP-friendly region, RFC 8312 Sec. 4.2) */
+  target = clib_max (W_cubic (cd, t + rtt), W_est (cd, t, rtt));
+  target *= tc->snd_mss;
+
+  /* Don't grow faster than slow start would (RFC 8312 Sec. 4.3) */
+  target = clib_min (target, 1.5 * tc->cwnd);
+  if (target <= tc->cwnd)
+    return;
+
+  /* Grow by (target - cwnd)/cwnd for each segment acked */
+  inc = (target - tc->cwnd) * tc->bytes_acked / tc->cwnd;
+  tc->cwnd += clib_max (inc, 1);
+}
+
+static void
+cubic_conn_init (tcp_connection_t * tc)
+{
+  tc->ssthresh = tc->snd_wnd;
+  tc->cwnd = tcp_initial_cwnd (tc);
+}
+
+const static tcp_cc_algorithm_t tcp_cubic = {
+  .congestion = cubic_congestion,
+  .recovered = cubic_recovered,
+  .rcv_ack = cubic_rcv_ack,
+  .rcv_cong_ack = newreno_rcv_cong_ack,
+  .init = cubic_conn_init
+};
+
+clib_error_t *
+cubic_init (vlib_main_t * vm)
+{
+  clib_error_t *error = 0;
+
+  tcp_cc_algo_register (TCP_CC_CUBIC, &tcp_cubic);
+
+  return error;
+}
+
+VLIB_INIT_FUNCTION (cubic_init);
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
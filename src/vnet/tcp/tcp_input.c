@@ -1196,13 +1196,65 @@ partial_ack:
   tcp_fast_retransmit (tc);
 }
 
+/**
+ * Initialize the connection's congestion control algorithm, the default
+ * one unless its app or app namespace picked one when it was set up.
+ */
 void
 tcp_cc_init (tcp_connection_t * tc)
 {
-  tc->cc_algo = tcp_cc_algo_get (TCP_CC_NEWRENO);
+  tcp_main_t *tm = vnet_get_tcp_main ();
+
+  /* Unless picked for the connection's app when it was set up */
+  if (!tc->cc_algo)
+    tc->cc_algo = tcp_cc_algo_get (tm->cc_algo);
+  memset (tc->cc_data, 0, sizeof (tc->cc_data));
+  tc->delivered = 0;
+  tc->rs_tracking = 0;
+  if (tc->cc_algo->rcv_rate_sample)
+    tc->delivered_time = tcp_time_now_precise ();
   tc->cc_algo->init (tc);
 }
 
+/**
+ * Account for the bytes delivered by an ack and, if it acks the tracked
+ * segment, hand a delivery rate sample to the congestion control algorithm.
+ */
+void
+tcp_rate_sample_update (tcp_connection_t * tc)
+{
+  sack_scoreboard_t *sb = &tc->sack_sb;
+  tcp_rate_sample_t rs;
+  int delivered;
+  f64 now;
+
+  /* Previously sacked bytes that are now cumulatively acked were counted
+   * when they were sacked */
+  delivered = tc->bytes_acked + sb->snd_una_adv + sb->last_sacked_bytes
+    - sb->last_bytes_delivered;
+  if (delivered <= 0)
+    return;
+
+  now = tcp_time_now_precise ();
+  tc->delivered += delivered;
+  tc->delivered_time = now;
+
+  if (!tc->rs_tracking || seq_leq (tc->snd_una, tc->rs_seq))
+    return;
+
+  tc->rs_tracking = 0;
+  rs.delivered = tc->delivered - tc->rs_prior_delivered;
+  rs.interval = now - tc->rs_prior_time;
+  rs.prior_delivered = tc->rs_prior_delivered;
+  rs.is_app_limited = tc->rs_app_limited;
+  /* Karn's rule: tracked segment may have been retransmitted */
+  rs.rtt = tcp_in_cong_recovery (tc) ? 0 : now - tc->rs_tx_time;
+  if (rs.interval <= 0)
+    return;
+
+  tc->cc_algo->rcv_rate_sample (tc, &rs);
+}
+
 /**
  * Process incoming ACK
  */
@@ -1272,6 +1324,9 @@ tcp_rcv_ack (tcp_connection_t * tc, vlib_buffer_t * b,
   if (tc->bytes_acked)
     tcp_dequeue_acked (tc, vnet_buffer (b)->tcp.ack_number);
 
+  if (tc->cc_algo->rcv_rate_sample)
+    tcp_rate_sample_update (tc);
+
   TCP_EVT_DBG (TCP_EVT_ACK_RCVD, tc);
 
   /*
@@ -2105,6 +2160,9 @@ tcp46_syn_sent_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  new_tc0->snd_wl1 = seq0;
 	  new_tc0->snd_wl2 = ack0;
 
+	  /* The half-open handle has the index of the app connecting */
+	  new_tc0->cc_algo = tcp_cc_algo_for_app
+	    (session_lookup_half_open_handle (&new_tc0->connection) >> 32);
 	  tcp_connection_init_vars (new_tc0);
 
 	  /* SYN-ACK: See if we can switch to ESTABLISHED state */
@@ -2685,6 +2743,7 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  ip4_header_t *ip40;
 	  ip6_header_t *ip60;
 	  tcp_connection_t *child0;
+	  stream_session_t *ls0;
 	  u32 error0 = TCP_ERROR_SYNS_RCVD, next0 = TCP_LISTEN_NEXT_DROP;
 
 	  bi0 = from[0];
@@ -2738,6 +2797,7 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  child0->c_lcl_port = th0->dst_port;
 	  child0->c_rmt_port = th0->src_port;
 	  child0->c_is_ip4 = is_ip4;
+	  child0->c_fib_index = lc0->c_fib_index;
 	  child0->state = TCP_STATE_SYN_RCVD;
 
 	  if (is_ip4)
@@ -2779,6 +2839,11 @@ tcp46_listen_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  child0->snd_wl1 = vnet_buffer (b0)->tcp.seq_number;
 	  child0->snd_wl2 = vnet_buffer (b0)->tcp.ack_number;
 
+	  /* The listener's session has the index of the app accepting */
+	  ls0 = listen_session_get (session_type_from_proto_and_ip
+				    (TRANSPORT_PROTO_TCP, lc0->c_is_ip4),
+				    lc0->c_s_index);
+	  child0->cc_algo = tcp_cc_algo_for_app (ls0->app_index);
 	  tcp_connection_init_vars (child0);
 	  TCP_EVT_DBG (TCP_EVT_SYN_RCVD, child0, 1);
 
@@ -1341,10 +1341,11 @@ tcp_rtx_timeout_cc (tcp_connection_t * tc)
     tcp_cc_fastrecovery_exit (tc);
 
   /* Start again from the beginning */
-  tc->ssthresh = clib_max (tcp_flight_size (tc) / 2, 2 * tc->snd_mss);
+  tc->cc_algo->congestion (tc);
   tc->cwnd = tcp_loss_wnd (tc);
   tc->snd_congestion = tc->snd_una_max;
   tc->rtt_ts = 0;
+  tc->rs_tracking = 0;
   tcp_recovery_on (tc);
 }
 
@@ -1961,12 +1962,49 @@ VLIB_REGISTER_NODE (tcp6_output_node) =
 
 VLIB_NODE_FUNCTION_MULTIARCH (tcp6_output_node, tcp6_output);
 
+/**
+ * Start tracking a segment for delivery rate estimation, if none is.
+ *
+ * Called before the segment's header is pushed, so snd_nxt is its first
+ * byte. The sample ends when that byte is acked.
+ */
+static void
+tcp_rate_sample_track (tcp_connection_t * tc)
+{
+  int unsent;
+  f64 now;
+
+  if (tc->rs_tracking && tc->snd_una != tc->snd_nxt)
+    return;
+
+  now = tcp_time_now_precise ();
+
+  /* Nothing in flight, so nothing can be delivered before now */
+  if (tc->snd_una == tc->snd_nxt)
+    tc->delivered_time = now;
+
+  tc->rs_tracking = 1;
+  tc->rs_seq = tc->snd_nxt;
+  tc->rs_tx_time = now;
+  tc->rs_prior_delivered = tc->delivered;
+  tc->rs_prior_time = tc->delivered_time;
+
+  /* App limited if this is the last segment the app gave us and cwnd
+   * would've allowed more */
+  unsent = stream_session_tx_fifo_max_dequeue (&tc->connection)
+    - (tc->snd_nxt - tc->snd_una);
+  tc->rs_app_limited = unsent <= tc->snd_mss
+    && tcp_flight_size (tc) + tc->snd_mss < tc->cwnd;
+}
+
 u32
 tcp_push_header (transport_connection_t * tconn, vlib_buffer_t * b)
 {
   tcp_connection_t *tc;
 
   tc = (tcp_connection_t *) tconn;
+  if (tc->cc_algo->rcv_rate_sample)
+    tcp_rate_sample_track (tc);
   tcp_push_hdr_i (tc, b, TCP_STATE_ESTABLISHED, 0);
   ASSERT (seq_leq (tc->snd_una_max, tc->snd_una + tc->snd_wnd));
 
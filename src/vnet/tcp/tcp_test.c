@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 #include <vnet/tcp/tcp.h>
+#include <math.h>
 
 #define TCP_TEST_I(_cond, _comment, _args...)			\
 ({								\
@@ -34,6 +35,8 @@
     }								\
 }
 
+#define TCP_TEST_BBR_RTT 0.1
+
 /* *INDENT-OFF* */
 scoreboard_trace_elt_t sb_trace[] = {};
 /* *INDENT-ON* */
@@ -1426,6 +1429,90 @@ tcp_test_fifo5 (vlib_main_t * vm, unformat_input_t * input)
   return 0;
 }
 
+static int
+tcp_test_fifo6 (vlib_main_t * vm, unformat_input_t * input)
+{
+  svm_fifo_t *f;
+  u32 fifo_size = 400, j = 0, offset = 350, n_bytes;
+  int i, rv, verbose = 0;
+  u8 *test_data = 0, *data_buf = 0;
+  svm_fifo_seg_t fs[2];
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	{
+	  clib_error_t *e = clib_error_return
+	    (0, "unknown input `%U'", format_unformat_error, input);
+	  clib_error_report (e);
+	  return -1;
+	}
+    }
+
+  f = fifo_prepare (fifo_size);
+  svm_fifo_init_pointers (f, offset);
+
+  vec_validate (test_data, 199);
+  for (i = 0; i < vec_len (test_data); i++)
+    test_data[i] = i % 0xff;
+
+  /*
+   * Enqueue 200 bytes starting 50 bytes before the end, so data wraps
+   */
+  rv = svm_fifo_enqueue_nowait (f, 200, test_data);
+  TCP_TEST ((rv == 200), "enqueued %u expected %u", rv, 200);
+
+  if (verbose)
+    vlib_cli_output (vm, "fifo: %U", format_svm_fifo, f, 1);
+
+  /*
+   * Segments from the head: 50 bytes to the end, 150 after the wrap
+   */
+  n_bytes = svm_fifo_segments (f, 0, 400, fs);
+  TCP_TEST ((n_bytes == 200), "referenced %u expected %u", n_bytes, 200);
+  TCP_TEST ((fs[0].len == 50), "first seg len %u expected %u", fs[0].len,
+	    50);
+  TCP_TEST ((fs[1].len == 150), "second seg len %u expected %u", fs[1].len,
+	    150);
+  TCP_TEST ((fs[1].data == f->data), "second seg starts at fifo start");
+
+  vec_validate (data_buf, 199);
+  clib_memcpy (data_buf, fs[0].data, fs[0].len);
+  clib_memcpy (data_buf + fs[0].len, fs[1].data, fs[1].len);
+  if (compare_data (data_buf, test_data, 0, 200, &j))
+    {
+      TCP_TEST (0, "[%d] referenced %u expected %u", j, data_buf[j],
+		test_data[j]);
+    }
+
+  /*
+   * Segments at an offset past the wrap, limited by max_bytes
+   */
+  n_bytes = svm_fifo_segments (f, 60, 100, fs);
+  TCP_TEST ((n_bytes == 100), "referenced %u expected %u", n_bytes, 100);
+  TCP_TEST ((fs[0].len == 100 && fs[1].len == 0), "seg lens %u %u "
+	    "expected %u %u", fs[0].len, fs[1].len, 100, 0);
+  if (compare_data (fs[0].data, &test_data[60], 0, 100, &j))
+    {
+      TCP_TEST (0, "[%d] referenced %u expected %u", j, fs[0].data[j],
+		test_data[60 + j]);
+    }
+
+  /*
+   * Offset at or beyond the data references nothing
+   */
+  n_bytes = svm_fifo_segments (f, 200, 100, fs);
+  TCP_TEST ((n_bytes == 0 && fs[0].len == 0 && fs[1].len == 0),
+	    "referenced %u expected %u", n_bytes, 0);
+
+  svm_fifo_free (f);
+  vec_free (data_buf);
+  vec_free (test_data);
+  return 0;
+}
+
 /* *INDENT-OFF* */
 svm_fifo_trace_elem_t fifo_trace[] = {};
 /* *INDENT-ON* */
@@ -1518,6 +1605,10 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
       res = tcp_test_fifo5 (vm, input);
       if (res)
 	return res;
+
+      res = tcp_test_fifo6 (vm, input);
+      if (res)
+	return res;
     }
   else
     {
@@ -1541,6 +1632,10 @@ tcp_test_fifo (vlib_main_t * vm, unformat_input_t * input)
 	{
 	  res = tcp_test_fifo5 (vm, input);
 	}
+      else if (unformat (input, "fifo6"))
+	{
+	  res = tcp_test_fifo6 (vm, input);
+	}
       else if (unformat (input, "replay"))
 	{
 	  res = tcp_test_fifo_replay (vm, input);
@@ -1706,6 +1801,239 @@ tcp_test_session (vlib_main_t * vm, unformat_input_t * input)
   return rv;
 }
 
+/**
+ * Expected cubic window, in segments, t seconds into an epoch that started
+ * at window w after a loss at w_max
+ */
+static f64
+tcp_test_cubic_w (f64 w_max, f64 w, f64 t)
+{
+  f64 K = cbrt ((w_max - w) / 0.4);
+  return 0.4 * (t - K) * (t - K) * (t - K) + w_max;
+}
+
+static int
+tcp_test_cc_cubic (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_main_t *tm = vnet_get_tcp_main ();
+  u32 thread_index = vlib_get_thread_index ();
+  tcp_connection_t _tc, *tc = &_tc;
+  u32 t0, mss = 1000;
+  f64 rtt, t, w;
+
+  memset (tc, 0, sizeof (*tc));
+  tc->snd_mss = mss;
+  tc->snd_wnd = 1 << 30;
+  tc->srtt = 100;
+  tc->cc_algo = tcp_cc_algo_get (TCP_CC_CUBIC);
+  tcp_cc_init (tc);
+  rtt = tc->srtt * TCP_TICK;
+
+  /* Cubic time is the tcp tick, so the test drives the clock */
+  t0 = tcp_time_now ();
+
+  /*
+   * Slow start, then a loss at 100 segments
+   */
+  tc->bytes_acked = mss;
+  tc->cc_algo->rcv_ack (tc);
+  TCP_TEST ((tc->cwnd == 5 * mss), "slow start cwnd %u", tc->cwnd);
+
+  tc->cwnd = 100 * mss;
+  tc->cc_algo->congestion (tc);
+  TCP_TEST ((tc->ssthresh == 70 * mss), "ssthresh %u", tc->ssthresh);
+  tc->cc_algo->recovered (tc);
+  TCP_TEST ((tc->cwnd == 70 * mss), "recovered cwnd %u", tc->cwnd);
+
+  /*
+   * Acking a window's worth of bytes takes cwnd to W(t + rtt). The first
+   * ack starts the epoch, so K = cbrt((100 - 70) / C)
+   */
+  tc->bytes_acked = tc->cwnd;
+  tc->cc_algo->rcv_ack (tc);
+  w = tcp_test_cubic_w (100, 70, rtt) * mss;
+  TCP_TEST ((fabs (tc->cwnd - w) < 2), "epoch start cwnd %u expected %.1f",
+	    tc->cwnd, w);
+
+  /* Concave region, below W_max */
+  tm->time_now[thread_index] = t0 + 2000;
+  tc->bytes_acked = tc->cwnd;
+  tc->cc_algo->rcv_ack (tc);
+  w = tcp_test_cubic_w (100, 70, 2 + rtt) * mss;
+  TCP_TEST ((w < 100 * mss && fabs (tc->cwnd - w) < 2),
+	    "concave cwnd %u expected %.1f", tc->cwnd, w);
+
+  /* Convex region, a second past K */
+  t = cbrt (30 / 0.4) + 1 - rtt;
+  tm->time_now[thread_index] = t0 + (u32) (t / TCP_TICK);
+  t = (u32) (t / TCP_TICK) * TCP_TICK;
+  tc->bytes_acked = tc->cwnd;
+  tc->cc_algo->rcv_ack (tc);
+  w = tcp_test_cubic_w (100, 70, t + rtt) * mss;
+  TCP_TEST ((w > 100 * mss && fabs (tc->cwnd - w) < 2),
+	    "convex cwnd %u expected %.1f", tc->cwnd, w);
+
+  /*
+   * Loss below the last W_max. Fast convergence lowers W_max to
+   * 80 * (1 + 0.7) / 2 segments
+   */
+  tc->cwnd = 80 * mss;
+  tc->cc_algo->congestion (tc);
+  TCP_TEST ((tc->ssthresh == 56 * mss), "ssthresh %u", tc->ssthresh);
+  tc->cc_algo->recovered (tc);
+
+  tm->time_now[thread_index] = t0 + 10000;
+  tc->bytes_acked = tc->cwnd;
+  tc->cc_algo->rcv_ack (tc);
+  w = tcp_test_cubic_w (68, 56, rtt) * mss;
+  TCP_TEST ((fabs (tc->cwnd - w) < 2),
+	    "fast convergence cwnd %u expected %.1f", tc->cwnd, w);
+
+  tm->time_now[thread_index] = t0;
+  return 0;
+}
+
+/**
+ * Ack delivered bytes sent one bbr test rtt ago, with flight bytes left
+ * in flight, so the ack completes a delivery rate sample
+ */
+static void
+tcp_test_bbr_sample (tcp_connection_t * tc, u32 delivered, u32 flight,
+		     u8 app_limited)
+{
+  f64 now = tcp_time_now_precise ();
+
+  tc->rs_tracking = 1;
+  tc->rs_seq = tc->snd_una;
+  tc->rs_tx_time = now - TCP_TEST_BBR_RTT;
+  tc->rs_prior_time = now - TCP_TEST_BBR_RTT;
+  tc->rs_prior_delivered = tc->delivered;
+  tc->rs_app_limited = app_limited;
+
+  tc->bytes_acked = delivered;
+  tc->snd_una += delivered;
+  tc->snd_nxt = tc->snd_una_max = tc->snd_una + flight;
+  tcp_rate_sample_update (tc);
+}
+
+/**
+ * Pacing gain bbr is using, i.e., pacing rate over bottleneck bandwidth
+ */
+static int
+tcp_test_bbr_gain_is (tcp_connection_t * tc, f64 bw, f64 gain)
+{
+  f64 rate = tc->cc_algo->pacing_rate (tc);
+  return fabs (rate / bw - gain) < 0.01;
+}
+
+static int
+tcp_test_cc_bbr (vlib_main_t * vm, unformat_input_t * input)
+{
+  tcp_connection_t _tc, *tc = &_tc;
+  u32 i, mss = 1000, delivered = 10000, n_probe = 0, n_drain = 0;
+  f64 bw;
+
+  memset (tc, 0, sizeof (*tc));
+  tc->snd_mss = mss;
+  tc->snd_wnd = 1 << 30;
+  tc->cc_algo = tcp_cc_algo_get (TCP_CC_BBR);
+  tcp_cc_init (tc);
+
+  /*
+   * Startup, bw doubles every round
+   */
+  for (i = 0; i < 4; i++)
+    {
+      tcp_test_bbr_sample (tc, delivered, 1 << 20, 0);
+      bw = delivered / TCP_TEST_BBR_RTT;
+      TCP_TEST (tcp_test_bbr_gain_is (tc, bw, 2.885),
+		"startup round %u gain 2.885", i);
+      delivered *= 2;
+    }
+  delivered /= 2;
+
+  /* App limited rounds don't show the pipe is full */
+  for (i = 0; i < 4; i++)
+    {
+      tcp_test_bbr_sample (tc, delivered, 1 << 20, 1);
+      TCP_TEST (tcp_test_bbr_gain_is (tc, bw, 2.885),
+		"app limited round %u still in startup", i);
+    }
+
+  /*
+   * Three rounds without 25% bw growth fill the pipe. Drain until
+   * flight size is down to the bandwidth-delay product
+   */
+  for (i = 0; i < 2; i++)
+    {
+      tcp_test_bbr_sample (tc, delivered, 1 << 20, 0);
+      TCP_TEST (tcp_test_bbr_gain_is (tc, bw, 2.885),
+		"flat round %u still in startup", i);
+    }
+  tcp_test_bbr_sample (tc, delivered, 1 << 20, 0);
+  TCP_TEST (tcp_test_bbr_gain_is (tc, bw, 1 / 2.885), "drain");
+  tcp_test_bbr_sample (tc, delivered, 1 << 20, 0);
+  TCP_TEST (tcp_test_bbr_gain_is (tc, bw, 1 / 2.885), "still draining");
+
+  /*
+   * Probe bw. Starts at a random phase of the 8 round gain cycle, not the
+   * one that probes up, then walks the whole cycle
+   */
+  tcp_test_bbr_sample (tc, delivered, delivered / 2, 0);
+  TCP_TEST (tcp_test_bbr_gain_is (tc, bw, 1)
+	    || tcp_test_bbr_gain_is (tc, bw, 0.75), "probe bw");
+  for (i = 0; i < 8; i++)
+    {
+      tcp_test_bbr_sample (tc, delivered, delivered, 0);
+      n_probe += tcp_test_bbr_gain_is (tc, bw, 1.25);
+      n_drain += tcp_test_bbr_gain_is (tc, bw, 0.75);
+    }
+  TCP_TEST ((n_probe == 1 && n_drain == 1),
+	    "gain cycle probes %u drains %u", n_probe, n_drain);
+
+  /* cwnd follows the model, twice the bdp plus 3 segments */
+  tc->cwnd = 1 << 20;
+  tc->bytes_acked = mss;
+  tc->cc_algo->rcv_ack (tc);
+  TCP_TEST ((fabs (tc->cwnd - (2 * delivered + 3 * mss)) < 0.01 * tc->cwnd),
+	    "probe bw cwnd %u expected %u", tc->cwnd, 2 * delivered + 3 * mss);
+
+  return 0;
+}
+
+static int
+tcp_test_cc (vlib_main_t * vm, unformat_input_t * input)
+{
+  int res = 0;
+
+  /* Run all tests */
+  if (unformat_check_input (input) == UNFORMAT_END_OF_INPUT)
+    {
+      if (tcp_test_cc_cubic (vm, input))
+	{
+	  return -1;
+	}
+
+      if (tcp_test_cc_bbr (vm, input))
+	{
+	  return -1;
+	}
+    }
+  else
+    {
+      if (unformat (input, "cubic"))
+	{
+	  res = tcp_test_cc_cubic (vm, input);
+	}
+      else if (unformat (input, "bbr"))
+	{
+	  res = tcp_test_cc_bbr (vm, input);
+	}
+    }
+
+  return res;
+}
+
 static clib_error_t *
 tcp_test (vlib_main_t * vm,
 	  unformat_input_t * input, vlib_cli_command_t * cmd_arg)
@@ -1730,6 +2058,10 @@ tcp_test (vlib_main_t * vm,
 	{
 	  res = tcp_test_lookup (vm, input);
 	}
+      else if (unformat (input, "cc"))
+	{
+	  res = tcp_test_cc (vm, input);
+	}
       else
 	break;
     }
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <vppinfra/format.h>
+#include <svm/ssvm.h>
+#include <vpp/stats/stat_client.h>
+
+int
+stat_segment_connect (stat_client_main_t * sm, char *name)
+{
+  ssvm_shared_header_t *sh;
+  struct stat st;
+  void *base;
+  int fd, rv;
+
+  memset (sm, 0, sizeof (*sm));
+
+  if ((fd = shm_open (name, O_RDONLY, 0)) < 0)
+    return -errno;
+
+  if (fstat (fd, &st) < 0)
+    {
+      rv = -errno;
+      close (fd);
+      return rv;
+    }
+
+  base = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (base == MAP_FAILED)
+    return -errno;
+
+  sh = base;
+  if (st.st_size < sizeof (*sh) || !sh->ready)
+    {
+      munmap (base, st.st_size);
+      return -EAGAIN;
+    }
+
+  sm->base = base;
+  sm->size = st.st_size;
+  sm->master_base = sh->ssvm_va;
+  sm->shared_header =
+    stat_segment_pointer (base, sm->master_base, sm->size,
+			  sh->opaque[STAT_SEGMENT_OPAQUE_HEADER],
+			  sizeof (stat_segment_shared_header_t));
+  if (sm->shared_header == 0)
+    {
+      stat_segment_disconnect (sm);
+      return -EINVAL;
+    }
+  sm->name = format (0, "%s", name);
+  return 0;
+}
+
+void
+stat_segment_disconnect (stat_client_main_t * sm)
+{
+  if (sm->base)
+    munmap (sm->base, sm->size);
+  vec_free (sm->name);
+  memset (sm, 0, sizeof (*sm));
+}
+
+/* Local address and length of the directory, 0 if inconsistent */
+static stat_segment_directory_entry_t *
+stat_segment_directory (stat_client_main_t * sm, uword * n_entries)
+{
+  void *directory = sm->shared_header->directory;
+  uword n;
+
+  n = stat_segment_vec_len (sm->base, sm->master_base, sm->size, directory);
+  *n_entries = n;
+  return stat_segment_pointer (sm->base, sm->master_base, sm->size,
+			       directory, n * sizeof
+			       (stat_segment_directory_entry_t));
+}
+
+/* Names read during an update may not be terminated */
+static u8 *
+stat_segment_entry_name (stat_segment_directory_entry_t * ep)
+{
+  u8 *name = 0;
+
+  vec_add (name, ep->name, strnlen (ep->name, STAT_SEGMENT_NAME_LEN));
+  return name;
+}
+
+u8 **
+stat_segment_ls (stat_client_main_t * sm)
+{
+  stat_segment_directory_entry_t *directory;
+  u8 **names = 0;
+  uword i, n;
+  u64 epoch;
+
+  do
+    {
+      for (i = 0; i < vec_len (names); i++)
+	vec_free (names[i]);
+      vec_reset_length (names);
+
+      epoch = stat_segment_epoch_begin (sm->shared_header);
+      directory = stat_segment_directory (sm, &n);
+      if (directory)
+	for (i = 0; i < n; i++)
+	  vec_add1 (names, stat_segment_entry_name (&directory[i]));
+    }
+  while (stat_segment_epoch_changed (sm->shared_header, epoch));
+
+  return names;
+}
+
+static int
+stat_segment_name_matches (stat_segment_directory_entry_t * ep,
+			   u8 ** patterns)
+{
+  int i;
+
+  if (patterns == 0)
+    return 1;
+
+  for (i = 0; i < vec_len (patterns); i++)
+    if (!strncmp (ep->name, (char *) patterns[i],
+		  clib_min (vec_len (patterns[i]), STAT_SEGMENT_NAME_LEN)))
+      return 1;
+  return 0;
+}
+
+stat_segment_data_t *
+stat_segment_dump (stat_client_main_t * sm, u8 ** patterns)
+{
+  stat_segment_directory_entry_t *directory, *ep;
+  stat_segment_data_t *res = 0, *d;
+  uword i, n, elt_bytes;
+  u64 epoch;
+  int rv;
+
+again:
+  stat_segment_data_free (res);
+  res = 0;
+
+  epoch = stat_segment_epoch_begin (sm->shared_header);
+  directory = stat_segment_directory (sm, &n);
+  if (directory == 0 && n)
+    goto retry;
+
+  for (i = 0; i < n; i++)
+    {
+      ep = &directory[i];
+      if (!stat_segment_name_matches (ep, patterns))
+	continue;
+
+      vec_add2 (res, d, 1);
+      memset (d, 0, sizeof (*d));
+      d->name = stat_segment_entry_name (ep);
+      d->type = ep->type;
+      elt_bytes = (d->type == STAT_DIR_TYPE_COMBINED_COUNTER ?
+		   sizeof (vlib_counter_t) : sizeof (counter_t));
+      rv = stat_segment_copy_counters (sm->base, sm->master_base, sm->size,
+				       ep->data, elt_bytes,
+				       (void ***) &d->simple_counter_vec);
+      if (rv)
+	goto retry;
+    }
+
+  if (!stat_segment_epoch_changed (sm->shared_header, epoch))
+    return res;
+
+retry:
+  /* Inconsistent data in a stable segment: not a stats segment */
+  if (!stat_segment_epoch_changed (sm->shared_header, epoch))
+    {
+      stat_segment_data_free (res);
+      return 0;
+    }
+  goto again;
+}
+
+void
+stat_segment_data_free (stat_segment_data_t * res)
+{
+  stat_segment_data_t *d;
+  int i;
+
+  vec_foreach (d, res)
+  {
+    for (i = 0; i < vec_len (d->simple_counter_vec); i++)
+      vec_free (d->simple_counter_vec[i]);
+    vec_free (d->simple_counter_vec);
+    vec_free (d->name);
+  }
+  vec_free (res);
+}
+
+counter_t
+stat_segment_simple_counter_sum (stat_segment_data_t * d, u32 index)
+{
+  counter_t sum = 0;
+  int i;
+
+  for (i = 0; i < vec_len (d->simple_counter_vec); i++)
+    if (index < vec_len (d->simple_counter_vec[i]))
+      sum += d->simple_counter_vec[i][index];
+  return sum;
+}
+
+vlib_counter_t
+stat_segment_combined_counter_sum (stat_segment_data_t * d, u32 index)
+{
+  vlib_counter_t sum = { 0 };
+  int i;
+
+  for (i = 0; i < vec_len (d->combined_counter_vec); i++)
+    if (index < vec_len (d->combined_counter_vec[i]))
+      {
+	sum.packets += d->combined_counter_vec[i][index].packets;
+	sum.bytes += d->combined_counter_vec[i][index].bytes;
+      }
+  return sum;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
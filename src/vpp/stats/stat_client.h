@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __included_stat_client_h__
+#define __included_stat_client_h__
+
+#include <vpp/stats/stat_segment.h>
+
+/*
+ * Reader side of the vpp stats segment. The segment is mapped read-only;
+ * readers never write to it and never block vpp.
+ */
+
+typedef struct
+{
+  u8 *name;
+  void *base;			/* local mapping */
+  uword size;
+  uword master_base;		/* mapping address in vpp */
+  stat_segment_shared_header_t *shared_header;	/* local address */
+} stat_client_main_t;
+
+typedef struct
+{
+  u8 *name;
+  stat_directory_type_t type;
+  union
+  {
+    counter_t **simple_counter_vec;	/* [thread][index] */
+    vlib_counter_t **combined_counter_vec;	/* [thread][index] */
+  };
+} stat_segment_data_t;
+
+/* Map the named segment; returns 0 or a -ve errno */
+int stat_segment_connect (stat_client_main_t * sm, char *name);
+void stat_segment_disconnect (stat_client_main_t * sm);
+
+/* Vector of directory entry names; free with vec_free of each */
+u8 **stat_segment_ls (stat_client_main_t * sm);
+
+/*
+ * Consistent copy of every collection whose name starts with one of
+ * patterns (all of them if patterns is 0).
+ */
+stat_segment_data_t *stat_segment_dump (stat_client_main_t * sm,
+					u8 ** patterns);
+void stat_segment_data_free (stat_segment_data_t * res);
+
+/* Sum of one counter over all threads */
+counter_t stat_segment_simple_counter_sum (stat_segment_data_t * d,
+					   u32 index);
+vlib_counter_t stat_segment_combined_counter_sum (stat_segment_data_t * d,
+						  u32 index);
+
+#endif /* __included_stat_client_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
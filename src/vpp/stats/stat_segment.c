@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <vlib/vlib.h>
+#include <svm/ssvm.h>
+#include <vlibapi/api.h>
+#include <vpp/stats/stat_segment.h>
+
+typedef struct
+{
+  ssvm_private_t ssvm;
+  stat_segment_shared_header_t *shared_header;
+
+  /* Directory index by counter collection name, in the main heap */
+  uword *directory_index_by_name;
+
+  /* Configuration */
+  u8 *name;
+  uword size;
+  u8 disabled;
+} stat_segment_main_t;
+
+stat_segment_main_t stat_segment_main;
+
+/*
+ * Would validating counter index still fit in the segment heap? Every
+ * per-thread vector may move and grow, so be generous; mheap panics
+ * rather than failing an allocation.
+ */
+static int
+stat_segment_has_room (stat_segment_main_t * sm, u32 index, uword elt_bytes)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  clib_mem_usage_t usage;
+  uword n_bytes, n_free;
+
+  n_bytes = tm->n_vlib_mains * (2 * (index + 1) * elt_bytes
+				+ 2 * CLIB_CACHE_LINE_BYTES + sizeof (void *))
+    + STAT_SEGMENT_HEAP_RESERVE;
+
+  mheap_usage (sm->ssvm.sh->heap, &usage);
+  /* Free objects, plus what the heap has not grown into yet */
+  n_free = usage.bytes_free;
+  if (usage.bytes_max > usage.bytes_total)
+    n_free += usage.bytes_max - usage.bytes_total;
+
+  return n_bytes <= n_free;
+}
+
+/*
+ * Move a collection that outgrew the segment to the main heap, and drop
+ * it from the directory. Readers then fall back to the locked path.
+ * Called from vlib_validate_*_counter, with the workers stopped.
+ */
+static void
+stat_segment_evict_counters (stat_segment_main_t * sm, void *cm_arg,
+			     int is_combined)
+{
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  stat_segment_directory_entry_t *ep;
+  void ***countersp, **old, **new = 0;
+  char **namep;
+  uword elt_bytes, *p;
+  void *oldheap;
+  int i, n;
+
+  if (is_combined)
+    {
+      vlib_combined_counter_main_t *cm = cm_arg;
+      countersp = (void ***) &cm->counters;
+      namep = &cm->stat_segment_name;
+      elt_bytes = sizeof (vlib_counter_t);
+    }
+  else
+    {
+      vlib_simple_counter_main_t *cm = cm_arg;
+      countersp = (void ***) &cm->counters;
+      namep = &cm->stat_segment_name;
+      elt_bytes = sizeof (counter_t);
+    }
+
+  clib_warning ("stats segment '%v' full, '%s' moves to the main heap",
+		sm->name, *namep);
+
+  old = *countersp;
+  if (vec_len (old))
+    {
+      vec_validate (new, vec_len (old) - 1);
+      for (i = 0; i < vec_len (old); i++)
+	{
+	  n = vec_len (old[i]);
+	  new[i] = _vec_resize (new[i], n, n * elt_bytes, 0,
+				CLIB_CACHE_LINE_BYTES);
+	  clib_memcpy (new[i], old[i], n * elt_bytes);
+	}
+    }
+
+  shared_header->epoch++;
+  CLIB_MEMORY_BARRIER ();
+
+  *countersp = new;
+
+  p = hash_get_mem (sm->directory_index_by_name, *namep);
+  if (p)
+    {
+      vec_delete (shared_header->directory, 1, p[0]);
+      hash_unset_mem (sm->directory_index_by_name, *namep);
+      /* Entries after the deleted one moved down */
+      vec_foreach (ep, shared_header->directory)
+      {
+	p = hash_get_mem (sm->directory_index_by_name, ep->name);
+	p[0] = ep - shared_header->directory;
+      }
+    }
+
+  oldheap = ssvm_push_heap (sm->ssvm.sh);
+  for (i = 0; i < vec_len (old); i++)
+    vec_free (old[i]);
+  vec_free (old);
+  ssvm_pop_heap (oldheap);
+
+  *namep = 0;
+
+  CLIB_MEMORY_BARRIER ();
+  shared_header->epoch++;
+}
+
+/*
+ * Strong versions of the vlib/counter.c hooks. Counter vectors are only
+ * (re)allocated by the main thread, so there is a single writer.
+ */
+void *
+vlib_stats_push_heap (void *cm, u32 index, int is_combined)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+
+  if (sm->ssvm.sh == 0)
+    return clib_mem_get_heap ();
+
+  if (!stat_segment_has_room (sm, index, is_combined ?
+			      sizeof (vlib_counter_t) : sizeof (counter_t)))
+    {
+      stat_segment_evict_counters (sm, cm, is_combined);
+      return clib_mem_get_heap ();
+    }
+
+  sm->shared_header->epoch++;
+  CLIB_MEMORY_BARRIER ();
+  return ssvm_push_heap (sm->ssvm.sh);
+}
+
+void
+vlib_stats_pop_heap (void *cm_arg, void *oldheap, int is_combined)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  stat_segment_shared_header_t *shared_header = sm->shared_header;
+  stat_segment_directory_entry_t *ep;
+  char *name;
+  void *data;
+  uword *p;
+
+  if (sm->ssvm.sh == 0)
+    {
+      clib_mem_set_heap (oldheap);
+      return;
+    }
+
+  if (is_combined)
+    {
+      vlib_combined_counter_main_t *cm = cm_arg;
+      name = cm->stat_segment_name;
+      data = cm->counters;
+    }
+  else
+    {
+      vlib_simple_counter_main_t *cm = cm_arg;
+      name = cm->stat_segment_name;
+      data = cm->counters;
+    }
+
+  /* The directory lives in the segment heap, which is still current */
+  p = hash_get_mem (sm->directory_index_by_name, name);
+  if (p)
+    ep = vec_elt_at_index (shared_header->directory, p[0]);
+  else
+    {
+      vec_add2 (shared_header->directory, ep, 1);
+      memset (ep, 0, sizeof (*ep));
+      strncpy (ep->name, name, STAT_SEGMENT_NAME_LEN - 1);
+      ep->type = is_combined ? STAT_DIR_TYPE_COMBINED_COUNTER :
+	STAT_DIR_TYPE_SIMPLE_COUNTER;
+    }
+  ep->data = data;
+
+  ssvm_pop_heap (oldheap);
+
+  if (p == 0)
+    hash_set_mem (sm->directory_index_by_name, name,
+		  ep - shared_header->directory);
+
+  CLIB_MEMORY_BARRIER ();
+  shared_header->epoch++;
+}
+
+/*
+ * Copy a counter collection kept in the segment, without taking any
+ * lock, by way of the reader side of the epoch protocol. Only fails if
+ * the segment does not exist or the vectors are not in it.
+ */
+int
+stat_segment_snapshot_counters (void **countersp, uword elt_bytes,
+				void ***result)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  ssvm_shared_header_t *sh = sm->ssvm.sh;
+  u64 epoch;
+  int rv;
+
+  if (sh == 0)
+    return -1;
+
+  while (1)
+    {
+      epoch = stat_segment_epoch_begin (sm->shared_header);
+      rv = stat_segment_copy_counters (sh, sh->ssvm_va, sh->ssvm_size,
+				       *(void *volatile *) countersp,
+				       elt_bytes, result);
+      if (!stat_segment_epoch_changed (sm->shared_header, epoch))
+	return rv;
+    }
+}
+
+static clib_error_t *
+stat_segment_create (stat_segment_main_t * sm)
+{
+  ssvm_private_t *ssvm = &sm->ssvm;
+  ssvm_shared_header_t *sh;
+  void *oldheap;
+  int rv;
+
+  ssvm->ssvm_size = sm->size;
+  ssvm->name = format (0, "%v%c", sm->name, 0);
+  ssvm->requested_va = 0;
+
+  if ((rv = ssvm_master_init (ssvm, ~0 /* master_index */ )))
+    {
+      ssvm->sh = 0;
+      return clib_error_return (0, "stats segment '%v' create failed: %d",
+				sm->name, rv);
+    }
+
+  sh = ssvm->sh;
+  oldheap = ssvm_push_heap (sh);
+  sm->shared_header = clib_mem_alloc (sizeof (*sm->shared_header));
+  memset (sm->shared_header, 0, sizeof (*sm->shared_header));
+  ssvm_pop_heap (oldheap);
+
+  sm->directory_index_by_name = hash_create_string (0, sizeof (uword));
+
+  sh->opaque[STAT_SEGMENT_OPAQUE_HEADER] = sm->shared_header;
+  CLIB_MEMORY_BARRIER ();
+  sh->ready = 1;
+  return 0;
+}
+
+/*
+ * Runs whether or not a statseg section is present, before any init
+ * function can validate an interface counter.
+ */
+static clib_error_t *
+statseg_config (vlib_main_t * vm, unformat_input_t * input)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  clib_error_t *error;
+
+  sm->size = STAT_SEGMENT_DEFAULT_SIZE;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "name %s", &sm->name))
+	;
+      else if (unformat (input, "size %U", unformat_memory_size, &sm->size))
+	;
+      else if (unformat (input, "disable"))
+	sm->disabled = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sm->disabled)
+    return 0;
+
+  /*
+   * Like the svm regions, the default name carries the api-segment
+   * prefix: ssvm_master_init would otherwise take over the segment of
+   * another instance on the same host.
+   */
+  if (sm->name == 0)
+    {
+      api_main_t *am = &api_main;
+
+      if ((error = vlib_call_config_function (vm, api_segment_config)))
+	return error;
+
+      if (am->root_path)
+	sm->name = format (0, "%s-%s", am->root_path[0] == '/' ?
+			   am->root_path + 1 : am->root_path,
+			   STAT_SEGMENT_DEFAULT_NAME);
+      else
+	sm->name = format (0, "%s", STAT_SEGMENT_DEFAULT_NAME);
+    }
+
+  /* Not fatal: counters stay in the main heap without a segment */
+  if ((error = stat_segment_create (sm)))
+    clib_error_report (error);
+
+  return 0;
+}
+
+VLIB_EARLY_CONFIG_FUNCTION (statseg_config, "statseg");
+
+static clib_error_t *
+stat_segment_exit (vlib_main_t * vm)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+
+  /* Readers already attached keep their mapping */
+  if (sm->ssvm.sh)
+    shm_unlink ((char *) sm->ssvm.name);
+  return 0;
+}
+
+VLIB_MAIN_LOOP_EXIT_FUNCTION (stat_segment_exit);
+
+static clib_error_t *
+show_stat_segment_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  stat_segment_main_t *sm = &stat_segment_main;
+  ssvm_shared_header_t *sh = sm->ssvm.sh;
+  stat_segment_directory_entry_t *ep;
+  int verbose = 0;
+
+  if (unformat (input, "verbose"))
+    verbose = 1;
+
+  if (sh == 0)
+    {
+      vlib_cli_output (vm, "stats segment not configured");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "stats segment '%v', %U, epoch %lld",
+		   sm->name, format_memory_size, sh->ssvm_size,
+		   sm->shared_header->epoch);
+
+  vec_foreach (ep, sm->shared_header->directory)
+  {
+    vlib_cli_output (vm, "  %-40s %s, %d threads, %d counters", ep->name,
+		     ep->type == STAT_DIR_TYPE_COMBINED_COUNTER ?
+		     "combined" : "simple", vec_len (ep->data),
+		     vec_len (ep->data) ?
+		     vec_len (((void **) ep->data)[0]) : 0);
+  }
+
+  if (verbose)
+    vlib_cli_output (vm, "%U", format_mheap, sh->heap, 1 /* verbose */ );
+
+  return 0;
+}
+
+/*?
+ * Show the shared memory stats segment and the counter collections
+ * exported through it.
+ *
+ * @cliexpar
+ * @cliexstart{show statseg}
+ * stats segment 'vpp-stats', 32m, epoch 24
+ *   /if/drops                                simple, 2 threads, 3 counters
+ *   /if/rx                                   combined, 2 threads, 3 counters
+ * @cliexend
+?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (show_stat_segment_command, static) =
+{
+  .path = "show statseg",
+  .short_help = "show statseg [verbose]",
+  .function = show_stat_segment_command_fn,
+};
+/* *INDENT-ON* */
+
+#define STAT_SEGMENT_TEST(_cond, _comment, _args...)		\
+{									\
+  if (!(_cond))								\
+    {									\
+      vlib_cli_output (vm, "FAIL:%d: " _comment, __LINE__, ##_args);	\
+      return 1;								\
+    }									\
+}
+
+/* Read a collection back the way a client does, by directory name */
+static int
+stat_segment_test_read (stat_segment_main_t * sm, char *name,
+			uword elt_bytes, void ***result)
+{
+  ssvm_shared_header_t *sh = sm->ssvm.sh;
+  stat_segment_directory_entry_t *ep;
+
+  vec_foreach (ep, sm->shared_header->directory)
+  {
+    if (strncmp (ep->name, name, STAT_SEGMENT_NAME_LEN) == 0)
+      return stat_segment_copy_counters (sh, sh->ssvm_va, sh->ssvm_size,
+					 ep->data, elt_bytes, result);
+  }
+  return -1;
+}
+
+/* Only for collections moved to the main heap */
+static void
+stat_segment_test_free (vlib_simple_counter_main_t * cm)
+{
+  int i;
+
+  for (i = 0; i < vec_len (cm->counters); i++)
+    vec_free (cm->counters[i]);
+  vec_free (cm->counters);
+}
+
+static int
+stat_segment_test_counters (vlib_main_t * vm)
+{
+  static vlib_simple_counter_main_t scm = {
+    .name = "test-simple",
+  };
+  static vlib_simple_counter_main_t big = {
+    .name = "test-big",
+  };
+  static vlib_combined_counter_main_t ccm = {
+    .name = "test-combined",
+  };
+  stat_segment_main_t *sm = &stat_segment_main;
+  u32 n_threads = vlib_get_thread_main ()->n_vlib_mains;
+  counter_t **simple = 0, sum;
+  vlib_counter_t **combined = 0, c;
+  u32 i, n_big;
+
+  /* Clean slate if run again; collections stay in the directory */
+  if (big.stat_segment_name == 0)
+    stat_segment_test_free (&big);
+  scm.stat_segment_name = "/test/simple";
+  big.stat_segment_name = "/test/big";
+  ccm.stat_segment_name = "/test/combined";
+  vlib_clear_simple_counters (&scm);
+  vlib_clear_combined_counters (&ccm);
+
+  vlib_validate_simple_counter (&big, 0);
+  vlib_validate_simple_counter (&scm, 9);
+  vlib_validate_combined_counter (&ccm, 4);
+  for (i = 0; i < n_threads; i++)
+    {
+      vlib_increment_simple_counter (&big, i, 0, 7);
+      vlib_increment_simple_counter (&scm, i, 3, i + 1);
+      vlib_increment_combined_counter (&ccm, i, 4, 2, 128);
+    }
+
+  STAT_SEGMENT_TEST (stat_segment_test_read (sm, "/test/simple",
+					     sizeof (counter_t),
+					     (void ***) &simple) == 0,
+		     "read /test/simple");
+  STAT_SEGMENT_TEST (vec_len (simple) == n_threads, "%d threads",
+		     vec_len (simple));
+  for (i = 0, sum = 0; i < n_threads; i++)
+    {
+      STAT_SEGMENT_TEST (vec_len (simple[i]) == 10, "thread %d: %d counters",
+			 i, vec_len (simple[i]));
+      sum += simple[i][3];
+    }
+  STAT_SEGMENT_TEST (sum == n_threads * (n_threads + 1) / 2,
+		     "/test/simple[3] is %lld", sum);
+
+  STAT_SEGMENT_TEST (stat_segment_test_read (sm, "/test/combined",
+					     sizeof (vlib_counter_t),
+					     (void ***) &combined) == 0,
+		     "read /test/combined");
+  for (i = 0, c.packets = c.bytes = 0; i < vec_len (combined); i++)
+    {
+      c.packets += combined[i][4].packets;
+      c.bytes += combined[i][4].bytes;
+    }
+  STAT_SEGMENT_TEST (c.packets == 2 * n_threads && c.bytes == 128 * n_threads,
+		     "/test/combined[4] is %lld packets, %lld bytes",
+		     c.packets, c.bytes);
+
+  /* Growing moves the vectors; the directory must follow */
+  vlib_validate_simple_counter (&scm, 1000);
+  STAT_SEGMENT_TEST (stat_segment_test_read (sm, "/test/simple",
+					     sizeof (counter_t),
+					     (void ***) &simple) == 0,
+		     "read /test/simple after growing it");
+  for (i = 0, sum = 0; i < n_threads; i++)
+    {
+      STAT_SEGMENT_TEST (vec_len (simple[i]) == 1001,
+			 "thread %d: %d counters", i, vec_len (simple[i]));
+      sum += simple[i][3];
+    }
+  STAT_SEGMENT_TEST (sum == n_threads * (n_threads + 1) / 2,
+		     "/test/simple[3] is %lld after growing it", sum);
+
+  /* More than the whole segment: moves to the main heap, no panic */
+  n_big = sm->size / sizeof (counter_t);
+  vlib_validate_simple_counter (&big, n_big);
+  STAT_SEGMENT_TEST (big.stat_segment_name == 0,
+		     "/test/big left the segment");
+  STAT_SEGMENT_TEST (stat_segment_test_read (sm, "/test/big",
+					     sizeof (counter_t),
+					     (void ***) &simple) != 0,
+		     "/test/big not in the directory");
+  STAT_SEGMENT_TEST (vlib_get_simple_counter (&big, 0) == 7 * n_threads,
+		     "/test/big[0] is %lld", vlib_get_simple_counter (&big, 0));
+  STAT_SEGMENT_TEST (vlib_simple_counter_n_counters (&big) == n_big + 1,
+		     "/test/big has %d counters",
+		     vlib_simple_counter_n_counters (&big));
+
+  /* The remaining entries are still indexed by name */
+  vlib_validate_simple_counter (&scm, 1001);
+  vlib_validate_combined_counter (&ccm, 5);
+  STAT_SEGMENT_TEST (stat_segment_test_read (sm, "/test/simple",
+					     sizeof (counter_t),
+					     (void ***) &simple) == 0
+		     && vec_len (simple[0]) == 1002,
+		     "read /test/simple after the eviction");
+  STAT_SEGMENT_TEST (stat_segment_test_read (sm, "/test/combined",
+					     sizeof (vlib_counter_t),
+					     (void ***) &combined) == 0
+		     && vec_len (combined[0]) == 6,
+		     "read /test/combined after the eviction");
+
+  stat_segment_test_free (&big);
+
+  for (i = 0; i < vec_len (simple); i++)
+    vec_free (simple[i]);
+  vec_free (simple);
+  for (i = 0; i < vec_len (combined); i++)
+    vec_free (combined[i]);
+  vec_free (combined);
+
+  vlib_cli_output (vm, "PASS: stats segment counters");
+  return 0;
+}
+
+static clib_error_t *
+test_stat_segment_command_fn (vlib_main_t * vm,
+			      unformat_input_t * input,
+			      vlib_cli_command_t * cmd)
+{
+  if (stat_segment_main.ssvm.sh == 0)
+    return clib_error_return (0, "stats segment not configured");
+
+  if (stat_segment_test_counters (vm))
+    return clib_error_return (0, "stats segment unit test FAILED");
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (test_stat_segment_command, static) =
+{
+  .path = "test statseg",
+  .short_help = "test statseg",
+  .function = test_stat_segment_command_fn,
+};
+/* *INDENT-ON* */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __included_stat_segment_h__
+#define __included_stat_segment_h__
+
+#include <vppinfra/clib.h>
+#include <vppinfra/vec.h>
+#include <vppinfra/serialize.h>
+#include <vlib/counter.h>
+
+/*
+ * The stats segment is a shared memory (ssvm) segment whose heap holds
+ * the per-thread counter vectors of every counter collection with a
+ * stat_segment_name. Workers increment their own vectors in place, as
+ * before; nothing in the data path knows the segment exists.
+ *
+ * A directory of { name, type, counter vector } entries lets readers
+ * find the collections. The master bumps the header epoch to an odd
+ * value before it moves any counter vector or edits the directory, and
+ * back to an even value when done. Readers copy what they need and
+ * retry if the epoch was odd or changed meanwhile: a seqlock, with no
+ * lock taken on either side.
+ *
+ * The segment is mapped at a different address in each reader, so
+ * pointers found in the segment are master addresses; see
+ * stat_segment_pointer().
+ */
+
+/* Prefixed with the api-segment prefix, if any: <prefix>-vpp-stats */
+#define STAT_SEGMENT_DEFAULT_NAME "vpp-stats"
+#define STAT_SEGMENT_DEFAULT_SIZE (32 << 20)
+
+/* Segment heap kept free when growing counters, for the directory */
+#define STAT_SEGMENT_HEAP_RESERVE (64 << 10)
+
+/* ssvm_shared_header_t opaque[] slot holding the stats header */
+#define STAT_SEGMENT_OPAQUE_HEADER 0
+
+#define STAT_SEGMENT_NAME_LEN 64
+
+typedef enum
+{
+  STAT_DIR_TYPE_SIMPLE_COUNTER,
+  STAT_DIR_TYPE_COMBINED_COUNTER,
+} stat_directory_type_t;
+
+typedef struct
+{
+  char name[STAT_SEGMENT_NAME_LEN];
+  stat_directory_type_t type;
+  /* counter_t ** or vlib_counter_t **, indexed by thread */
+  void *data;
+} stat_segment_directory_entry_t;
+
+typedef struct
+{
+  /* Odd while the master updates the segment */
+  volatile u64 epoch;
+
+  /* Vector of directory entries */
+  stat_segment_directory_entry_t *directory;
+} stat_segment_shared_header_t;
+
+/*
+ * Translate a master address found in the segment into a local one,
+ * checking that n_bytes from there are within the segment. Stale
+ * pointers read during an update may point anywhere.
+ */
+always_inline void *
+stat_segment_pointer (void *base, uword master_base, uword size,
+		      void *p, uword n_bytes)
+{
+  uword offset = pointer_to_uword (p) - master_base;
+
+  if (offset >= size || n_bytes > size - offset)
+    return 0;
+  return (u8 *) base + offset;
+}
+
+/* Length of a segment vector, 0 if it is out of bounds */
+always_inline uword
+stat_segment_vec_len (void *base, uword master_base, uword size, void *v)
+{
+  vec_header_t *vh;
+
+  if (v == 0)
+    return 0;
+  vh = stat_segment_pointer (base, master_base, size,
+			     (u8 *) v - sizeof (vec_header_t),
+			     sizeof (vec_header_t));
+  return vh ? vh->len : 0;
+}
+
+always_inline u64
+stat_segment_epoch_begin (stat_segment_shared_header_t * hdr)
+{
+  u64 epoch;
+
+  while ((epoch = hdr->epoch) & 1)
+    ;
+  CLIB_MEMORY_BARRIER ();
+  return epoch;
+}
+
+always_inline int
+stat_segment_epoch_changed (stat_segment_shared_header_t * hdr, u64 epoch)
+{
+  CLIB_MEMORY_BARRIER ();
+  return hdr->epoch != epoch;
+}
+
+/*
+ * Copy the per-thread vectors of a counter collection out of the
+ * segment into *result, a vector of per-thread vectors of elt_bytes
+ * sized elements, reusing its memory. Returns 0 on success, -1 if the
+ * data was inconsistent; the caller retries from
+ * stat_segment_epoch_begin().
+ */
+always_inline int
+stat_segment_copy_counters (void *base, uword master_base, uword size,
+			    void *data, uword elt_bytes, void ***result)
+{
+  void **threads, **copy = *result, *t;
+  uword i, n_threads, n;
+
+  n_threads = stat_segment_vec_len (base, master_base, size, data);
+  threads = stat_segment_pointer (base, master_base, size, data,
+				  n_threads * sizeof (void *));
+  if (n_threads && threads == 0)
+    return -1;
+
+  for (i = n_threads; i < vec_len (copy); i++)
+    vec_free (copy[i]);
+
+  if (n_threads == 0)
+    {
+      vec_reset_length (copy);
+      *result = copy;
+      return 0;
+    }
+
+  vec_validate (copy, n_threads - 1);
+  _vec_len (copy) = n_threads;
+  *result = copy;
+
+  for (i = 0; i < n_threads; i++)
+    {
+      n = stat_segment_vec_len (base, master_base, size, threads[i]);
+      t = stat_segment_pointer (base, master_base, size, threads[i],
+				n * elt_bytes);
+      if (n && t == 0)
+	return -1;
+      if (copy[i])
+	_vec_len (copy[i]) = 0;
+      copy[i] = _vec_resize (copy[i], n, n * elt_bytes, 0,
+			     CLIB_CACHE_LINE_BYTES);
+      clib_memcpy (copy[i], t, n * elt_bytes);
+    }
+
+  return 0;
+}
+
+/* In vpp: lock-free copy of a counter collection kept in the segment */
+int stat_segment_snapshot_counters (void **countersp, uword elt_bytes,
+				    void ***result);
+
+#endif /* __included_stat_segment_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
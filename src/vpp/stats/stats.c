@@ -17,6 +17,7 @@
 #include <vnet/fib/ip4_fib.h>
 #include <vnet/fib/fib_entry.h>
 #include <vnet/dpo/load_balance.h>
+#include <vpp/stats/stat_segment.h>
 
 #define STATS_DEBUG 0
 
@@ -436,6 +437,49 @@ enable_all_client_reg (u32 ** registrations)
   return registrations;
 }
 
+/*
+ * Sum a simple counter collection into sm->simple_counter_totals.
+ * Collections kept in the stats segment are copied without any lock;
+ * the others are read under the interface counter lock.
+ */
+static void
+collect_simple_counters (stats_main_t * sm, vlib_simple_counter_main_t * cm)
+{
+  vnet_interface_main_t *im = sm->interface_main;
+  counter_t **snapshot;
+  int i, j, n_counts;
+
+  vec_reset_length (sm->simple_counter_totals);
+
+  if (cm->stat_segment_name &&
+      stat_segment_snapshot_counters ((void **) &cm->counters,
+				      sizeof (counter_t),
+				      (void ***) &sm->simple_counter_snapshot)
+      == 0)
+    {
+      snapshot = sm->simple_counter_snapshot;
+      for (j = 0; j < vec_len (snapshot); j++)
+	{
+	  n_counts = vec_len (snapshot[j]);
+	  vec_validate (sm->simple_counter_totals, n_counts - 1);
+	  for (i = 0; i < n_counts; i++)
+	    sm->simple_counter_totals[i] += snapshot[j][i];
+	}
+      return;
+    }
+
+  /*
+   * Prevent interface registration from expanding / moving the vectors...
+   * That tends never to happen, so we can hold this lock for a while.
+   */
+  vnet_interface_counter_lock (im);
+  n_counts = vlib_simple_counter_n_counters (cm);
+  vec_validate (sm->simple_counter_totals, n_counts - 1);
+  for (i = 0; i < n_counts; i++)
+    sm->simple_counter_totals[i] = vlib_get_simple_counter (cm, i);
+  vnet_interface_counter_unlock (im);
+}
+
 static void
 do_simple_interface_counters (stats_main_t * sm)
 {
@@ -449,15 +493,10 @@ do_simple_interface_counters (stats_main_t * sm)
   u64 v, *vp = 0;
   int i, n_counts;
 
-  /*
-   * Prevent interface registration from expanding / moving the vectors...
-   * That tends never to happen, so we can hold this lock for a while.
-   */
-  vnet_interface_counter_lock (im);
-
   vec_foreach (cm, im->sw_if_counters)
   {
-    n_counts = vlib_simple_counter_n_counters (cm);
+    collect_simple_counters (sm, cm);
+    n_counts = vec_len (sm->simple_counter_totals);
     for (i = 0; i < n_counts; i++)
       {
 	if (mp == 0)
@@ -473,7 +512,7 @@ do_simple_interface_counters (stats_main_t * sm)
 	    mp->count = 0;
 	    vp = (u64 *) mp->data;
 	  }
-	v = vlib_get_simple_counter (cm, i);
+	v = sm->simple_counter_totals[i];
 	clib_mem_unaligned (vp, u64) = clib_host_to_net_u64 (v);
 	vp++;
 	mp->count++;
@@ -487,7 +526,6 @@ do_simple_interface_counters (stats_main_t * sm)
       }
     ASSERT (mp == 0);
   }
-  vnet_interface_counter_unlock (im);
 }
 
 void
@@ -615,6 +653,45 @@ static void
     }
 }
 
+/* Combined counter version of collect_simple_counters */
+static void
+collect_combined_counters (stats_main_t * sm,
+			   vlib_combined_counter_main_t * cm)
+{
+  vnet_interface_main_t *im = sm->interface_main;
+  vlib_counter_t **snapshot;
+  int i, j, n_counts;
+
+  vec_reset_length (sm->combined_counter_totals);
+
+  if (cm->stat_segment_name &&
+      stat_segment_snapshot_counters ((void **) &cm->counters,
+				      sizeof (vlib_counter_t),
+				      (void ***) &sm->combined_counter_snapshot)
+      == 0)
+    {
+      snapshot = sm->combined_counter_snapshot;
+      for (j = 0; j < vec_len (snapshot); j++)
+	{
+	  n_counts = vec_len (snapshot[j]);
+	  vec_validate (sm->combined_counter_totals, n_counts - 1);
+	  for (i = 0; i < n_counts; i++)
+	    {
+	      sm->combined_counter_totals[i].packets += snapshot[j][i].packets;
+	      sm->combined_counter_totals[i].bytes += snapshot[j][i].bytes;
+	    }
+	}
+      return;
+    }
+
+  vnet_interface_counter_lock (im);
+  n_counts = vlib_combined_counter_n_counters (cm);
+  vec_validate (sm->combined_counter_totals, n_counts - 1);
+  for (i = 0; i < n_counts; i++)
+    vlib_get_combined_counter (cm, i, &sm->combined_counter_totals[i]);
+  vnet_interface_counter_unlock (im);
+}
+
 static void
 do_combined_interface_counters (stats_main_t * sm)
 {
@@ -628,11 +705,10 @@ do_combined_interface_counters (stats_main_t * sm)
   vlib_counter_t v, *vp = 0;
   int i, n_counts;
 
-  vnet_interface_counter_lock (im);
-
   vec_foreach (cm, im->combined_sw_if_counters)
   {
-    n_counts = vlib_combined_counter_n_counters (cm);
+    collect_combined_counters (sm, cm);
+    n_counts = vec_len (sm->combined_counter_totals);
     for (i = 0; i < n_counts; i++)
       {
 	if (mp == 0)
@@ -648,7 +724,7 @@ do_combined_interface_counters (stats_main_t * sm)
 	    mp->count = 0;
 	    vp = (vlib_counter_t *) mp->data;
 	  }
-	vlib_get_combined_counter (cm, i, &v);
+	v = sm->combined_counter_totals[i];
 	clib_mem_unaligned (&vp->packets, u64)
 	  = clib_host_to_net_u64 (v.packets);
 	clib_mem_unaligned (&vp->bytes, u64) = clib_host_to_net_u64 (v.bytes);
@@ -664,7 +740,6 @@ do_combined_interface_counters (stats_main_t * sm)
       }
     ASSERT (mp == 0);
   }
-  vnet_interface_counter_unlock (im);
 }
 
 /**********************************
@@ -177,6 +177,12 @@ typedef struct
   vpe_client_stats_registration_t **regs_tmp;
   vpe_client_registration_t **clients_tmp;
 
+  /* Interface counter snapshots and per-interface totals */
+  counter_t **simple_counter_snapshot;
+  vlib_counter_t **combined_counter_snapshot;
+  u64 *simple_counter_totals;
+  vlib_counter_t *combined_counter_totals;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
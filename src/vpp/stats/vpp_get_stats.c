@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <vppinfra/mem.h>
+#include <vppinfra/format.h>
+#include <vpp/stats/stat_client.h>
+
+static void
+dump_stats (stat_segment_data_t * res)
+{
+  stat_segment_data_t *d;
+  vlib_counter_t c;
+  u32 i, n;
+
+  vec_foreach (d, res)
+  {
+    n = vec_len (d->simple_counter_vec) ?
+      vec_len (d->simple_counter_vec[0]) : 0;
+    for (i = 0; i < n; i++)
+      {
+	if (d->type == STAT_DIR_TYPE_COMBINED_COUNTER)
+	  {
+	    c = stat_segment_combined_counter_sum (d, i);
+	    fformat (stdout, "[%d]: %lld packets %lld bytes %v\n", i,
+		     c.packets, c.bytes, d->name);
+	  }
+	else
+	  fformat (stdout, "[%d]: %lld %v\n", i,
+		   stat_segment_simple_counter_sum (d, i), d->name);
+      }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  unformat_input_t _input, *input = &_input;
+  stat_client_main_t _sm, *sm = &_sm;
+  stat_segment_data_t *res;
+  u8 *segment_name = 0, *prefix = 0, *pattern = 0, **patterns = 0, **names;
+  int interval = 0, do_ls = 0, rv, i;
+
+  clib_mem_init (0, 64 << 20);
+
+  unformat_init_command_line (input, argv);
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "segment %s", &segment_name))
+	;
+      else if (unformat (input, "prefix %s", &prefix))
+	;
+      else if (unformat (input, "interval %d", &interval))
+	;
+      else if (unformat (input, "ls"))
+	do_ls = 1;
+      else if (unformat (input, "dump"))
+	;
+      else if (unformat (input, "%s", &pattern))
+	vec_add1 (patterns, pattern);
+      else
+	break;
+    }
+  unformat_free (input);
+
+  /* Same default as vpp, given the api-segment prefix */
+  if (segment_name == 0 && prefix)
+    segment_name = format (0, "%v-%s", prefix, STAT_SEGMENT_DEFAULT_NAME);
+  else if (segment_name == 0)
+    segment_name = format (0, "%s", STAT_SEGMENT_DEFAULT_NAME);
+  vec_add1 (segment_name, 0);
+
+  if ((rv = stat_segment_connect (sm, (char *) segment_name)))
+    {
+      fformat (stderr, "couldn't map stats segment '%s': %d\n",
+	       segment_name, rv);
+      fformat (stderr,
+	       "usage: vpp_get_stats [segment <name> | prefix <prefix>] "
+	       "[interval <nn>] "
+	       "[ls | dump] [<pattern>...]\n");
+      exit (1);
+    }
+
+  do
+    {
+      if (do_ls)
+	{
+	  names = stat_segment_ls (sm);
+	  for (i = 0; i < vec_len (names); i++)
+	    {
+	      fformat (stdout, "%v\n", names[i]);
+	      vec_free (names[i]);
+	    }
+	  vec_free (names);
+	}
+      else
+	{
+	  res = stat_segment_dump (sm, patterns);
+	  dump_stats (res);
+	  stat_segment_data_free (res);
+	}
+      if (interval)
+	sleep (interval);
+    }
+  while (interval);
+
+  stat_segment_disconnect (sm);
+  exit (0);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
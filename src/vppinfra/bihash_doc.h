@@ -72,7 +72,7 @@ typedef struct
   volatile u32 *writer_lock;  /**< Writer lock, in its own cache line */
     BVT (clib_bihash_value) ** working_copies;
 					    /**< Working copies (various sizes), to avoid locking against readers */
-  clib_bihash_bucket_t saved_bucket; /**< Saved bucket pointer */
+  u8 bucket_locks;   /**< Writers lock buckets, not the whole table */
   u32 nbuckets;			     /**< Number of hash buckets */
   u32 log2_nbuckets;		     /**< lg(nbuckets) */
   u8 *name;			     /**< hash table name */
@@ -105,6 +105,19 @@ void clib_bihash_init
 
 void clib_bihash_free (clib_bihash * h);
 
+/** Enable or disable per-bucket writer locking
+
+    By default, clib_bihash_add_del serializes all writers on the
+    table-wide writer lock. With per-bucket locking enabled, writers
+    which hit different buckets proceed in parallel; the writer lock
+    is held only while allocating or freeing value pages.
+
+    @param h - the bi-hash table
+    @param enable - 1 to lock per bucket, 0 to use the table-wide lock
+    @note Call before any concurrent writers touch the table
+*/
+void clib_bihash_set_bucket_locks (clib_bihash * h, int enable);
+
 /** Add or delete a (key,value) pair from a bi-hash table
 
     @param h - the bi-hash table to search
@@ -128,6 +141,53 @@ int clib_bihash_search (clib_bihash * h,
 			clib_bihash_kv * search_v, clib_bihash_kv * return_v);
 
 
+/** Prefetch the bucket of a bi-hash table for a precomputed hash
+
+    @param h - the bi-hash table
+    @param hash - key hash, as computed by clib_bihash_hash
+    @note First stage of a software pipelined lookup
+*/
+static inline void clib_bihash_prefetch_bucket (clib_bihash * h, u64 hash);
+
+/** Prefetch the (key,value) page of a bi-hash table for a precomputed hash
+
+    @param h - the bi-hash table
+    @param hash - key hash, as computed by clib_bihash_hash
+    @note Second stage of a software pipelined lookup, reads the bucket
+    so it should be issued once the bucket prefetch had time to complete
+*/
+static inline void clib_bihash_prefetch_data (clib_bihash * h, u64 hash);
+
+/** Search a bi-hash table using a precomputed hash
+
+    @param h - the bi-hash table to search
+    @param hash - hash of search_key, as computed by clib_bihash_hash
+    @param search_key - (key,value) pair containing the search key
+    @param valuep - (key,value) pair which matches search_key.key
+    @returns 0 on success (with valuep set), < 0 on error
+*/
+static inline int clib_bihash_search_inline_2_with_hash
+  (clib_bihash * h, u64 hash, clib_bihash_kv * search_key,
+   clib_bihash_kv * valuep);
+
+/** Search a bi-hash table for a batch of keys
+
+    @param h - the bi-hash table to search
+    @param search_keys - vector of n_keys (key,value) pairs to search for
+    @param valuesp - n_keys (key,value) pairs, set for each key found;
+    may be the same array as search_keys
+    @param rvs - n_keys results, 0 if found, < 0 otherwise
+    @param n_keys - number of keys to search for
+    @returns the number of keys found
+    @note Hashes keys and prefetches their buckets and value pages
+    BIHASH_SEARCH_BATCH_STRIDE keys apart, hiding the cache misses
+    when the table is much larger than the last-level cache
+*/
+static inline u32 clib_bihash_search_batch
+  (clib_bihash * h, clib_bihash_kv * search_keys, clib_bihash_kv * valuesp,
+   int *rvs, u32 n_keys);
+
+
 /** Visit active (key,value) pairs in a bi-hash table
 
     @param h - the bi-hash table to search
@@ -28,6 +28,7 @@ void BV (clib_bihash_init)
   h->log2_nbuckets = max_log2 (nbuckets);
   h->cache_hits = 0;
   h->cache_misses = 0;
+  h->bucket_locks = 0;
 
   h->mheap = mheap_alloc (0 /* use VM */ , memory_size);
 
@@ -49,6 +50,46 @@ void BV (clib_bihash_free) (BVT (clib_bihash) * h)
   memset (h, 0, sizeof (*h));
 }
 
+void BV (clib_bihash_set_bucket_locks) (BVT (clib_bihash) * h, int enable)
+{
+  void *oldheap;
+
+  /*
+   * Size the per-thread working copy vectors up front, so that
+   * concurrent writers never see them move.
+   */
+  if (enable)
+    {
+      oldheap = clib_mem_set_heap (h->mheap);
+      vec_validate (h->working_copies, CLIB_MAX_MHEAPS - 1);
+      vec_validate_init_empty (h->working_copy_lengths, CLIB_MAX_MHEAPS - 1,
+			       ~0);
+      clib_mem_set_heap (oldheap);
+    }
+  h->bucket_locks = (enable != 0);
+}
+
+/*
+ * In per-bucket lock mode, writer_lock only protects the shared
+ * allocator state: the freelists, the working copy vectors and the
+ * mheap. Otherwise the caller already holds it for the whole update.
+ */
+static inline void BV (clib_bihash_alloc_lock) (BVT (clib_bihash) * h)
+{
+  if (h->bucket_locks)
+    while (__sync_lock_test_and_set (h->writer_lock, 1))
+      ;
+}
+
+static inline void BV (clib_bihash_alloc_unlock) (BVT (clib_bihash) * h)
+{
+  if (h->bucket_locks)
+    {
+      CLIB_MEMORY_BARRIER ();
+      h->writer_lock[0] = 0;
+    }
+}
+
 static
 BVT (clib_bihash_value) *
 BV (value_alloc) (BVT (clib_bihash) * h, u32 log2_pages)
@@ -56,6 +97,7 @@ BV (value_alloc) (BVT (clib_bihash) * h, u32 log2_pages)
   BVT (clib_bihash_value) * rv = 0;
   void *oldheap;
 
+  BV (clib_bihash_alloc_lock) (h);
   ASSERT (h->writer_lock[0]);
   if (log2_pages >= vec_len (h->freelists) || h->freelists[log2_pages] == 0)
     {
@@ -71,6 +113,7 @@ BV (value_alloc) (BVT (clib_bihash) * h, u32 log2_pages)
   h->freelists[log2_pages] = rv->next_free;
 
 initialize:
+  BV (clib_bihash_alloc_unlock) (h);
   ASSERT (rv);
   /*
    * Latest gcc complains that the length arg is zero
@@ -85,15 +128,22 @@ static void
 BV (value_free) (BVT (clib_bihash) * h, BVT (clib_bihash_value) * v,
 		 u32 log2_pages)
 {
+  BV (clib_bihash_alloc_lock) (h);
   ASSERT (h->writer_lock[0]);
 
   ASSERT (vec_len (h->freelists) > log2_pages);
 
   v->next_free = h->freelists[log2_pages];
   h->freelists[log2_pages] = v;
+  BV (clib_bihash_alloc_unlock) (h);
 }
 
-static inline void
+/*
+ * Point the (locked) bucket at a private copy of its pages, so that
+ * readers see a consistent view while the original pages are edited
+ * in place. Returns the working copy.
+ */
+static inline BVT (clib_bihash_value) *
 BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
 {
   BVT (clib_bihash_value) * v;
@@ -105,6 +155,7 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
 
   if (thread_index >= vec_len (h->working_copies))
     {
+      ASSERT (h->bucket_locks == 0);
       oldheap = clib_mem_set_heap (h->mheap);
       vec_validate (h->working_copies, thread_index);
       vec_validate_init_empty (h->working_copy_lengths, thread_index, ~0);
@@ -119,11 +170,10 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
   working_copy = h->working_copies[thread_index];
   log2_working_copy_length = h->working_copy_lengths[thread_index];
 
-  h->saved_bucket.as_u64 = b->as_u64;
-  oldheap = clib_mem_set_heap (h->mheap);
-
   if (b->log2_pages > log2_working_copy_length)
     {
+      BV (clib_bihash_alloc_lock) (h);
+      oldheap = clib_mem_set_heap (h->mheap);
       if (working_copy)
 	clib_mem_free (working_copy);
 
@@ -132,14 +182,10 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
 	 CLIB_CACHE_LINE_BYTES);
       h->working_copy_lengths[thread_index] = b->log2_pages;
       h->working_copies[thread_index] = working_copy;
+      clib_mem_set_heap (oldheap);
+      BV (clib_bihash_alloc_unlock) (h);
     }
 
-  clib_mem_set_heap (oldheap);
-
-  /* Lock the bucket... */
-  while (BV (clib_bihash_lock_bucket) (b) == 0)
-    ;
-
   v = BV (clib_bihash_get_value) (h, b->offset);
 
   clib_memcpy (working_copy, v, sizeof (*v) * (1 << b->log2_pages));
@@ -147,7 +193,7 @@ BV (make_working_copy) (BVT (clib_bihash) * h, BVT (clib_bihash_bucket) * b)
   working_bucket.offset = BV (clib_bihash_get_offset) (h, working_copy);
   CLIB_MEMORY_BARRIER ();
   b->as_u64 = working_bucket.as_u64;
-  h->working_copies[thread_index] = working_copy;
+  return working_copy;
 }
 
 static
@@ -246,13 +292,12 @@ int BV (clib_bihash_add_del)
   (BVT (clib_bihash) * h, BVT (clib_bihash_kv) * add_v, int is_add)
 {
   u32 bucket_index;
-  BVT (clib_bihash_bucket) * b, tmp_b;
+  BVT (clib_bihash_bucket) * b, tmp_b, saved_bucket;
   BVT (clib_bihash_value) * v, *new_v, *save_new_v, *working_copy;
   int rv = 0;
   int i, limit;
   u64 hash, new_hash;
   u32 new_log2_pages, old_log2_pages;
-  u32 thread_index = os_get_thread_index ();
   int mark_bucket_linear;
   int resplit_once;
 
@@ -265,7 +310,15 @@ int BV (clib_bihash_add_del)
 
   tmp_b.linear_search = 0;
 
-  while (__sync_lock_test_and_set (h->writer_lock, 1))
+  if (h->bucket_locks == 0)
+    while (__sync_lock_test_and_set (h->writer_lock, 1))
+      ;
+
+  /*
+   * Lock the bucket. Every bucket update below keeps the lock bit set;
+   * the final bucket store at unlock releases it.
+   */
+  while (BV (clib_bihash_lock_bucket) (b) == 0)
     ;
 
   /* First elt in the bucket? */
@@ -282,15 +335,19 @@ int BV (clib_bihash_add_del)
       *v->kvp = *add_v;
       tmp_b.as_u64 = 0;
       tmp_b.offset = BV (clib_bihash_get_offset) (h, v);
+      tmp_b.cache_lru = 1 << 15;
 
+      CLIB_MEMORY_BARRIER ();
       b->as_u64 = tmp_b.as_u64;
       goto unlock;
     }
 
+  saved_bucket.as_u64 = b->as_u64;
+
   /* Note: this leaves the cache disabled */
-  BV (make_working_copy) (h, b);
+  working_copy = BV (make_working_copy) (h, b);
 
-  v = BV (clib_bihash_get_value) (h, h->saved_bucket.offset);
+  v = BV (clib_bihash_get_value) (h, saved_bucket.offset);
 
   limit = BIHASH_KVP_PER_PAGE;
   v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
@@ -310,7 +367,7 @@ int BV (clib_bihash_add_del)
 	      clib_memcpy (&(v->kvp[i]), add_v, sizeof (*add_v));
 	      CLIB_MEMORY_BARRIER ();
 	      /* Restore the previous (k,v) pairs */
-	      b->as_u64 = h->saved_bucket.as_u64;
+	      b->as_u64 = saved_bucket.as_u64;
 	      goto unlock;
 	    }
 	}
@@ -320,7 +377,7 @@ int BV (clib_bihash_add_del)
 	    {
 	      clib_memcpy (&(v->kvp[i]), add_v, sizeof (*add_v));
 	      CLIB_MEMORY_BARRIER ();
-	      b->as_u64 = h->saved_bucket.as_u64;
+	      b->as_u64 = saved_bucket.as_u64;
 	      goto unlock;
 	    }
 	}
@@ -334,20 +391,19 @@ int BV (clib_bihash_add_del)
 	    {
 	      memset (&(v->kvp[i]), 0xff, sizeof (*(add_v)));
 	      CLIB_MEMORY_BARRIER ();
-	      b->as_u64 = h->saved_bucket.as_u64;
+	      b->as_u64 = saved_bucket.as_u64;
 	      goto unlock;
 	    }
 	}
       rv = -3;
-      b->as_u64 = h->saved_bucket.as_u64;
+      b->as_u64 = saved_bucket.as_u64;
       goto unlock;
     }
 
-  old_log2_pages = h->saved_bucket.log2_pages;
+  old_log2_pages = saved_bucket.log2_pages;
   new_log2_pages = old_log2_pages + 1;
   mark_bucket_linear = 0;
 
-  working_copy = h->working_copies[thread_index];
   resplit_once = 0;
 
   new_v = BV (split_and_rehash) (h, working_copy, old_log2_pages,
@@ -405,22 +461,24 @@ int BV (clib_bihash_add_del)
 expand_ok:
   /* Keep track of the number of linear-scan buckets */
   if (tmp_b.linear_search ^ mark_bucket_linear)
-    h->linear_buckets += (mark_bucket_linear == 1) ? 1 : -1;
+    __sync_fetch_and_add (&h->linear_buckets,
+			  (mark_bucket_linear == 1) ? 1 : -1);
 
   tmp_b.log2_pages = new_log2_pages;
   tmp_b.offset = BV (clib_bihash_get_offset) (h, save_new_v);
   tmp_b.linear_search = mark_bucket_linear;
+  tmp_b.cache_lru = 1 << 15;
 
   CLIB_MEMORY_BARRIER ();
   b->as_u64 = tmp_b.as_u64;
-  v = BV (clib_bihash_get_value) (h, h->saved_bucket.offset);
+  v = BV (clib_bihash_get_value) (h, saved_bucket.offset);
   BV (value_free) (h, v, old_log2_pages);
 
 unlock:
-  BV (clib_bihash_reset_cache) (b);
-  BV (clib_bihash_unlock_bucket) (b);
+  BV (clib_bihash_reset_cache_and_unlock) (b);
   CLIB_MEMORY_BARRIER ();
-  h->writer_lock[0] = 0;
+  if (h->bucket_locks == 0)
+    h->writer_lock[0] = 0;
   return rv;
 }
 
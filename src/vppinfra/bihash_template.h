@@ -78,7 +78,13 @@ typedef struct
 
     BVT (clib_bihash_value) ** working_copies;
   int *working_copy_lengths;
-    BVT (clib_bihash_bucket) saved_bucket;
+
+  /*
+   * Per-bucket writer locking. When set, writers serialize on the
+   * target bucket's lock bit, and writer_lock only guards the
+   * freelists, working copy vectors and the mheap.
+   */
+  u8 bucket_locks;
 
   u32 nbuckets;
   u32 log2_nbuckets;
@@ -164,20 +170,15 @@ static inline u8 BV (clib_bihash_get_lru) (BVT (clib_bihash_bucket) * b)
 #endif
 }
 
-static inline void BV (clib_bihash_reset_cache) (BVT (clib_bihash_bucket) * b)
+static inline u16 BV (clib_bihash_initial_lru) (void)
 {
-#if BIHASH_KVP_CACHE_SIZE > 0
-  u16 initial_lru_value;
-
-  memset (b->cache, 0xff, sizeof (b->cache));
+  u16 initial_lru_value = 0;
 
   /*
    * We'll want the cache to be loaded from slot 0 -> slot N, so
    * the initial LRU order is reverse index order.
    */
-  if (BIHASH_KVP_CACHE_SIZE == 1)
-    initial_lru_value = 0;
-  else if (BIHASH_KVP_CACHE_SIZE == 2)
+  if (BIHASH_KVP_CACHE_SIZE == 2)
     initial_lru_value = (0 << 3) | (1 << 0);
   else if (BIHASH_KVP_CACHE_SIZE == 3)
     initial_lru_value = (0 << 6) | (1 << 3) | (2 << 0);
@@ -186,7 +187,14 @@ static inline void BV (clib_bihash_reset_cache) (BVT (clib_bihash_bucket) * b)
   else if (BIHASH_KVP_CACHE_SIZE == 5)
     initial_lru_value = (0 << 12) | (1 << 9) | (2 << 6) | (3 << 3) | (4 << 0);
 
-  b->cache_lru = initial_lru_value;
+  return initial_lru_value;
+}
+
+static inline void BV (clib_bihash_reset_cache) (BVT (clib_bihash_bucket) * b)
+{
+#if BIHASH_KVP_CACHE_SIZE > 0
+  memset (b->cache, 0xff, sizeof (b->cache));
+  b->cache_lru = BV (clib_bihash_initial_lru) ();
 #endif
 }
 
@@ -216,6 +224,26 @@ static inline void BV (clib_bihash_unlock_bucket)
   b->as_u64 = tmp_b.as_u64;
 }
 
+/*
+ * Writer side unlock. The cache is invalidated while the lock bit is
+ * still set, then the final bucket word goes out, unlocked and with a
+ * fresh LRU, in a single store. Only the lock holder writes the word,
+ * so reading it back here is not racy.
+ */
+static inline void BV (clib_bihash_reset_cache_and_unlock)
+  (BVT (clib_bihash_bucket) * b)
+{
+  BVT (clib_bihash_bucket) tmp_b;
+
+#if BIHASH_KVP_CACHE_SIZE > 0
+  memset (b->cache, 0xff, sizeof (b->cache));
+#endif
+  tmp_b.as_u64 = b->as_u64;
+  tmp_b.cache_lru = BV (clib_bihash_initial_lru) ();
+  CLIB_MEMORY_BARRIER ();
+  b->as_u64 = tmp_b.as_u64;
+}
+
 static inline void *BV (clib_bihash_get_value) (BVT (clib_bihash) * h,
 						uword offset)
 {
@@ -242,6 +270,9 @@ void BV (clib_bihash_init)
 
 void BV (clib_bihash_free) (BVT (clib_bihash) * h);
 
+void BV (clib_bihash_set_bucket_locks) (BVT (clib_bihash) * h,
+					int enable);
+
 int BV (clib_bihash_add_del) (BVT (clib_bihash) * h,
 			      BVT (clib_bihash_kv) * add_v, int is_add);
 int BV (clib_bihash_search) (BVT (clib_bihash) * h,
@@ -329,11 +360,44 @@ static inline int BV (clib_bihash_search_inline)
   return -1;
 }
 
-static inline int BV (clib_bihash_search_inline_2)
+static inline void BV (clib_bihash_prefetch_bucket)
+  (BVT (clib_bihash) * h, u64 hash)
+{
+  u32 bucket_index;
+  BVT (clib_bihash_bucket) * b;
+
+  bucket_index = hash & (h->nbuckets - 1);
+  b = &h->buckets[bucket_index];
+
+  CLIB_PREFETCH (b, sizeof (*b), READ);
+}
+
+static inline void BV (clib_bihash_prefetch_data)
+  (BVT (clib_bihash) * h, u64 hash)
+{
+  u32 bucket_index;
+  BVT (clib_bihash_value) * v;
+  BVT (clib_bihash_bucket) * b;
+
+  bucket_index = hash & (h->nbuckets - 1);
+  b = &h->buckets[bucket_index];
+
+  if (PREDICT_FALSE (b->offset == 0))
+    return;
+
+  hash >>= h->log2_nbuckets;
+  v = BV (clib_bihash_get_value) (h, b->offset);
+
+  v += (b->linear_search == 0) ? hash & ((1 << b->log2_pages) - 1) : 0;
+
+  CLIB_PREFETCH (v, sizeof (*v), READ);
+}
+
+static inline int BV (clib_bihash_search_inline_2_with_hash)
   (BVT (clib_bihash) * h,
-   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+   u64 hash, BVT (clib_bihash_kv) * search_key,
+   BVT (clib_bihash_kv) * valuep)
 {
-  u64 hash;
   u32 bucket_index;
   BVT (clib_bihash_value) * v;
   BVT (clib_bihash_bucket) * b;
@@ -343,8 +407,7 @@ static inline int BV (clib_bihash_search_inline_2)
   int i, limit;
 
   ASSERT (valuep);
-
-  hash = BV (clib_bihash_hash) (search_key);
+  ASSERT (hash == BV (clib_bihash_hash) (search_key));
 
   bucket_index = hash & (h->nbuckets - 1);
   b = &h->buckets[bucket_index];
@@ -406,6 +469,64 @@ static inline int BV (clib_bihash_search_inline_2)
   return -1;
 }
 
+static inline int BV (clib_bihash_search_inline_2)
+  (BVT (clib_bihash) * h,
+   BVT (clib_bihash_kv) * search_key, BVT (clib_bihash_kv) * valuep)
+{
+  u64 hash;
+
+  hash = BV (clib_bihash_hash) (search_key);
+
+  return BV (clib_bihash_search_inline_2_with_hash) (h, hash, search_key,
+						     valuep);
+}
+
+/*
+ * Search pipeline depth: keys are hashed and their buckets prefetched
+ * two strides ahead of the search, their value pages one stride ahead.
+ */
+#ifndef BIHASH_SEARCH_BATCH_STRIDE
+#define BIHASH_SEARCH_BATCH_STRIDE 4
+#endif
+
+static inline u32 BV (clib_bihash_search_batch)
+  (BVT (clib_bihash) * h,
+   BVT (clib_bihash_kv) * search_keys,
+   BVT (clib_bihash_kv) * valuesp, int *rvs, u32 n_keys)
+{
+  const u32 d = BIHASH_SEARCH_BATCH_STRIDE;
+  const u32 mask = 4 * BIHASH_SEARCH_BATCH_STRIDE - 1;
+  u64 hashes[4 * BIHASH_SEARCH_BATCH_STRIDE];
+  u32 i, n_found = 0;
+
+  /* Prime the pipeline */
+  for (i = 0; i < clib_min (n_keys, 2 * d); i++)
+    {
+      hashes[i] = BV (clib_bihash_hash) (search_keys + i);
+      BV (clib_bihash_prefetch_bucket) (h, hashes[i]);
+    }
+  for (i = 0; i < clib_min (n_keys, d); i++)
+    BV (clib_bihash_prefetch_data) (h, hashes[i]);
+
+  for (i = 0; i < n_keys; i++)
+    {
+      if (PREDICT_TRUE (i + 2 * d < n_keys))
+	{
+	  hashes[(i + 2 * d) & mask] =
+	    BV (clib_bihash_hash) (search_keys + i + 2 * d);
+	  BV (clib_bihash_prefetch_bucket) (h, hashes[(i + 2 * d) & mask]);
+	}
+      if (PREDICT_TRUE (i + d < n_keys))
+	BV (clib_bihash_prefetch_data) (h, hashes[(i + d) & mask]);
+
+      rvs[i] = BV (clib_bihash_search_inline_2_with_hash)
+	(h, hashes[i & mask], search_keys + i, valuesp + i);
+      n_found += (rvs[i] == 0);
+    }
+
+  return n_found;
+}
+
 #endif /* __included_bihash_template_h__ */
 
 /** @endcond */
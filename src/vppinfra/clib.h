@@ -111,6 +111,15 @@
 #define CLIB_MEMORY_STORE_BARRIER() __sync_synchronize ()
 #endif
 
+/* Spin-wait hint, yields pipeline resources to the sibling hyperthread. */
+#if defined (__x86_64__) || defined (__i386__)
+#define CLIB_PAUSE() __builtin_ia32_pause ()
+#elif defined (__aarch64__) || defined (__arm__)
+#define CLIB_PAUSE() __asm__ volatile ("yield" ::: "memory")
+#else
+#define CLIB_PAUSE()
+#endif
+
 /* Arranges for function to be called before main. */
 #define INIT_FUNCTION(decl)			\
   decl __attribute ((constructor));		\
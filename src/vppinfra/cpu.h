@@ -68,6 +68,7 @@ _ (avx,      1, ecx, 28)  \
 _ (avx2,     7, ebx, 5)   \
 _ (avx512f,  7, ebx, 16)  \
 _ (aes,      1, ecx, 25)  \
+_ (pclmulqdq, 1, ecx, 1)  \
 _ (sha,      7, ebx, 29)  \
 _ (invariant_tsc, 0x80000007, edx, 8)
 
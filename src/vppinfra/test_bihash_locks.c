@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Per-bucket writer locks on a table type with a kv cache.
+ *
+ * Writer threads add and delete keys from their own key ranges while
+ * reader threads search a set of keys that never change. Few buckets, so
+ * writers keep colliding on the same bucket, and readers filling the
+ * cache take the same lock bit. Each writer checks every add and delete
+ * with a search, and at the end the table must hold exactly the keys the
+ * writers think it does, plus all of the readers' keys.
+ *
+ * A reader can miss while a writer recycles the pages it is walking, so
+ * reader misses are reported but don't fail the test.
+ *
+ * test_bihash_locks [writers <n>] [readers <n>] [nbuckets <n>]
+ *                   [keys <n>] [iterations <n>] [seed <n>]
+ */
+
+#include <vppinfra/time.h>
+#include <vppinfra/cache.h>
+#include <vppinfra/error.h>
+
+#include <vppinfra/bihash_16_8.h>
+#include <vppinfra/bihash_template.h>
+
+#include <vppinfra/bihash_template.c>
+
+#include <pthread.h>
+
+#define MAX_THREADS 64
+
+typedef struct
+{
+  u32 n_writers;
+  u32 n_readers;
+  u32 nbuckets;
+  u32 keys_per_thread;
+  u32 iterations;
+  u32 seed;
+  volatile u32 go;
+  volatile u32 stop;
+  BVT (clib_bihash) hash;
+} test_main_t;
+
+typedef struct
+{
+  test_main_t *tm;
+  u32 thread_index;
+  u32 seed;
+  u8 *present;
+  u32 n_failed;
+  u32 n_misses;
+} test_thread_t;
+
+test_main_t test_main;
+
+static void
+make_key (BVT (clib_bihash_kv) * kv, u32 thread_index, u32 i)
+{
+  /* Writers use thread indices from 1, readers' static keys 0 */
+  kv->key[0] = ((u64) thread_index << 32) | i;
+  kv->key[1] = ~kv->key[0];
+}
+
+static void *
+writer_thread (void *arg)
+{
+  test_thread_t *t = arg;
+  test_main_t *tm = t->tm;
+  BVT (clib_bihash_kv) kv, result;
+  u32 i, k;
+  int found;
+
+  /* Distinct thread indices give each writer its own working copy */
+  __os_thread_index = t->thread_index;
+
+  while (tm->go == 0)
+    ;
+
+  for (i = 0; i < tm->iterations; i++)
+    {
+      k = random_u32 (&t->seed) % tm->keys_per_thread;
+      make_key (&kv, t->thread_index, k);
+
+      if (t->present[k])
+	{
+	  BV (clib_bihash_add_del) (&tm->hash, &kv, 0 /* is_add */ );
+	  t->present[k] = 0;
+	  found = BV (clib_bihash_search) (&tm->hash, &kv, &result) == 0;
+	  t->n_failed += found;
+	}
+      else
+	{
+	  kv.value = i;
+	  BV (clib_bihash_add_del) (&tm->hash, &kv, 1 /* is_add */ );
+	  t->present[k] = 1;
+	  found = BV (clib_bihash_search) (&tm->hash, &kv, &result) == 0;
+	  t->n_failed += !found || result.value != i;
+	}
+    }
+  return 0;
+}
+
+static void *
+reader_thread (void *arg)
+{
+  test_thread_t *t = arg;
+  test_main_t *tm = t->tm;
+  BVT (clib_bihash_kv) kv, result;
+  u32 k;
+
+  while (tm->go == 0)
+    ;
+
+  while (tm->stop == 0)
+    {
+      k = random_u32 (&t->seed) % tm->keys_per_thread;
+      make_key (&kv, 0, k);
+      if (BV (clib_bihash_search) (&tm->hash, &kv, &result) < 0
+	  || result.value != k)
+	t->n_misses++;
+    }
+  return 0;
+}
+
+static clib_error_t *
+test_bihash_locks (test_main_t * tm)
+{
+  test_thread_t threads[MAX_THREADS];
+  pthread_t ids[MAX_THREADS];
+  BVT (clib_bihash_kv) kv, result;
+  u32 i, k, n_threads, n_failed = 0, n_misses = 0, n_lost = 0;
+  test_thread_t *t;
+
+  n_threads = tm->n_writers + tm->n_readers;
+  if (tm->n_writers == 0 || n_threads > MAX_THREADS)
+    return clib_error_return (0, "need 1 to %d threads, at least one "
+			      "writer", MAX_THREADS);
+
+  BV (clib_bihash_init) (&tm->hash, "test", tm->nbuckets, 1ULL << 30);
+  BV (clib_bihash_set_bucket_locks) (&tm->hash, 1);
+
+  /* The readers' keys */
+  for (k = 0; k < tm->keys_per_thread; k++)
+    {
+      make_key (&kv, 0, k);
+      kv.value = k;
+      BV (clib_bihash_add_del) (&tm->hash, &kv, 1 /* is_add */ );
+    }
+
+  memset (threads, 0, sizeof (threads));
+  for (i = 0; i < n_threads; i++)
+    {
+      t = threads + i;
+      t->tm = tm;
+      t->thread_index = i + 1;
+      t->seed = tm->seed + i;
+      /* Allocated here, the writers run on their own heaps */
+      vec_validate (t->present, tm->keys_per_thread - 1);
+      if (pthread_create (ids + i, NULL, i < tm->n_writers ?
+			  writer_thread : reader_thread, t))
+	return clib_error_return_unix (0, "pthread_create");
+    }
+
+  tm->go = 1;
+  for (i = 0; i < tm->n_writers; i++)
+    pthread_join (ids[i], NULL);
+  tm->stop = 1;
+  for (; i < n_threads; i++)
+    pthread_join (ids[i], NULL);
+
+  for (i = 0; i < n_threads; i++)
+    {
+      n_failed += threads[i].n_failed;
+      n_misses += threads[i].n_misses;
+      if (i >= tm->n_writers)
+	vec_free (threads[i].present);
+    }
+
+  /* The table must hold exactly what the writers think it does */
+  for (k = 0; k < tm->keys_per_thread; k++)
+    {
+      make_key (&kv, 0, k);
+      if (BV (clib_bihash_search) (&tm->hash, &kv, &result) < 0
+	  || result.value != k)
+	n_lost++;
+    }
+  for (i = 0; i < tm->n_writers; i++)
+    {
+      t = threads + i;
+      for (k = 0; k < tm->keys_per_thread; k++)
+	{
+	  make_key (&kv, t->thread_index, k);
+	  if ((BV (clib_bihash_search) (&tm->hash, &kv, &result) == 0)
+	      != t->present[k])
+	    n_lost++;
+	}
+      vec_free (t->present);
+    }
+
+  fformat (stdout, "%d writers, %d readers, %d buckets: %d failed "
+	   "searches, %d reader misses, %d keys lost or leaked\n",
+	   tm->n_writers, tm->n_readers, tm->nbuckets, n_failed, n_misses,
+	   n_lost);
+
+  if (tm->hash.nbuckets < 16)
+    fformat (stdout, "%U", BV (format_bihash), &tm->hash, 0 /* verbose */ );
+
+  BV (clib_bihash_free) (&tm->hash);
+
+  if (n_failed || n_lost)
+    return clib_error_return (0, "concurrent add/del corrupted the table");
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unformat_input_t i;
+  clib_error_t *error = 0;
+  test_main_t *tm = &test_main;
+
+  clib_mem_init (0, 3ULL << 30);
+
+  tm->n_writers = 4;
+  tm->n_readers = 2;
+  tm->nbuckets = 4;
+  tm->keys_per_thread = 32;
+  tm->iterations = 100000;
+  tm->seed = 0xdeaddabe;
+
+  unformat_init_command_line (&i, argv);
+  while (unformat_check_input (&i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (&i, "writers %u", &tm->n_writers))
+	;
+      else if (unformat (&i, "readers %u", &tm->n_readers))
+	;
+      else if (unformat (&i, "nbuckets %u", &tm->nbuckets))
+	;
+      else if (unformat (&i, "keys %u", &tm->keys_per_thread))
+	;
+      else if (unformat (&i, "iterations %u", &tm->iterations))
+	;
+      else if (unformat (&i, "seed %u", &tm->seed))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, &i);
+	  break;
+	}
+    }
+  unformat_free (&i);
+
+  if (!error)
+    error = test_bihash_locks (tm);
+
+  if (error)
+    {
+      clib_error_report (error);
+      return 1;
+    }
+  return 0;
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
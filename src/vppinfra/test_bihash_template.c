@@ -21,6 +21,11 @@
 
 #include <vppinfra/bihash_template.c>
 
+#include <pthread.h>
+
+#define MAX_THREADS 64
+#define SEARCH_BATCH_SIZE 256
+
 typedef struct
 {
   u64 seed;
@@ -30,6 +35,7 @@ typedef struct
   int careful_delete_tests;
   int verbose;
   int non_random_keys;
+  u32 nthreads;
   uword *key_hash;
   u64 *keys;
     BVT (clib_bihash) hash;
@@ -41,6 +47,15 @@ typedef struct
 
 test_main_t test_main;
 
+typedef struct
+{
+  test_main_t *tm;
+  u32 thread_index;
+  u32 first_key;
+  u32 n_keys;
+  volatile u32 *go;
+} test_thread_args_t;
+
 uword
 vl (void *v)
 {
@@ -236,6 +251,212 @@ test_bihash (test_main_t * tm)
   return 0;
 }
 
+static void *
+test_bihash_insert_thread (void *arg)
+{
+  test_thread_args_t *a = arg;
+  test_main_t *tm = a->tm;
+  BVT (clib_bihash_kv) kv;
+  u32 i;
+
+  /* Distinct thread indices give each writer its own working copy */
+  __os_thread_index = a->thread_index;
+
+  while (a->go[0] == 0)
+    ;
+
+  for (i = a->first_key; i < a->first_key + a->n_keys; i++)
+    {
+      kv.key = tm->keys[i];
+      kv.value = i + 1;
+      BV (clib_bihash_add_del) (&tm->hash, &kv, 1 /* is_add */ );
+    }
+  return 0;
+}
+
+static clib_error_t *
+test_bihash_threads (test_main_t * tm)
+{
+  test_thread_args_t args[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  BVT (clib_bihash) * h = &tm->hash;
+  BVT (clib_bihash_kv) kv;
+  volatile u32 go;
+  u32 i, n_threads, per_thread, n_failed;
+  int bucket_locks;
+  f64 before, delta;
+
+  if (tm->nthreads == 0 || tm->nthreads > MAX_THREADS)
+    return clib_error_return (0, "threads must be in 1..%d", MAX_THREADS);
+
+  fformat (stdout, "Pick %d unique random keys...\n", tm->nitems);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      u64 rndkey;
+
+      do
+	rndkey = random_u64 (&tm->seed);
+      while (hash_get (tm->key_hash, rndkey));
+
+      hash_set (tm->key_hash, rndkey, i + 1);
+      vec_add1 (tm->keys, rndkey);
+    }
+
+  for (bucket_locks = 0; bucket_locks < 2; bucket_locks++)
+    {
+      n_threads = 1;
+      while (1)
+	{
+	  BV (clib_bihash_init) (h, "test", tm->nbuckets, 3ULL << 30);
+	  BV (clib_bihash_set_bucket_locks) (h, bucket_locks);
+
+	  per_thread = tm->nitems / n_threads;
+	  go = 0;
+
+	  for (i = 0; i < n_threads; i++)
+	    {
+	      args[i].tm = tm;
+	      args[i].thread_index = i + 1;
+	      args[i].first_key = i * per_thread;
+	      args[i].n_keys = (i == n_threads - 1) ?
+		tm->nitems - i * per_thread : per_thread;
+	      args[i].go = &go;
+	      if (pthread_create (&threads[i], NULL,
+				  test_bihash_insert_thread, &args[i]))
+		return clib_error_return_unix (0, "pthread_create");
+	    }
+
+	  before = clib_time_now (&tm->clib_time);
+	  go = 1;
+
+	  for (i = 0; i < n_threads; i++)
+	    pthread_join (threads[i], NULL);
+
+	  delta = clib_time_now (&tm->clib_time) - before;
+
+	  n_failed = 0;
+	  for (i = 0; i < tm->nitems; i++)
+	    {
+	      kv.key = tm->keys[i];
+	      if (BV (clib_bihash_search) (h, &kv, &kv) < 0
+		  || kv.value != (u64) (i + 1))
+		n_failed++;
+	    }
+
+	  fformat (stdout, "%s lock, %2d threads: %d adds in %.6f seconds, "
+		   "%.f adds per second%s\n",
+		   bucket_locks ? "bucket" : "writer", n_threads, tm->nitems,
+		   delta, delta > 0 ? (f64) tm->nitems / delta : 0.0,
+		   n_failed ? "" : ", all keys found");
+
+	  if (n_failed)
+	    clib_warning ("%d of %d keys missing after concurrent adds",
+			  n_failed, tm->nitems);
+
+	  if (tm->verbose > 1)
+	    fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+
+	  BV (clib_bihash_free) (h);
+
+	  /* 1, 2, 4, ... threads, always finishing with tm->nthreads */
+	  if (n_threads == tm->nthreads)
+	    break;
+	  n_threads = clib_min (n_threads << 1, tm->nthreads);
+	}
+    }
+
+  return 0;
+}
+
+static clib_error_t *
+test_bihash_batch (test_main_t * tm)
+{
+  BVT (clib_bihash) * h = &tm->hash;
+  BVT (clib_bihash_kv) keys[SEARCH_BATCH_SIZE], results[SEARCH_BATCH_SIZE];
+  int rvs[SEARCH_BATCH_SIZE];
+  u32 i, j, k, n, n_found;
+  u64 total_searches;
+  f64 before, delta;
+
+  fformat (stdout, "Pick and add %d unique random keys...\n", tm->nitems);
+
+  BV (clib_bihash_init) (h, "test", tm->nbuckets, 3ULL << 30);
+
+  for (i = 0; i < tm->nitems; i++)
+    {
+      u64 rndkey;
+
+      do
+	rndkey = random_u64 (&tm->seed);
+      while (hash_get (tm->key_hash, rndkey));
+
+      hash_set (tm->key_hash, rndkey, i + 1);
+      vec_add1 (tm->keys, rndkey);
+
+      keys[0].key = rndkey;
+      keys[0].value = i + 1;
+      BV (clib_bihash_add_del) (h, keys, 1 /* is_add */ );
+    }
+
+  fformat (stdout, "%U", BV (format_bihash), h, 0 /* verbose */ );
+
+  total_searches = (u64) tm->search_iter * (u64) tm->nitems;
+
+  /* One key at a time */
+  n_found = 0;
+  before = clib_time_now (&tm->clib_time);
+
+  for (j = 0; j < tm->search_iter; j++)
+    for (i = 0; i < tm->nitems; i++)
+      {
+	keys[0].key = tm->keys[i];
+	n_found += BV (clib_bihash_search_inline_2) (h, keys, results) == 0;
+      }
+
+  delta = clib_time_now (&tm->clib_time) - before;
+
+  fformat (stdout, "single: %lld searches in %.6f seconds, "
+	   "%.f searches per second, %lld found\n",
+	   total_searches, delta,
+	   delta > 0 ? (f64) total_searches / delta : 0.0, (u64) n_found);
+
+  /* SEARCH_BATCH_SIZE keys at a time, as a graph node would */
+  n_found = 0;
+  before = clib_time_now (&tm->clib_time);
+
+  for (j = 0; j < tm->search_iter; j++)
+    for (i = 0; i < tm->nitems; i += n)
+      {
+	n = clib_min (tm->nitems - i, SEARCH_BATCH_SIZE);
+	for (k = 0; k < n; k++)
+	  keys[k].key = tm->keys[i + k];
+	n_found += BV (clib_bihash_search_batch) (h, keys, results, rvs, n);
+      }
+
+  delta = clib_time_now (&tm->clib_time) - before;
+
+  fformat (stdout, "batch:  %lld searches in %.6f seconds, "
+	   "%.f searches per second, %lld found\n",
+	   total_searches, delta,
+	   delta > 0 ? (f64) total_searches / delta : 0.0, (u64) n_found);
+
+  for (i = 0; i < tm->nitems; i += n)
+    {
+      n = clib_min (tm->nitems - i, SEARCH_BATCH_SIZE);
+      for (k = 0; k < n; k++)
+	keys[k].key = tm->keys[i + k];
+      BV (clib_bihash_search_batch) (h, keys, results, rvs, n);
+      for (k = 0; k < n; k++)
+	if (rvs[k] || results[k].value != (u64) (i + k + 1))
+	  clib_warning ("[%d] batch search for key %lld failed", i + k,
+			tm->keys[i + k]);
+    }
+
+  BV (clib_bihash_free) (h);
+  return 0;
+}
+
 clib_error_t *
 test_bihash_cache (test_main_t * tm)
 {
@@ -297,6 +518,10 @@ test_bihash_main (test_main_t * tm)
 	which = 1;
       else if (unformat (i, "cache"))
 	which = 2;
+      else if (unformat (i, "threads %d", &tm->nthreads))
+	which = 3;
+      else if (unformat (i, "batch"))
+	which = 4;
 
       else if (unformat (i, "verbose"))
 	tm->verbose = 1;
@@ -319,6 +544,14 @@ test_bihash_main (test_main_t * tm)
       error = test_bihash_cache (tm);
       break;
 
+    case 3:
+      error = test_bihash_threads (tm);
+      break;
+
+    case 4:
+      error = test_bihash_batch (tm);
+      break;
+
     default:
       return clib_error_return (0, "no such test?");
     }
@@ -381,5 +381,86 @@ class TestClassifier(VppTestCase):
         # and the table should be gone.
         self.assertFalse(self.verify_vrf(self.pbr_vrfid))
 
+    def get_ip4_classify_hits(self):
+        """Return the ip4-classify node's hit counter"""
+        for line in self.vapi.cli("show errors").splitlines():
+            if "ip4-classify" in line and line.endswith("Classify hits"):
+                return int(line.split()[0])
+        return 0
+
+    def add_del_tss_rule(self, table_index, rule_index, ip4_offset,
+                         ip4_addr, is_add=1):
+        """Add/Delete a tss rule matching a whole IPv4 address
+
+        The table skips one vector and matches two, from the start of
+        the ethernet header.
+
+        :param int table_index: tss table index.
+        :param int rule_index: rule order, lowest first.
+        :param int ip4_offset: offset of the address in the IPv4 header.
+        :param str ip4_addr: address with format of "x.x.x.x".
+        :param int is_add: option to configure the rule.
+            - create(1) or delete(0)
+        """
+        offset = 14 + ip4_offset
+        mask = '\x00' * (offset - 16) + '\xff' * 4
+        mask += '\x00' * (32 - len(mask))
+        match = '\x00' * offset + socket.inet_aton(ip4_addr)
+        match += '\x00' * (48 - len(match))
+        r = self.vapi.classify_tss_add_del_rule(
+            is_add, table_index, rule_index, mask + match,
+            hit_next_index=0)
+        self.assertIsNotNone(r, msg='No response msg for tss_add_del_rule')
+
+    def test_tss_ip4_classify(self):
+        """ TSS classify table test
+
+        Test scenario for a tuple space search table on an ip4 route
+            - Create a tss table with a dst and a src IP rule.
+            - Route pg1's neighbour through the table.
+            - Send traffic from pg0 and verify the src IP rule drops it.
+            - Delete the table and verify its set is gone.
+        """
+
+        r = self.vapi.classify_tss_add_del_table(
+            1, skip_n_vectors=1, match_n_vectors=2)
+        self.assertIsNotNone(r, msg='No response msg for tss_add_del_table')
+        table_index = r.new_table_index
+
+        # rules of different masks, the first one does not match
+        self.add_del_tss_rule(table_index, 1, 16, self.pg2.remote_ip4)
+        self.add_del_tss_rule(table_index, 2, 12, self.pg0.remote_ip4)
+        reply = self.vapi.cli("show classify tss")
+        self.assertIn("2 rules in 2 tuples", reply)
+
+        self.vapi.ip_add_del_route(self.pg1.remote_ip4n, 32,
+                                   self.pg1.remote_ip4n,
+                                   is_classify=1,
+                                   classify_table_index=table_index)
+
+        hits = self.get_ip4_classify_hits()
+        pkts = self.create_stream(self.pg0, self.pg1, self.pg_if_packet_sizes)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        self.pg1.assert_nothing_captured(remark="packets forwarded")
+        self.assertEqual(self.get_ip4_classify_hits() - hits, len(pkts))
+
+        self.vapi.ip_add_del_route(self.pg1.remote_ip4n, 32,
+                                   self.pg1.remote_ip4n,
+                                   is_classify=1,
+                                   classify_table_index=table_index,
+                                   is_add=0)
+        self.add_del_tss_rule(table_index, 1, 16, self.pg2.remote_ip4,
+                              is_add=0)
+        reply = self.vapi.cli("show classify tss")
+        self.assertIn("1 rules in 1 tuples", reply)
+
+        # and the set goes with the table.
+        self.vapi.classify_tss_add_del_table(0, table_index=table_index)
+        reply = self.vapi.cli("show classify tss")
+        self.assertIn("No tuple space search sets configured", reply)
+
 if __name__ == '__main__':
     unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+
+import unittest
+
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, TCP
+from scapy.layers.inet6 import IPv6
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestGSO(VppTestCase):
+    """ GSO Test Case
+
+    pg interfaces don't take GSO packets, so the interface output node
+    segments them. "test gso" sends one GSO packet, whose payload byte
+    at offset n is n % 256, to the interface's output node.
+    """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestGSO, cls).setUpClass()
+
+        cls.create_pg_interfaces(range(1))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+
+    def tearDown(self):
+        super(TestGSO, self).tearDown()
+        if not self.vpp_dead:
+            self.logger.info(self.vapi.cli("show errors"))
+
+    def check_checksums(self, p, ip_layer):
+        new = p.__class__(str(p))
+        if ip_layer == IP:
+            del new[IP].chksum
+        del new[TCP].chksum
+        new = new.__class__(str(new))
+        if ip_layer == IP:
+            self.assertEqual(new[IP].chksum, p[IP].chksum)
+        self.assertEqual(new[TCP].chksum, p[TCP].chksum)
+
+    def send_gso(self, ip_layer, size, mss, chunk=1001):
+        n_segs = (size + mss - 1) / mss
+        self.pg0.enable_capture()
+        self.vapi.cli("test gso %s%s size %d mss %d chunk %d" %
+                      (self.pg0.name, " ip6" if ip_layer == IPv6 else "",
+                       size, mss, chunk))
+        rx = self.pg0.get_capture(n_segs)
+
+        payload = ""
+        for i, p in enumerate(rx):
+            n_payload = min(mss, size - i * mss)
+            self.assertEqual(len(p[TCP].payload), n_payload)
+            if ip_layer == IP:
+                self.assertEqual(p[IP].len, 40 + n_payload)
+                self.assertEqual(p[IP].id, 1 + i)
+            else:
+                self.assertEqual(p[IPv6].plen, 20 + n_payload)
+            self.assertEqual(p[TCP].seq, 1000 + i * mss)
+            # PSH on the last segment only
+            self.assertEqual(p[TCP].flags,
+                             0x18 if i == n_segs - 1 else 0x10)
+            self.check_checksums(p, ip_layer)
+            payload += str(p[TCP].payload)
+
+        self.assertEqual(payload,
+                         "".join(chr(i % 256) for i in range(size)))
+
+    def test_gso_ip4(self):
+        """ GSO segmentation, IPv4 """
+        self.send_gso(IP, 8000, 1448)
+        self.send_gso(IP, 1448, 1448)
+        self.send_gso(IP, 1449, 1447, chunk=1)
+        self.send_gso(IP, 9001, 4000, chunk=2048)
+
+    def test_gso_ip6(self):
+        """ GSO segmentation, IPv6 """
+        self.send_gso(IPv6, 8000, 1428)
+        self.send_gso(IPv6, 1, 1428)
+        self.send_gso(IPv6, 3001, 999, chunk=3)
+        self.send_gso(IPv6, 9001, 4000, chunk=2048)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
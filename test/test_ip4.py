@@ -469,6 +469,141 @@ class TestIPv4FibCrud(VppTestCase):
         self.verify_not_in_route_dump(fib_dump, self.deleted_routes)
 
 
+class TestIPv4FibBulk(VppTestCase):
+    """ FIB - bulk add/delete - ip4 routes """
+
+    def setUp(self):
+        super(TestIPv4FibBulk, self).setUp()
+
+        self.create_pg_interfaces(range(3))
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+        super(TestIPv4FibBulk, self).tearDown()
+
+    def send_and_expect(self, input, pkts, output):
+        input.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        return output.get_capture(len(pkts))
+
+    def bulk_routes(self):
+        """ /32s via pg0 and /24s via pg1, two per /16 so they share
+        covers """
+        routes = []
+        for ii in range(200):
+            routes.append({
+                'prefix': "10.%d.%d.%d" % (1 + ii / 100, ii % 100, ii),
+                'len': 32,
+                'nh': self.pg0.remote_ip4})
+            routes.append({
+                'prefix': "11.%d.%d.0" % (1 + ii / 100, ii),
+                'len': 24,
+                'nh': self.pg1.remote_ip4})
+        for r in routes:
+            r['dst_address'] = socket.inet_pton(socket.AF_INET, r['prefix'])
+            r['dst_address_length'] = r['len']
+            r['next_hop_address'] = socket.inet_pton(socket.AF_INET,
+                                                     r['nh'])
+        return routes
+
+    def fib_routes(self):
+        fib = {}
+        for d in self.vapi.ip_fib_dump():
+            if d.table_id == 0:
+                fib[(socket.inet_ntoa(d.address),
+                     d.address_length)] = d
+        return fib
+
+    def verify_fib(self, present, absent):
+        fib = self.fib_routes()
+        for r in present:
+            d = fib.get((r['prefix'], r['len']))
+            self.assertTrue(d, "%s/%d in the FIB" % (r['prefix'], r['len']))
+            self.assertEqual(d.count, 1)
+            self.assertEqual(d.path[0].next_hop[:4], r['next_hop_address'])
+        for r in absent:
+            self.assertFalse((r['prefix'], r['len']) in fib,
+                             "%s/%d not in the FIB" % (r['prefix'],
+                                                       r['len']))
+
+    def verify_forwarding(self, routes):
+        """ one packet to each route, out of its next hop's interface """
+        for itf in [self.pg0, self.pg1]:
+            pkts = []
+            for r in routes:
+                if r['nh'] != itf.remote_ip4:
+                    continue
+                dst = r['prefix']
+                if r['len'] == 24:
+                    dst = dst[:-1] + '9'
+                pkts.append(Ether(src=self.pg2.remote_mac,
+                                  dst=self.pg2.local_mac) /
+                            IP(src=self.pg2.remote_ip4, dst=dst) /
+                            UDP(sport=1234, dport=1234) /
+                            Raw('\xa5' * 100))
+            rx = self.send_and_expect(self.pg2, pkts, itf)
+            for p in rx:
+                self.assertEqual(p[Ether].dst, itf.remote_mac)
+
+    def test_fib_bulk(self):
+        """ Bulk route add/delete """
+
+        routes = self.bulk_routes()
+
+        #
+        # add them all in one batch
+        #
+        reply = self.vapi.ip_add_del_route_bulk(routes)
+        self.assertEqual(reply.n_routes, len(routes))
+        self.verify_fib(routes, [])
+        self.verify_forwarding(routes[::17])
+
+        #
+        # adding the same routes again is an update, not a duplicate
+        #
+        reply = self.vapi.ip_add_del_route_bulk(routes)
+        self.assertEqual(reply.n_routes, len(routes))
+        self.verify_fib(routes, [])
+
+        #
+        # delete every other route, the rest still forward
+        #
+        deleted = routes[::2]
+        kept = routes[1::2]
+        reply = self.vapi.ip_add_del_route_bulk(deleted, is_add=0)
+        self.assertEqual(reply.n_routes, len(deleted))
+        self.verify_fib(kept, deleted)
+        self.verify_forwarding(kept[::7])
+
+        #
+        # a bad route stops the batch, the routes before it are in
+        #
+        bad = {'prefix': "12.0.0.0", 'len': 33, 'nh': self.pg0.remote_ip4}
+        bad['dst_address'] = socket.inet_pton(socket.AF_INET, bad['prefix'])
+        bad['dst_address_length'] = bad['len']
+        bad['next_hop_address'] = socket.inet_pton(socket.AF_INET, bad['nh'])
+        with self.vapi.expect_negative_api_retval():
+            reply = self.vapi.ip_add_del_route_bulk(deleted[:3] + [bad] +
+                                                    deleted[3:6])
+        self.assertEqual(reply.n_routes, 3)
+        self.verify_fib(kept + deleted[:3], deleted[3:6])
+
+        #
+        # delete the lot
+        #
+        reply = self.vapi.ip_add_del_route_bulk(kept + deleted[:3],
+                                                is_add=0)
+        self.assertEqual(reply.n_routes, len(kept) + 3)
+        self.verify_fib([], routes)
+
+
 class TestIPNull(VppTestCase):
     """ IPv4 routes via NULL """
 
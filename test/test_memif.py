@@ -0,0 +1,136 @@
+#!/usr/bin/env python
+
+import unittest
+
+from scapy.packet import Raw
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestMemif(VppTestCase):
+    """ Memif Test Case
+
+    A master and a slave memif in the same VPP, connected to each other
+    through one socket under two names, as a socket file cannot be used
+    by a master and a slave both. Traffic goes:
+
+        pg0 <-> slave memif === master memif <-> pg1
+
+    with L2 cross-connects at both ends.
+    """
+
+    def setUp(self):
+        super(TestMemif, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+        for i in self.pg_interfaces:
+            i.admin_up()
+
+        self.memifs = []
+
+    def tearDown(self):
+        for sw_if_index in self.memifs:
+            self.vapi.memif_delete(sw_if_index)
+        for i in self.pg_interfaces:
+            i.admin_down()
+        super(TestMemif, self).tearDown()
+
+    def create_memif_pair(self, zero_copy):
+        socket = "%s/memif.sock" % self.tempdir
+        master = self.vapi.memif_create(0, socket,
+                                        ring_size=256).sw_if_index
+        self.memifs.append(master)
+        slave = self.vapi.memif_create(1, "%s/./memif.sock" % self.tempdir,
+                                       ring_size=256,
+                                       zero_copy=zero_copy).sw_if_index
+        self.memifs.append(slave)
+
+        for sw_if_index in [master, slave]:
+            self.vapi.sw_interface_set_flags(sw_if_index, 1)
+
+        self.vapi.sw_interface_set_l2_xconnect(
+            self.pg0.sw_if_index, slave, enable=1)
+        self.vapi.sw_interface_set_l2_xconnect(
+            slave, self.pg0.sw_if_index, enable=1)
+        self.vapi.sw_interface_set_l2_xconnect(
+            self.pg1.sw_if_index, master, enable=1)
+        self.vapi.sw_interface_set_l2_xconnect(
+            master, self.pg1.sw_if_index, enable=1)
+
+        return master, slave
+
+    def wait_for_link_up(self, sw_if_indexes, timeout=5):
+        """ the slave connects from the memif process, so it takes a
+        moment """
+        for _ in range(timeout * 10):
+            up = [d.sw_if_index for d in self.vapi.memif_dump()
+                  if d.link_up_down]
+            if all(i in up for i in sw_if_indexes):
+                return
+            self.sleep(0.1, "waiting for memif link up")
+        self.fail("memif link is not up")
+
+    def create_stream(self, src_if, dst_if, sizes):
+        pkts = []
+        for size in sizes:
+            info = self.create_packet_info(src_if, dst_if)
+            payload = self.info_to_payload(info)
+            p = (Ether(dst="00:00:00:00:00:02", src="00:00:00:00:00:01") /
+                 IP(src="10.0.0.1", dst="10.0.0.2") /
+                 UDP(sport=1234, dport=1234) /
+                 Raw(payload))
+            info.data = p.copy()
+            self.extend_packet(p, size)
+            pkts.append(p)
+        return pkts
+
+    def send_and_verify(self, src_if, dst_if, sizes):
+        pkts = self.create_stream(src_if, dst_if, sizes)
+        src_if.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        rx = dst_if.get_capture(len(pkts))
+        for p, r in zip(pkts, rx):
+            self.assertEqual(str(p), str(r))
+
+    def run_traffic(self, zero_copy):
+        master, slave = self.create_memif_pair(zero_copy)
+        self.wait_for_link_up([master, slave])
+
+        dump = dict((d.sw_if_index, d) for d in self.vapi.memif_dump())
+        self.assertEqual(dump[master].zero_copy, 0)
+        self.assertEqual(dump[slave].zero_copy, zero_copy)
+
+        # a few sizes, one of which takes two buffers. Each burst fits
+        # in the 256 slot ring, and a few of them make it wrap.
+        sizes = [64, 128, 1500, 3000] * 40
+
+        for _ in range(3):
+            # slave tx: its buffers are handed to the master
+            self.send_and_verify(self.pg0, self.pg1, sizes)
+            # slave rx: the master writes into the slave's buffers
+            self.send_and_verify(self.pg1, self.pg0, sizes)
+
+        self.logger.info(self.vapi.cli("show memif"))
+
+    def test_memif_copy(self):
+        """ Memif traffic, copy mode """
+        self.run_traffic(zero_copy=0)
+
+    def test_memif_zero_copy(self):
+        """ Memif traffic, zero-copy slave """
+        self.run_traffic(zero_copy=1)
+
+    def test_memif_zero_copy_master(self):
+        """ Memif zero-copy master is refused """
+        with self.vapi.expect_negative_api_retval():
+            self.vapi.memif_create(0, "%s/memif.sock" % self.tempdir,
+                                   zero_copy=1)
+        self.assertEqual(len(self.vapi.memif_dump()), 0)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
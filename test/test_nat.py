@@ -712,6 +712,8 @@ class TestNAT44(MethodHolder):
         """
         Clear NAT44 configuration.
         """
+        self.vapi.cli("set nat44 timeout reset")
+
         # I found no elegant way to do this
         self.vapi.ip_add_del_route(dst_address=self.pg7.remote_ip4n,
                                    dst_address_length=32,
@@ -2601,6 +2603,29 @@ class TestNAT44(MethodHolder):
         sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4n, 0)
         self.assertEqual(nsessions - len(sessions), 2)
 
+    def test_session_timeout(self):
+        """ NAT44 dynamic session timeouts """
+        self.nat44_add_address(self.nat_addr)
+        self.vapi.nat44_interface_add_del_feature(self.pg0.sw_if_index)
+        self.vapi.nat44_interface_add_del_feature(self.pg1.sw_if_index,
+                                                  is_inside=0)
+        self.vapi.cli("set nat44 timeout udp 5 tcp-established 5 "
+                      "tcp-transitory 5 icmp 5")
+
+        pkts = self.create_stream_in(self.pg0, self.pg1)
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        capture = self.pg1.get_capture(len(pkts))
+
+        sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4n, 0)
+        self.assertEqual(len(sessions), len(pkts))
+
+        sleep(10)
+
+        users = self.vapi.nat44_user_dump()
+        self.assertEqual(len(users), 0)
+
     def test_set_get_reass(self):
         """ NAT44 set/get virtual fragmentation reassembly """
         reas_cfg1 = self.vapi.nat_get_reass()
@@ -0,0 +1,45 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestStatSegment(VppTestCase):
+    """ Stats Segment Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestStatSegment, cls).setUpClass()
+
+    def setUp(self):
+        super(TestStatSegment, self).setUp()
+
+    def tearDown(self):
+        super(TestStatSegment, self).tearDown()
+
+    def test_statseg_name(self):
+        """ Stats segment named after the api-segment prefix """
+        reply = self.vapi.cli("show statseg")
+        self.assertIn("'%s-vpp-stats'" % self.shm_prefix, reply)
+
+    def test_statseg_counters(self):
+        """ Stats segment counters read back through the segment """
+        error = self.vapi.cli("test statseg")
+
+        if error:
+            self.logger.critical(error)
+        self.assertEqual(error.find("FAIL"), -1)
+
+        # again, with the collections already in the directory
+        error = self.vapi.cli("test statseg")
+        self.assertEqual(error.find("FAIL"), -1)
+
+        reply = self.vapi.cli("show statseg")
+        self.assertIn("/test/simple", reply)
+        self.assertIn("/test/combined", reply)
+        self.assertNotIn("/test/big", reply)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+
+
+class TestVhostUser(VppTestCase):
+    """ Vhost-user Test Case """
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestVhostUser, cls).setUpClass()
+
+    def setUp(self):
+        super(TestVhostUser, self).setUp()
+
+    def tearDown(self):
+        super(TestVhostUser, self).tearDown()
+
+    def test_vhost_user_rx_offload(self):
+        """ Vhost-user rx offload header parsing """
+        error = self.vapi.cli("test vhost-user rx-offload")
+
+        if error:
+            self.logger.critical(error)
+        self.assertEqual(error.find("Failed"), -1)
+
+
+if __name__ == '__main__':
+    unittest.main(testRunner=VppTestRunner)
@@ -802,6 +802,45 @@ class VppPapiProvider(object):
              'next_hop_via_label': next_hop_via_label,
              'next_hop_out_label_stack': next_hop_out_label_stack})
 
+    def ip_add_del_route_bulk(
+            self,
+            routes,
+            table_id=0,
+            next_hop_table_id=0,
+            is_add=1,
+            is_ipv6=0):
+        """
+
+        :param routes: list of dicts with dst_address, dst_address_length,
+                       next_hop_address and optionally
+                       next_hop_sw_if_index, next_hop_weight and
+                       next_hop_preference
+        :param table_id:  (Default value = 0)
+        :param next_hop_table_id:  (Default value = 0)
+        :param is_add:  (Default value = 1)
+        :param is_ipv6:  (Default value = 0)
+
+        """
+        entries = []
+        for r in routes:
+            entries.append({
+                'next_hop_sw_if_index': r.get('next_hop_sw_if_index',
+                                              0xFFFFFFFF),
+                'next_hop_weight': r.get('next_hop_weight', 1),
+                'next_hop_preference': r.get('next_hop_preference', 0),
+                'dst_address_length': r['dst_address_length'],
+                'dst_address': r['dst_address'],
+                'next_hop_address': r['next_hop_address']})
+
+        return self.api(
+            self.papi.ip_add_del_route_bulk,
+            {'table_id': table_id,
+             'next_hop_table_id': next_hop_table_id,
+             'is_add': is_add,
+             'is_ipv6': is_ipv6,
+             'count': len(entries),
+             'routes': entries})
+
     def ip_fib_dump(self):
         return self.api(self.papi.ip_fib_dump, {})
 
@@ -1957,6 +1996,61 @@ class VppPapiProvider(object):
              'metadata': metadata,
              'match': match})
 
+    def classify_tss_add_del_table(
+            self,
+            is_add,
+            match_n_vectors=1,
+            table_index=0xFFFFFFFF,
+            nbuckets=2,
+            memory_size=2097152,
+            skip_n_vectors=0,
+            next_table_index=0xFFFFFFFF,
+            miss_next_index=0xFFFFFFFF):
+        """
+        :param is_add:
+        :param match_n_vectors: (Default value = 1)
+        :param table_index: (Default value = 0xFFFFFFFF)
+        :param nbuckets:  (Default value = 2)
+        :param memory_size:  (Default value = 2097152)
+        :param skip_n_vectors:  (Default value = 0)
+        :param next_table_index:  (Default value = 0xFFFFFFFF)
+        :param miss_next_index:  (Default value = 0xFFFFFFFF)
+        """
+
+        return self.api(
+            self.papi.classify_tss_add_del_table,
+            {'is_add': is_add,
+             'table_index': table_index,
+             'nbuckets': nbuckets,
+             'memory_size': memory_size,
+             'skip_n_vectors': skip_n_vectors,
+             'match_n_vectors': match_n_vectors,
+             'next_table_index': next_table_index,
+             'miss_next_index': miss_next_index})
+
+    def classify_tss_add_del_rule(
+            self,
+            is_add,
+            table_index,
+            rule_index,
+            mask_and_match,
+            hit_next_index=0xFFFFFFFF):
+        """
+        :param is_add:
+        :param table_index:
+        :param rule_index:
+        :param mask_and_match: the rule's mask followed by its match
+        :param hit_next_index:  (Default value = 0xFFFFFFFF)
+        """
+
+        return self.api(
+            self.papi.classify_tss_add_del_rule,
+            {'is_add': is_add,
+             'table_index': table_index,
+             'rule_index': rule_index,
+             'hit_next_index': hit_next_index,
+             'mask_and_match': mask_and_match})
+
     def input_acl_set_interface(
             self,
             is_add,
@@ -2767,3 +2861,46 @@ class VppPapiProvider(object):
         return self.api(self.papi.add_node_next,
                         {'node_name': node_name,
                          'next_name': next_name})
+
+    def memif_create(
+            self,
+            role,
+            socket_filename,
+            id=0,
+            mode=0,
+            ring_size=0,
+            buffer_size=0,
+            hw_addr='',
+            zero_copy=0):
+        """ Create a memif interface
+
+        :param role: 0 = master, 1 = slave
+        :param socket_filename: socket used to connect to the peer
+        :param id: id that matches the two ends (Default value = 0)
+        :param mode: 0 = ethernet, 1 = ip (Default value = 0)
+        :param ring_size: 0 for the default (Default value = 0)
+        :param buffer_size: 0 for the default (Default value = 0)
+        :param hw_addr: MAC address, random if empty (Default value = '')
+        :param zero_copy: exchange vlib buffers with the peer, slave only
+                          (Default value = 0)
+        """
+        return self.api(self.papi.memif_create,
+                        {'role': role,
+                         'mode': mode,
+                         'id': id,
+                         'socket_filename': socket_filename,
+                         'ring_size': ring_size,
+                         'buffer_size': buffer_size,
+                         'hw_addr': hw_addr,
+                         'zero_copy': zero_copy})
+
+    def memif_delete(self, sw_if_index):
+        """ Delete a memif interface
+
+        :param sw_if_index: software index of the interface
+        """
+        return self.api(self.papi.memif_delete,
+                        {'sw_if_index': sw_if_index})
+
+    def memif_dump(self):
+        return self.api(self.papi.memif_dump, {})